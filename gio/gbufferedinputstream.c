@@ -43,6 +43,15 @@
  * for buffered reads. 
  * 
  * By default, #GBufferedInputStream's buffer size is set at 4 kilobytes.
+ * When the buffer keeps getting drained as fast as it is filled, it is
+ * doubled, up to 256 kilobytes, so that fast readers need fewer reads
+ * from the base stream. A size chosen with
+ * g_buffered_input_stream_new_sized() or
+ * g_buffered_input_stream_set_buffer_size() is kept as it is.
+ *
+ * g_buffered_input_stream_borrow() and g_buffered_input_stream_consume()
+ * give direct access to the buffered data, so that parsers can look at
+ * it without copying it out of the stream first.
  * 
  * To create a buffered input stream, use g_buffered_input_stream_new(), 
  * or g_buffered_input_stream_new_sized() to specify the buffer's size at 
@@ -60,11 +69,19 @@
 
 #define DEFAULT_BUFFER_SIZE 4096
 
+/* The buffer is doubled after this many consecutive refills of an empty
+ * buffer came back full, up to MAX_ADAPTIVE_BUFFER_SIZE.
+ */
+#define FULL_FILLS_BEFORE_GROWTH 2
+#define MAX_ADAPTIVE_BUFFER_SIZE (256 * 1024)
+
 struct _GBufferedInputStreamPrivate {
   guint8 *buffer;
   gsize   len;
   gsize   pos;
   gsize   end;
+  guint   fixed_size : 1;
+  guint   n_full_fills;
   GAsyncReadyCallback outstanding_callback;
 };
 
@@ -191,24 +208,13 @@ g_buffered_input_stream_get_buffer_size (GBufferedInputStream  *stream)
   return stream->priv->len;
 }
 
-/**
- * g_buffered_input_stream_set_buffer_size:
- * @stream: #GBufferedInputStream.
- * @size: a #gsize.
- *
- * Sets the size of the internal buffer of @stream to @size, or to the 
- * size of the contents of the buffer. The buffer can never be resized 
- * smaller than its current contents.
- **/
-void
-g_buffered_input_stream_set_buffer_size (GBufferedInputStream  *stream,
-                                         gsize                  size)
+static void
+resize_buffer (GBufferedInputStream *stream,
+               gsize                 size)
 {
   GBufferedInputStreamPrivate *priv;
   gsize in_buffer;
   guint8 *buffer;
-  
-  g_return_if_fail (G_IS_BUFFERED_INPUT_STREAM (stream));
 
   priv = stream->priv;
 
@@ -241,6 +247,30 @@ g_buffered_input_stream_set_buffer_size (GBufferedInputStream  *stream,
   g_object_notify (G_OBJECT (stream), "buffer-size");
 }
 
+/**
+ * g_buffered_input_stream_set_buffer_size:
+ * @stream: #GBufferedInputStream.
+ * @size: a #gsize.
+ *
+ * Sets the size of the internal buffer of @stream to @size, or to the 
+ * size of the contents of the buffer. The buffer can never be resized 
+ * smaller than its current contents.
+ *
+ * After this, @stream no longer grows its buffer on its own.
+ **/
+void
+g_buffered_input_stream_set_buffer_size (GBufferedInputStream  *stream,
+                                         gsize                  size)
+{
+  g_return_if_fail (G_IS_BUFFERED_INPUT_STREAM (stream));
+
+  /* The construct-time default does not count as an explicit size */
+  if (stream->priv->buffer)
+    stream->priv->fixed_size = TRUE;
+
+  resize_buffer (stream, size);
+}
+
 static void
 g_buffered_input_stream_set_property (GObject      *object,
                                       guint         prop_id,
@@ -342,7 +372,7 @@ g_buffered_input_stream_new (GInputStream *base_stream)
  * @size: a #gsize.
  * 
  * Creates a new #GBufferedInputStream from the given @base_stream, 
- * with a buffer set to @size.
+ * with a buffer set to @size. The buffer does not grow on its own.
  *
  * Returns: a #GInputStream.
  **/
@@ -358,6 +388,7 @@ g_buffered_input_stream_new_sized (GInputStream *base_stream,
                          "base-stream", base_stream,
                          "buffer-size", (guint)size,
                          NULL);
+  G_BUFFERED_INPUT_STREAM (stream)->priv->fixed_size = TRUE;
 
   return stream;
 }
@@ -633,6 +664,110 @@ g_buffered_input_stream_peek_buffer (GBufferedInputStream *stream,
   return priv->buffer + priv->pos;
 }
 
+/**
+ * g_buffered_input_stream_borrow:
+ * @stream: a #GBufferedInputStream.
+ * @count: the number of bytes wanted.
+ * @available: location to store the number of bytes in the returned
+ *     buffer, or %NULL.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @error: location to store the error occuring, or %NULL to ignore.
+ *
+ * Fills the buffer of @stream until it holds at least @count bytes,
+ * growing it if @count is larger than the buffer size, and returns the
+ * buffered data without copying it. Will block during this read.
+ *
+ * The returned buffer holds all buffered data, which may be more than
+ * @count bytes, or less if the end of the stream was reached. It must
+ * not be modified, and becomes invalid when reading from the stream or
+ * filling the buffer. Use g_buffered_input_stream_consume() to drop
+ * the bytes that have been dealt with.
+ *
+ * If @cancellable is not %NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned.
+ *
+ * Returns: read-only buffer, or %NULL on error.
+ *
+ * Since: 2.20
+ **/
+const void *
+g_buffered_input_stream_borrow (GBufferedInputStream  *stream,
+                                gsize                  count,
+                                gsize                 *available,
+                                GCancellable          *cancellable,
+                                GError               **error)
+{
+  GBufferedInputStreamPrivate *priv;
+  GBufferedInputStreamClass *class;
+  GInputStream *input_stream;
+  gssize res;
+
+  g_return_val_if_fail (G_IS_BUFFERED_INPUT_STREAM (stream), NULL);
+
+  priv = stream->priv;
+  input_stream = G_INPUT_STREAM (stream);
+
+  if (!g_input_stream_set_pending (input_stream, error))
+    return NULL;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  class = G_BUFFERED_INPUT_STREAM_GET_CLASS (stream);
+  res = 0;
+  while (priv->end - priv->pos < count)
+    {
+      if (count > priv->len)
+        resize_buffer (stream, MAX (count, 2 * priv->len));
+
+      res = class->fill (stream, -1, cancellable, error);
+      if (res <= 0)
+        break;
+    }
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  g_input_stream_clear_pending (input_stream);
+
+  if (res < 0)
+    return NULL;
+
+  if (available)
+    *available = priv->end - priv->pos;
+
+  return priv->buffer + priv->pos;
+}
+
+/**
+ * g_buffered_input_stream_consume:
+ * @stream: a #GBufferedInputStream.
+ * @count: the number of bytes to drop.
+ *
+ * Drops the first @count bytes of the buffer of @stream, as if they
+ * had been read. @count must not be larger than
+ * g_buffered_input_stream_get_available(). This does no I/O; it is
+ * meant to be used after g_buffered_input_stream_borrow() or
+ * g_buffered_input_stream_peek_buffer().
+ *
+ * Since: 2.20
+ **/
+void
+g_buffered_input_stream_consume (GBufferedInputStream *stream,
+                                 gsize                 count)
+{
+  GBufferedInputStreamPrivate *priv;
+
+  g_return_if_fail (G_IS_BUFFERED_INPUT_STREAM (stream));
+
+  priv = stream->priv;
+
+  g_return_if_fail (count <= priv->end - priv->pos);
+
+  priv->pos += count;
+}
+
 static void
 compact_buffer (GBufferedInputStream *stream)
 {
@@ -649,6 +784,46 @@ compact_buffer (GBufferedInputStream *stream)
   priv->end = current_size;
 }
 
+/* Refilling an empty buffer and getting it back full, several times in
+ * a row, means the reader keeps up with the base stream and would do
+ * fewer, larger reads with a bigger buffer. Returns the count to read.
+ */
+static gssize
+adapt_fill_count (GBufferedInputStream *stream,
+                  gssize                count)
+{
+  GBufferedInputStreamPrivate *priv;
+
+  priv = stream->priv;
+
+  if (priv->fixed_size ||
+      priv->end != priv->pos ||
+      (gsize) count < priv->len ||
+      priv->n_full_fills < FULL_FILLS_BEFORE_GROWTH ||
+      priv->len >= MAX_ADAPTIVE_BUFFER_SIZE)
+    return count;
+
+  priv->n_full_fills = 0;
+  resize_buffer (stream, MIN (2 * priv->len, MAX_ADAPTIVE_BUFFER_SIZE));
+
+  return priv->len;
+}
+
+static void
+note_fill_result (GBufferedInputStream *stream,
+                  gssize                nread)
+{
+  GBufferedInputStreamPrivate *priv;
+
+  priv = stream->priv;
+
+  /* Only a fill of the whole, empty buffer can read priv->len bytes */
+  if ((gsize) nread == priv->len)
+    priv->n_full_fills++;
+  else
+    priv->n_full_fills = 0;
+}
+
 static gssize
 g_buffered_input_stream_real_fill (GBufferedInputStream  *stream,
                                    gssize                 count,
@@ -664,6 +839,8 @@ g_buffered_input_stream_real_fill (GBufferedInputStream  *stream,
 
   if (count == -1)
     count = priv->len;
+
+  count = adapt_fill_count (stream, count);
   
   in_buffer = priv->end - priv->pos;
 
@@ -683,6 +860,9 @@ g_buffered_input_stream_real_fill (GBufferedInputStream  *stream,
 
   if (nread > 0)
     priv->end += nread;
+
+  if (nread >= 0)
+    note_fill_result (stream, nread);
   
   return nread;
 }
@@ -955,6 +1135,8 @@ fill_async_callback (GObject      *source_object,
       g_assert_cmpint (priv->end + res, <=, priv->len);
       priv->end += res;
 
+      note_fill_result (G_BUFFERED_INPUT_STREAM (object), res);
+
       g_object_unref (object);
     }
   
@@ -980,6 +1162,8 @@ g_buffered_input_stream_real_fill_async (GBufferedInputStream *stream,
 
   if (count == -1)
     count = priv->len;
+
+  count = adapt_fill_count (stream, count);
   
   in_buffer = priv->end - priv->pos;
 
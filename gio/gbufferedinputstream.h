@@ -99,6 +99,13 @@ gsize         g_buffered_input_stream_peek            (GBufferedInputStream  *st
 						       gsize                  count);
 const void*   g_buffered_input_stream_peek_buffer     (GBufferedInputStream  *stream,
 						       gsize                 *count);
+const void*   g_buffered_input_stream_borrow          (GBufferedInputStream  *stream,
+						       gsize                  count,
+						       gsize                 *available,
+						       GCancellable          *cancellable,
+						       GError               **error);
+void          g_buffered_input_stream_consume         (GBufferedInputStream  *stream,
+						       gsize                  count);
 
 gssize        g_buffered_input_stream_fill            (GBufferedInputStream  *stream,
 						       gssize                 count,
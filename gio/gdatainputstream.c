@@ -26,6 +26,7 @@
 #include "gioenumtypes.h"
 #include "gioerror.h"
 #include "glibintl.h"
+#include <string.h>
 
 #include "gioalias.h"
 
@@ -627,104 +628,235 @@ g_data_input_stream_read_uint64 (GDataInputStream  *stream,
   return 0;
 }
 
+/* Looks for the end of the line that starts at the beginning of the
+ * buffer, resuming at *checked_out. The scanned bytes stay in the buffer
+ * until the line is consumed, so a CR that ended the previous scan can
+ * still be looked at.
+ */
 static gssize
 scan_for_newline (GDataInputStream *stream,
 		  gsize            *checked_out,
-		  gboolean         *last_saw_cr_out,
 		  int              *newline_len_out)
 {
   GBufferedInputStream *bstream;
   GDataInputStreamPrivate *priv;
-  const char *buffer;
-  gsize start, end, peeked;
-  int i;
-  gssize found_pos;
-  int newline_len;
+  const char *buffer, *lf, *cr;
   gsize available, checked;
-  gboolean last_saw_cr;
 
   priv = stream->priv;
   
   bstream = G_BUFFERED_INPUT_STREAM (stream);
 
   checked = *checked_out;
-  last_saw_cr = *last_saw_cr_out;
-  found_pos = -1;
-  newline_len = 0;
-  
-  start = checked;
-  buffer = (const char*)g_buffered_input_stream_peek_buffer (bstream, &available) + start;
-  end = available;
-  peeked = end - start;
+  buffer = (const char*)g_buffered_input_stream_peek_buffer (bstream, &available);
 
-  for (i = 0; checked < available && i < peeked; i++)
+  switch (priv->newline_type)
     {
-      switch (priv->newline_type)
+    case G_DATA_STREAM_NEWLINE_TYPE_LF:
+      lf = memchr (buffer + checked, '\n', available - checked);
+      if (lf)
 	{
-	case G_DATA_STREAM_NEWLINE_TYPE_LF:
-	  if (buffer[i] == 10)
-	    {
-	      found_pos = start + i;
-	      newline_len = 1;
-	    }
-	  break;
-	case G_DATA_STREAM_NEWLINE_TYPE_CR:
-	  if (buffer[i] == 13)
+	  *newline_len_out = 1;
+	  return lf - buffer;
+	}
+      break;
+
+    case G_DATA_STREAM_NEWLINE_TYPE_CR:
+      cr = memchr (buffer + checked, '\r', available - checked);
+      if (cr)
+	{
+	  *newline_len_out = 1;
+	  return cr - buffer;
+	}
+      break;
+
+    case G_DATA_STREAM_NEWLINE_TYPE_CR_LF:
+      while ((lf = memchr (buffer + checked, '\n', available - checked)) != NULL)
+	{
+	  if (lf > buffer && lf[-1] == '\r')
 	    {
-	      found_pos = start + i;
-	      newline_len = 1;
+	      *newline_len_out = 2;
+	      return lf - 1 - buffer;
 	    }
-	  break;
-	case G_DATA_STREAM_NEWLINE_TYPE_CR_LF:
-	  if (last_saw_cr && buffer[i] == 10)
+	  checked = lf + 1 - buffer;
+	}
+      break;
+
+    default:
+    case G_DATA_STREAM_NEWLINE_TYPE_ANY:
+      lf = memchr (buffer + checked, '\n', available - checked);
+      cr = memchr (buffer + checked, '\r',
+		   (lf ? lf : buffer + available) - (buffer + checked));
+      if (cr == NULL && lf != NULL)
+	{
+	  *newline_len_out = 1;
+	  return lf - buffer;
+	}
+      if (cr != NULL)
+	{
+	  /* A CR at the end of the buffer needs the next byte to tell
+	   * CR from CR LF; scan it again after the next fill.
+	   */
+	  if (cr + 1 == buffer + available)
 	    {
-	      found_pos = start + i - 1;
-	      newline_len = 2;
+	      *checked_out = cr - buffer;
+	      return -1;
 	    }
-	  break;
-	default:
-	case G_DATA_STREAM_NEWLINE_TYPE_ANY:
-	  if (buffer[i] == 10) /* LF */
+
+	  *newline_len_out = (cr[1] == '\n') ? 2 : 1;
+	  return cr - buffer;
+	}
+      break;
+    }
+
+  *checked_out = available;
+  return -1;
+}
+
+/* Reads a line or token of @len bytes, followed by @skip bytes that are
+ * dropped, straight out of the buffer.
+ */
+static char *
+take_buffered (GDataInputStream *stream,
+	       gsize             len,
+	       gsize             skip,
+	       gsize            *length)
+{
+  GBufferedInputStream *bstream;
+  const char *buffer;
+  char *data;
+
+  bstream = G_BUFFERED_INPUT_STREAM (stream);
+  buffer = g_buffered_input_stream_peek_buffer (bstream, NULL);
+
+  data = g_malloc (len + 1);
+  memcpy (data, buffer, len);
+  data[len] = 0;
+
+  g_buffered_input_stream_consume (bstream, len + skip);
+
+  if (length)
+    *length = len;
+
+  return data;
+}
+
+/* Makes at least one more byte available in the buffer. Returns FALSE
+ * on error or at the end of the stream, and stores the number of
+ * buffered bytes in @available.
+ */
+static gboolean
+buffer_more (GDataInputStream *stream,
+	     gsize            *available,
+	     GCancellable     *cancellable,
+	     GError          **error)
+{
+  GBufferedInputStream *bstream;
+  gsize before;
+
+  bstream = G_BUFFERED_INPUT_STREAM (stream);
+  before = g_buffered_input_stream_get_available (bstream);
+
+  if (g_buffered_input_stream_borrow (bstream, before + 1, available,
+				      cancellable, error) == NULL)
+    return FALSE;
+
+  return *available > before;
+}
+
+/* Validates the bytes of the line from *validated up to @end, and moves
+ * *validated past them. Newline characters are ASCII and never occur
+ * inside a multibyte character, so this can follow the newline scan.
+ * A character cut off at @end is left for the next call, unless the
+ * line is @complete.
+ */
+static gboolean
+validate_utf8 (GDataInputStream *stream,
+	       gsize            *validated,
+	       gsize             end,
+	       gboolean          complete)
+{
+  const char *buffer;
+  const gchar *stop;
+
+  buffer = g_buffered_input_stream_peek_buffer (G_BUFFERED_INPUT_STREAM (stream), NULL);
+
+  if (g_utf8_validate (buffer + *validated, end - *validated, &stop))
+    {
+      *validated = end;
+      return TRUE;
+    }
+
+  *validated = stop - buffer;
+
+  return !complete &&
+    g_utf8_get_char_validated (stop, end - *validated) == (gunichar) -2;
+}
+
+static char *
+read_line (GDataInputStream  *stream,
+	   gsize             *length,
+	   gboolean           utf8,
+	   GCancellable      *cancellable,
+	   GError           **error)
+{
+  gsize checked, available, validated;
+  gssize found_pos;
+  int newline_len;
+  gboolean valid;
+  GError *local_error;
+
+  newline_len = 0;
+  checked = 0;
+  validated = 0;
+  valid = TRUE;
+
+  while ((found_pos = scan_for_newline (stream, &checked, &newline_len)) == -1)
+    {
+      if (utf8 && valid)
+	valid = validate_utf8 (stream, &validated, checked, FALSE);
+
+      local_error = NULL;
+      if (!buffer_more (stream, &available, cancellable, &local_error))
+	{
+	  if (local_error)
 	    {
-	      if (last_saw_cr)
-		{
-		  /* CR LF */
-		  found_pos = start + i - 1;
-		  newline_len = 2;
-		}
-	      else
-		{
-		  /* LF */
-		  found_pos = start + i;
-		  newline_len = 1;
-		}
+	      g_propagate_error (error, local_error);
+	      return NULL;
 	    }
-	  else if (last_saw_cr)
+
+	  /* End of stream */
+	  if (available == 0)
 	    {
-	      /* Last was cr, this is not LF, end is CR */
-	      found_pos = start + i - 1;
-	      newline_len = 1;
+	      if (length)
+		*length = 0;
+	      return NULL;
 	    }
-	  /* Don't check for CR here, instead look at last_saw_cr on next byte */
-	  break;
-	}
-	
-      last_saw_cr = (buffer[i] == 13);
 
-      if (found_pos != -1)
-	{
-	  *newline_len_out = newline_len;
-	  return found_pos;
+	  found_pos = available;
+	  newline_len = 0;
+	  break;
 	}
     }
 
-  checked = end;
+  if (utf8 && valid)
+    valid = validate_utf8 (stream, &validated, found_pos, TRUE);
 
-  *checked_out = checked;
-  *last_saw_cr_out = last_saw_cr;
-  return -1;
+  if (!valid)
+    {
+      /* Drop the line, so that reading can go on with the next one */
+      g_buffered_input_stream_consume (G_BUFFERED_INPUT_STREAM (stream),
+				       found_pos + newline_len);
+      g_set_error_literal (error, G_CONVERT_ERROR,
+			   G_CONVERT_ERROR_ILLEGAL_SEQUENCE,
+			   _("Invalid byte sequence in conversion input"));
+      if (length)
+	*length = 0;
+      return NULL;
+    }
+
+  return take_buffered (stream, found_pos, newline_len, length);
 }
-		  
 
 /**
  * g_data_input_stream_read_line:
@@ -750,103 +882,114 @@ g_data_input_stream_read_line (GDataInputStream  *stream,
 			       GCancellable      *cancellable,
 			       GError           **error)
 {
-  GBufferedInputStream *bstream;
-  gsize checked;
-  gboolean last_saw_cr;
-  gssize found_pos;
-  gssize res;
-  int newline_len;
-  char *line;
-  
-  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (stream), NULL);  
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (stream), NULL);
 
-  bstream = G_BUFFERED_INPUT_STREAM (stream);
+  return read_line (stream, length, FALSE, cancellable, error);
+}
 
-  newline_len = 0;
-  checked = 0;
-  last_saw_cr = FALSE;
+/**
+ * g_data_input_stream_read_line_utf8:
+ * @stream: a given #GDataInputStream.
+ * @length: a #gsize to get the length of the data read in.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @error: #GError for error reporting.
+ *
+ * Reads a UTF-8 encoded line from the data input stream. This is like
+ * g_data_input_stream_read_line(), but the line is checked to be valid
+ * UTF-8 while its end is searched for, instead of in a second pass.
+ *
+ * If the line is not valid UTF-8, it is skipped, and %NULL is returned
+ * with a %G_CONVERT_ERROR_ILLEGAL_SEQUENCE error.
+ *
+ * If @cancellable is not %NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned.
+ *
+ * Returns: a UTF-8 string with the line that was read in (without the
+ * newlines). Set @length to a #gsize to get the length of the read line.
+ * On an error, it will return %NULL and @error will be set. If there's no
+ * content to read, it will still return %NULL, but @error won't be set.
+ *
+ * Since: 2.20
+ **/
+char *
+g_data_input_stream_read_line_utf8 (GDataInputStream  *stream,
+				    gsize             *length,
+				    GCancellable      *cancellable,
+				    GError           **error)
+{
+  g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (stream), NULL);
 
-  while ((found_pos = scan_for_newline (stream, &checked, &last_saw_cr, &newline_len)) == -1)
-    {
-      if (g_buffered_input_stream_get_available (bstream) ==
-	  g_buffered_input_stream_get_buffer_size (bstream))
-	g_buffered_input_stream_set_buffer_size (bstream,
-						 2 * g_buffered_input_stream_get_buffer_size (bstream));
+  return read_line (stream, length, TRUE, cancellable, error);
+}
 
-      res = g_buffered_input_stream_fill (bstream, -1, cancellable, error);
-      if (res < 0)
-	return NULL;
-      if (res == 0)
-	{
-	  /* End of stream */
-	  if (g_buffered_input_stream_get_available (bstream) == 0)
-	    {
-	      if (length)
-		*length = 0;
-	      return NULL;
-	    }
-	  else
-	    {
-	      found_pos = checked;
-	      newline_len = 0;
-	      break;
-	    }
-	}
-    }
+/* A set of stop characters, as a table indexed by byte value */
+typedef struct {
+  guint8 is_stop[256];
+  guchar first;
+  gint   n_chars;
+} StopChars;
 
-  line = g_malloc (found_pos + newline_len + 1);
+static void
+stop_chars_init (StopChars  *stop_chars,
+		 const char *chars)
+{
+  const char *c;
 
-  res = g_input_stream_read (G_INPUT_STREAM (stream),
-			     line,
-			     found_pos + newline_len,
-			     NULL, NULL);
-  if (length)
-    *length = (gsize)found_pos;
-  g_warn_if_fail (res == found_pos + newline_len);
-  line[found_pos] = 0;
-  
-  return line;
-}
+  memset (stop_chars->is_stop, 0, sizeof (stop_chars->is_stop));
+  stop_chars->first = chars[0];
+  stop_chars->n_chars = 0;
 
+  for (c = chars; *c != '\0'; c++)
+    {
+      if (!stop_chars->is_stop[(guchar) *c])
+	stop_chars->n_chars++;
+      stop_chars->is_stop[(guchar) *c] = 1;
+    }
+}
 
 static gssize
 scan_for_chars (GDataInputStream *stream,
 		gsize            *checked_out,
-		const char       *stop_chars)
+		const StopChars  *stop_chars)
 {
   GBufferedInputStream *bstream;
-  GDataInputStreamPrivate *priv;
-  const char *buffer;
-  gsize start, end, peeked;
-  int i;
-  gssize found_pos;
-  gsize available, checked;
-  const char *stop_char;
+  const guchar *buffer, *p, *end;
+  gsize available;
 
-  priv = stream->priv;
-  
   bstream = G_BUFFERED_INPUT_STREAM (stream);
 
-  checked = *checked_out;
-  found_pos = -1;
-  
-  start = checked;
-  buffer = (const char *)g_buffered_input_stream_peek_buffer (bstream, &available) + start;
-  end = available;
-  peeked = end - start;
+  buffer = g_buffered_input_stream_peek_buffer (bstream, &available);
+  p = buffer + *checked_out;
+  end = buffer + available;
 
-  for (i = 0; checked < available && i < peeked; i++)
+  if (stop_chars->n_chars == 1)
+    {
+      p = memchr (p, stop_chars->first, end - p);
+      if (p)
+	return p - buffer;
+    }
+  else if (stop_chars->n_chars > 1)
     {
-      for (stop_char = stop_chars; *stop_char != '\0'; stop_char++)
+      /* Four bytes per round keeps the loop overhead down */
+      while (end - p >= 4)
 	{
-	  if (buffer[i] == *stop_char)
-	    return (start + i);
+	  if (stop_chars->is_stop[p[0]])
+	    return p - buffer;
+	  if (stop_chars->is_stop[p[1]])
+	    return p + 1 - buffer;
+	  if (stop_chars->is_stop[p[2]])
+	    return p + 2 - buffer;
+	  if (stop_chars->is_stop[p[3]])
+	    return p + 3 - buffer;
+	  p += 4;
 	}
+      for (; p < end; p++)
+	if (stop_chars->is_stop[*p])
+	  return p - buffer;
     }
 
-  checked = end;
-
-  *checked_out = checked;
+  *checked_out = available;
   return -1;
 }
 
@@ -872,60 +1015,45 @@ g_data_input_stream_read_until (GDataInputStream  *stream,
 			       GCancellable       *cancellable,
 			       GError            **error)
 {
-  GBufferedInputStream *bstream;
-  gsize checked;
+  StopChars table;
+  gsize checked, available;
   gssize found_pos;
-  gssize res;
   int stop_char_len;
-  char *data_until;
+  GError *local_error;
   
   g_return_val_if_fail (G_IS_DATA_INPUT_STREAM (stream), NULL);  
+  g_return_val_if_fail (stop_chars != NULL, NULL);
 
-  bstream = G_BUFFERED_INPUT_STREAM (stream);
-
+  stop_chars_init (&table, stop_chars);
   stop_char_len = 1;
   checked = 0;
 
-  while ((found_pos = scan_for_chars (stream, &checked, stop_chars)) == -1)
+  while ((found_pos = scan_for_chars (stream, &checked, &table)) == -1)
     {
-      if (g_buffered_input_stream_get_available (bstream) ==
-	  g_buffered_input_stream_get_buffer_size (bstream))
-	g_buffered_input_stream_set_buffer_size (bstream,
-						 2 * g_buffered_input_stream_get_buffer_size (bstream));
-
-      res = g_buffered_input_stream_fill (bstream, -1, cancellable, error);
-      if (res < 0)
-	return NULL;
-      if (res == 0)
+      local_error = NULL;
+      if (!buffer_more (stream, &available, cancellable, &local_error))
 	{
+	  if (local_error)
+	    {
+	      g_propagate_error (error, local_error);
+	      return NULL;
+	    }
+
 	  /* End of stream */
-	  if (g_buffered_input_stream_get_available (bstream) == 0)
+	  if (available == 0)
 	    {
 	      if (length)
 		*length = 0;
 	      return NULL;
 	    }
-	  else
-	    {
-	      found_pos = checked;
-	      stop_char_len = 0;
-	      break;
-	    }
+
+	  found_pos = available;
+	  stop_char_len = 0;
+	  break;
 	}
     }
 
-  data_until = g_malloc (found_pos + stop_char_len + 1);
-
-  res = g_input_stream_read (G_INPUT_STREAM (stream),
-			     data_until,
-			     found_pos + stop_char_len,
-			     NULL, NULL);
-  if (length)
-    *length = (gsize)found_pos;
-  g_warn_if_fail (res == found_pos + stop_char_len);
-  data_until[found_pos] = 0;
-  
-  return data_until;
+  return take_buffered (stream, found_pos, stop_char_len, length);
 }
 
 #define __G_DATA_INPUT_STREAM_C__
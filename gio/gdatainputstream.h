@@ -103,6 +103,10 @@ char *                 g_data_input_stream_read_line        (GDataInputStream
 							     gsize                   *length,
 							     GCancellable            *cancellable,
 							     GError                 **error);
+char *                 g_data_input_stream_read_line_utf8   (GDataInputStream        *stream,
+							     gsize                   *length,
+							     GCancellable            *cancellable,
+							     GError                 **error);
 char *                 g_data_input_stream_read_until       (GDataInputStream        *stream,
 							     const gchar             *stop_chars,
 							     gsize                   *length,
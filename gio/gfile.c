@@ -23,15 +23,31 @@
  */
 
 #include "config.h"
+
+#define _GNU_SOURCE		/* For copy_file_range */
+
 #include <string.h>
+#include <errno.h>
 #include <sys/types.h>
 #ifdef HAVE_PWD_H
 #include <pwd.h>
 #endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+#ifdef HAVE_LINUX_FS_H
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
 #include "gfile.h"
 #include "gvfs.h"
 #include "gioscheduler.h"
 #include "glocalfile.h"
+#include "glocalfileinputstream.h"
+#include "glocalfileoutputstream.h"
 #include "gsimpleasyncresult.h"
 #include "gfileattribute-priv.h"
 #include "gpollfilemonitor.h"
@@ -1430,6 +1446,47 @@ g_file_read (GFile         *file,
   return (* iface->read_fn) (file, cancellable, error);
 }
 
+/**
+ * g_file_read_mapped:
+ * @file: #GFile to read.
+ * @cancellable: a #GCancellable
+ * @error: a #GError, or %NULL
+ *
+ * Opens a file for reading, like g_file_read(). For regular local
+ * files, the returned stream reads from a memory mapping of the file
+ * instead of doing a system call per read: reads copy from the mapping,
+ * skipping and seeking only move the position, and
+ * g_file_input_stream_borrow() gives direct access to the file
+ * contents. Other files are read as with g_file_read().
+ *
+ * The stream sees the file as it was when it was opened. Since the
+ * file is accessed through memory, truncating it while it is being
+ * read can crash the program; only use this for files that are not
+ * modified in place, such as files replaced with g_file_replace().
+ *
+ * Returns: #GFileInputStream or %NULL on error.
+ *     Free the returned object with g_object_unref().
+ *
+ * Since: 2.20
+ **/
+GFileInputStream *
+g_file_read_mapped (GFile         *file,
+		    GCancellable  *cancellable,
+		    GError       **error)
+{
+  GFileInputStream *stream;
+
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+
+  stream = g_file_read (file, cancellable, error);
+
+  /* Mapping is only an optimization, the stream works without it */
+  if (stream != NULL && G_IS_LOCAL_FILE_INPUT_STREAM (stream))
+    _g_local_file_input_stream_map (G_LOCAL_FILE_INPUT_STREAM (stream));
+
+  return stream;
+}
+
 /**
  * g_file_append_to:
  * @file: input #GFile.
@@ -2190,6 +2247,179 @@ g_file_copy_attributes (GFile           *source,
   return res;
 }
 
+/* The copy through user space starts out with a buffer of the
+ * minimum size, and doubles it for as long as reads fill it.
+ */
+#define COPY_BUFFER_MIN_SIZE (64 * 1024)
+#define COPY_BUFFER_MAX_SIZE (1024 * 1024)
+
+#if defined (HAVE_COPY_FILE_RANGE) || (defined (HAVE_SENDFILE) && defined (HAVE_SYS_SENDFILE_H)) || defined (FICLONE)
+#define HAVE_KERNEL_COPY
+
+/* How much the kernel copies between progress callbacks and checks
+ * for cancellation
+ */
+#define KERNEL_COPY_CHUNK_SIZE (8 * 1024 * 1024)
+
+typedef gssize (* KernelCopyFunc) (int   in_fd,
+                                   int   out_fd,
+                                   gsize count);
+
+#ifdef HAVE_COPY_FILE_RANGE
+static gssize
+kernel_copy_file_range (int   in_fd,
+                        int   out_fd,
+                        gsize count)
+{
+  return copy_file_range (in_fd, NULL, out_fd, NULL, count, 0);
+}
+#endif
+
+#if defined (HAVE_SENDFILE) && defined (HAVE_SYS_SENDFILE_H)
+static gssize
+kernel_copy_sendfile (int   in_fd,
+                      int   out_fd,
+                      gsize count)
+{
+  return sendfile (out_fd, in_fd, NULL, count);
+}
+#endif
+
+static const KernelCopyFunc kernel_copy_funcs[] = {
+#ifdef HAVE_COPY_FILE_RANGE
+  kernel_copy_file_range,
+#endif
+#if defined (HAVE_SENDFILE) && defined (HAVE_SYS_SENDFILE_H)
+  kernel_copy_sendfile,
+#endif
+  NULL
+};
+
+/* Errors that mean a way of copying doesn't work for these files,
+ * rather than that the copy failed
+ */
+static gboolean
+kernel_copy_unsupported (int errsv)
+{
+  return errsv == EINVAL || errsv == ENOSYS || errsv == EXDEV ||
+    errsv == EBADF || errsv == ESPIPE ||
+#if defined (ENOTSUP) && ENOTSUP != EOPNOTSUPP
+    errsv == ENOTSUP ||
+#endif
+    errsv == EOPNOTSUPP;
+}
+
+/* Errors that can only come from the writing side; the kernel copy
+ * functions don't tell which file failed, so anything else is
+ * reported as a read error
+ */
+static gboolean
+kernel_copy_write_error (int errsv)
+{
+  return errsv == ENOSPC || errsv == EFBIG || errsv == EPIPE ||
+#ifdef EDQUOT
+    errsv == EDQUOT ||
+#endif
+    errsv == EROFS;
+}
+
+/* Copies as much as possible between two local files without going
+ * through user space: by sharing the blocks of the source if the file
+ * system can, else by copying in the kernel. Both file offsets are
+ * kept up to date, so that whatever is left can be copied the normal
+ * way afterwards.
+ */
+static gboolean
+copy_stream_in_kernel (GInputStream           *in,
+                       GOutputStream          *out,
+                       goffset                *current_size,
+                       goffset                 total_size,
+                       GCancellable           *cancellable,
+                       GFileProgressCallback   progress_callback,
+                       gpointer                progress_callback_data,
+                       GError                **error)
+{
+  int in_fd, out_fd, errsv;
+  gssize n_copied;
+  guint i;
+
+  if (!G_IS_LOCAL_FILE_INPUT_STREAM (in) ||
+      !G_IS_LOCAL_FILE_OUTPUT_STREAM (out))
+    return TRUE;
+
+  in_fd = _g_local_file_input_stream_get_fd (G_LOCAL_FILE_INPUT_STREAM (in));
+  out_fd = _g_local_file_output_stream_get_fd (G_LOCAL_FILE_OUTPUT_STREAM (out));
+
+#ifdef FICLONE
+  if (lseek (in_fd, 0, SEEK_CUR) == 0 && lseek (out_fd, 0, SEEK_CUR) == 0 &&
+      ioctl (out_fd, FICLONE, in_fd) == 0)
+    {
+      off_t size = lseek (in_fd, 0, SEEK_END);
+
+      if (size >= 0 && lseek (out_fd, size, SEEK_SET) == size)
+        {
+          *current_size = size;
+          if (progress_callback)
+            progress_callback (*current_size, total_size, progress_callback_data);
+
+          return TRUE;
+        }
+
+      /* start over, the copy overwrites the clone */
+      lseek (in_fd, 0, SEEK_SET);
+      lseek (out_fd, 0, SEEK_SET);
+    }
+#endif
+
+  for (i = 0; kernel_copy_funcs[i] != NULL; i++)
+    {
+      while (TRUE)
+        {
+          if (g_cancellable_set_error_if_cancelled (cancellable, error))
+            return FALSE;
+
+          n_copied = kernel_copy_funcs[i] (in_fd, out_fd, KERNEL_COPY_CHUNK_SIZE);
+
+          /* the end, or a file that doesn't know its size, like
+           * the ones in /proc; reading it normally will tell
+           */
+          if (n_copied == 0)
+            return TRUE;
+
+          if (n_copied < 0)
+            {
+              errsv = errno;
+
+              if (errsv == EINTR)
+                continue;
+
+              /* try the next way */
+              if (kernel_copy_unsupported (errsv))
+                break;
+
+              if (kernel_copy_write_error (errsv))
+                g_set_error (error, G_IO_ERROR,
+                             g_io_error_from_errno (errsv),
+                             _("Error writing to file: %s"),
+                             g_strerror (errsv));
+              else
+                g_set_error (error, G_IO_ERROR,
+                             g_io_error_from_errno (errsv),
+                             _("Error reading from file: %s"),
+                             g_strerror (errsv));
+              return FALSE;
+            }
+
+          *current_size += n_copied;
+          if (progress_callback)
+            progress_callback (*current_size, total_size, progress_callback_data);
+        }
+    }
+
+  return TRUE;
+}
+#endif /* HAVE_KERNEL_COPY */
+
 /* Closes the streams */
 static gboolean
 copy_stream_with_progress (GInputStream           *in,
@@ -2202,7 +2432,8 @@ copy_stream_with_progress (GInputStream           *in,
 {
   gssize n_read, n_written;
   goffset current_size;
-  char buffer[1024*64], *p;
+  char *buffer, *p;
+  gsize buffer_size;
   gboolean res;
   goffset total_size;
   GFileInfo *info;
@@ -2237,9 +2468,20 @@ copy_stream_with_progress (GInputStream           *in,
   
   current_size = 0;
   res = TRUE;
-  while (TRUE)
+
+#ifdef HAVE_KERNEL_COPY
+  res = copy_stream_in_kernel (in, out, &current_size, total_size,
+                               cancellable,
+                               progress_callback, progress_callback_data,
+                               error);
+#endif
+
+  buffer_size = COPY_BUFFER_MIN_SIZE;
+  buffer = g_malloc (buffer_size);
+
+  while (res)
     {
-      n_read = g_input_stream_read (in, buffer, sizeof (buffer), cancellable, error);
+      n_read = g_input_stream_read (in, buffer, buffer_size, cancellable, error);
       if (n_read == -1)
 	{
 	  res = FALSE;
@@ -2270,8 +2512,18 @@ copy_stream_with_progress (GInputStream           *in,
 
       if (progress_callback)
 	progress_callback (current_size, total_size, progress_callback_data);
+
+      /* a big file, read it in bigger blocks */
+      if ((gsize) n_read == buffer_size && buffer_size < COPY_BUFFER_MAX_SIZE)
+        {
+          buffer_size *= 2;
+          g_free (buffer);
+          buffer = g_malloc (buffer_size);
+        }
     }
 
+  g_free (buffer);
+
   if (!res)
     error = NULL; /* Ignore further errors */
 
@@ -474,6 +474,9 @@ void                    g_file_read_async                 (GFile
 GFileInputStream *      g_file_read_finish                (GFile                      *file,
 							   GAsyncResult               *res,
 							   GError                    **error);
+GFileInputStream *      g_file_read_mapped                (GFile                      *file,
+							   GCancellable               *cancellable,
+							   GError                    **error);
 GFileOutputStream *     g_file_append_to                  (GFile                      *file,
 							   GFileCreateFlags             flags,
 							   GCancellable               *cancellable,
@@ -87,6 +87,7 @@ struct _GFileInfoClass
 
 static gboolean g_file_attribute_matcher_matches_id (GFileAttributeMatcher *matcher,
 						     guint32 id);
+static guint    matcher_size_hint                   (GFileAttributeMatcher *matcher);
 
 G_DEFINE_TYPE (GFileInfo, g_file_info, G_TYPE_OBJECT);
 
@@ -123,6 +124,122 @@ static char ***attributes = NULL;
     ( ((((guint32) _ns) & NS_MASK) << NS_POS) |		\
       ((((guint32) _id) & ID_MASK) << ID_POS) )
 
+/* The common attributes are interned first, in this order, so that
+ * their ids are known at compile time. This keeps the accessors below
+ * from looking them up, and lookup_attribute() can find them without
+ * taking the lock.
+ */
+#define NS_STANDARD 1
+#define NS_ETAG 2
+#define NS_ID 3
+#define NS_ACCESS 4
+#define NS_TIME 5
+#define NS_UNIX 6
+#define NS_OWNER 7
+
+#define ATTR_STANDARD_TYPE              MAKE_ATTR_ID (NS_STANDARD, 1)
+#define ATTR_STANDARD_IS_HIDDEN         MAKE_ATTR_ID (NS_STANDARD, 2)
+#define ATTR_STANDARD_IS_BACKUP         MAKE_ATTR_ID (NS_STANDARD, 3)
+#define ATTR_STANDARD_IS_SYMLINK        MAKE_ATTR_ID (NS_STANDARD, 4)
+#define ATTR_STANDARD_IS_VIRTUAL        MAKE_ATTR_ID (NS_STANDARD, 5)
+#define ATTR_STANDARD_NAME              MAKE_ATTR_ID (NS_STANDARD, 6)
+#define ATTR_STANDARD_DISPLAY_NAME      MAKE_ATTR_ID (NS_STANDARD, 7)
+#define ATTR_STANDARD_EDIT_NAME         MAKE_ATTR_ID (NS_STANDARD, 8)
+#define ATTR_STANDARD_COPY_NAME         MAKE_ATTR_ID (NS_STANDARD, 9)
+#define ATTR_STANDARD_DESCRIPTION       MAKE_ATTR_ID (NS_STANDARD, 10)
+#define ATTR_STANDARD_ICON              MAKE_ATTR_ID (NS_STANDARD, 11)
+#define ATTR_STANDARD_CONTENT_TYPE      MAKE_ATTR_ID (NS_STANDARD, 12)
+#define ATTR_STANDARD_FAST_CONTENT_TYPE MAKE_ATTR_ID (NS_STANDARD, 13)
+#define ATTR_STANDARD_SIZE              MAKE_ATTR_ID (NS_STANDARD, 14)
+#define ATTR_STANDARD_SYMLINK_TARGET    MAKE_ATTR_ID (NS_STANDARD, 15)
+#define ATTR_STANDARD_TARGET_URI        MAKE_ATTR_ID (NS_STANDARD, 16)
+#define ATTR_STANDARD_SORT_ORDER        MAKE_ATTR_ID (NS_STANDARD, 17)
+#define ATTR_ETAG_VALUE                 MAKE_ATTR_ID (NS_ETAG, 1)
+#define ATTR_ID_FILE                    MAKE_ATTR_ID (NS_ID, 1)
+#define ATTR_ID_FILESYSTEM              MAKE_ATTR_ID (NS_ID, 2)
+#define ATTR_ACCESS_CAN_READ            MAKE_ATTR_ID (NS_ACCESS, 1)
+#define ATTR_ACCESS_CAN_WRITE           MAKE_ATTR_ID (NS_ACCESS, 2)
+#define ATTR_ACCESS_CAN_EXECUTE         MAKE_ATTR_ID (NS_ACCESS, 3)
+#define ATTR_ACCESS_CAN_DELETE          MAKE_ATTR_ID (NS_ACCESS, 4)
+#define ATTR_ACCESS_CAN_TRASH           MAKE_ATTR_ID (NS_ACCESS, 5)
+#define ATTR_ACCESS_CAN_RENAME          MAKE_ATTR_ID (NS_ACCESS, 6)
+#define ATTR_TIME_MODIFIED              MAKE_ATTR_ID (NS_TIME, 1)
+#define ATTR_TIME_MODIFIED_USEC         MAKE_ATTR_ID (NS_TIME, 2)
+#define ATTR_TIME_ACCESS                MAKE_ATTR_ID (NS_TIME, 3)
+#define ATTR_TIME_ACCESS_USEC           MAKE_ATTR_ID (NS_TIME, 4)
+#define ATTR_TIME_CHANGED               MAKE_ATTR_ID (NS_TIME, 5)
+#define ATTR_TIME_CHANGED_USEC          MAKE_ATTR_ID (NS_TIME, 6)
+#define ATTR_TIME_CREATED               MAKE_ATTR_ID (NS_TIME, 7)
+#define ATTR_TIME_CREATED_USEC          MAKE_ATTR_ID (NS_TIME, 8)
+#define ATTR_UNIX_DEVICE                MAKE_ATTR_ID (NS_UNIX, 1)
+#define ATTR_UNIX_INODE                 MAKE_ATTR_ID (NS_UNIX, 2)
+#define ATTR_UNIX_MODE                  MAKE_ATTR_ID (NS_UNIX, 3)
+#define ATTR_UNIX_NLINK                 MAKE_ATTR_ID (NS_UNIX, 4)
+#define ATTR_UNIX_UID                   MAKE_ATTR_ID (NS_UNIX, 5)
+#define ATTR_UNIX_GID                   MAKE_ATTR_ID (NS_UNIX, 6)
+#define ATTR_UNIX_RDEV                  MAKE_ATTR_ID (NS_UNIX, 7)
+#define ATTR_UNIX_BLOCK_SIZE            MAKE_ATTR_ID (NS_UNIX, 8)
+#define ATTR_UNIX_BLOCKS                MAKE_ATTR_ID (NS_UNIX, 9)
+#define ATTR_UNIX_IS_MOUNTPOINT         MAKE_ATTR_ID (NS_UNIX, 10)
+#define ATTR_OWNER_USER                 MAKE_ATTR_ID (NS_OWNER, 1)
+#define ATTR_OWNER_USER_REAL            MAKE_ATTR_ID (NS_OWNER, 2)
+#define ATTR_OWNER_GROUP                MAKE_ATTR_ID (NS_OWNER, 3)
+
+static const struct {
+  const char *name;
+  guint32 id;
+} known_attributes[] = {
+  { G_FILE_ATTRIBUTE_STANDARD_TYPE, ATTR_STANDARD_TYPE },
+  { G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN, ATTR_STANDARD_IS_HIDDEN },
+  { G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP, ATTR_STANDARD_IS_BACKUP },
+  { G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK, ATTR_STANDARD_IS_SYMLINK },
+  { G_FILE_ATTRIBUTE_STANDARD_IS_VIRTUAL, ATTR_STANDARD_IS_VIRTUAL },
+  { G_FILE_ATTRIBUTE_STANDARD_NAME, ATTR_STANDARD_NAME },
+  { G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME, ATTR_STANDARD_DISPLAY_NAME },
+  { G_FILE_ATTRIBUTE_STANDARD_EDIT_NAME, ATTR_STANDARD_EDIT_NAME },
+  { G_FILE_ATTRIBUTE_STANDARD_COPY_NAME, ATTR_STANDARD_COPY_NAME },
+  { G_FILE_ATTRIBUTE_STANDARD_DESCRIPTION, ATTR_STANDARD_DESCRIPTION },
+  { G_FILE_ATTRIBUTE_STANDARD_ICON, ATTR_STANDARD_ICON },
+  { G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE, ATTR_STANDARD_CONTENT_TYPE },
+  { G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE, ATTR_STANDARD_FAST_CONTENT_TYPE },
+  { G_FILE_ATTRIBUTE_STANDARD_SIZE, ATTR_STANDARD_SIZE },
+  { G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET, ATTR_STANDARD_SYMLINK_TARGET },
+  { G_FILE_ATTRIBUTE_STANDARD_TARGET_URI, ATTR_STANDARD_TARGET_URI },
+  { G_FILE_ATTRIBUTE_STANDARD_SORT_ORDER, ATTR_STANDARD_SORT_ORDER },
+  { G_FILE_ATTRIBUTE_ETAG_VALUE, ATTR_ETAG_VALUE },
+  { G_FILE_ATTRIBUTE_ID_FILE, ATTR_ID_FILE },
+  { G_FILE_ATTRIBUTE_ID_FILESYSTEM, ATTR_ID_FILESYSTEM },
+  { G_FILE_ATTRIBUTE_ACCESS_CAN_READ, ATTR_ACCESS_CAN_READ },
+  { G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE, ATTR_ACCESS_CAN_WRITE },
+  { G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE, ATTR_ACCESS_CAN_EXECUTE },
+  { G_FILE_ATTRIBUTE_ACCESS_CAN_DELETE, ATTR_ACCESS_CAN_DELETE },
+  { G_FILE_ATTRIBUTE_ACCESS_CAN_TRASH, ATTR_ACCESS_CAN_TRASH },
+  { G_FILE_ATTRIBUTE_ACCESS_CAN_RENAME, ATTR_ACCESS_CAN_RENAME },
+  { G_FILE_ATTRIBUTE_TIME_MODIFIED, ATTR_TIME_MODIFIED },
+  { G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC, ATTR_TIME_MODIFIED_USEC },
+  { G_FILE_ATTRIBUTE_TIME_ACCESS, ATTR_TIME_ACCESS },
+  { G_FILE_ATTRIBUTE_TIME_ACCESS_USEC, ATTR_TIME_ACCESS_USEC },
+  { G_FILE_ATTRIBUTE_TIME_CHANGED, ATTR_TIME_CHANGED },
+  { G_FILE_ATTRIBUTE_TIME_CHANGED_USEC, ATTR_TIME_CHANGED_USEC },
+  { G_FILE_ATTRIBUTE_TIME_CREATED, ATTR_TIME_CREATED },
+  { G_FILE_ATTRIBUTE_TIME_CREATED_USEC, ATTR_TIME_CREATED_USEC },
+  { G_FILE_ATTRIBUTE_UNIX_DEVICE, ATTR_UNIX_DEVICE },
+  { G_FILE_ATTRIBUTE_UNIX_INODE, ATTR_UNIX_INODE },
+  { G_FILE_ATTRIBUTE_UNIX_MODE, ATTR_UNIX_MODE },
+  { G_FILE_ATTRIBUTE_UNIX_NLINK, ATTR_UNIX_NLINK },
+  { G_FILE_ATTRIBUTE_UNIX_UID, ATTR_UNIX_UID },
+  { G_FILE_ATTRIBUTE_UNIX_GID, ATTR_UNIX_GID },
+  { G_FILE_ATTRIBUTE_UNIX_RDEV, ATTR_UNIX_RDEV },
+  { G_FILE_ATTRIBUTE_UNIX_BLOCK_SIZE, ATTR_UNIX_BLOCK_SIZE },
+  { G_FILE_ATTRIBUTE_UNIX_BLOCKS, ATTR_UNIX_BLOCKS },
+  { G_FILE_ATTRIBUTE_UNIX_IS_MOUNTPOINT, ATTR_UNIX_IS_MOUNTPOINT },
+  { G_FILE_ATTRIBUTE_OWNER_USER, ATTR_OWNER_USER },
+  { G_FILE_ATTRIBUTE_OWNER_USER_REAL, ATTR_OWNER_USER_REAL },
+  { G_FILE_ATTRIBUTE_OWNER_GROUP, ATTR_OWNER_GROUP },
+};
+
+static gpointer known_hash = NULL;
+
 static NSInfo *
 _lookup_namespace (const char *namespace)
 {
@@ -140,6 +257,69 @@ _lookup_namespace (const char *namespace)
   return ns_info;
 }
 
+static guint32
+_lookup_attribute (const char *attribute)
+{
+  guint32 attr_id, id;
+  char *ns;
+  const char *colon;
+  NSInfo *ns_info;
+
+  attr_id = GPOINTER_TO_UINT (g_hash_table_lookup (attribute_hash, attribute));
+
+  if (attr_id != 0)
+    return attr_id;
+
+  colon = strstr (attribute, "::");
+  if (colon)
+    ns = g_strndup (attribute, colon - attribute);
+  else
+    ns = g_strdup ("");
+
+  ns_info = _lookup_namespace (ns);
+  g_free (ns);
+
+  id = ++ns_info->attribute_id_counter;
+  attributes[ns_info->id] = g_realloc (attributes[ns_info->id], (id + 1) * sizeof (char *));
+  attributes[ns_info->id][id] = g_strdup (attribute);
+  
+  attr_id = MAKE_ATTR_ID (ns_info->id, id);
+
+  g_hash_table_insert (attribute_hash, attributes[ns_info->id][id], GUINT_TO_POINTER (attr_id));
+
+  return attr_id;
+}
+
+/* Must be called with the attribute_hash lock held */
+static void
+ensure_attribute_hash (void)
+{
+  GHashTable *hash;
+  int i;
+
+  if (attribute_hash != NULL)
+    return;
+
+  ns_hash = g_hash_table_new (g_str_hash, g_str_equal);
+  attribute_hash = g_hash_table_new (g_str_hash, g_str_equal);
+
+  hash = g_hash_table_new (g_str_hash, g_str_equal);
+  for (i = 0; i < G_N_ELEMENTS (known_attributes); i++)
+    {
+      guint32 attr_id;
+
+      attr_id = _lookup_attribute (known_attributes[i].name);
+      g_assert (attr_id == known_attributes[i].id);
+      g_hash_table_insert (hash, (char *)known_attributes[i].name,
+			   GUINT_TO_POINTER (attr_id));
+    }
+
+  /* The known hash is never changed after this, so it can be read
+   * without the lock once it is set.
+   */
+  g_atomic_pointer_set (&known_hash, hash);
+}
+
 static guint32
 lookup_namespace (const char *namespace)
 {
@@ -148,11 +328,7 @@ lookup_namespace (const char *namespace)
   
   G_LOCK (attribute_hash);
   
-  if (attribute_hash == NULL)
-    {
-      ns_hash = g_hash_table_new (g_str_hash, g_str_equal);
-      attribute_hash = g_hash_table_new (g_str_hash, g_str_equal);
-    }
+  ensure_attribute_hash ();
 
   ns_info = _lookup_namespace (namespace);
   id = 0;
@@ -177,43 +353,20 @@ get_attribute_for_id (int attribute)
 static guint32
 lookup_attribute (const char *attribute)
 {
-  guint32 attr_id, id;
-  char *ns;
-  const char *colon;
-  NSInfo *ns_info;
-  
-  G_LOCK (attribute_hash);
-  if (attribute_hash == NULL)
-    {
-      ns_hash = g_hash_table_new (g_str_hash, g_str_equal);
-      attribute_hash = g_hash_table_new (g_str_hash, g_str_equal);
-    }
-
-  attr_id = GPOINTER_TO_UINT (g_hash_table_lookup (attribute_hash, attribute));
+  GHashTable *hash;
+  guint32 attr_id;
 
-  if (attr_id != 0)
+  hash = g_atomic_pointer_get (&known_hash);
+  if (hash != NULL)
     {
-      G_UNLOCK (attribute_hash);
-      return attr_id;
+      attr_id = GPOINTER_TO_UINT (g_hash_table_lookup (hash, attribute));
+      if (attr_id != 0)
+	return attr_id;
     }
 
-  colon = strstr (attribute, "::");
-  if (colon)
-    ns = g_strndup (attribute, colon - attribute);
-  else
-    ns = g_strdup ("");
-
-  ns_info = _lookup_namespace (ns);
-  g_free (ns);
-
-  id = ++ns_info->attribute_id_counter;
-  attributes[ns_info->id] = g_realloc (attributes[ns_info->id], (id + 1) * sizeof (char *));
-  attributes[ns_info->id][id] = g_strdup (attribute);
-  
-  attr_id = MAKE_ATTR_ID (ns_info->id, id);
-
-  g_hash_table_insert (attribute_hash, attributes[ns_info->id][id], GUINT_TO_POINTER (attr_id));
-  
+  G_LOCK (attribute_hash);
+  ensure_attribute_hash ();
+  attr_id = _lookup_attribute (attribute);
   G_UNLOCK (attribute_hash);
   
   return attr_id;
@@ -245,6 +398,11 @@ g_file_info_class_init (GFileInfoClass *klass)
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   
   gobject_class->finalize = g_file_info_finalize;
+
+  /* Intern the known attributes, which the accessors rely on */
+  G_LOCK (attribute_hash);
+  ensure_attribute_hash ();
+  G_UNLOCK (attribute_hash);
 }
 
 static void
@@ -350,6 +508,18 @@ g_file_info_set_attribute_mask (GFileInfo             *info,
 	g_file_attribute_matcher_unref (info->mask);
       info->mask = g_file_attribute_matcher_ref (mask);
 
+      /* Masks are mostly set on new infos, before any attribute.
+       * Allocate room for all the attributes the mask lets in at
+       * once, instead of growing the array as they are set.
+       */
+      if (info->attributes->len == 0)
+	{
+	  g_array_free (info->attributes, TRUE);
+	  info->attributes = g_array_sized_new (FALSE, FALSE,
+						sizeof (GFileAttribute),
+						matcher_size_hint (mask));
+	}
+
       /* Remove non-matching attributes */
       for (i = 0; i < info->attributes->len; i++)
 	{
@@ -1142,15 +1312,11 @@ g_file_info_set_attribute_int64  (GFileInfo  *info,
 GFileType
 g_file_info_get_file_type (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
 
   g_return_val_if_fail (G_IS_FILE_INFO (info), G_FILE_TYPE_UNKNOWN);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_TYPE);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_TYPE);
   return (GFileType)_g_file_attribute_value_get_uint32 (value);
 }
 
@@ -1165,15 +1331,11 @@ g_file_info_get_file_type (GFileInfo *info)
 gboolean
 g_file_info_get_is_hidden (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_IS_HIDDEN);
   return (GFileType)_g_file_attribute_value_get_boolean (value);
 }
 
@@ -1188,15 +1350,11 @@ g_file_info_get_is_hidden (GFileInfo *info)
 gboolean
 g_file_info_get_is_backup (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_IS_BACKUP);
   return (GFileType)_g_file_attribute_value_get_boolean (value);
 }
 
@@ -1211,15 +1369,11 @@ g_file_info_get_is_backup (GFileInfo *info)
 gboolean
 g_file_info_get_is_symlink (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), FALSE);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_IS_SYMLINK);
   return (GFileType)_g_file_attribute_value_get_boolean (value);
 }
 
@@ -1234,15 +1388,11 @@ g_file_info_get_is_symlink (GFileInfo *info)
 const char *
 g_file_info_get_name (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_NAME);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_NAME);
   return _g_file_attribute_value_get_byte_string (value);
 }
 
@@ -1257,15 +1407,11 @@ g_file_info_get_name (GFileInfo *info)
 const char *
 g_file_info_get_display_name (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_DISPLAY_NAME);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1280,15 +1426,11 @@ g_file_info_get_display_name (GFileInfo *info)
 const char *
 g_file_info_get_edit_name (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_EDIT_NAME);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_EDIT_NAME);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1303,16 +1445,12 @@ g_file_info_get_edit_name (GFileInfo *info)
 GIcon *
 g_file_info_get_icon (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   GObject *obj;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_ICON);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_ICON);
   obj = _g_file_attribute_value_get_object (value);
   if (G_IS_ICON (obj))
     return G_ICON (obj);
@@ -1330,15 +1468,11 @@ g_file_info_get_icon (GFileInfo *info)
 const char *
 g_file_info_get_content_type (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_CONTENT_TYPE);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1353,15 +1487,11 @@ g_file_info_get_content_type (GFileInfo *info)
 goffset
 g_file_info_get_size (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
  
   g_return_val_if_fail (G_IS_FILE_INFO (info), (goffset) 0);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SIZE);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_SIZE);
   return (goffset) _g_file_attribute_value_get_uint64 (value);
 }
 
@@ -1377,21 +1507,14 @@ void
 g_file_info_get_modification_time (GFileInfo *info,
 				   GTimeVal  *result)
 {
-  static guint32 attr_mtime = 0, attr_mtime_usec;
   GFileAttributeValue *value;
 
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (result != NULL);
   
-  if (attr_mtime == 0)
-    {
-      attr_mtime = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED);
-      attr_mtime_usec = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
-    }
-  
-  value = g_file_info_find_value (info, attr_mtime);
+  value = g_file_info_find_value (info, ATTR_TIME_MODIFIED);
   result->tv_sec = _g_file_attribute_value_get_uint64 (value);
-  value = g_file_info_find_value (info, attr_mtime_usec);
+  value = g_file_info_find_value (info, ATTR_TIME_MODIFIED_USEC);
   result->tv_usec = _g_file_attribute_value_get_uint32 (value);
 }
 
@@ -1406,15 +1529,11 @@ g_file_info_get_modification_time (GFileInfo *info,
 const char *
 g_file_info_get_symlink_target (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_SYMLINK_TARGET);
   return _g_file_attribute_value_get_byte_string (value);
 }
 
@@ -1430,15 +1549,11 @@ g_file_info_get_symlink_target (GFileInfo *info)
 const char *
 g_file_info_get_etag (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_ETAG_VALUE);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_ETAG_VALUE);
   return _g_file_attribute_value_get_string (value);
 }
 
@@ -1454,15 +1569,11 @@ g_file_info_get_etag (GFileInfo *info)
 gint32
 g_file_info_get_sort_order (GFileInfo *info)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_val_if_fail (G_IS_FILE_INFO (info), 0);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SORT_ORDER);
-  
-  value = g_file_info_find_value (info, attr);
+  value = g_file_info_find_value (info, ATTR_STANDARD_SORT_ORDER);
   return _g_file_attribute_value_get_int32 (value);
 }
 
@@ -1479,15 +1590,11 @@ void
 g_file_info_set_file_type (GFileInfo *info,
 			   GFileType  type)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_TYPE);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_TYPE);
   if (value)
     _g_file_attribute_value_set_uint32 (value, type);
 }
@@ -1504,15 +1611,11 @@ void
 g_file_info_set_is_hidden (GFileInfo *info,
 			   gboolean   is_hidden)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_IS_HIDDEN);
   if (value)
     _g_file_attribute_value_set_boolean (value, is_hidden);
 }
@@ -1529,15 +1632,11 @@ void
 g_file_info_set_is_symlink (GFileInfo *info,
 			    gboolean   is_symlink)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_IS_SYMLINK);
   if (value)
     _g_file_attribute_value_set_boolean (value, is_symlink);
 }
@@ -1554,16 +1653,12 @@ void
 g_file_info_set_name (GFileInfo  *info,
 		      const char *name)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (name != NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_NAME);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_NAME);
   if (value)
     _g_file_attribute_value_set_byte_string (value, name);
 }
@@ -1580,16 +1675,12 @@ void
 g_file_info_set_display_name (GFileInfo  *info,
 			      const char *display_name)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (display_name != NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_DISPLAY_NAME);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_DISPLAY_NAME);
   if (value)
     _g_file_attribute_value_set_string (value, display_name);
 }
@@ -1606,16 +1697,12 @@ void
 g_file_info_set_edit_name (GFileInfo  *info,
 			   const char *edit_name)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (edit_name != NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_EDIT_NAME);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_EDIT_NAME);
   if (value)
     _g_file_attribute_value_set_string (value, edit_name);
 }
@@ -1632,16 +1719,12 @@ void
 g_file_info_set_icon (GFileInfo *info,
 		      GIcon     *icon)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (G_IS_ICON (icon));
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_ICON);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_ICON);
   if (value)
     _g_file_attribute_value_set_object (value, G_OBJECT (icon));
 }
@@ -1658,16 +1741,12 @@ void
 g_file_info_set_content_type (GFileInfo  *info,
 			      const char *content_type)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (content_type != NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_CONTENT_TYPE);
   if (value)
     _g_file_attribute_value_set_string (value, content_type);
 }
@@ -1684,15 +1763,11 @@ void
 g_file_info_set_size (GFileInfo *info,
 		      goffset    size)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SIZE);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_SIZE);
   if (value)
     _g_file_attribute_value_set_uint64 (value, size);
 }
@@ -1709,22 +1784,15 @@ void
 g_file_info_set_modification_time (GFileInfo *info,
 				   GTimeVal  *mtime)
 {
-  static guint32 attr_mtime = 0, attr_mtime_usec;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (mtime != NULL);
   
-  if (attr_mtime == 0)
-    {
-      attr_mtime = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED);
-      attr_mtime_usec = lookup_attribute (G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
-    }
-  
-  value = g_file_info_create_value (info, attr_mtime);
+  value = g_file_info_create_value (info, ATTR_TIME_MODIFIED);
   if (value)
     _g_file_attribute_value_set_uint64 (value, mtime->tv_sec);
-  value = g_file_info_create_value (info, attr_mtime_usec);
+  value = g_file_info_create_value (info, ATTR_TIME_MODIFIED_USEC);
   if (value)
     _g_file_attribute_value_set_uint32 (value, mtime->tv_usec);
 }
@@ -1741,16 +1809,12 @@ void
 g_file_info_set_symlink_target (GFileInfo  *info,
 				const char *symlink_target)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   g_return_if_fail (symlink_target != NULL);
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SYMLINK_TARGET);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_SYMLINK_TARGET);
   if (value)
     _g_file_attribute_value_set_byte_string (value, symlink_target);
 }
@@ -1767,15 +1831,11 @@ void
 g_file_info_set_sort_order (GFileInfo *info,
 			    gint32     sort_order)
 {
-  static guint32 attr = 0;
   GFileAttributeValue *value;
   
   g_return_if_fail (G_IS_FILE_INFO (info));
   
-  if (attr == 0)
-    attr = lookup_attribute (G_FILE_ATTRIBUTE_STANDARD_SORT_ORDER);
-  
-  value = g_file_info_create_value (info, attr);
+  value = g_file_info_create_value (info, ATTR_STANDARD_SORT_ORDER);
   if (value)
     _g_file_attribute_value_set_int32 (value, sort_order);
 }
@@ -1799,6 +1859,34 @@ struct _GFileAttributeMatcher {
   int ref;
 };
 
+/* A guess of how many attributes of a file a matcher lets in */
+static guint
+matcher_size_hint (GFileAttributeMatcher *matcher)
+{
+  SubMatcher *sub_matchers;
+  guint size;
+  int i;
+
+  if (matcher == NULL)
+    return 0;
+
+  if (matcher->all)
+    return 32;
+
+  size = 0;
+  for (i = 0; i < ON_STACK_MATCHERS && matcher->sub_matchers[i].id != 0; i++)
+    size += matcher->sub_matchers[i].mask == 0xffffffff ? 1 : 8;
+
+  if (matcher->more_sub_matchers)
+    {
+      sub_matchers = (SubMatcher *)matcher->more_sub_matchers->data;
+      for (i = 0; i < matcher->more_sub_matchers->len; i++)
+	size += sub_matchers[i].mask == 0xffffffff ? 1 : 8;
+    }
+
+  return size;
+}
+
 static void
 matcher_add (GFileAttributeMatcher *matcher,
 	     guint                  id,
@@ -2001,6 +2089,64 @@ g_file_attribute_matcher_matches_only (GFileAttributeMatcher *matcher,
   return FALSE;
 }
 
+static gboolean
+sub_matcher_in_list (SubMatcher         *sub_matcher,
+		     const char * const *attributes)
+{
+  int i;
+
+  /* A namespace match may cover attributes outside the list */
+  if (sub_matcher->mask != 0xffffffff)
+    return FALSE;
+
+  for (i = 0; attributes[i] != NULL; i++)
+    {
+      if (sub_matcher->id == lookup_attribute (attributes[i]))
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+/* Checks that the matcher matches none but (some of) the given
+ * attributes, so that the caller can skip work needed only for
+ * other attributes. A %NULL matcher matches nothing at all.
+ */
+gboolean
+_g_file_attribute_matcher_matches_only_set (GFileAttributeMatcher *matcher,
+					    const char * const    *attributes)
+{
+  SubMatcher *sub_matchers;
+  int i;
+
+  if (matcher == NULL)
+    return TRUE;
+
+  if (matcher->all)
+    return FALSE;
+
+  for (i = 0; i < ON_STACK_MATCHERS; i++)
+    {
+      if (matcher->sub_matchers[i].id == 0)
+	return TRUE;
+
+      if (!sub_matcher_in_list (&matcher->sub_matchers[i], attributes))
+	return FALSE;
+    }
+
+  if (matcher->more_sub_matchers)
+    {
+      sub_matchers = (SubMatcher *)matcher->more_sub_matchers->data;
+      for (i = 0; i < matcher->more_sub_matchers->len; i++)
+	{
+	  if (!sub_matcher_in_list (&sub_matchers[i], attributes))
+	    return FALSE;
+	}
+    }
+
+  return TRUE;
+}
+
 static gboolean
 matcher_matches_id (GFileAttributeMatcher *matcher,
                     guint32                id)
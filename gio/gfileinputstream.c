@@ -267,6 +267,50 @@ g_file_input_stream_query_info_finish (GFileInputStream  *stream,
   return class->query_info_finish (stream, result, error);
 }
 
+/**
+ * g_file_input_stream_borrow:
+ * @stream: a #GFileInputStream.
+ * @count: the number of bytes wanted.
+ * @available: location to store the number of bytes returned, or %NULL.
+ *
+ * Gets up to @count bytes at the current position of @stream without
+ * copying them, if @stream reads from a memory mapping of the file,
+ * like the streams returned by g_file_read_mapped() do. Fewer bytes
+ * are returned near the end of the file.
+ *
+ * The position of @stream does not change; use g_input_stream_skip()
+ * to move past the bytes. They stay valid until @stream is closed, and
+ * must not be modified.
+ *
+ * Returns: read-only bytes, or %NULL if @stream is not mapped, is
+ *     closed or has an outstanding operation.
+ *
+ * Since: 2.20
+ **/
+const void *
+g_file_input_stream_borrow (GFileInputStream *stream,
+			    gsize             count,
+			    gsize            *available)
+{
+  GFileInputStreamClass *class;
+  GInputStream *input_stream;
+
+  g_return_val_if_fail (G_IS_FILE_INPUT_STREAM (stream), NULL);
+
+  if (available)
+    *available = 0;
+
+  class = G_FILE_INPUT_STREAM_GET_CLASS (stream);
+  input_stream = G_INPUT_STREAM (stream);
+
+  if (class->borrow == NULL ||
+      g_input_stream_is_closed (input_stream) ||
+      g_input_stream_has_pending (input_stream))
+    return NULL;
+
+  return class->borrow (stream, count, available);
+}
+
 static goffset
 g_file_input_stream_tell (GFileInputStream *stream)
 {
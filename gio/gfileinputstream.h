@@ -81,10 +81,12 @@ struct _GFileInputStreamClass
   GFileInfo * (* query_info_finish) (GFileInputStream     *stream,
                                      GAsyncResult         *res,
                                      GError              **error);
+  const void *(* borrow)            (GFileInputStream     *stream,
+                                     gsize                 count,
+                                     gsize                *available);
 
   /*< private >*/
   /* Padding for future expansion */
-  void (*_g_reserved1) (void);
   void (*_g_reserved2) (void);
   void (*_g_reserved3) (void);
   void (*_g_reserved4) (void);
@@ -106,6 +108,9 @@ void       g_file_input_stream_query_info_async  (GFileInputStream     *stream,
 GFileInfo *g_file_input_stream_query_info_finish (GFileInputStream     *stream,
 						  GAsyncResult         *result,
 						  GError              **error);
+const void *g_file_input_stream_borrow           (GFileInputStream     *stream,
+						  gsize                 count,
+						  gsize                *available);
 
 G_END_DECLS
 
@@ -45,12 +45,19 @@
  *
  * To get informed about changes to the file or directory you
  * are monitoring, connect to the #GFileMonitor::changed signal.
+ *
+ * Monitors that see many changes at once, for instance while a large
+ * archive is unpacked, can be switched to batched delivery with
+ * g_file_monitor_set_batch_window(). The changes are then collected
+ * for a while, repeated changes to the same file are folded together,
+ * and the whole batch is delivered by one #GFileMonitor::changes signal.
  **/
 
 G_LOCK_DEFINE_STATIC(cancelled);
 
 enum {
   CHANGED,
+  CHANGES,
   LAST_SIGNAL
 };
 
@@ -75,12 +82,22 @@ struct _GFileMonitorPrivate {
 
   GSource *timeout;
   guint32 timeout_fires_at;
+
+  /* Batched delivery */
+  int batch_window_msec;
+  GArray *batch;
+  GHashTable *batch_last; /* GFile -> index + 1 of its last change in batch */
+  GSource *batch_timeout;
+
+  guint n_coalesced;
+  guint n_dropped;
 };
 
 enum {
   PROP_0,
   PROP_RATE_LIMIT,
-  PROP_CANCELLED
+  PROP_CANCELLED,
+  PROP_BATCH_WINDOW
 };
 
 static void
@@ -99,6 +116,10 @@ g_file_monitor_set_property (GObject      *object,
       g_file_monitor_set_rate_limit (monitor, g_value_get_int (value));
       break;
 
+    case PROP_BATCH_WINDOW:
+      g_file_monitor_set_batch_window (monitor, g_value_get_int (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -129,6 +150,10 @@ g_file_monitor_get_property (GObject    *object,
       G_UNLOCK (cancelled);
       break;
 
+    case PROP_BATCH_WINDOW:
+      g_value_set_int (value, priv->batch_window_msec);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -138,6 +163,9 @@ g_file_monitor_get_property (GObject    *object,
 #define DEFAULT_RATE_LIMIT_MSECS 800
 #define DEFAULT_VIRTUAL_CHANGES_DONE_DELAY_SECS 2
 
+/* A batch this large is delivered without waiting for the window to end */
+#define MAX_BATCH_SIZE 4096
+
 static guint signals[LAST_SIGNAL] = { 0 };
 
 static void
@@ -147,6 +175,23 @@ rate_limiter_free (RateLimiter *limiter)
   g_slice_free (RateLimiter, limiter);
 }
 
+static void
+free_changes (GArray *changes)
+{
+  GFileMonitorChange *change;
+  guint i;
+
+  for (i = 0; i < changes->len; i++)
+    {
+      change = &g_array_index (changes, GFileMonitorChange, i);
+      g_object_unref (change->file);
+      if (change->other_file)
+	g_object_unref (change->other_file);
+    }
+
+  g_array_free (changes, TRUE);
+}
+
 static void
 g_file_monitor_finalize (GObject *object)
 {
@@ -162,6 +207,15 @@ g_file_monitor_finalize (GObject *object)
 
   g_hash_table_destroy (monitor->priv->rate_limiter);
 
+  if (monitor->priv->batch_timeout)
+    {
+      g_source_destroy (monitor->priv->batch_timeout);
+      g_source_unref (monitor->priv->batch_timeout);
+    }
+
+  free_changes (monitor->priv->batch);
+  g_hash_table_destroy (monitor->priv->batch_last);
+
   G_OBJECT_CLASS (g_file_monitor_parent_class)->finalize (object);
 }
 
@@ -210,6 +264,32 @@ g_file_monitor_class_init (GFileMonitorClass *klass)
 		  G_TYPE_NONE, 3,
 		  G_TYPE_FILE, G_TYPE_FILE, G_TYPE_FILE_MONITOR_EVENT);
 
+  /**
+   * GFileMonitor::changes:
+   * @monitor: a #GFileMonitor.
+   * @changes: an array of #GFileMonitorChange<!-- -->s.
+   * @n_changes: the number of elements in @changes.
+   *
+   * Emitted with all the changes collected during one batch window,
+   * in the order they happened, when batched delivery is enabled with
+   * g_file_monitor_set_batch_window(). Repeated events of the same type
+   * for a file are delivered only once.
+   *
+   * The #GFileMonitor::changed signal is still emitted for each change
+   * if it has handlers connected.
+   *
+   * Since: 2.20
+   **/
+  signals[CHANGES] =
+    g_signal_new (I_("changes"),
+		  G_TYPE_FILE_MONITOR,
+		  G_SIGNAL_RUN_LAST,
+		  G_STRUCT_OFFSET (GFileMonitorClass, changes),
+		  NULL, NULL,
+		  _gio_marshal_VOID__POINTER_UINT,
+		  G_TYPE_NONE, 2,
+		  G_TYPE_POINTER, G_TYPE_UINT);
+
   g_object_class_install_property (object_class,
                                    PROP_RATE_LIMIT,
                                    g_param_spec_int ("rate-limit",
@@ -228,6 +308,24 @@ g_file_monitor_class_init (GFileMonitorClass *klass)
                                                          FALSE,
                                                          G_PARAM_READABLE|
                                                          G_PARAM_STATIC_NAME|G_PARAM_STATIC_NICK|G_PARAM_STATIC_BLURB));
+
+  /**
+   * GFileMonitor:batch-window:
+   *
+   * The time in milliseconds for which changes are collected before
+   * they are delivered together, or 0 to deliver each change on its own.
+   *
+   * Since: 2.20
+   **/
+  g_object_class_install_property (object_class,
+                                   PROP_BATCH_WINDOW,
+                                   g_param_spec_int ("batch-window",
+                                                     P_("Batch window"),
+                                                     P_("The time for which changes are collected before they are delivered together, in milliseconds"),
+                                                     0, G_MAXINT,
+                                                     0,
+                                                     G_PARAM_READWRITE|
+                                                     G_PARAM_STATIC_NAME|G_PARAM_STATIC_NICK|G_PARAM_STATIC_BLURB));
 }
 
 static void
@@ -239,6 +337,8 @@ g_file_monitor_init (GFileMonitor *monitor)
   monitor->priv->rate_limit_msec = DEFAULT_RATE_LIMIT_MSECS;
   monitor->priv->rate_limiter = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal,
 						       NULL, (GDestroyNotify) rate_limiter_free);
+  monitor->priv->batch = g_array_new (FALSE, FALSE, sizeof (GFileMonitorChange));
+  monitor->priv->batch_last = g_hash_table_new (g_file_hash, (GEqualFunc)g_file_equal);
 }
 
 /**
@@ -320,6 +420,93 @@ g_file_monitor_set_rate_limit (GFileMonitor *monitor,
     }
 }
 
+static void schedule_batch (GFileMonitor *monitor,
+			    int           delay_msecs);
+
+/**
+ * g_file_monitor_set_batch_window:
+ * @monitor: a #GFileMonitor.
+ * @window_msecs: the time in milliseconds for which changes are
+ *     collected, or 0 to turn batched delivery off.
+ *
+ * Turns on batched delivery of changes. The changes seen during
+ * @window_msecs after the first one are delivered together by one
+ * #GFileMonitor::changes signal instead of an idle callback each,
+ * and an event that repeats the last pending event for the same file
+ * is folded into it.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_monitor_set_batch_window (GFileMonitor *monitor,
+				 int           window_msecs)
+{
+  GFileMonitorPrivate *priv;
+
+  g_return_if_fail (G_IS_FILE_MONITOR (monitor));
+  g_return_if_fail (window_msecs >= 0);
+
+  priv = monitor->priv;
+  if (priv->batch_window_msec != window_msecs)
+    {
+      priv->batch_window_msec = window_msecs;
+
+      /* Don't hold on to what was collected under the old window */
+      if (priv->batch->len > 0)
+	schedule_batch (monitor, 0);
+
+      g_object_notify (G_OBJECT (monitor), "batch-window");
+    }
+}
+
+/**
+ * g_file_monitor_get_stats:
+ * @monitor: a #GFileMonitor.
+ * @n_coalesced: return location for the number of coalesced events,
+ *     or %NULL.
+ * @n_dropped: return location for the number of dropped events,
+ *     or %NULL.
+ *
+ * Gets the number of events that @monitor folded into other events,
+ * either by rate limiting or in batched delivery, and the number of
+ * events that the monitor implementation reported as lost with
+ * g_file_monitor_report_dropped().
+ *
+ * Since: 2.20
+ **/
+void
+g_file_monitor_get_stats (GFileMonitor *monitor,
+			  guint        *n_coalesced,
+			  guint        *n_dropped)
+{
+  g_return_if_fail (G_IS_FILE_MONITOR (monitor));
+
+  if (n_coalesced)
+    *n_coalesced = monitor->priv->n_coalesced;
+  if (n_dropped)
+    *n_dropped = monitor->priv->n_dropped;
+}
+
+/**
+ * g_file_monitor_report_dropped:
+ * @monitor: a #GFileMonitor.
+ * @n_dropped: the number of events that were lost.
+ *
+ * Records that events for @monitor were lost, for instance because
+ * the kernel event queue overflowed. Should be called from file
+ * monitor implementations only.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_monitor_report_dropped (GFileMonitor *monitor,
+			       guint         n_dropped)
+{
+  g_return_if_fail (G_IS_FILE_MONITOR (monitor));
+
+  monitor->priv->n_dropped += n_dropped;
+}
+
 typedef struct {
   GFileMonitor      *monitor;
   GFile             *child;
@@ -347,6 +534,109 @@ file_change_free (FileChange *change)
   g_slice_free (FileChange, change);
 }
 
+static gboolean
+emit_batch_cb (gpointer data)
+{
+  GFileMonitor *monitor = data;
+  GFileMonitorPrivate *priv = monitor->priv;
+  GFileMonitorChange *change;
+  GArray *changes;
+  guint i;
+
+  g_source_unref (priv->batch_timeout);
+  priv->batch_timeout = NULL;
+
+  changes = priv->batch;
+  priv->batch = g_array_new (FALSE, FALSE, sizeof (GFileMonitorChange));
+  g_hash_table_remove_all (priv->batch_last);
+
+  g_object_ref (monitor);
+
+  g_signal_emit (monitor, signals[CHANGES], 0,
+		 changes->data, changes->len);
+
+  if (g_signal_has_handler_pending (monitor, signals[CHANGED], 0, FALSE))
+    {
+      for (i = 0; i < changes->len; i++)
+	{
+	  change = &g_array_index (changes, GFileMonitorChange, i);
+	  g_signal_emit (monitor, signals[CHANGED], 0,
+			 change->file, change->other_file, change->event_type);
+	}
+    }
+
+  free_changes (changes);
+  g_object_unref (monitor);
+
+  return FALSE;
+}
+
+static void
+schedule_batch (GFileMonitor *monitor,
+		int           delay_msecs)
+{
+  GFileMonitorPrivate *priv = monitor->priv;
+  GSource *source;
+
+  if (priv->batch_timeout)
+    {
+      if (delay_msecs > 0)
+	return;
+
+      g_source_destroy (priv->batch_timeout);
+      g_source_unref (priv->batch_timeout);
+    }
+
+  if (delay_msecs > 0)
+    source = g_timeout_source_new (delay_msecs);
+  else
+    {
+      source = g_idle_source_new ();
+      g_source_set_priority (source, 0);
+    }
+
+  g_source_set_callback (source, emit_batch_cb, monitor, NULL);
+  g_source_attach (source, NULL);
+  priv->batch_timeout = source;
+}
+
+static void
+add_to_batch (GFileMonitor      *monitor,
+	      GFile             *child,
+	      GFile             *other_file,
+	      GFileMonitorEvent  event_type)
+{
+  GFileMonitorPrivate *priv = monitor->priv;
+  GFileMonitorChange change, *last;
+  guint last_index;
+
+  /* Only an event that repeats the last one for the same file is
+   * dropped, so the order of different events is kept.
+   */
+  last_index = GPOINTER_TO_UINT (g_hash_table_lookup (priv->batch_last, child));
+  if (last_index != 0 && other_file == NULL)
+    {
+      last = &g_array_index (priv->batch, GFileMonitorChange, last_index - 1);
+      if (last->event_type == event_type && last->other_file == NULL)
+	{
+	  priv->n_coalesced++;
+	  return;
+	}
+    }
+
+  change.file = g_object_ref (child);
+  change.other_file = other_file ? g_object_ref (other_file) : NULL;
+  change.event_type = event_type;
+  g_array_append_val (priv->batch, change);
+  g_hash_table_insert (priv->batch_last, change.file,
+		       GUINT_TO_POINTER (priv->batch->len));
+
+  if (priv->batch->len == MAX_BATCH_SIZE)
+    schedule_batch (monitor, 0);
+  else
+    schedule_batch (monitor, priv->batch_window_msec);
+}
+
 static void
 emit_in_idle (GFileMonitor      *monitor,
 	      GFile             *child,
@@ -356,6 +646,12 @@ emit_in_idle (GFileMonitor      *monitor,
   GSource *source;
   FileChange *change;
 
+  if (monitor->priv->batch_window_msec > 0)
+    {
+      add_to_batch (monitor, child, other_file, event_type);
+      return;
+    }
+
   change = g_slice_new (FileChange);
 
   change->monitor = g_object_ref (monitor);
@@ -643,6 +939,8 @@ g_file_monitor_emit_event (GFileMonitor      *monitor,
 		  limiter->send_delayed_change_at = time_now + monitor->priv->rate_limit_msec;
 		  update_rate_limiter_timeout (monitor, limiter->send_delayed_change_at);
 		}
+	      else
+		monitor->priv->n_coalesced++;
 	    }
 	}
       
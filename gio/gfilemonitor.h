@@ -41,6 +41,22 @@ G_BEGIN_DECLS
 typedef struct _GFileMonitorClass       GFileMonitorClass;
 typedef struct _GFileMonitorPrivate	GFileMonitorPrivate;
 
+/**
+ * GFileMonitorChange:
+ * @file: the #GFile that changed.
+ * @other_file: the other #GFile involved in the change, or %NULL.
+ * @event_type: the #GFileMonitorEvent.
+ *
+ * One change delivered by the #GFileMonitor::changes signal.
+ *
+ * Since: 2.20
+ **/
+typedef struct {
+  GFile             *file;
+  GFile             *other_file;
+  GFileMonitorEvent  event_type;
+} GFileMonitorChange;
+
 /**
  * GFileMonitor:
  *
@@ -67,9 +83,13 @@ struct _GFileMonitorClass
   /* Virtual Table */
   gboolean (* cancel)  (GFileMonitor      *monitor);
 
+  /* Signals */
+  void     (* changes) (GFileMonitor             *monitor,
+                        const GFileMonitorChange *changes,
+                        guint                     n_changes);
+
   /*< private >*/
   /* Padding for future expansion */
-  void (*_g_reserved1) (void);
   void (*_g_reserved2) (void);
   void (*_g_reserved3) (void);
   void (*_g_reserved4) (void);
@@ -82,6 +102,11 @@ gboolean g_file_monitor_cancel         (GFileMonitor      *monitor);
 gboolean g_file_monitor_is_cancelled   (GFileMonitor      *monitor);
 void     g_file_monitor_set_rate_limit (GFileMonitor      *monitor,
                                         int                limit_msecs);
+void     g_file_monitor_set_batch_window (GFileMonitor    *monitor,
+                                          int              window_msecs);
+void     g_file_monitor_get_stats      (GFileMonitor      *monitor,
+                                        guint             *n_coalesced,
+                                        guint             *n_dropped);
 
 
 /* For implementations */
@@ -89,6 +114,8 @@ void     g_file_monitor_emit_event     (GFileMonitor      *monitor,
                                         GFile             *child,
                                         GFile             *other_file,
                                         GFileMonitorEvent  event_type);
+void     g_file_monitor_report_dropped (GFileMonitor      *monitor,
+                                        guint              n_dropped);
 
 G_END_DECLS
 
@@ -0,0 +1,768 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include "gfilewalker.h"
+#include "gfileenumerator.h"
+#include "gfileattribute.h"
+#include "gfile.h"
+#include "gfileinfo.h"
+#include "gcancellable.h"
+#include "gioerror.h"
+#include "gioscheduler.h"
+#include "gsimpleasyncresult.h"
+#include "glibintl.h"
+
+#include "gioalias.h"
+
+/**
+ * SECTION:gfilewalker
+ * @short_description: Recursive directory traversal
+ * @include: gio/gio.h
+ * @see_also: #GFileEnumerator
+ *
+ * #GFileWalker enumerates all the files below a directory. Several
+ * directories are enumerated at once, each in an I/O job (see
+ * g_io_scheduler_push_job()), and the files found are handed to the
+ * main loop in batches.
+ *
+ * The number of directories enumerated at once is limited with
+ * g_file_walker_set_max_jobs(), and the depth of the walk with
+ * g_file_walker_set_max_depth(). A filter function set with
+ * g_file_walker_set_filter() can leave files out and keep the walker
+ * from descending into directories.
+ *
+ * By default, the batches arrive in whatever order the directories
+ * are enumerated in. With g_file_walker_set_ordered(), the batches
+ * of a directory arrive before those of its subdirectories, and the
+ * subdirectories follow each other in the order they were found in,
+ * as if the tree was walked depth-first by a single thread.
+ *
+ * Asking only for the attributes that are really needed makes a big
+ * difference here: for local files, a walk that only needs names
+ * and types can do without stat() calls.
+ **/
+
+/* The most files per batch */
+#define BATCH_SIZE 100
+
+#define DEFAULT_MAX_JOBS 8
+
+/* The attributes the walker needs to descend */
+#define WALKER_ATTRIBUTES \
+  G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+  G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK
+
+typedef struct _WalkNode WalkNode;
+
+typedef struct {
+  GFile *directory;
+  GList *infos;
+} Batch;
+
+/* A directory to enumerate. For ordered walks, the nodes form a tree
+ * that is kept until the batches of a node and all its children have
+ * been delivered.
+ */
+struct _WalkNode {
+  GFileWalker *walker;
+  WalkNode *parent;
+  GFile *directory;
+  int depth;
+
+  /* Only used for ordered walks */
+  GQueue batches;
+  GQueue children;
+  gboolean done;
+};
+
+struct _GFileWalker {
+  GObject parent;
+
+  GFile *root;
+  char *attributes;
+  GFileQueryInfoFlags flags;
+  int max_depth;
+  int max_jobs;
+  gboolean ordered;
+
+  GFileWalkerFilterFunc filter;
+  gpointer filter_data;
+  GDestroyNotify filter_notify;
+
+  /* The state of a walk, protected by the lock */
+  GStaticMutex lock;
+  gboolean walking;
+  int io_priority;
+  GCancellable *cancellable;
+  GFileWalkerBatchFunc batch_func;
+  gpointer batch_data;
+  GSimpleAsyncResult *result;
+  GError *error;
+
+  GQueue pending;
+  int n_jobs;
+  int n_dirs;
+
+  GQueue batches;
+  WalkNode *cursor;
+  gboolean dispatch_scheduled;
+};
+
+G_DEFINE_TYPE (GFileWalker, g_file_walker, G_TYPE_OBJECT);
+
+static void
+g_file_walker_finalize (GObject *object)
+{
+  GFileWalker *walker;
+
+  walker = G_FILE_WALKER (object);
+
+  g_object_unref (walker->root);
+  g_free (walker->attributes);
+
+  if (walker->filter_notify)
+    walker->filter_notify (walker->filter_data);
+
+  g_static_mutex_free (&walker->lock);
+
+  G_OBJECT_CLASS (g_file_walker_parent_class)->finalize (object);
+}
+
+static void
+g_file_walker_class_init (GFileWalkerClass *klass)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  gobject_class->finalize = g_file_walker_finalize;
+}
+
+static void
+g_file_walker_init (GFileWalker *walker)
+{
+  walker->max_depth = -1;
+  walker->max_jobs = DEFAULT_MAX_JOBS;
+  g_static_mutex_init (&walker->lock);
+  g_queue_init (&walker->pending);
+  g_queue_init (&walker->batches);
+}
+
+/**
+ * g_file_walker_new:
+ * @root: the directory to walk.
+ * @attributes: an attribute query string, as for
+ *     g_file_enumerate_children().
+ * @flags: a set of #GFileQueryInfoFlags.
+ *
+ * Creates a walker for the tree below @root. The #GFileInfo<!-- -->s
+ * it finds have the attributes in @attributes, and also the name,
+ * the type and whether the file is a symlink, which the walker needs
+ * to descend. Symlinks to directories are not descended into.
+ *
+ * Returns: a new #GFileWalker.
+ *
+ * Since: 2.20
+ **/
+GFileWalker *
+g_file_walker_new (GFile               *root,
+		   const char          *attributes,
+		   GFileQueryInfoFlags  flags)
+{
+  GFileWalker *walker;
+
+  g_return_val_if_fail (G_IS_FILE (root), NULL);
+
+  walker = g_object_new (G_TYPE_FILE_WALKER, NULL);
+  walker->root = g_object_ref (root);
+  walker->flags = flags;
+
+  if (attributes != NULL && *attributes != '\0')
+    walker->attributes = g_strconcat (attributes, ",", WALKER_ATTRIBUTES, NULL);
+  else
+    walker->attributes = g_strdup (WALKER_ATTRIBUTES);
+
+  return walker;
+}
+
+/**
+ * g_file_walker_set_max_depth:
+ * @walker: a #GFileWalker.
+ * @max_depth: the number of levels of subdirectories to descend
+ *     into, or -1 for no limit.
+ *
+ * Limits the depth of the walk. With a @max_depth of 0, only the
+ * files in the root directory are found.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_walker_set_max_depth (GFileWalker *walker,
+			     int          max_depth)
+{
+  g_return_if_fail (G_IS_FILE_WALKER (walker));
+  g_return_if_fail (!walker->walking);
+
+  walker->max_depth = max_depth;
+}
+
+/**
+ * g_file_walker_set_max_jobs:
+ * @walker: a #GFileWalker.
+ * @max_jobs: the number of directories to enumerate at once.
+ *
+ * Sets how many directories the walker enumerates at once. More
+ * jobs help with slow disks and network file systems, as long as
+ * the I/O scheduler has threads to run them.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_walker_set_max_jobs (GFileWalker *walker,
+			    int          max_jobs)
+{
+  g_return_if_fail (G_IS_FILE_WALKER (walker));
+  g_return_if_fail (max_jobs > 0);
+  g_return_if_fail (!walker->walking);
+
+  walker->max_jobs = max_jobs;
+}
+
+/**
+ * g_file_walker_set_ordered:
+ * @walker: a #GFileWalker.
+ * @ordered: whether to deliver the batches in order.
+ *
+ * Sets whether the batches are delivered in the order of a
+ * depth-first walk, or as soon as they are found. Ordered walks
+ * hold back batches from directories that are not next in turn.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_walker_set_ordered (GFileWalker *walker,
+			   gboolean     ordered)
+{
+  g_return_if_fail (G_IS_FILE_WALKER (walker));
+  g_return_if_fail (!walker->walking);
+
+  walker->ordered = ordered;
+}
+
+/**
+ * g_file_walker_set_filter:
+ * @walker: a #GFileWalker.
+ * @filter: a #GFileWalkerFilterFunc, or %NULL.
+ * @user_data: data to pass to @filter.
+ * @notify: a #GDestroyNotify for @user_data, or %NULL.
+ *
+ * Sets a function that decides which files are kept. The walker
+ * does not descend into directories that the filter leaves out.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_walker_set_filter (GFileWalker           *walker,
+			  GFileWalkerFilterFunc  filter,
+			  gpointer               user_data,
+			  GDestroyNotify         notify)
+{
+  g_return_if_fail (G_IS_FILE_WALKER (walker));
+  g_return_if_fail (!walker->walking);
+
+  if (walker->filter_notify)
+    walker->filter_notify (walker->filter_data);
+
+  walker->filter = filter;
+  walker->filter_data = user_data;
+  walker->filter_notify = notify;
+}
+
+static WalkNode *
+walk_node_new (GFileWalker *walker,
+	       WalkNode    *parent,
+	       GFile       *directory,
+	       int          depth)
+{
+  WalkNode *node;
+
+  node = g_new0 (WalkNode, 1);
+  node->walker = walker;
+  node->parent = parent;
+  node->directory = directory;
+  node->depth = depth;
+  g_queue_init (&node->batches);
+  g_queue_init (&node->children);
+
+  return node;
+}
+
+static void
+batch_free (Batch *batch)
+{
+  g_object_unref (batch->directory);
+  g_list_foreach (batch->infos, (GFunc)g_object_unref, NULL);
+  g_list_free (batch->infos);
+  g_free (batch);
+}
+
+static void
+walk_node_free (WalkNode *node)
+{
+  g_queue_foreach (&node->batches, (GFunc)batch_free, NULL);
+  g_queue_clear (&node->batches);
+  g_queue_clear (&node->children);
+  g_object_unref (node->directory);
+  g_free (node);
+}
+
+static gboolean dispatch_batches (gpointer user_data);
+
+static void
+schedule_dispatch_locked (GFileWalker *walker)
+{
+  if (walker->dispatch_scheduled)
+    return;
+
+  walker->dispatch_scheduled = TRUE;
+  g_idle_add_full (G_PRIORITY_DEFAULT, dispatch_batches,
+		   g_object_ref (walker), g_object_unref);
+}
+
+static gboolean walk_job (GIOSchedulerJob *job,
+			  GCancellable    *cancellable,
+			  gpointer         user_data);
+
+static void
+start_jobs_locked (GFileWalker *walker)
+{
+  WalkNode *node;
+
+  while (walker->n_jobs < walker->max_jobs &&
+	 !g_queue_is_empty (&walker->pending))
+    {
+      node = g_queue_pop_head (&walker->pending);
+      walker->n_jobs++;
+      g_io_scheduler_push_job (walk_job, node, NULL,
+			       walker->io_priority, walker->cancellable);
+    }
+}
+
+/* Puts the subdirectories found in @node first in line, in the order
+ * they were found in. Walking depth-first keeps the pending queue
+ * short, and lets ordered walks deliver their batches early.
+ */
+static void
+add_children_locked (GFileWalker *walker,
+		     WalkNode    *node,
+		     GList       *children)
+{
+  GList *l;
+
+  for (l = g_list_last (children); l != NULL; l = l->prev)
+    {
+      g_queue_push_head (&walker->pending, l->data);
+      walker->n_dirs++;
+    }
+
+  if (walker->ordered)
+    {
+      for (l = children; l != NULL; l = l->next)
+	g_queue_push_tail (&node->children, l->data);
+    }
+
+  start_jobs_locked (walker);
+}
+
+static void
+queue_batch_locked (GFileWalker *walker,
+		    WalkNode    *node,
+		    GList       *infos)
+{
+  Batch *batch;
+
+  batch = g_new (Batch, 1);
+  batch->directory = g_object_ref (node->directory);
+  batch->infos = infos;
+
+  if (walker->ordered)
+    g_queue_push_tail (&node->batches, batch);
+  else
+    g_queue_push_tail (&walker->batches, batch);
+
+  schedule_dispatch_locked (walker);
+}
+
+static gboolean
+should_descend (GFileWalker *walker,
+		WalkNode    *node,
+		GFileInfo   *info)
+{
+  return g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY &&
+    !g_file_info_get_is_symlink (info) &&
+    (walker->max_depth < 0 || node->depth < walker->max_depth);
+}
+
+/* Runs the filter over @infos, and collects the subdirectories to
+ * descend into in @children.
+ */
+static GList *
+filter_infos (GFileWalker  *walker,
+	      WalkNode     *node,
+	      GList        *infos,
+	      GList       **children)
+{
+  GList *l, *next;
+  GFileInfo *info;
+  GFile *child;
+
+  for (l = infos; l != NULL; l = next)
+    {
+      next = l->next;
+      info = l->data;
+
+      if (walker->filter != NULL &&
+	  !walker->filter (node->directory, info, walker->filter_data))
+	{
+	  g_object_unref (info);
+	  infos = g_list_delete_link (infos, l);
+	  continue;
+	}
+
+      if (should_descend (walker, node, info))
+	{
+	  child = g_file_get_child (node->directory, g_file_info_get_name (info));
+	  *children = g_list_prepend (*children,
+				      walk_node_new (walker,
+						     walker->ordered ? node : NULL,
+						     child, node->depth + 1));
+	}
+    }
+
+  *children = g_list_reverse (*children);
+
+  return infos;
+}
+
+/* Reads up to BATCH_SIZE infos, in order. Stops at the first error,
+ * and returns what was read before it; the caller must not read on
+ * once @error is set.
+ */
+static GList *
+next_batch (GFileEnumerator  *enumerator,
+	    GCancellable     *cancellable,
+	    GError          **error)
+{
+  GList *infos;
+  GFileInfo *info;
+  int i;
+
+  infos = NULL;
+  for (i = 0; i < BATCH_SIZE; i++)
+    {
+      info = g_file_enumerator_next_file (enumerator, cancellable, error);
+      if (info == NULL)
+	break;
+      infos = g_list_prepend (infos, info);
+    }
+
+  return g_list_reverse (infos);
+}
+
+static gboolean
+walk_job (GIOSchedulerJob *job,
+	  GCancellable    *cancellable,
+	  gpointer         user_data)
+{
+  WalkNode *node = user_data;
+  GFileWalker *walker = node->walker;
+  GFileEnumerator *enumerator;
+  GList *infos, *children;
+  GError *error;
+
+  error = NULL;
+  enumerator = NULL;
+  if (!g_cancellable_set_error_if_cancelled (cancellable, &error))
+    enumerator = g_file_enumerate_children (node->directory,
+					    walker->attributes,
+					    walker->flags,
+					    cancellable, &error);
+
+  while (enumerator != NULL)
+    {
+      infos = next_batch (enumerator, cancellable, &error);
+      if (infos == NULL)
+	break;
+
+      children = NULL;
+      infos = filter_infos (walker, node, infos, &children);
+
+      g_static_mutex_lock (&walker->lock);
+      if (infos != NULL)
+	queue_batch_locked (walker, node, infos);
+      if (children != NULL)
+	add_children_locked (walker, node, children);
+      g_static_mutex_unlock (&walker->lock);
+
+      g_list_free (children);
+
+      /* The rest of a directory that failed to read is dropped */
+      if (error != NULL)
+	break;
+    }
+
+  if (enumerator != NULL)
+    {
+      g_file_enumerator_close (enumerator, NULL, NULL);
+      g_object_unref (enumerator);
+    }
+
+  g_static_mutex_lock (&walker->lock);
+
+  /* Subdirectories that can't be read are skipped, but if the root
+   * can't be, or the walk is cancelled, the walk fails.
+   */
+  if (error != NULL &&
+      walker->error == NULL &&
+      (node->depth == 0 ||
+       g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED)))
+    walker->error = error;
+  else if (error != NULL)
+    g_error_free (error);
+
+  walker->n_jobs--;
+  walker->n_dirs--;
+
+  if (walker->ordered)
+    node->done = TRUE;
+  else
+    walk_node_free (node);
+
+  start_jobs_locked (walker);
+  schedule_dispatch_locked (walker);
+
+  g_static_mutex_unlock (&walker->lock);
+
+  return FALSE;
+}
+
+static Batch *
+next_batch_locked (GFileWalker *walker)
+{
+  WalkNode *node, *parent;
+
+  if (!walker->ordered)
+    return g_queue_pop_head (&walker->batches);
+
+  while ((node = walker->cursor) != NULL)
+    {
+      if (!g_queue_is_empty (&node->batches))
+	return g_queue_pop_head (&node->batches);
+
+      if (!node->done)
+	return NULL;
+
+      if (!g_queue_is_empty (&node->children))
+	{
+	  walker->cursor = g_queue_pop_head (&node->children);
+	  continue;
+	}
+
+      /* All of the node is delivered, go back up */
+      parent = node->parent;
+      walk_node_free (node);
+      walker->cursor = parent;
+    }
+
+  return NULL;
+}
+
+static gboolean
+dispatch_batches (gpointer user_data)
+{
+  GFileWalker *walker = user_data;
+  GSimpleAsyncResult *result;
+  Batch *batch;
+
+  g_static_mutex_lock (&walker->lock);
+
+  walker->dispatch_scheduled = FALSE;
+
+  while ((batch = next_batch_locked (walker)) != NULL)
+    {
+      g_static_mutex_unlock (&walker->lock);
+
+      if (!g_cancellable_is_cancelled (walker->cancellable))
+	walker->batch_func (walker, batch->directory, batch->infos,
+			    walker->batch_data);
+      batch_free (batch);
+
+      g_static_mutex_lock (&walker->lock);
+    }
+
+  if (!walker->walking ||
+      walker->n_dirs > 0 ||
+      walker->cursor != NULL ||
+      !g_queue_is_empty (&walker->batches))
+    {
+      g_static_mutex_unlock (&walker->lock);
+      return FALSE;
+    }
+
+  /* The walk is over */
+  result = walker->result;
+  walker->result = NULL;
+  walker->walking = FALSE;
+
+  if (walker->error == NULL)
+    g_cancellable_set_error_if_cancelled (walker->cancellable, &walker->error);
+
+  if (walker->error != NULL)
+    {
+      g_simple_async_result_set_from_error (result, walker->error);
+      g_error_free (walker->error);
+      walker->error = NULL;
+    }
+
+  if (walker->cancellable)
+    g_object_unref (walker->cancellable);
+  walker->cancellable = NULL;
+
+  g_static_mutex_unlock (&walker->lock);
+
+  g_simple_async_result_complete (result);
+  g_object_unref (result);
+
+  return FALSE;
+}
+
+/**
+ * g_file_walker_walk_async:
+ * @walker: a #GFileWalker.
+ * @io_priority: the <link linkend="io-priority">I/O priority</link>
+ *     of the enumeration jobs.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @batch_func: a #GFileWalkerBatchFunc to receive the files.
+ * @batch_data: data to pass to @batch_func.
+ * @callback: a #GAsyncReadyCallback to call when the walk is over.
+ * @user_data: the data to pass to @callback.
+ *
+ * Walks the tree below the root of @walker. The files found are
+ * passed to @batch_func in the main loop, in batches of files from
+ * the same directory. When all the files have been delivered,
+ * @callback is called, and it can call g_file_walker_walk_finish()
+ * to find out whether the walk succeeded.
+ *
+ * Subdirectories that can't be enumerated are skipped. If the root
+ * can't be enumerated, the walk fails with the error from
+ * g_file_enumerate_children(). A directory that fails partway through
+ * is treated the same way; the files read before the error are still
+ * delivered, and the rest of the directory is not read.
+ *
+ * If @cancellable is not %NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error %G_IO_ERROR_CANCELLED will be returned, and
+ * no more batches are delivered.
+ *
+ * Only one walk can be done at a time, a second one fails with
+ * %G_IO_ERROR_PENDING.
+ *
+ * Since: 2.20
+ **/
+void
+g_file_walker_walk_async (GFileWalker          *walker,
+			  int                   io_priority,
+			  GCancellable         *cancellable,
+			  GFileWalkerBatchFunc  batch_func,
+			  gpointer              batch_data,
+			  GAsyncReadyCallback   callback,
+			  gpointer              user_data)
+{
+  WalkNode *root;
+
+  g_return_if_fail (G_IS_FILE_WALKER (walker));
+  g_return_if_fail (batch_func != NULL);
+
+  g_static_mutex_lock (&walker->lock);
+
+  if (walker->walking)
+    {
+      g_static_mutex_unlock (&walker->lock);
+      g_simple_async_report_error_in_idle (G_OBJECT (walker),
+					   callback,
+					   user_data,
+					   G_IO_ERROR, G_IO_ERROR_PENDING,
+					   _("Walk already in progress"));
+      return;
+    }
+
+  walker->walking = TRUE;
+  walker->io_priority = io_priority;
+  walker->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+  walker->batch_func = batch_func;
+  walker->batch_data = batch_data;
+  walker->result = g_simple_async_result_new (G_OBJECT (walker),
+					      callback, user_data,
+					      g_file_walker_walk_async);
+
+  root = walk_node_new (walker, NULL, g_object_ref (walker->root), 0);
+  if (walker->ordered)
+    walker->cursor = root;
+  g_queue_push_tail (&walker->pending, root);
+  walker->n_dirs = 1;
+  start_jobs_locked (walker);
+
+  g_static_mutex_unlock (&walker->lock);
+}
+
+/**
+ * g_file_walker_walk_finish:
+ * @walker: a #GFileWalker.
+ * @result: a #GAsyncResult.
+ * @error: a #GError location to store the error occuring, or %NULL to
+ *     ignore.
+ *
+ * Finishes a walk started with g_file_walker_walk_async().
+ *
+ * Returns: %TRUE if the walk succeeded, %FALSE on error.
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_file_walker_walk_finish (GFileWalker   *walker,
+			   GAsyncResult  *result,
+			   GError       **error)
+{
+  GSimpleAsyncResult *simple;
+
+  g_return_val_if_fail (G_IS_FILE_WALKER (walker), FALSE);
+  g_return_val_if_fail (G_IS_SIMPLE_ASYNC_RESULT (result), FALSE);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+  if (g_simple_async_result_propagate_error (simple, error))
+    return FALSE;
+
+  g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == g_file_walker_walk_async);
+
+  return TRUE;
+}
+
+#define __G_FILE_WALKER_C__
+#include "gioaliasdef.c"
@@ -0,0 +1,122 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#if !defined (__GIO_GIO_H_INSIDE__) && !defined (GIO_COMPILATION)
+#error "Only <gio/gio.h> can be included directly."
+#endif
+
+#ifndef __G_FILE_WALKER_H__
+#define __G_FILE_WALKER_H__
+
+#include <gio/giotypes.h>
+
+G_BEGIN_DECLS
+
+#define G_TYPE_FILE_WALKER         (g_file_walker_get_type ())
+#define G_FILE_WALKER(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), G_TYPE_FILE_WALKER, GFileWalker))
+#define G_FILE_WALKER_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), G_TYPE_FILE_WALKER, GFileWalkerClass))
+#define G_FILE_WALKER_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), G_TYPE_FILE_WALKER, GFileWalkerClass))
+#define G_IS_FILE_WALKER(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), G_TYPE_FILE_WALKER))
+#define G_IS_FILE_WALKER_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), G_TYPE_FILE_WALKER))
+
+/**
+ * GFileWalker:
+ *
+ * Walks a directory tree, enumerating several directories at once.
+ **/
+typedef struct _GFileWalkerClass GFileWalkerClass;
+
+struct _GFileWalkerClass
+{
+  GObjectClass parent_class;
+
+  /*< private >*/
+  /* Padding for future expansion */
+  void (*_g_reserved1) (void);
+  void (*_g_reserved2) (void);
+  void (*_g_reserved3) (void);
+};
+
+/**
+ * GFileWalkerFilterFunc:
+ * @directory: the directory that contains the file.
+ * @info: the #GFileInfo of the file.
+ * @user_data: the data passed to g_file_walker_set_filter().
+ *
+ * Decides whether a file found by a #GFileWalker is reported, and for
+ * directories, whether the walker descends into it. This is called in
+ * the threads that do the enumeration, not in the main loop.
+ *
+ * Returns: %TRUE to keep the file, %FALSE to leave it out.
+ *
+ * Since: 2.20
+ **/
+typedef gboolean (*GFileWalkerFilterFunc) (GFile     *directory,
+					   GFileInfo *info,
+					   gpointer   user_data);
+
+/**
+ * GFileWalkerBatchFunc:
+ * @walker: the #GFileWalker.
+ * @directory: the directory that contains the files.
+ * @infos: a #GList of #GFileInfo<!-- -->s of files in @directory.
+ * @user_data: the data passed to g_file_walker_walk_async().
+ *
+ * Receives a batch of files found by g_file_walker_walk_async(), in
+ * the main loop. The list and the infos are owned by the walker, and
+ * are freed when the function returns.
+ *
+ * Since: 2.20
+ **/
+typedef void (*GFileWalkerBatchFunc) (GFileWalker *walker,
+				      GFile       *directory,
+				      GList       *infos,
+				      gpointer     user_data);
+
+GType        g_file_walker_get_type      (void) G_GNUC_CONST;
+
+GFileWalker *g_file_walker_new           (GFile                  *root,
+					  const char             *attributes,
+					  GFileQueryInfoFlags     flags);
+void         g_file_walker_set_max_depth (GFileWalker            *walker,
+					  int                     max_depth);
+void         g_file_walker_set_max_jobs  (GFileWalker            *walker,
+					  int                     max_jobs);
+void         g_file_walker_set_ordered   (GFileWalker            *walker,
+					  gboolean                ordered);
+void         g_file_walker_set_filter    (GFileWalker            *walker,
+					  GFileWalkerFilterFunc   filter,
+					  gpointer                user_data,
+					  GDestroyNotify          notify);
+
+void         g_file_walker_walk_async    (GFileWalker            *walker,
+					  int                     io_priority,
+					  GCancellable           *cancellable,
+					  GFileWalkerBatchFunc    batch_func,
+					  gpointer                batch_data,
+					  GAsyncReadyCallback     callback,
+					  gpointer                user_data);
+gboolean     g_file_walker_walk_finish   (GFileWalker            *walker,
+					  GAsyncResult           *result,
+					  GError                **error);
+
+G_END_DECLS
+
+#endif /* __G_FILE_WALKER_H__ */
@@ -40,7 +40,8 @@
  *
  * GInputStream has functions to read from a stream (g_input_stream_read()),
  * to close a stream (g_input_stream_close()) and to skip some content
- * (g_input_stream_skip()). 
+ * (g_input_stream_skip()). To read into several buffers at once,
+ * use g_input_stream_readv().
  *
  * To copy the content of an input stream to an output stream without 
  * manually handling the reads and writes, use g_output_stream_splice(). 
@@ -87,6 +88,21 @@ static void     g_input_stream_real_close_async  (GInputStream         *stream,
 static gboolean g_input_stream_real_close_finish (GInputStream         *stream,
 						  GAsyncResult         *result,
 						  GError              **error);
+static gssize   g_input_stream_real_readv        (GInputStream         *stream,
+						  GInputVector         *vectors,
+						  gint                  n_vectors,
+						  GCancellable         *cancellable,
+						  GError              **error);
+static void     g_input_stream_real_readv_async  (GInputStream         *stream,
+						  GInputVector         *vectors,
+						  gint                  n_vectors,
+						  int                   io_priority,
+						  GCancellable         *cancellable,
+						  GAsyncReadyCallback   callback,
+						  gpointer              user_data);
+static gssize   g_input_stream_real_readv_finish (GInputStream         *stream,
+						  GAsyncResult         *result,
+						  GError              **error);
 
 static void
 g_input_stream_finalize (GObject *object)
@@ -132,6 +148,9 @@ g_input_stream_class_init (GInputStreamClass *klass)
   klass->skip_finish = g_input_stream_real_skip_finish;
   klass->close_async = g_input_stream_real_close_async;
   klass->close_finish = g_input_stream_real_close_finish;
+  klass->readv_fn = g_input_stream_real_readv;
+  klass->readv_async = g_input_stream_real_readv_async;
+  klass->readv_finish = g_input_stream_real_readv_finish;
 }
 
 static void
@@ -400,6 +419,155 @@ g_input_stream_real_skip (GInputStream  *stream,
     }
 }
 
+/* Returns the total size of @vectors, or -1 if it doesn't fit a gssize */
+static gssize
+input_vectors_size (const GInputVector *vectors,
+		    gint                n_vectors)
+{
+  gsize total = 0;
+  gint i;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (vectors[i].size > (gsize) G_MAXSSIZE - total)
+	return -1;
+      total += vectors[i].size;
+    }
+
+  return total;
+}
+
+/**
+ * g_input_stream_readv:
+ * @stream: a #GInputStream.
+ * @vectors: an array of #GInputVector<!-- -->s to read data into
+ * @n_vectors: the number of elements in @vectors
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @error: location to store the error occuring, or %NULL to ignore
+ *
+ * Tries to read from the stream into several buffers, filling each
+ * buffer in @vectors before moving on to the next one. Will block
+ * during this read.
+ *
+ * This works like g_input_stream_read(), but streams that can do
+ * scatter reads, such as local files and #GUnixInputStream, fill all
+ * the buffers with a single system call.
+ *
+ * If the vectors add up to zero bytes, returns zero and does nothing.
+ * A total size larger than %G_MAXSSIZE will cause a
+ * %G_IO_ERROR_INVALID_ARGUMENT error.
+ *
+ * On success, the number of bytes read into the buffers is returned.
+ * It is not an error if this is less than the total size of @vectors.
+ * Zero is returned on end of file (or if the vectors are empty), but
+ * never otherwise.
+ *
+ * If @cancellable is not NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error G_IO_ERROR_CANCELLED will be returned. If an
+ * operation was partially finished when the operation was cancelled the
+ * partial result will be returned, without an error.
+ *
+ * On error -1 is returned and @error is set accordingly.
+ *
+ * Return value: Number of bytes read, or -1 on error
+ *
+ * Since: 2.20
+ **/
+gssize
+g_input_stream_readv (GInputStream  *stream,
+		      GInputVector  *vectors,
+		      gint           n_vectors,
+		      GCancellable  *cancellable,
+		      GError       **error)
+{
+  GInputStreamClass *class;
+  gssize size, res;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), -1);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, -1);
+  g_return_val_if_fail (n_vectors >= 0, -1);
+
+  size = input_vectors_size (vectors, n_vectors);
+  if (size == 0)
+    return 0;
+
+  if (size < 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+		   _("Too large count value passed to %s"), G_STRFUNC);
+      return -1;
+    }
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+
+  if (!g_input_stream_set_pending (stream, error))
+    return -1;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  res = class->readv_fn (stream, vectors, n_vectors, cancellable, error);
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  g_input_stream_clear_pending (stream);
+
+  return res;
+}
+
+static gssize
+g_input_stream_real_readv (GInputStream  *stream,
+			   GInputVector  *vectors,
+			   gint           n_vectors,
+			   GCancellable  *cancellable,
+			   GError       **error)
+{
+  GInputStreamClass *class;
+  GError *my_error = NULL;
+  gssize res, total;
+  gint i;
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+
+  if (class->read_fn == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Input stream doesn't implement read"));
+      return -1;
+    }
+
+  total = 0;
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (vectors[i].size == 0)
+	continue;
+
+      res = class->read_fn (stream, vectors[i].buffer, vectors[i].size,
+			    cancellable, &my_error);
+      if (res == -1)
+	{
+	  /* Report what was read so far, the error will come up
+	   * again on the next read */
+	  if (total > 0)
+	    g_error_free (my_error);
+	  else
+	    {
+	      g_propagate_error (error, my_error);
+	      total = -1;
+	    }
+	  break;
+	}
+
+      total += res;
+      if (res < vectors[i].size)
+	break;
+    }
+
+  return total;
+}
+
 /**
  * g_input_stream_close:
  * @stream: A #GInputStream.
@@ -846,6 +1014,128 @@ g_input_stream_close_finish (GInputStream  *stream,
   return class->close_finish (stream, result, error);
 }
 
+/**
+ * g_input_stream_readv_async:
+ * @stream: A #GInputStream.
+ * @vectors: an array of #GInputVector<!-- -->s to read data into
+ * @n_vectors: the number of elements in @vectors
+ * @io_priority: the <link linkend="io-priority">I/O priority</link>
+ * of the request.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @callback: callback to call when the request is satisfied
+ * @user_data: the data to pass to callback function
+ *
+ * Request an asynchronous read from the stream into the buffers in
+ * @vectors. When the operation is finished @callback will be called.
+ * You can then call g_input_stream_readv_finish() to get the result
+ * of the operation.
+ *
+ * Both @vectors and the buffers must stay valid until @callback
+ * is called.
+ *
+ * This works like g_input_stream_read_async(), see
+ * g_input_stream_readv() for how the buffers are filled.
+ *
+ * Since: 2.20
+ **/
+void
+g_input_stream_readv_async (GInputStream        *stream,
+			    GInputVector        *vectors,
+			    gint                 n_vectors,
+			    int                  io_priority,
+			    GCancellable        *cancellable,
+			    GAsyncReadyCallback  callback,
+			    gpointer             user_data)
+{
+  GInputStreamClass *class;
+  GSimpleAsyncResult *simple;
+  GError *error = NULL;
+  gssize size;
+
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+  g_return_if_fail (vectors != NULL || n_vectors == 0);
+  g_return_if_fail (n_vectors >= 0);
+
+  size = input_vectors_size (vectors, n_vectors);
+  if (size == 0)
+    {
+      simple = g_simple_async_result_new (G_OBJECT (stream),
+					  callback,
+					  user_data,
+					  g_input_stream_readv_async);
+      g_simple_async_result_complete_in_idle (simple);
+      g_object_unref (simple);
+      return;
+    }
+
+  if (size < 0)
+    {
+      g_simple_async_report_error_in_idle (G_OBJECT (stream),
+					   callback,
+					   user_data,
+					   G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+					   _("Too large count value passed to %s"),
+					   G_STRFUNC);
+      return;
+    }
+
+  if (!g_input_stream_set_pending (stream, &error))
+    {
+      g_simple_async_report_gerror_in_idle (G_OBJECT (stream),
+					    callback,
+					    user_data,
+					    error);
+      g_error_free (error);
+      return;
+    }
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+  stream->priv->outstanding_callback = callback;
+  g_object_ref (stream);
+  class->readv_async (stream, vectors, n_vectors, io_priority, cancellable,
+		      async_ready_callback_wrapper, user_data);
+}
+
+/**
+ * g_input_stream_readv_finish:
+ * @stream: a #GInputStream.
+ * @result: a #GAsyncResult.
+ * @error: a #GError location to store the error occuring, or %NULL to
+ * ignore.
+ *
+ * Finishes an asynchronous vectored read started with
+ * g_input_stream_readv_async().
+ *
+ * Returns: number of bytes read in, or -1 on error.
+ *
+ * Since: 2.20
+ **/
+gssize
+g_input_stream_readv_finish (GInputStream  *stream,
+			     GAsyncResult  *result,
+			     GError       **error)
+{
+  GSimpleAsyncResult *simple;
+  GInputStreamClass *class;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), -1);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), -1);
+
+  if (G_IS_SIMPLE_ASYNC_RESULT (result))
+    {
+      simple = G_SIMPLE_ASYNC_RESULT (result);
+      if (g_simple_async_result_propagate_error (simple, error))
+	return -1;
+
+      /* Special case read of 0 bytes */
+      if (g_simple_async_result_get_source_tag (simple) == g_input_stream_readv_async)
+	return 0;
+    }
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+  return class->readv_finish (stream, result, error);
+}
+
 /**
  * g_input_stream_is_closed:
  * @stream: input stream.
@@ -1211,5 +1501,172 @@ g_input_stream_real_close_finish (GInputStream  *stream,
   return TRUE;
 }
 
+typedef struct {
+  GInputVector *vectors;
+  gint n_vectors;
+  gssize count_read;
+} ReadvData;
+
+static void
+readv_async_thread (GSimpleAsyncResult *res,
+		    GObject            *object,
+		    GCancellable       *cancellable)
+{
+  ReadvData *op;
+  GInputStreamClass *class;
+  GError *error = NULL;
+
+  op = g_simple_async_result_get_op_res_gpointer (res);
+
+  class = G_INPUT_STREAM_GET_CLASS (object);
+
+  op->count_read = class->readv_fn (G_INPUT_STREAM (object),
+				    op->vectors, op->n_vectors,
+				    cancellable, &error);
+  if (op->count_read == -1)
+    {
+      g_simple_async_result_set_from_error (res, error);
+      g_error_free (error);
+    }
+}
+
+typedef struct {
+  GSimpleAsyncResult *res;
+  int io_prio;
+  GCancellable *cancellable;
+  gint current;
+} ReadvFallbackAsyncData;
+
+static void
+readv_next_vector (GInputStream           *stream,
+		   ReadvFallbackAsyncData *data);
+
+static void
+readv_callback_wrapper (GObject      *source_object,
+			GAsyncResult *result,
+			gpointer      user_data)
+{
+  ReadvFallbackAsyncData *data = user_data;
+  ReadvData *op;
+  GError *error = NULL;
+  gssize ret;
+
+  op = g_simple_async_result_get_op_res_gpointer (data->res);
+  ret = g_input_stream_read_finish (G_INPUT_STREAM (source_object), result, &error);
+
+  if (ret == -1)
+    {
+      /* Report what was read so far, as the sync version does */
+      if (op->count_read == 0)
+	g_simple_async_result_set_from_error (data->res, error);
+      g_error_free (error);
+    }
+  else
+    {
+      op->count_read += ret;
+      if (ret == op->vectors[data->current].size)
+	{
+	  data->current++;
+	  readv_next_vector (G_INPUT_STREAM (source_object), data);
+	  return;
+	}
+    }
+
+  /* Complete immediately, not in idle, since we're already in a mainloop callout */
+  g_simple_async_result_complete (data->res);
+  g_object_unref (data->res);
+  g_free (data);
+}
+
+static void
+readv_next_vector (GInputStream           *stream,
+		   ReadvFallbackAsyncData *data)
+{
+  GInputStreamClass *class;
+  ReadvData *op;
+
+  op = g_simple_async_result_get_op_res_gpointer (data->res);
+
+  while (data->current < op->n_vectors &&
+	 op->vectors[data->current].size == 0)
+    data->current++;
+
+  if (data->current == op->n_vectors)
+    {
+      g_simple_async_result_complete (data->res);
+      g_object_unref (data->res);
+      g_free (data);
+      return;
+    }
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+  class->read_async (stream,
+		     op->vectors[data->current].buffer,
+		     op->vectors[data->current].size,
+		     data->io_prio, data->cancellable,
+		     readv_callback_wrapper, data);
+}
+
+static void
+g_input_stream_real_readv_async (GInputStream        *stream,
+				 GInputVector        *vectors,
+				 gint                 n_vectors,
+				 int                  io_priority,
+				 GCancellable        *cancellable,
+				 GAsyncReadyCallback  callback,
+				 gpointer             user_data)
+{
+  GInputStreamClass *class;
+  GSimpleAsyncResult *res;
+  ReadvFallbackAsyncData *data;
+  ReadvData *op;
+
+  class = G_INPUT_STREAM_GET_CLASS (stream);
+
+  op = g_new0 (ReadvData, 1);
+  res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				   g_input_stream_real_readv_async);
+  g_simple_async_result_set_op_res_gpointer (res, op, g_free);
+  op->vectors = vectors;
+  op->n_vectors = n_vectors;
+
+  if (class->read_async == g_input_stream_real_read_async ||
+      class->readv_fn != g_input_stream_real_readv)
+    {
+      /* Read is thread-using async fallback, or there is a sync
+       * scatter read. Use threads, so that we get to do the whole
+       * read in one go. */
+      g_simple_async_result_run_in_thread (res, readv_async_thread, io_priority, cancellable);
+      g_object_unref (res);
+    }
+  else
+    {
+      /* There is a custom async read function, lets read one vector
+       * at a time with that. */
+      data = g_new (ReadvFallbackAsyncData, 1);
+      data->res = res;
+      data->io_prio = io_priority;
+      data->cancellable = cancellable;
+      data->current = 0;
+      readv_next_vector (stream, data);
+    }
+}
+
+static gssize
+g_input_stream_real_readv_finish (GInputStream  *stream,
+				  GAsyncResult  *result,
+				  GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+  ReadvData *op;
+
+  g_warn_if_fail (g_simple_async_result_get_source_tag (simple) ==
+		  g_input_stream_real_readv_async);
+
+  op = g_simple_async_result_get_op_res_gpointer (simple);
+
+  return op->count_read;
+}
+
 #define __G_INPUT_STREAM_C__
 #include "gioaliasdef.c"
@@ -102,11 +102,25 @@ struct _GInputStreamClass
                              GAsyncResult        *result,
                              GError             **error);
 
+  /* Vectored ops: (optional, default to reading one vector at a time) */
+  gssize   (* readv_fn)     (GInputStream        *stream,
+                             GInputVector        *vectors,
+                             gint                 n_vectors,
+                             GCancellable        *cancellable,
+                             GError             **error);
+  void     (* readv_async)  (GInputStream        *stream,
+                             GInputVector        *vectors,
+                             gint                 n_vectors,
+                             int                  io_priority,
+                             GCancellable        *cancellable,
+                             GAsyncReadyCallback  callback,
+                             gpointer             user_data);
+  gssize   (* readv_finish) (GInputStream        *stream,
+                             GAsyncResult        *result,
+                             GError             **error);
+
   /*< private >*/
   /* Padding for future expansion */
-  void (*_g_reserved1) (void);
-  void (*_g_reserved2) (void);
-  void (*_g_reserved3) (void);
   void (*_g_reserved4) (void);
   void (*_g_reserved5) (void);
 };
@@ -128,6 +142,11 @@ gssize   g_input_stream_skip          (GInputStream          *stream,
 				       gsize                  count,
 				       GCancellable          *cancellable,
 				       GError               **error);
+gssize   g_input_stream_readv         (GInputStream          *stream,
+				       GInputVector          *vectors,
+				       gint                   n_vectors,
+				       GCancellable          *cancellable,
+				       GError               **error);
 gboolean g_input_stream_close         (GInputStream          *stream,
 				       GCancellable          *cancellable,
 				       GError               **error);
@@ -158,6 +177,16 @@ void     g_input_stream_close_async   (GInputStream          *stream,
 gboolean g_input_stream_close_finish  (GInputStream          *stream,
 				       GAsyncResult          *result,
 				       GError               **error);
+void     g_input_stream_readv_async   (GInputStream          *stream,
+				       GInputVector          *vectors,
+				       gint                   n_vectors,
+				       int                    io_priority,
+				       GCancellable          *cancellable,
+				       GAsyncReadyCallback    callback,
+				       gpointer               user_data);
+gssize   g_input_stream_readv_finish  (GInputStream          *stream,
+				       GAsyncResult          *result,
+				       GError               **error);
 
 /* For implementations: */
 
@@ -46,6 +46,7 @@
 #include <gio/gfilemonitor.h>
 #include <gio/gfilenamecompleter.h>
 #include <gio/gfileoutputstream.h>
+#include <gio/gfilewalker.h>
 #include <gio/gfilterinputstream.h>
 #include <gio/gfilteroutputstream.h>
 #include <gio/gicon.h>
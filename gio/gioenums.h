@@ -467,6 +467,28 @@ typedef enum  {
   G_EMBLEM_ORIGIN_TAG
 } GEmblemOrigin;
 
+/**
+ * GIOSchedulerLane:
+ * @G_IO_SCHEDULER_LANE_HIGH: Runs jobs with an I/O priority below
+ *     %G_PRIORITY_DEFAULT.
+ * @G_IO_SCHEDULER_LANE_DEFAULT: Runs jobs with an I/O priority from
+ *     %G_PRIORITY_DEFAULT up to %G_PRIORITY_DEFAULT_IDLE.
+ * @G_IO_SCHEDULER_LANE_LOW: Runs jobs with an I/O priority of
+ *     %G_PRIORITY_DEFAULT_IDLE or above, e.g. bulk copies.
+ *
+ * The #GIOScheduler runs jobs in separate lanes depending on their
+ * <link linkend="io-priority">I/O priority</link>. Each lane has
+ * its own threads, so that long running jobs of low priority can't
+ * keep more urgent jobs waiting.
+ *
+ * Since: 2.20
+ */
+typedef enum {
+  G_IO_SCHEDULER_LANE_HIGH,
+  G_IO_SCHEDULER_LANE_DEFAULT,
+  G_IO_SCHEDULER_LANE_LOW
+} GIOSchedulerLane;
+
 
 G_END_DECLS
 
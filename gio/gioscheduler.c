@@ -22,9 +22,20 @@
 
 #include "config.h"
 
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 #include "gioscheduler.h"
 #include "gcancellable.h"
 
+#ifdef G_OS_WIN32
+#include <windows.h>
+#endif
+
 #include "gioalias.h"
 
 /**
@@ -57,12 +68,47 @@ struct _GIOSchedulerJob {
   GCancellable *cancellable;
 
   guint idle_tag;
+
+  GIOSchedulerLane lane;
+  guint64 push_time;
 };
 
 G_LOCK_DEFINE_STATIC(active_jobs);
 static GSList *active_jobs = NULL;
 
-static GThreadPool *job_thread_pool = NULL;
+/* Each lane has a thread pool of its own, so that jobs in one lane
+ * never wait for threads that are busy with jobs from another lane.
+ * The size of the pools follows the number of CPUs and how much of
+ * its time a job spends blocked rather than on the CPU.
+ */
+#define N_LANES (G_IO_SCHEDULER_LANE_LOW + 1)
+
+/* Fixed point scale of the cpu_load averages */
+#define LOAD_ONE 1024
+
+/* Recompute the pool sizes after this many jobs in a lane */
+#define ADJUST_INTERVAL 32
+
+typedef struct {
+  GThreadPool *pool;
+  guint max_threads;
+  guint n_running;
+  guint64 n_completed;
+  guint64 busy_time;
+  guint64 cpu_time;
+  guint64 wait_histogram[G_IO_SCHEDULER_N_LATENCY_BUCKETS];
+  guint64 run_histogram[G_IO_SCHEDULER_N_LATENCY_BUCKETS];
+
+  /* Moving average of CPU time over run time, in 1/LOAD_ONE */
+  guint cpu_load;
+} Lane;
+
+G_LOCK_DEFINE_STATIC(lanes);
+static Lane lanes[N_LANES];
+static GOnce lanes_once = G_ONCE_INIT;
+
+static guint n_cpus = 1;
+static guint fixed_max_threads = 0;
 
 static void io_job_thread (gpointer data,
 			   gpointer user_data);
@@ -94,33 +140,185 @@ g_io_job_compare (gconstpointer a,
   return 1;
 }
 
+static GIOSchedulerLane
+lane_for_priority (gint io_priority)
+{
+  if (io_priority < G_PRIORITY_DEFAULT)
+    return G_IO_SCHEDULER_LANE_HIGH;
+  if (io_priority < G_PRIORITY_DEFAULT_IDLE)
+    return G_IO_SCHEDULER_LANE_DEFAULT;
+  return G_IO_SCHEDULER_LANE_LOW;
+}
+
+static guint64
+get_time (void)
+{
+  GTimeVal tv;
+
+  g_get_current_time (&tv);
+  return (guint64) tv.tv_sec * G_USEC_PER_SEC + tv.tv_usec;
+}
+
+static guint64
+get_thread_cpu_time (void)
+{
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_THREAD_CPUTIME_ID)
+  struct timespec ts;
+
+  if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+    return (guint64) ts.tv_sec * G_USEC_PER_SEC + ts.tv_nsec / 1000;
+#endif
+  return 0;
+}
+
+static guint
+get_n_cpus (void)
+{
+  long n = -1;
+
+#if defined (_SC_NPROCESSORS_ONLN)
+  n = sysconf (_SC_NPROCESSORS_ONLN);
+#elif defined (G_OS_WIN32)
+  SYSTEM_INFO info;
+
+  GetSystemInfo (&info);
+  n = info.dwNumberOfProcessors;
+#endif
+
+  return n > 0 ? n : 1;
+}
+
+/* Jobs that mostly wait for the disk or the network need many threads
+ * to keep the CPUs busy, jobs that mostly compute need about one per
+ * CPU. The low priority lane gets half as many threads as the others,
+ * so that bulk work can't take over the machine.
+ */
+static guint
+lane_max_threads (GIOSchedulerLane  lane,
+		  guint             cpu_load)
+{
+  guint max_threads;
+
+  if (fixed_max_threads > 0)
+    return fixed_max_threads;
+
+  cpu_load = CLAMP (cpu_load, LOAD_ONE / 8, LOAD_ONE);
+  max_threads = MAX (4, n_cpus * LOAD_ONE / cpu_load);
+
+  if (lane == G_IO_SCHEDULER_LANE_LOW)
+    max_threads = (max_threads + 1) / 2;
+
+  return max_threads;
+}
+
 static gpointer
 init_scheduler (gpointer arg)
 {
-  if (job_thread_pool == NULL)
+  const gchar *env;
+  gint i;
+
+  n_cpus = get_n_cpus ();
+
+  env = g_getenv ("GIO_SCHEDULER_MAX_THREADS");
+  if (env != NULL)
+    fixed_max_threads = MAX (atoi (env), 0);
+
+  for (i = 0; i < N_LANES; i++)
     {
+      Lane *lane = &lanes[i];
+
+      /* Assume that jobs spend most of their time blocked until
+       * we know better */
+      lane->cpu_load = LOAD_ONE / 4;
+      lane->max_threads = lane_max_threads (i, lane->cpu_load);
+
       /* TODO: thread_pool_new can fail */
-      job_thread_pool = g_thread_pool_new (io_job_thread,
-					   NULL,
-					   10,
-					   FALSE,
-					   NULL);
-      if (job_thread_pool != NULL)
-	{
-	  g_thread_pool_set_sort_function (job_thread_pool,
-					   g_io_job_compare,
-					   NULL);
-	  /* Its kinda weird that this is a global setting
-	   * instead of per threadpool. However, we really
-	   * want to cache some threads, but not keep around
-	   * those threads forever. */
-	  g_thread_pool_set_max_idle_time (15 * 1000);
-	  g_thread_pool_set_max_unused_threads (2);
-	}
+      lane->pool = g_thread_pool_new (io_job_thread,
+				      lane,
+				      lane->max_threads,
+				      FALSE,
+				      NULL);
+      if (lane->pool != NULL)
+	g_thread_pool_set_sort_function (lane->pool,
+					 g_io_job_compare,
+					 NULL);
     }
+
+  /* Its kinda weird that this is a global setting
+   * instead of per threadpool. However, we really
+   * want to cache some threads, but not keep around
+   * those threads forever. */
+  g_thread_pool_set_max_idle_time (15 * 1000);
+  g_thread_pool_set_max_unused_threads (MAX (2, n_cpus));
+
   return NULL;
 }
 
+static guint
+latency_bucket (guint64 usec)
+{
+  guint bucket = 0;
+
+  while (usec > 0 && bucket < G_IO_SCHEDULER_N_LATENCY_BUCKETS - 1)
+    {
+      usec >>= 1;
+      bucket++;
+    }
+
+  return bucket;
+}
+
+static void
+lane_job_started (Lane            *lane,
+		  GIOSchedulerJob *job,
+		  guint64          now)
+{
+  guint64 wait_time;
+
+  wait_time = now > job->push_time ? now - job->push_time : 0;
+
+  G_LOCK (lanes);
+  lane->n_running++;
+  lane->wait_histogram[latency_bucket (wait_time)]++;
+  G_UNLOCK (lanes);
+}
+
+static void
+lane_job_finished (Lane    *lane,
+		   guint64  run_time,
+		   guint64  cpu_time)
+{
+  guint max_threads = 0;
+
+  G_LOCK (lanes);
+  lane->n_running--;
+  lane->n_completed++;
+  lane->busy_time += run_time;
+  lane->cpu_time += cpu_time;
+  lane->run_histogram[latency_bucket (run_time)]++;
+
+  if (run_time > 0)
+    {
+      guint load;
+
+      load = MIN (cpu_time, run_time) * LOAD_ONE / run_time;
+      lane->cpu_load = (lane->cpu_load * 7 + load) / 8;
+    }
+
+  if (lane->n_completed % ADJUST_INTERVAL == 0)
+    {
+      max_threads = lane_max_threads (lane - lanes, lane->cpu_load);
+      if (max_threads != lane->max_threads)
+	lane->max_threads = max_threads;
+      else
+	max_threads = 0;
+    }
+  G_UNLOCK (lanes);
+
+  if (max_threads > 0)
+    g_thread_pool_set_max_threads (lane->pool, max_threads, NULL);
+}
+
 static void
 remove_active_job (GIOSchedulerJob *job)
 {
@@ -144,12 +342,16 @@ remove_active_job (GIOSchedulerJob *job)
     }
   G_UNLOCK (active_jobs);
   
-  if (resort_jobs &&
-      job_thread_pool != NULL)
-    g_thread_pool_set_sort_function (job_thread_pool,
-				     g_io_job_compare,
-				     NULL);
+  if (resort_jobs)
+    {
+      gint i;
 
+      for (i = 0; i < N_LANES; i++)
+	if (lanes[i].pool != NULL)
+	  g_thread_pool_set_sort_function (lanes[i].pool,
+					   g_io_job_compare,
+					   NULL);
+    }
 }
 
 static void
@@ -169,8 +371,14 @@ io_job_thread (gpointer data,
 	       gpointer user_data)
 {
   GIOSchedulerJob *job = data;
+  Lane *lane = user_data;
+  guint64 start_time, start_cpu_time, end_time;
   gboolean result;
 
+  start_time = get_time ();
+  start_cpu_time = get_thread_cpu_time ();
+  lane_job_started (lane, job, start_time);
+
   if (job->cancellable)
     g_cancellable_push_current (job->cancellable);
 
@@ -184,6 +392,11 @@ io_job_thread (gpointer data,
     g_cancellable_pop_current (job->cancellable);
 
   job_destroy (job);
+
+  end_time = get_time ();
+  lane_job_finished (lane,
+		     end_time > start_time ? end_time - start_time : 0,
+		     get_thread_cpu_time () - start_cpu_time);
 }
 
 static gboolean
@@ -220,6 +433,10 @@ run_job_at_idle (gpointer data)
  * If @cancellable is not %NULL, it can be used to cancel the I/O job
  * by calling g_cancellable_cancel() or by calling 
  * g_io_scheduler_cancel_all_jobs().
+ *
+ * Jobs are run in one of the #GIOSchedulerLane<!-- -->s, depending
+ * on @io_priority. Each lane has threads of its own, so jobs of low
+ * priority can not keep jobs of a higher priority from running.
  **/
 void
 g_io_scheduler_push_job (GIOSchedulerJobFunc  job_func,
@@ -228,7 +445,6 @@ g_io_scheduler_push_job (GIOSchedulerJobFunc  job_func,
 			 gint                 io_priority,
 			 GCancellable        *cancellable)
 {
-  static GOnce once_init = G_ONCE_INIT;
   GIOSchedulerJob *job;
 
   g_return_if_fail (job_func != NULL);
@@ -238,6 +454,8 @@ g_io_scheduler_push_job (GIOSchedulerJobFunc  job_func,
   job->data = user_data;
   job->destroy_notify = notify;
   job->io_priority = io_priority;
+  job->lane = lane_for_priority (io_priority);
+  job->push_time = get_time ();
     
   if (cancellable)
     job->cancellable = g_object_ref (cancellable);
@@ -249,8 +467,8 @@ g_io_scheduler_push_job (GIOSchedulerJobFunc  job_func,
 
   if (g_thread_supported())
     {
-      g_once (&once_init, init_scheduler, NULL);
-      g_thread_pool_push (job_thread_pool, job, NULL);
+      g_once (&lanes_once, init_scheduler, NULL);
+      g_thread_pool_push (lanes[job->lane].pool, job, NULL);
     }
   else
     {
@@ -296,6 +514,56 @@ g_io_scheduler_cancel_all_jobs (void)
   g_slist_free (cancellable_list);
 }
 
+/**
+ * g_io_scheduler_get_stats:
+ * @lane: a #GIOSchedulerLane
+ * @stats: a #GIOSchedulerStats to fill in
+ *
+ * Fills in @stats with the current state of @lane and with counters
+ * for the jobs it ran so far. This can be used to find out whether
+ * jobs are kept waiting and how busy the threads of a lane are.
+ *
+ * Jobs only run in a lane when threads are available. Without
+ * threads, all the counters stay at zero.
+ *
+ * Since: 2.20
+ **/
+void
+g_io_scheduler_get_stats (GIOSchedulerLane   lane,
+			  GIOSchedulerStats *stats)
+{
+  Lane *l;
+
+  g_return_if_fail (lane >= G_IO_SCHEDULER_LANE_HIGH &&
+		    lane <= G_IO_SCHEDULER_LANE_LOW);
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof (GIOSchedulerStats));
+
+  if (!g_thread_supported ())
+    return;
+
+  g_once (&lanes_once, init_scheduler, NULL);
+  l = &lanes[lane];
+  if (l->pool == NULL)
+    return;
+
+  stats->n_queued = g_thread_pool_unprocessed (l->pool);
+  stats->n_threads = g_thread_pool_get_num_threads (l->pool);
+
+  G_LOCK (lanes);
+  stats->n_running = l->n_running;
+  stats->max_threads = l->max_threads;
+  stats->n_completed = l->n_completed;
+  stats->busy_time = l->busy_time;
+  stats->cpu_time = l->cpu_time;
+  memcpy (stats->wait_histogram, l->wait_histogram,
+	  sizeof (stats->wait_histogram));
+  memcpy (stats->run_histogram, l->run_histogram,
+	  sizeof (stats->run_histogram));
+  G_UNLOCK (lanes);
+}
+
 typedef struct {
   GSourceFunc func;
   gboolean ret_val;
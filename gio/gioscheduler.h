@@ -31,6 +31,57 @@
 
 G_BEGIN_DECLS
 
+/**
+ * G_IO_SCHEDULER_N_LATENCY_BUCKETS:
+ *
+ * The number of buckets in the latency histograms of
+ * #GIOSchedulerStats.
+ *
+ * Since: 2.20
+ */
+#define G_IO_SCHEDULER_N_LATENCY_BUCKETS 24
+
+/**
+ * GIOSchedulerStats:
+ * @n_queued: the number of jobs waiting for a thread
+ * @n_running: the number of jobs that are running
+ * @n_threads: the number of threads of the lane
+ * @max_threads: the number of threads the lane may use at the moment
+ * @n_completed: the number of jobs that have run to completion
+ * @busy_time: the time spent running jobs, in microseconds, summed
+ *     over all threads
+ * @cpu_time: the CPU time used by jobs, in microseconds, or 0 if
+ *     it can't be measured on this system
+ * @wait_histogram: the time jobs spent waiting for a thread.
+ *     Bucket 0 counts jobs that waited less than a microsecond,
+ *     bucket n counts waits from 2^(n-1) up to 2^n microseconds,
+ *     and the last bucket counts all longer waits
+ * @run_histogram: the time jobs took to run, bucketed like
+ *     @wait_histogram
+ *
+ * Information about a #GIOSchedulerLane, filled in by
+ * g_io_scheduler_get_stats(). @n_queued, @n_running and @n_threads
+ * describe the lane at the time of the call, the other fields count
+ * everything since the first job was scheduled.
+ *
+ * The ratio of @busy_time to the elapsed time, divided by
+ * @max_threads, tells how much the threads of a lane are used.
+ *
+ * Since: 2.20
+ */
+struct _GIOSchedulerStats
+{
+  guint   n_queued;
+  guint   n_running;
+  guint   n_threads;
+  guint   max_threads;
+  guint64 n_completed;
+  guint64 busy_time;
+  guint64 cpu_time;
+  guint64 wait_histogram[G_IO_SCHEDULER_N_LATENCY_BUCKETS];
+  guint64 run_histogram[G_IO_SCHEDULER_N_LATENCY_BUCKETS];
+};
+
 
 void     g_io_scheduler_push_job                   (GIOSchedulerJobFunc  job_func,
 						    gpointer             user_data,
@@ -46,6 +97,8 @@ void     g_io_scheduler_job_send_to_mainloop_async (GIOSchedulerJob     *job,
 						    GSourceFunc          func,
 						    gpointer             user_data,
 						    GDestroyNotify       notify);
+void     g_io_scheduler_get_stats                  (GIOSchedulerLane     lane,
+						    GIOSchedulerStats   *stats);
 
 G_END_DECLS
 
@@ -72,6 +72,7 @@ typedef struct _GFileInputStream              GFileInputStream;
 typedef struct _GFileOutputStream             GFileOutputStream;
 typedef struct _GFileIcon                     GFileIcon;
 typedef struct _GFilenameCompleter            GFilenameCompleter;
+typedef struct _GFileWalker                   GFileWalker;
 
 
 typedef struct _GIcon                         GIcon; /* Dummy typedef */
@@ -86,6 +87,7 @@ typedef struct _GIOExtension                  GIOExtension;
  * Opaque class for definining and scheduling IO jobs.
  **/
 typedef struct _GIOSchedulerJob               GIOSchedulerJob;
+typedef struct _GIOSchedulerStats             GIOSchedulerStats;
 typedef struct _GLoadableIcon                 GLoadableIcon; /* Dummy typedef */
 typedef struct _GMemoryInputStream            GMemoryInputStream;
 typedef struct _GMemoryOutputStream           GMemoryOutputStream;
@@ -191,6 +193,40 @@ typedef void (*GSimpleAsyncThreadFunc) (GSimpleAsyncResult *res,
                                         GObject *object,
                                         GCancellable *cancellable);
 
+/**
+ * GInputVector:
+ * @buffer: Pointer to a buffer where data will be written.
+ * @size: the available size in @buffer.
+ *
+ * Structure used for scatter reads with g_input_stream_readv().
+ * On Unix it has the same layout as <structname>struct iovec</structname>.
+ *
+ * Since: 2.20
+ */
+typedef struct _GInputVector GInputVector;
+
+struct _GInputVector {
+  gpointer buffer;
+  gsize size;
+};
+
+/**
+ * GOutputVector:
+ * @buffer: Pointer to a buffer of data to read.
+ * @size: the size of @buffer.
+ *
+ * Structure used for gather writes with g_output_stream_writev().
+ * On Unix it has the same layout as <structname>struct iovec</structname>.
+ *
+ * Since: 2.20
+ */
+typedef struct _GOutputVector GOutputVector;
+
+struct _GOutputVector {
+  gconstpointer buffer;
+  gsize size;
+};
+
 G_END_DECLS
 
 #endif /* __GIO_TYPES_H__ */
@@ -0,0 +1,501 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <string.h>
+
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "giouring.h"
+
+#include "gioalias.h"
+
+/* A single io_uring instance, created on first use. Requests can be
+ * submitted from any thread; completions are read by a source in the
+ * default main context, which is where the results of asynchronous
+ * operations are delivered anyway, and handed to the callers there.
+ *
+ * Only regular files go through the ring. Reads and writes of those
+ * don't block for long, so there's no need to cancel requests once
+ * they are submitted, the same as when they run in a thread.
+ */
+
+#if defined (HAVE_LINUX_IO_URING_H) && defined (__NR_io_uring_setup) && defined (IORING_FEAT_RW_CUR_POS)
+
+#define RING_ENTRIES 128
+
+#define ring_barrier() __sync_synchronize ()
+
+typedef struct
+{
+  GIOUringFunc func;
+  gpointer     user_data;
+} RingRequest;
+
+typedef struct
+{
+  GSource       source;
+  GPollFD       pollfd;
+
+  int           fd;
+  GStaticMutex  submit_lock;
+
+  unsigned     *sq_head;
+  unsigned     *sq_tail;
+  unsigned      sq_mask;
+  unsigned     *sq_array;
+  struct io_uring_sqe *sqes;
+
+  unsigned     *cq_head;
+  unsigned     *cq_tail;
+  unsigned      cq_mask;
+  struct io_uring_cqe *cqes;
+
+  /* kept below the number of completion entries, so that the
+   * completion queue can't overflow
+   */
+  volatile gint n_in_flight;
+  gint          max_in_flight;
+} Ring;
+
+static gboolean
+ring_has_completions (Ring *ring)
+{
+  unsigned head = *ring->cq_head;
+
+  ring_barrier ();
+
+  return head != *(volatile unsigned *) ring->cq_tail;
+}
+
+static gboolean
+ring_source_prepare (GSource *source,
+                     gint    *timeout)
+{
+  *timeout = -1;
+
+  return ring_has_completions ((Ring *) source);
+}
+
+static gboolean
+ring_source_check (GSource *source)
+{
+  Ring *ring = (Ring *) source;
+
+  return (ring->pollfd.revents & G_IO_IN) || ring_has_completions (ring);
+}
+
+static gboolean
+ring_source_dispatch (GSource     *source,
+                      GSourceFunc  callback,
+                      gpointer     user_data)
+{
+  Ring *ring = (Ring *) source;
+  guint64 count;
+  unsigned head, tail;
+
+  /* clear the eventfd first, so that anything completing from now
+   * on wakes up the main loop again
+   */
+  if (ring->pollfd.revents & G_IO_IN)
+    read (ring->pollfd.fd, &count, sizeof (count));
+
+  head = *ring->cq_head;
+
+  while (TRUE)
+    {
+      struct io_uring_cqe *cqe;
+      RingRequest *request;
+      gint result;
+
+      tail = *(volatile unsigned *) ring->cq_tail;
+      ring_barrier ();
+      if (head == tail)
+        break;
+
+      cqe = &ring->cqes[head & ring->cq_mask];
+      request = (RingRequest *) (gsize) cqe->user_data;
+      result = cqe->res;
+
+      /* hand the entry back before calling out, the callback may
+       * well submit the next request
+       */
+      head++;
+      ring_barrier ();
+      *(volatile unsigned *) ring->cq_head = head;
+      g_atomic_int_add (&ring->n_in_flight, -1);
+
+      request->func (result, request->user_data);
+      g_slice_free (RingRequest, request);
+    }
+
+  return TRUE;
+}
+
+static GSourceFuncs ring_source_funcs = {
+  ring_source_prepare,
+  ring_source_check,
+  ring_source_dispatch,
+  NULL
+};
+
+static gpointer
+ring_new (gpointer data)
+{
+  struct io_uring_params params;
+  Ring *ring;
+  guchar *sq_ring, *cq_ring;
+  struct io_uring_sqe *sqes;
+  gsize sq_size, cq_size;
+  int fd, event_fd;
+
+  memset (&params, 0, sizeof (params));
+  fd = syscall (__NR_io_uring_setup, RING_ENTRIES, &params);
+  if (fd < 0)
+    return NULL;
+
+  /* reads and writes at the current file position came with the
+   * other opcodes we need
+   */
+  if (!(params.features & IORING_FEAT_RW_CUR_POS))
+    goto fail;
+
+  sq_size = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+  cq_size = params.cq_off.cqes + params.cq_entries * sizeof (struct io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    sq_size = cq_size = MAX (sq_size, cq_size);
+
+  sq_ring = mmap (NULL, sq_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sq_ring == MAP_FAILED)
+    goto fail;
+
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    cq_ring = sq_ring;
+  else
+    {
+      cq_ring = mmap (NULL, cq_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (cq_ring == MAP_FAILED)
+        goto fail_unmap;
+    }
+
+  sqes = mmap (NULL, params.sq_entries * sizeof (struct io_uring_sqe),
+               PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+               fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    goto fail_unmap;
+
+  event_fd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (event_fd < 0)
+    goto fail_unmap_sqes;
+
+  if (syscall (__NR_io_uring_register, fd, IORING_REGISTER_EVENTFD, &event_fd, 1) < 0)
+    {
+      close (event_fd);
+      goto fail_unmap_sqes;
+    }
+
+  ring = (Ring *) g_source_new (&ring_source_funcs, sizeof (Ring));
+  ring->fd = fd;
+  g_static_mutex_init (&ring->submit_lock);
+
+  ring->sq_head = (unsigned *) (sq_ring + params.sq_off.head);
+  ring->sq_tail = (unsigned *) (sq_ring + params.sq_off.tail);
+  ring->sq_mask = *(unsigned *) (sq_ring + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned *) (sq_ring + params.sq_off.array);
+  ring->sqes = sqes;
+
+  ring->cq_head = (unsigned *) (cq_ring + params.cq_off.head);
+  ring->cq_tail = (unsigned *) (cq_ring + params.cq_off.tail);
+  ring->cq_mask = *(unsigned *) (cq_ring + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *) (cq_ring + params.cq_off.cqes);
+
+  ring->n_in_flight = 0;
+  ring->max_in_flight = MIN (params.sq_entries, params.cq_entries);
+
+  ring->pollfd.fd = event_fd;
+  ring->pollfd.events = G_IO_IN;
+  g_source_add_poll (&ring->source, &ring->pollfd);
+  g_source_attach (&ring->source, NULL);
+
+  return ring;
+
+ fail_unmap_sqes:
+  munmap (sqes, params.sq_entries * sizeof (struct io_uring_sqe));
+ fail_unmap:
+  munmap (sq_ring, sq_size);
+  if (cq_ring != sq_ring && cq_ring != MAP_FAILED)
+    munmap (cq_ring, cq_size);
+ fail:
+  close (fd);
+  return NULL;
+}
+
+static Ring *
+ring_get (void)
+{
+  static GOnce once = G_ONCE_INIT;
+
+  return g_once (&once, ring_new, NULL);
+}
+
+static gboolean
+ring_submit (guint8        opcode,
+             int           fd,
+             gconstpointer buffer,
+             gsize         count,
+             GIOUringFunc  func,
+             gpointer      user_data)
+{
+  Ring *ring = ring_get ();
+  struct io_uring_sqe *sqe;
+  RingRequest *request;
+  unsigned tail, index;
+  int res;
+
+  if (ring == NULL)
+    return FALSE;
+
+  /* past this, requests wait for a thread like they used to */
+  if (g_atomic_int_exchange_and_add (&ring->n_in_flight, 1) >= ring->max_in_flight)
+    {
+      g_atomic_int_add (&ring->n_in_flight, -1);
+      return FALSE;
+    }
+
+  request = g_slice_new (RingRequest);
+  request->func = func;
+  request->user_data = user_data;
+
+  g_static_mutex_lock (&ring->submit_lock);
+
+  tail = *ring->sq_tail;
+  index = tail & ring->sq_mask;
+  sqe = &ring->sqes[index];
+
+  memset (sqe, 0, sizeof (*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  if (opcode != IORING_OP_CLOSE)
+    {
+      /* at the current position */
+      sqe->off = (__u64) -1;
+      sqe->addr = (__u64) (gsize) buffer;
+      sqe->len = MIN (count, G_MAXINT);
+    }
+  sqe->user_data = (__u64) (gsize) request;
+  ring->sq_array[index] = index;
+
+  ring_barrier ();
+  *(volatile unsigned *) ring->sq_tail = tail + 1;
+  ring_barrier ();
+
+  do
+    res = syscall (__NR_io_uring_enter, ring->fd, 1, 0, 0, NULL, 0);
+  while (res < 0 && errno == EINTR);
+
+  /* the kernel didn't take it, take it back */
+  if (res != 1 && *(volatile unsigned *) ring->sq_head == tail)
+    {
+      *(volatile unsigned *) ring->sq_tail = tail;
+      g_static_mutex_unlock (&ring->submit_lock);
+
+      g_atomic_int_add (&ring->n_in_flight, -1);
+      g_slice_free (RingRequest, request);
+      return FALSE;
+    }
+
+  g_static_mutex_unlock (&ring->submit_lock);
+
+  return TRUE;
+}
+
+/*
+ * _g_io_uring_can_use_fd:
+ * @fd: a file descriptor
+ *
+ * Checks whether reads and writes of @fd can go through the ring:
+ * the kernel must support it, and @fd must be a regular file.
+ * Callers should remember the answer for @fd.
+ *
+ * Returns: %TRUE if @fd can be used with _g_io_uring_read() and
+ * friends.
+ */
+gboolean
+_g_io_uring_can_use_fd (int fd)
+{
+  struct stat buf;
+
+  if (ring_get () == NULL)
+    return FALSE;
+
+  return fstat (fd, &buf) == 0 && S_ISREG (buf.st_mode);
+}
+
+/*
+ * _g_io_uring_read:
+ * @fd: a file descriptor that _g_io_uring_can_use_fd() accepted
+ * @buffer: where to read to
+ * @count: how much to read
+ * @func: function to call in the main context once the read is done
+ * @user_data: data for @func
+ *
+ * Starts reading from @fd at its current position, like read().
+ *
+ * Returns: %TRUE if the read was started, %FALSE if it has to be
+ * done some other way.
+ */
+gboolean
+_g_io_uring_read (int           fd,
+                  void         *buffer,
+                  gsize         count,
+                  GIOUringFunc  func,
+                  gpointer      user_data)
+{
+  return ring_submit (IORING_OP_READ, fd, buffer, count, func, user_data);
+}
+
+/*
+ * _g_io_uring_write:
+ *
+ * Like _g_io_uring_read(), but writes to @fd.
+ */
+gboolean
+_g_io_uring_write (int           fd,
+                   const void   *buffer,
+                   gsize         count,
+                   GIOUringFunc  func,
+                   gpointer      user_data)
+{
+  return ring_submit (IORING_OP_WRITE, fd, buffer, count, func, user_data);
+}
+
+/*
+ * _g_io_uring_readv:
+ *
+ * Like _g_io_uring_read(), but scatters the data over @n_vectors
+ * buffers. @vectors must stay valid until @func is called.
+ */
+gboolean
+_g_io_uring_readv (int                 fd,
+                   const struct iovec *vectors,
+                   gint                n_vectors,
+                   GIOUringFunc        func,
+                   gpointer            user_data)
+{
+  return ring_submit (IORING_OP_READV, fd, vectors, n_vectors, func, user_data);
+}
+
+/*
+ * _g_io_uring_writev:
+ *
+ * Like _g_io_uring_readv(), but writes to @fd.
+ */
+gboolean
+_g_io_uring_writev (int                 fd,
+                    const struct iovec *vectors,
+                    gint                n_vectors,
+                    GIOUringFunc        func,
+                    gpointer            user_data)
+{
+  return ring_submit (IORING_OP_WRITEV, fd, vectors, n_vectors, func, user_data);
+}
+
+/*
+ * _g_io_uring_close:
+ *
+ * Like _g_io_uring_read(), but closes @fd.
+ */
+gboolean
+_g_io_uring_close (int           fd,
+                   GIOUringFunc  func,
+                   gpointer      user_data)
+{
+  return ring_submit (IORING_OP_CLOSE, fd, NULL, 0, func, user_data);
+}
+
+#else /* !io_uring */
+
+gboolean
+_g_io_uring_can_use_fd (int fd)
+{
+  return FALSE;
+}
+
+gboolean
+_g_io_uring_read (int           fd,
+                  void         *buffer,
+                  gsize         count,
+                  GIOUringFunc  func,
+                  gpointer      user_data)
+{
+  return FALSE;
+}
+
+gboolean
+_g_io_uring_write (int           fd,
+                   const void   *buffer,
+                   gsize         count,
+                   GIOUringFunc  func,
+                   gpointer      user_data)
+{
+  return FALSE;
+}
+
+gboolean
+_g_io_uring_readv (int                 fd,
+                   const struct iovec *vectors,
+                   gint                n_vectors,
+                   GIOUringFunc        func,
+                   gpointer            user_data)
+{
+  return FALSE;
+}
+
+gboolean
+_g_io_uring_writev (int                 fd,
+                    const struct iovec *vectors,
+                    gint                n_vectors,
+                    GIOUringFunc        func,
+                    gpointer            user_data)
+{
+  return FALSE;
+}
+
+gboolean
+_g_io_uring_close (int           fd,
+                   GIOUringFunc  func,
+                   gpointer      user_data)
+{
+  return FALSE;
+}
+
+#endif
@@ -0,0 +1,63 @@
+/* GIO - GLib Input, Output and Streaming Library
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place, Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __G_IO_URING_H__
+#define __G_IO_URING_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+struct iovec;
+
+/* Called in the main context with the number of bytes transferred,
+ * 0 for a close, or minus the errno value of the failure.
+ */
+typedef void (* GIOUringFunc) (gint     result,
+                               gpointer user_data);
+
+gboolean _g_io_uring_can_use_fd (int           fd);
+gboolean _g_io_uring_read       (int           fd,
+                                 void         *buffer,
+                                 gsize         count,
+                                 GIOUringFunc  func,
+                                 gpointer      user_data);
+gboolean _g_io_uring_write      (int           fd,
+                                 const void   *buffer,
+                                 gsize         count,
+                                 GIOUringFunc  func,
+                                 gpointer      user_data);
+gboolean _g_io_uring_readv      (int                 fd,
+                                 const struct iovec *vectors,
+                                 gint                n_vectors,
+                                 GIOUringFunc        func,
+                                 gpointer            user_data);
+gboolean _g_io_uring_writev     (int                 fd,
+                                 const struct iovec *vectors,
+                                 gint                n_vectors,
+                                 GIOUringFunc        func,
+                                 gpointer            user_data);
+gboolean _g_io_uring_close      (int           fd,
+                                 GIOUringFunc  func,
+                                 gpointer      user_data);
+
+G_END_DECLS
+
+#endif /* __G_IO_URING_H__ */
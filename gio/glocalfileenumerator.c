@@ -27,6 +27,7 @@
 #include <glocalfileinfo.h>
 #include <glocalfile.h>
 #include <gioerror.h>
+#include <gfileattribute-priv.h>
 #include <string.h>
 #include <stdlib.h>
 #include "glibintl.h"
@@ -35,12 +36,6 @@
 
 #define CHUNK_SIZE 1000
 
-  /* TODO:
-   *  It would be nice to use the dirent->d_type to check file type without
-   *  needing to stat each files on linux and other systems that support it.
-   *  (question: does that following symlink or not?)
-   */
-
 #ifdef G_OS_WIN32
 #define USE_GDIR
 #endif
@@ -54,6 +49,9 @@
 typedef struct {
   char *name;
   long inode;
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+  unsigned char type;
+#endif
 } DirEntry;
 
 #endif
@@ -77,6 +75,8 @@ struct _GLocalFileEnumerator
   DirEntry *entries;
   int entries_pos;
   gboolean at_end;
+  int dir_fd;
+  gboolean types_only;
 #endif
   
   gboolean follow_symlinks;
@@ -242,6 +242,31 @@ _g_local_file_enumerator_new (GLocalFile *file,
   local->filename = filename;
   local->matcher = g_file_attribute_matcher_new (attributes);
   local->flags = flags;
+
+#ifndef USE_GDIR
+#if defined (HAVE_FSTATAT) && defined (HAVE_DIRFD)
+  local->dir_fd = dirfd (dir);
+#else
+  local->dir_fd = -1;
+#endif
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+  {
+    static const char * const type_attributes[] = {
+      G_FILE_ATTRIBUTE_STANDARD_NAME,
+      G_FILE_ATTRIBUTE_STANDARD_TYPE,
+      G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN,
+      G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP,
+      G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK,
+      NULL
+    };
+
+    /* If only these are wanted, the d_type of the entries is enough */
+    local->types_only = local->matcher != NULL &&
+      _g_file_attribute_matcher_matches_only_set (local->matcher, type_attributes);
+  }
+#endif
+#endif
   
   return G_FILE_ENUMERATOR (local);
 }
@@ -257,8 +282,32 @@ sort_by_inode (const void *_a, const void *_b)
   return a->inode - b->inode;
 }
 
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+static GFileType
+file_type_from_dirent (unsigned char type)
+{
+  switch (type)
+    {
+    case DT_REG:
+      return G_FILE_TYPE_REGULAR;
+    case DT_DIR:
+      return G_FILE_TYPE_DIRECTORY;
+    case DT_LNK:
+      return G_FILE_TYPE_SYMBOLIC_LINK;
+    case DT_FIFO:
+    case DT_SOCK:
+    case DT_CHR:
+    case DT_BLK:
+      return G_FILE_TYPE_SPECIAL;
+    default:
+      return G_FILE_TYPE_UNKNOWN;
+    }
+}
+#endif
+
 static const char *
-next_file_helper (GLocalFileEnumerator *local)
+next_file_helper (GLocalFileEnumerator *local,
+		  GFileType            *file_type)
 {
   struct dirent *entry;
   const char *filename;
@@ -291,6 +340,9 @@ next_file_helper (GLocalFileEnumerator *local)
 	    {
 	      local->entries[i].name = g_strdup (entry->d_name);
 	      local->entries[i].inode = entry->d_ino;
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+	      local->entries[i].type = entry->d_type;
+#endif
 	    }
 	  else
 	    break;
@@ -301,9 +353,14 @@ next_file_helper (GLocalFileEnumerator *local)
       qsort (local->entries, i, sizeof (DirEntry), sort_by_inode);
     }
 
-  filename = local->entries[local->entries_pos++].name;
+  filename = local->entries[local->entries_pos].name;
   if (filename == NULL)
     local->at_end = TRUE;
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+  else
+    *file_type = file_type_from_dirent (local->entries[local->entries_pos].type);
+#endif
+  local->entries_pos++;
     
   return filename;
 }
@@ -320,6 +377,9 @@ g_local_file_enumerator_next_file (GFileEnumerator  *enumerator,
   char *path;
   GFileInfo *info;
   GError *my_error;
+#ifndef USE_GDIR
+  GFileType file_type;
+#endif
 
   if (!local->got_parent_info)
     {
@@ -332,19 +392,42 @@ g_local_file_enumerator_next_file (GFileEnumerator  *enumerator,
 #ifdef USE_GDIR
   filename = g_dir_read_name (local->dir);
 #else
-  filename = next_file_helper (local);
+  file_type = G_FILE_TYPE_UNKNOWN;
+  filename = next_file_helper (local, &file_type);
 #endif
 
   if (filename == NULL)
     return NULL;
 
+#ifndef USE_GDIR
+  /* The type of a symlink is that of its target, unless we don't
+   * follow symlinks, and that needs a stat.
+   */
+  if (local->types_only &&
+      file_type != G_FILE_TYPE_UNKNOWN &&
+      (file_type != G_FILE_TYPE_SYMBOLIC_LINK ||
+       (local->flags & G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS)))
+    return _g_local_file_info_new_for_type (filename, file_type,
+					    file_type == G_FILE_TYPE_SYMBOLIC_LINK,
+					    local->matcher);
+#endif
+
   my_error = NULL;
   path = g_build_filename (local->filename, filename, NULL);
+#ifdef USE_GDIR
   info = _g_local_file_info_get (filename, path,
 				 local->matcher,
 				 local->flags,
 				 &local->parent_info,
 				 &my_error); 
+#else
+  info = _g_local_file_info_get_at (local->dir_fd,
+				    filename, path,
+				    local->matcher,
+				    local->flags,
+				    &local->parent_info,
+				    &my_error);
+#endif
   g_free (path);
 
   if (info == NULL)
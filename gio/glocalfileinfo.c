@@ -1402,6 +1402,24 @@ _g_local_file_info_get (const char             *basename,
 			GFileQueryInfoFlags     flags,
 			GLocalParentFileInfo   *parent_info,
 			GError                **error)
+{
+  return _g_local_file_info_get_at (-1, basename, path,
+				    attribute_matcher, flags,
+				    parent_info, error);
+}
+
+/* Like _g_local_file_info_get(), but if @dir_fd is not -1, the file is
+ * stated as @basename relative to the directory @dir_fd, which saves
+ * the kernel a walk of the whole path for every file in a directory.
+ */
+GFileInfo *
+_g_local_file_info_get_at (int                     dir_fd,
+			   const char             *basename,
+			   const char             *path,
+			   GFileAttributeMatcher  *attribute_matcher,
+			   GFileQueryInfoFlags     flags,
+			   GLocalParentFileInfo   *parent_info,
+			   GError                **error)
 {
   GFileInfo *info;
   GLocalFileStat statbuf;
@@ -1426,7 +1444,12 @@ _g_local_file_info_get (const char             *basename,
     return info;
 
 #ifndef G_OS_WIN32
-  res = g_lstat (path, &statbuf);
+#ifdef HAVE_FSTATAT
+  if (dir_fd != -1)
+    res = fstatat (dir_fd, basename, &statbuf, AT_SYMLINK_NOFOLLOW);
+  else
+#endif
+    res = g_lstat (path, &statbuf);
 #else
   {
     wchar_t *wpath = g_utf8_to_utf16 (path, -1, NULL, NULL, error);
@@ -1479,7 +1502,12 @@ _g_local_file_info_get (const char             *basename,
       /* Unless NOFOLLOW was set we default to following symlinks */
       if (!(flags & G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS))
 	{
-	  res = stat (path, &statbuf2);
+#ifdef HAVE_FSTATAT
+	  if (dir_fd != -1)
+	    res = fstatat (dir_fd, basename, &statbuf2, 0);
+	  else
+#endif
+	    res = stat (path, &statbuf2);
 
 	    /* Report broken links as symlinks */
 	  if (res != -1)
@@ -1676,6 +1704,39 @@ _g_local_file_info_get (const char             *basename,
   return info;
 }
 
+/* Builds the info for a directory entry whose type is already known,
+ * e.g. from readdir(), without stating the file. Only the attributes
+ * that follow from the name and the type are set, so this is only
+ * useful when @attribute_matcher asks for nothing else.
+ */
+GFileInfo *
+_g_local_file_info_new_for_type (const char            *basename,
+				 GFileType              type,
+				 gboolean               is_symlink,
+				 GFileAttributeMatcher *attribute_matcher)
+{
+  GFileInfo *info;
+
+  info = g_file_info_new ();
+  g_file_info_set_attribute_mask (info, attribute_matcher);
+
+  g_file_info_set_name (info, basename);
+  g_file_info_set_file_type (info, type);
+
+  if (is_symlink)
+    g_file_info_set_is_symlink (info, TRUE);
+
+  if (basename[0] == '.')
+    g_file_info_set_is_hidden (info, TRUE);
+
+  if (basename[strlen (basename) -1] == '~')
+    g_file_info_set_attribute_boolean (info, G_FILE_ATTRIBUTE_STANDARD_IS_BACKUP, TRUE);
+
+  g_file_info_unset_attribute_mask (info);
+
+  return info;
+}
+
 GFileInfo *
 _g_local_file_info_get_from_fd (int      fd,
 				char    *attributes,
@@ -59,6 +59,17 @@ GFileInfo *_g_local_file_info_get             (const char             *basename,
                                                GFileQueryInfoFlags     flags,
                                                GLocalParentFileInfo   *parent_info,
                                                GError                **error);
+GFileInfo *_g_local_file_info_get_at          (int                     dir_fd,
+                                               const char             *basename,
+                                               const char             *path,
+                                               GFileAttributeMatcher  *attribute_matcher,
+                                               GFileQueryInfoFlags     flags,
+                                               GLocalParentFileInfo   *parent_info,
+                                               GError                **error);
+GFileInfo *_g_local_file_info_new_for_type    (const char             *basename,
+                                               GFileType               type,
+                                               gboolean                is_symlink,
+                                               GFileAttributeMatcher  *attribute_matcher);
 GFileInfo *_g_local_file_info_get_from_fd     (int                     fd,
                                                char                   *attributes,
                                                GError                **error);
@@ -29,6 +29,14 @@
 #include <unistd.h>
 #endif
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -36,19 +44,51 @@
 #include "gioerror.h"
 #include "glocalfileinputstream.h"
 #include "glocalfileinfo.h"
+#include "gsimpleasyncresult.h"
+#include "giouring.h"
 #include "glibintl.h"
 
 #ifdef G_OS_WIN32
 #include <io.h>
 #endif
 
+#ifndef IOV_MAX
+#ifdef UIO_MAXIOV
+#define IOV_MAX UIO_MAXIOV
+#else
+#define IOV_MAX 16
+#endif
+#endif
+
 #include "gioalias.h"
 
 #define g_local_file_input_stream_get_type _g_local_file_input_stream_get_type
 G_DEFINE_TYPE (GLocalFileInputStream, g_local_file_input_stream, G_TYPE_FILE_INPUT_STREAM);
 
+/* How the pages of a mapped file are going to be accessed */
+typedef enum {
+  ADVICE_NORMAL,
+  ADVICE_SEQUENTIAL,
+  ADVICE_WILLNEED
+} MappedAdvice;
+
+/* Reading this much after a seek counts as sequential again */
+#define SEQUENTIAL_AGAIN_SIZE (1024 * 1024)
+
 struct _GLocalFileInputStreamPrivate {
   int fd;
+  /* whether async operations go through io_uring,
+   * 0 until the first one
+   */
+  int use_ring;
+
+  /* set by _g_local_file_input_stream_map(), reads then
+   * come from the mapping and the fd position is unused
+   */
+  GMappedFile *mapped;
+  goffset mapped_pos;
+  gsize read_since_seek;
+  MappedAdvice advice;
 };
 
 static gssize     g_local_file_input_stream_read       (GInputStream      *stream,
@@ -60,9 +100,53 @@ static gssize     g_local_file_input_stream_skip       (GInputStream      *strea
 							gsize              count,
 							GCancellable      *cancellable,
 							GError           **error);
+#ifdef HAVE_READV
+static gssize     g_local_file_input_stream_readv      (GInputStream      *stream,
+							GInputVector      *vectors,
+							gint               n_vectors,
+							GCancellable      *cancellable,
+							GError           **error);
+#endif
 static gboolean   g_local_file_input_stream_close      (GInputStream      *stream,
 							GCancellable      *cancellable,
 							GError           **error);
+static void       g_local_file_input_stream_read_async  (GInputStream        *stream,
+							 void                *buffer,
+							 gsize                count,
+							 int                  io_priority,
+							 GCancellable        *cancellable,
+							 GAsyncReadyCallback  callback,
+							 gpointer             user_data);
+static gssize     g_local_file_input_stream_read_finish (GInputStream        *stream,
+							 GAsyncResult        *result,
+							 GError             **error);
+static void       g_local_file_input_stream_skip_async  (GInputStream        *stream,
+							 gsize                count,
+							 int                  io_priority,
+							 GCancellable        *cancellable,
+							 GAsyncReadyCallback  callback,
+							 gpointer             user_data);
+static gssize     g_local_file_input_stream_skip_finish (GInputStream        *stream,
+							 GAsyncResult        *result,
+							 GError             **error);
+static void       g_local_file_input_stream_close_async (GInputStream        *stream,
+							 int                  io_priority,
+							 GCancellable        *cancellable,
+							 GAsyncReadyCallback  callback,
+							 gpointer             user_data);
+static gboolean   g_local_file_input_stream_close_finish (GInputStream       *stream,
+							  GAsyncResult       *result,
+							  GError            **error);
+static void       g_local_file_input_stream_readv_async  (GInputStream        *stream,
+							  GInputVector        *vectors,
+							  gint                 n_vectors,
+							  int                  io_priority,
+							  GCancellable        *cancellable,
+							  GAsyncReadyCallback  callback,
+							  gpointer             user_data);
+static gssize     g_local_file_input_stream_readv_finish (GInputStream        *stream,
+							  GAsyncResult        *result,
+							  GError             **error);
 static goffset    g_local_file_input_stream_tell       (GFileInputStream  *stream);
 static gboolean   g_local_file_input_stream_can_seek   (GFileInputStream  *stream);
 static gboolean   g_local_file_input_stream_seek       (GFileInputStream  *stream,
@@ -74,6 +158,9 @@ static GFileInfo *g_local_file_input_stream_query_info (GFileInputStream  *strea
 							char              *attributes,
 							GCancellable      *cancellable,
 							GError           **error);
+static const void *g_local_file_input_stream_borrow    (GFileInputStream  *stream,
+							gsize              count,
+							gsize             *available);
 
 static void
 g_local_file_input_stream_finalize (GObject *object)
@@ -82,6 +169,9 @@ g_local_file_input_stream_finalize (GObject *object)
   
   file = G_LOCAL_FILE_INPUT_STREAM (object);
 
+  if (file->priv->mapped)
+    g_mapped_file_free (file->priv->mapped);
+
   G_OBJECT_CLASS (g_local_file_input_stream_parent_class)->finalize (object);
 }
 
@@ -99,10 +189,22 @@ g_local_file_input_stream_class_init (GLocalFileInputStreamClass *klass)
   stream_class->read_fn = g_local_file_input_stream_read;
   stream_class->skip = g_local_file_input_stream_skip;
   stream_class->close_fn = g_local_file_input_stream_close;
+  stream_class->read_async = g_local_file_input_stream_read_async;
+  stream_class->read_finish = g_local_file_input_stream_read_finish;
+  stream_class->skip_async = g_local_file_input_stream_skip_async;
+  stream_class->skip_finish = g_local_file_input_stream_skip_finish;
+  stream_class->close_async = g_local_file_input_stream_close_async;
+  stream_class->close_finish = g_local_file_input_stream_close_finish;
+#ifdef HAVE_READV
+  stream_class->readv_fn = g_local_file_input_stream_readv;
+#endif
+  stream_class->readv_async = g_local_file_input_stream_readv_async;
+  stream_class->readv_finish = g_local_file_input_stream_readv_finish;
   file_stream_class->tell = g_local_file_input_stream_tell;
   file_stream_class->can_seek = g_local_file_input_stream_can_seek;
   file_stream_class->seek = g_local_file_input_stream_seek;
   file_stream_class->query_info = g_local_file_input_stream_query_info;
+  file_stream_class->borrow = g_local_file_input_stream_borrow;
 }
 
 static void
@@ -130,6 +232,190 @@ _g_local_file_input_stream_new (int fd)
   return G_FILE_INPUT_STREAM (stream);
 }
 
+int
+_g_local_file_input_stream_get_fd (GLocalFileInputStream *stream)
+{
+  return stream->priv->fd;
+}
+
+static void
+mapped_advise (GLocalFileInputStream *file,
+	       gsize                  offset,
+	       gsize                  length,
+	       MappedAdvice           advice)
+{
+#if defined (HAVE_MADVISE) && defined (MADV_SEQUENTIAL)
+  static gsize page_size = 0;
+  char *contents;
+  gsize start;
+  int madv;
+
+  if (length == 0)
+    return;
+
+  if (page_size == 0)
+    page_size = sysconf (_SC_PAGESIZE);
+
+  switch (advice)
+    {
+    default:
+    case ADVICE_NORMAL:
+      madv = MADV_NORMAL;
+      break;
+    case ADVICE_SEQUENTIAL:
+      madv = MADV_SEQUENTIAL;
+      break;
+    case ADVICE_WILLNEED:
+      madv = MADV_WILLNEED;
+      break;
+    }
+
+  /* madvise() wants a page aligned start */
+  contents = g_mapped_file_get_contents (file->priv->mapped);
+  start = offset - offset % page_size;
+  madvise (contents + start, offset + length - start, madv);
+#endif
+}
+
+/**
+ * _g_local_file_input_stream_map:
+ * @stream: a #GLocalFileInputStream.
+ *
+ * Makes @stream read from a memory mapping of its file, if it is a
+ * regular file that can be mapped. Otherwise, nothing changes.
+ **/
+void
+_g_local_file_input_stream_map (GLocalFileInputStream *stream)
+{
+  GLocalFileInputStreamPrivate *priv;
+  GMappedFile *mapped;
+  struct stat buf;
+  off_t pos;
+
+  priv = stream->priv;
+
+  if (priv->mapped != NULL || priv->fd == -1)
+    return;
+
+  if (fstat (priv->fd, &buf) != 0 || !S_ISREG (buf.st_mode))
+    return;
+
+  pos = lseek (priv->fd, 0, SEEK_CUR);
+  if (pos == (off_t)-1)
+    return;
+
+  mapped = g_mapped_file_new_from_fd (priv->fd, FALSE, NULL);
+  if (mapped == NULL)
+    return;
+
+  priv->mapped = mapped;
+  priv->mapped_pos = pos;
+  priv->read_since_seek = 0;
+
+  /* Mapped files are mostly read front to back */
+  priv->advice = ADVICE_SEQUENTIAL;
+  mapped_advise (stream, 0, g_mapped_file_get_length (mapped), ADVICE_SEQUENTIAL);
+}
+
+/* Number of mapped bytes, up to @count, at the current position */
+static gsize
+mapped_available (GLocalFileInputStream *file,
+		  gsize                  count)
+{
+  gsize length;
+
+  length = g_mapped_file_get_length (file->priv->mapped);
+
+  if (file->priv->mapped_pos >= length)
+    return 0;
+
+  return MIN (count, length - file->priv->mapped_pos);
+}
+
+static void
+mapped_advance (GLocalFileInputStream *file,
+		gsize                  count)
+{
+  GLocalFileInputStreamPrivate *priv = file->priv;
+
+  priv->mapped_pos += count;
+
+  if (priv->advice != ADVICE_SEQUENTIAL)
+    {
+      priv->read_since_seek += count;
+      if (priv->read_since_seek >= SEQUENTIAL_AGAIN_SIZE)
+	{
+	  priv->advice = ADVICE_SEQUENTIAL;
+	  mapped_advise (file, 0, g_mapped_file_get_length (priv->mapped),
+			 ADVICE_SEQUENTIAL);
+	}
+    }
+}
+
+static gssize
+mapped_read (GLocalFileInputStream *file,
+	     void                  *buffer,
+	     gsize                  count)
+{
+  const char *contents;
+
+  count = mapped_available (file, count);
+  contents = g_mapped_file_get_contents (file->priv->mapped);
+  memcpy (buffer, contents + file->priv->mapped_pos, count);
+  mapped_advance (file, count);
+
+  return count;
+}
+
+static gboolean
+mapped_seek (GLocalFileInputStream *file,
+	     goffset                offset,
+	     GSeekType              type,
+	     GError               **error)
+{
+  GLocalFileInputStreamPrivate *priv = file->priv;
+  goffset pos;
+
+  switch (type)
+    {
+    default:
+    case G_SEEK_CUR:
+      pos = priv->mapped_pos + offset;
+      break;
+    case G_SEEK_SET:
+      pos = offset;
+      break;
+    case G_SEEK_END:
+      pos = g_mapped_file_get_length (priv->mapped) + offset;
+      break;
+    }
+
+  if (pos < 0)
+    {
+      g_set_error (error, G_IO_ERROR,
+		   g_io_error_from_errno (EINVAL),
+		   _("Error seeking in file: %s"),
+		   g_strerror (EINVAL));
+      return FALSE;
+    }
+
+  /* Jumping around makes readahead of the following pages wasteful */
+  if (pos != priv->mapped_pos)
+    {
+      priv->read_since_seek = 0;
+      if (priv->advice == ADVICE_SEQUENTIAL)
+	{
+	  priv->advice = ADVICE_NORMAL;
+	  mapped_advise (file, 0, g_mapped_file_get_length (priv->mapped),
+			 ADVICE_NORMAL);
+	}
+    }
+
+  priv->mapped_pos = pos;
+
+  return TRUE;
+}
+
 static gssize
 g_local_file_input_stream_read (GInputStream  *stream,
 				void          *buffer,
@@ -142,6 +428,13 @@ g_local_file_input_stream_read (GInputStream  *stream,
 
   file = G_LOCAL_FILE_INPUT_STREAM (stream);
 
+  if (file->priv->mapped)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	return -1;
+      return mapped_read (file, buffer, count);
+    }
+
   res = -1;
   while (1)
     {
@@ -167,6 +460,63 @@ g_local_file_input_stream_read (GInputStream  *stream,
   return res;
 }
 
+#ifdef HAVE_READV
+static gssize
+g_local_file_input_stream_readv (GInputStream  *stream,
+				 GInputVector  *vectors,
+				 gint           n_vectors,
+				 GCancellable  *cancellable,
+				 GError       **error)
+{
+  GLocalFileInputStream *file;
+  gssize res;
+
+  file = G_LOCAL_FILE_INPUT_STREAM (stream);
+
+  if (file->priv->mapped)
+    {
+      gint i;
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	return -1;
+
+      res = 0;
+      for (i = 0; i < n_vectors; i++)
+	res += mapped_read (file, vectors[i].buffer, vectors[i].size);
+
+      return res;
+    }
+
+  /* The rest of the vectors are left for the next read */
+  n_vectors = MIN (n_vectors, IOV_MAX);
+
+  res = -1;
+  while (1)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	break;
+      /* GInputVector has the layout of struct iovec */
+      res = readv (file->priv->fd, (struct iovec *) vectors, n_vectors);
+      if (res == -1)
+	{
+          int errsv = errno;
+
+	  if (errsv == EINTR)
+	    continue;
+	  
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error reading from file: %s"),
+		       g_strerror (errsv));
+	}
+      
+      break;
+    }
+  
+  return res;
+}
+#endif
+
 static gssize
 g_local_file_input_stream_skip (GInputStream  *stream,
 				gsize          count,
@@ -180,6 +530,13 @@ g_local_file_input_stream_skip (GInputStream  *stream,
   
   if (g_cancellable_set_error_if_cancelled (cancellable, error))
     return -1;
+
+  if (file->priv->mapped)
+    {
+      count = mapped_available (file, count);
+      mapped_advance (file, count);
+      return count;
+    }
   
   start = lseek (file->priv->fd, 0, SEEK_CUR);
   if (start == -1)
@@ -218,6 +575,12 @@ g_local_file_input_stream_close (GInputStream  *stream,
 
   file = G_LOCAL_FILE_INPUT_STREAM (stream);
 
+  if (file->priv->mapped)
+    {
+      g_mapped_file_free (file->priv->mapped);
+      file->priv->mapped = NULL;
+    }
+
   if (file->priv->fd == -1)
     return TRUE;
 
@@ -247,6 +610,9 @@ g_local_file_input_stream_tell (GFileInputStream *stream)
   off_t pos;
 
   file = G_LOCAL_FILE_INPUT_STREAM (stream);
+
+  if (file->priv->mapped)
+    return file->priv->mapped_pos;
   
   pos = lseek (file->priv->fd, 0, SEEK_CUR);
 
@@ -263,6 +629,9 @@ g_local_file_input_stream_can_seek (GFileInputStream *stream)
   off_t pos;
 
   file = G_LOCAL_FILE_INPUT_STREAM (stream);
+
+  if (file->priv->mapped)
+    return TRUE;
   
   pos = lseek (file->priv->fd, 0, SEEK_CUR);
 
@@ -301,6 +670,9 @@ g_local_file_input_stream_seek (GFileInputStream  *stream,
 
   file = G_LOCAL_FILE_INPUT_STREAM (stream);
 
+  if (file->priv->mapped)
+    return mapped_seek (file, offset, type, error);
+
   pos = lseek (file->priv->fd, offset, seek_type_to_lseek (type));
 
   if (pos == (off_t)-1)
@@ -334,3 +706,271 @@ g_local_file_input_stream_query_info (GFileInputStream  *stream,
 					 attributes,
 					 error);
 }
+
+static const void *
+g_local_file_input_stream_borrow (GFileInputStream *stream,
+				  gsize             count,
+				  gsize            *available)
+{
+  GLocalFileInputStream *file;
+  const char *contents;
+  gsize length;
+
+  file = G_LOCAL_FILE_INPUT_STREAM (stream);
+
+  if (file->priv->mapped == NULL)
+    return NULL;
+
+  count = mapped_available (file, count);
+
+  /* Sequential access already has the kernel reading ahead */
+  if (file->priv->advice != ADVICE_SEQUENTIAL)
+    mapped_advise (file, file->priv->mapped_pos, count, ADVICE_WILLNEED);
+
+  if (available)
+    *available = count;
+
+  contents = g_mapped_file_get_contents (file->priv->mapped);
+  length = g_mapped_file_get_length (file->priv->mapped);
+
+  return contents + MIN (file->priv->mapped_pos, length);
+}
+
+/* Reads, writes and closes of regular files go through io_uring when
+ * the kernel has it, so that they don't each need a thread from the
+ * pool. Everything else still does.
+ */
+static gboolean
+g_local_file_input_stream_use_ring (GLocalFileInputStream *file)
+{
+  /* Mapped reads are memory copies, done by the default threads */
+  if (file->priv->mapped)
+    return FALSE;
+
+  if (file->priv->use_ring == 0)
+    file->priv->use_ring = _g_io_uring_can_use_fd (file->priv->fd) ? 1 : -1;
+
+  return file->priv->use_ring > 0;
+}
+
+static void
+read_async_done (gint     result,
+		 gpointer user_data)
+{
+  GSimpleAsyncResult *res = user_data;
+
+  if (result < 0)
+    g_simple_async_result_set_error (res, G_IO_ERROR,
+				     g_io_error_from_errno (-result),
+				     _("Error reading from file: %s"),
+				     g_strerror (-result));
+  else
+    g_simple_async_result_set_op_res_gssize (res, result);
+
+  g_simple_async_result_complete (res);
+  g_object_unref (res);
+}
+
+static void
+g_local_file_input_stream_read_async (GInputStream        *stream,
+				      void                *buffer,
+				      gsize                count,
+				      int                  io_priority,
+				      GCancellable        *cancellable,
+				      GAsyncReadyCallback  callback,
+				      gpointer             user_data)
+{
+  GLocalFileInputStream *file = G_LOCAL_FILE_INPUT_STREAM (stream);
+  GSimpleAsyncResult *res;
+  GError *error = NULL;
+
+  if (g_local_file_input_stream_use_ring (file))
+    {
+      res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				       g_local_file_input_stream_read_async);
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+	{
+	  g_simple_async_result_set_from_error (res, error);
+	  g_error_free (error);
+	  g_simple_async_result_complete_in_idle (res);
+	  g_object_unref (res);
+	  return;
+	}
+
+      if (_g_io_uring_read (file->priv->fd, buffer, count, read_async_done, res))
+	return;
+
+      g_object_unref (res);
+    }
+
+  G_INPUT_STREAM_CLASS (g_local_file_input_stream_parent_class)->read_async (stream, buffer, count,
+									     io_priority, cancellable,
+									     callback, user_data);
+}
+
+static gssize
+g_local_file_input_stream_read_finish (GInputStream  *stream,
+				       GAsyncResult  *result,
+				       GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_get_source_tag (simple) != g_local_file_input_stream_read_async)
+    return G_INPUT_STREAM_CLASS (g_local_file_input_stream_parent_class)->read_finish (stream, result, error);
+
+  return g_simple_async_result_get_op_res_gssize (simple);
+}
+
+static void
+g_local_file_input_stream_readv_async (GInputStream        *stream,
+				       GInputVector        *vectors,
+				       gint                 n_vectors,
+				       int                  io_priority,
+				       GCancellable        *cancellable,
+				       GAsyncReadyCallback  callback,
+				       gpointer             user_data)
+{
+  GLocalFileInputStream *file = G_LOCAL_FILE_INPUT_STREAM (stream);
+  GSimpleAsyncResult *res;
+  GError *error = NULL;
+
+  if (g_local_file_input_stream_use_ring (file))
+    {
+      res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				       g_local_file_input_stream_readv_async);
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+	{
+	  g_simple_async_result_set_from_error (res, error);
+	  g_error_free (error);
+	  g_simple_async_result_complete_in_idle (res);
+	  g_object_unref (res);
+	  return;
+	}
+
+      /* GInputVector has the layout of struct iovec */
+      if (_g_io_uring_readv (file->priv->fd, (const struct iovec *) vectors,
+			     MIN (n_vectors, IOV_MAX), read_async_done, res))
+	return;
+
+      g_object_unref (res);
+    }
+
+  G_INPUT_STREAM_CLASS (g_local_file_input_stream_parent_class)->readv_async (stream, vectors, n_vectors,
+									      io_priority, cancellable,
+									      callback, user_data);
+}
+
+static gssize
+g_local_file_input_stream_readv_finish (GInputStream  *stream,
+					GAsyncResult  *result,
+					GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_get_source_tag (simple) != g_local_file_input_stream_readv_async)
+    return G_INPUT_STREAM_CLASS (g_local_file_input_stream_parent_class)->readv_finish (stream, result, error);
+
+  return g_simple_async_result_get_op_res_gssize (simple);
+}
+
+/* Skipping is only a seek, which doesn't block */
+static void
+g_local_file_input_stream_skip_async (GInputStream        *stream,
+				      gsize                count,
+				      int                  io_priority,
+				      GCancellable        *cancellable,
+				      GAsyncReadyCallback  callback,
+				      gpointer             user_data)
+{
+  GSimpleAsyncResult *res;
+  GError *error = NULL;
+  gssize skipped;
+
+  res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				   g_local_file_input_stream_skip_async);
+
+  skipped = g_local_file_input_stream_skip (stream, count, cancellable, &error);
+  if (skipped == -1)
+    {
+      g_simple_async_result_set_from_error (res, error);
+      g_error_free (error);
+    }
+  else
+    g_simple_async_result_set_op_res_gssize (res, skipped);
+
+  g_simple_async_result_complete_in_idle (res);
+  g_object_unref (res);
+}
+
+static gssize
+g_local_file_input_stream_skip_finish (GInputStream  *stream,
+				       GAsyncResult  *result,
+				       GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  g_warn_if_fail (g_simple_async_result_get_source_tag (simple) == g_local_file_input_stream_skip_async);
+
+  return g_simple_async_result_get_op_res_gssize (simple);
+}
+
+static void
+close_async_done (gint     result,
+		  gpointer user_data)
+{
+  GSimpleAsyncResult *res = user_data;
+
+  if (result < 0)
+    g_simple_async_result_set_error (res, G_IO_ERROR,
+				     g_io_error_from_errno (-result),
+				     _("Error closing file: %s"),
+				     g_strerror (-result));
+
+  g_simple_async_result_complete (res);
+  g_object_unref (res);
+}
+
+static void
+g_local_file_input_stream_close_async (GInputStream        *stream,
+				       int                  io_priority,
+				       GCancellable        *cancellable,
+				       GAsyncReadyCallback  callback,
+				       gpointer             user_data)
+{
+  GLocalFileInputStream *file = G_LOCAL_FILE_INPUT_STREAM (stream);
+  GSimpleAsyncResult *res;
+
+  /* closing ignores cancellation, so that nothing leaks */
+  if (file->priv->fd != -1 && g_local_file_input_stream_use_ring (file))
+    {
+      res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				       g_local_file_input_stream_close_async);
+
+      if (_g_io_uring_close (file->priv->fd, close_async_done, res))
+	{
+	  file->priv->fd = -1;
+	  return;
+	}
+
+      g_object_unref (res);
+    }
+
+  G_INPUT_STREAM_CLASS (g_local_file_input_stream_parent_class)->close_async (stream, io_priority,
+									      cancellable,
+									      callback, user_data);
+}
+
+static gboolean
+g_local_file_input_stream_close_finish (GInputStream  *stream,
+					GAsyncResult  *result,
+					GError       **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_get_source_tag (simple) != g_local_file_input_stream_close_async)
+    return G_INPUT_STREAM_CLASS (g_local_file_input_stream_parent_class)->close_finish (stream, result, error);
+
+  return TRUE;
+}
@@ -30,6 +30,10 @@
 #endif
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -38,6 +42,8 @@
 #include "gcancellable.h"
 #include "glocalfileoutputstream.h"
 #include "glocalfileinfo.h"
+#include "gsimpleasyncresult.h"
+#include "giouring.h"
 
 #ifdef G_OS_WIN32
 #include <io.h>
@@ -53,6 +59,14 @@
 #define O_BINARY 0
 #endif
 
+#ifndef IOV_MAX
+#ifdef UIO_MAXIOV
+#define IOV_MAX UIO_MAXIOV
+#else
+#define IOV_MAX 16
+#endif
+#endif
+
 #include "gioalias.h"
 
 #define g_local_file_output_stream_get_type _g_local_file_output_stream_get_type
@@ -70,6 +84,10 @@ struct _GLocalFileOutputStreamPrivate {
   char *backup_filename;
   char *etag;
   int fd;
+  /* whether async operations go through io_uring,
+   * 0 until the first one
+   */
+  int use_ring;
 };
 
 static gssize     g_local_file_output_stream_write        (GOutputStream      *stream,
@@ -77,6 +95,13 @@ static gssize     g_local_file_output_stream_write        (GOutputStream      *s
 							   gsize               count,
 							   GCancellable       *cancellable,
 							   GError            **error);
+#ifdef HAVE_WRITEV
+static gssize     g_local_file_output_stream_writev       (GOutputStream       *stream,
+							   const GOutputVector *vectors,
+							   gint                 n_vectors,
+							   GCancellable        *cancellable,
+							   GError             **error);
+#endif
 static gboolean   g_local_file_output_stream_close        (GOutputStream      *stream,
 							   GCancellable       *cancellable,
 							   GError            **error);
@@ -98,6 +123,35 @@ static gboolean   g_local_file_output_stream_truncate     (GFileOutputStream  *s
 							   GCancellable       *cancellable,
 							   GError            **error);
 
+static void       g_local_file_output_stream_write_async  (GOutputStream       *stream,
+							   const void          *buffer,
+							   gsize                count,
+							   int                  io_priority,
+							   GCancellable        *cancellable,
+							   GAsyncReadyCallback  callback,
+							   gpointer             user_data);
+static gssize     g_local_file_output_stream_write_finish (GOutputStream       *stream,
+							   GAsyncResult        *result,
+							   GError             **error);
+static void       g_local_file_output_stream_writev_async  (GOutputStream       *stream,
+							    const GOutputVector *vectors,
+							    gint                 n_vectors,
+							    int                  io_priority,
+							    GCancellable        *cancellable,
+							    GAsyncReadyCallback  callback,
+							    gpointer             user_data);
+static gssize     g_local_file_output_stream_writev_finish (GOutputStream       *stream,
+							    GAsyncResult        *result,
+							    GError             **error);
+static void       g_local_file_output_stream_close_async  (GOutputStream       *stream,
+							   int                  io_priority,
+							   GCancellable        *cancellable,
+							   GAsyncReadyCallback  callback,
+							   gpointer             user_data);
+static gboolean   g_local_file_output_stream_close_finish (GOutputStream       *stream,
+							   GAsyncResult        *result,
+							   GError             **error);
+
 static void
 g_local_file_output_stream_finalize (GObject *object)
 {
@@ -126,6 +180,15 @@ g_local_file_output_stream_class_init (GLocalFileOutputStreamClass *klass)
 
   stream_class->write_fn = g_local_file_output_stream_write;
   stream_class->close_fn = g_local_file_output_stream_close;
+  stream_class->write_async = g_local_file_output_stream_write_async;
+  stream_class->write_finish = g_local_file_output_stream_write_finish;
+#ifdef HAVE_WRITEV
+  stream_class->writev_fn = g_local_file_output_stream_writev;
+#endif
+  stream_class->writev_async = g_local_file_output_stream_writev_async;
+  stream_class->writev_finish = g_local_file_output_stream_writev_finish;
+  stream_class->close_async = g_local_file_output_stream_close_async;
+  stream_class->close_finish = g_local_file_output_stream_close_finish;
   file_stream_class->query_info = g_local_file_output_stream_query_info;
   file_stream_class->get_etag = g_local_file_output_stream_get_etag;
   file_stream_class->tell = g_local_file_output_stream_tell;
@@ -179,6 +242,48 @@ g_local_file_output_stream_write (GOutputStream  *stream,
   return res;
 }
 
+#ifdef HAVE_WRITEV
+static gssize
+g_local_file_output_stream_writev (GOutputStream        *stream,
+				   const GOutputVector  *vectors,
+				   gint                  n_vectors,
+				   GCancellable         *cancellable,
+				   GError              **error)
+{
+  GLocalFileOutputStream *file;
+  gssize res;
+
+  file = G_LOCAL_FILE_OUTPUT_STREAM (stream);
+
+  /* The rest of the vectors are left for the next write */
+  n_vectors = MIN (n_vectors, IOV_MAX);
+
+  while (1)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	return -1;
+      /* GOutputVector has the layout of struct iovec */
+      res = writev (file->priv->fd, (const struct iovec *) vectors, n_vectors);
+      if (res == -1)
+	{
+          int errsv = errno;
+
+	  if (errsv == EINTR)
+	    continue;
+	  
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error writing to file: %s"),
+		       g_strerror (errsv));
+	}
+      
+      break;
+    }
+  
+  return res;
+}
+#endif
+
 static gboolean
 g_local_file_output_stream_close (GOutputStream  *stream,
 				  GCancellable   *cancellable,
@@ -475,6 +580,215 @@ g_local_file_output_stream_query_info (GFileOutputStream  *stream,
 					 error);
 }
 
+/* See g_local_file_input_stream_use_ring() */
+static gboolean
+g_local_file_output_stream_use_ring (GLocalFileOutputStream *file)
+{
+  if (file->priv->use_ring == 0)
+    file->priv->use_ring = _g_io_uring_can_use_fd (file->priv->fd) ? 1 : -1;
+
+  return file->priv->use_ring > 0;
+}
+
+static void
+write_async_done (gint     result,
+		  gpointer user_data)
+{
+  GSimpleAsyncResult *res = user_data;
+
+  if (result < 0)
+    g_simple_async_result_set_error (res, G_IO_ERROR,
+				     g_io_error_from_errno (-result),
+				     _("Error writing to file: %s"),
+				     g_strerror (-result));
+  else
+    g_simple_async_result_set_op_res_gssize (res, result);
+
+  g_simple_async_result_complete (res);
+  g_object_unref (res);
+}
+
+static void
+g_local_file_output_stream_write_async (GOutputStream       *stream,
+					const void          *buffer,
+					gsize                count,
+					int                  io_priority,
+					GCancellable        *cancellable,
+					GAsyncReadyCallback  callback,
+					gpointer             user_data)
+{
+  GLocalFileOutputStream *file = G_LOCAL_FILE_OUTPUT_STREAM (stream);
+  GSimpleAsyncResult *res;
+  GError *error = NULL;
+
+  if (g_local_file_output_stream_use_ring (file))
+    {
+      res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				       g_local_file_output_stream_write_async);
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+	{
+	  g_simple_async_result_set_from_error (res, error);
+	  g_error_free (error);
+	  g_simple_async_result_complete_in_idle (res);
+	  g_object_unref (res);
+	  return;
+	}
+
+      if (_g_io_uring_write (file->priv->fd, buffer, count, write_async_done, res))
+	return;
+
+      g_object_unref (res);
+    }
+
+  G_OUTPUT_STREAM_CLASS (g_local_file_output_stream_parent_class)->write_async (stream, buffer, count,
+										io_priority, cancellable,
+										callback, user_data);
+}
+
+static gssize
+g_local_file_output_stream_write_finish (GOutputStream  *stream,
+					 GAsyncResult   *result,
+					 GError        **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_get_source_tag (simple) != g_local_file_output_stream_write_async)
+    return G_OUTPUT_STREAM_CLASS (g_local_file_output_stream_parent_class)->write_finish (stream, result, error);
+
+  return g_simple_async_result_get_op_res_gssize (simple);
+}
+
+static void
+g_local_file_output_stream_writev_async (GOutputStream       *stream,
+					 const GOutputVector *vectors,
+					 gint                 n_vectors,
+					 int                  io_priority,
+					 GCancellable        *cancellable,
+					 GAsyncReadyCallback  callback,
+					 gpointer             user_data)
+{
+  GLocalFileOutputStream *file = G_LOCAL_FILE_OUTPUT_STREAM (stream);
+  GSimpleAsyncResult *res;
+  GError *error = NULL;
+
+  if (g_local_file_output_stream_use_ring (file))
+    {
+      res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				       g_local_file_output_stream_writev_async);
+
+      if (g_cancellable_set_error_if_cancelled (cancellable, &error))
+	{
+	  g_simple_async_result_set_from_error (res, error);
+	  g_error_free (error);
+	  g_simple_async_result_complete_in_idle (res);
+	  g_object_unref (res);
+	  return;
+	}
+
+      /* GOutputVector has the layout of struct iovec */
+      if (_g_io_uring_writev (file->priv->fd, (const struct iovec *) vectors,
+			      MIN (n_vectors, IOV_MAX), write_async_done, res))
+	return;
+
+      g_object_unref (res);
+    }
+
+  G_OUTPUT_STREAM_CLASS (g_local_file_output_stream_parent_class)->writev_async (stream, vectors, n_vectors,
+										 io_priority, cancellable,
+										 callback, user_data);
+}
+
+static gssize
+g_local_file_output_stream_writev_finish (GOutputStream  *stream,
+					  GAsyncResult   *result,
+					  GError        **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_get_source_tag (simple) != g_local_file_output_stream_writev_async)
+    return G_OUTPUT_STREAM_CLASS (g_local_file_output_stream_parent_class)->writev_finish (stream, result, error);
+
+  return g_simple_async_result_get_op_res_gssize (simple);
+}
+
+static void
+close_async_done (gint     result,
+		  gpointer user_data)
+{
+  GSimpleAsyncResult *res = user_data;
+
+  if (result < 0)
+    g_simple_async_result_set_error (res, G_IO_ERROR,
+				     g_io_error_from_errno (-result),
+				     _("Error closing file: %s"),
+				     g_strerror (-result));
+
+  g_simple_async_result_complete (res);
+  g_object_unref (res);
+}
+
+static void
+g_local_file_output_stream_close_async (GOutputStream       *stream,
+					int                  io_priority,
+					GCancellable        *cancellable,
+					GAsyncReadyCallback  callback,
+					gpointer             user_data)
+{
+#ifndef G_OS_WIN32
+  GLocalFileOutputStream *file = G_LOCAL_FILE_OUTPUT_STREAM (stream);
+  GSimpleAsyncResult *res;
+  GLocalFileStat final_stat;
+  char *etag = NULL;
+
+  /* Replacing a file means renaming files around when closing,
+   * leave that to a thread
+   */
+  if (file->priv->tmp_filename == NULL &&
+      g_local_file_output_stream_use_ring (file))
+    {
+      res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				       g_local_file_output_stream_close_async);
+
+      if (fstat (file->priv->fd, &final_stat) == 0)
+	etag = _g_local_file_info_create_etag (&final_stat);
+
+      if (_g_io_uring_close (file->priv->fd, close_async_done, res))
+	{
+	  file->priv->etag = etag;
+	  file->priv->fd = -1;
+	  return;
+	}
+
+      g_free (etag);
+      g_object_unref (res);
+    }
+#endif
+
+  G_OUTPUT_STREAM_CLASS (g_local_file_output_stream_parent_class)->close_async (stream, io_priority,
+										cancellable,
+										callback, user_data);
+}
+
+static gboolean
+g_local_file_output_stream_close_finish (GOutputStream  *stream,
+					 GAsyncResult   *result,
+					 GError        **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_get_source_tag (simple) != g_local_file_output_stream_close_async)
+    return G_OUTPUT_STREAM_CLASS (g_local_file_output_stream_parent_class)->close_finish (stream, result, error);
+
+  return TRUE;
+}
+
+int
+_g_local_file_output_stream_get_fd (GLocalFileOutputStream *stream)
+{
+  return stream->priv->fd;
+}
+
 GFileOutputStream *
 _g_local_file_output_stream_create  (const char        *filename,
 				     GFileCreateFlags   flags,
@@ -38,7 +38,8 @@
  *
  * GOutputStream has functions to write to a stream (g_output_stream_write()),
  * to close a stream (g_output_stream_close()) and to flush pending writes
- * (g_output_stream_flush()). 
+ * (g_output_stream_flush()). To write a message that is made up of
+ * several buffers, use g_output_stream_writev().
  *
  * To copy the content of an input stream to an output stream without 
  * manually handling the reads and writes, use g_output_stream_splice(). 
@@ -96,6 +97,21 @@ static void     g_output_stream_real_close_async   (GOutputStream             *s
 static gboolean g_output_stream_real_close_finish  (GOutputStream             *stream,
 						    GAsyncResult              *result,
 						    GError                   **error);
+static gssize   g_output_stream_real_writev        (GOutputStream             *stream,
+						    const GOutputVector       *vectors,
+						    gint                       n_vectors,
+						    GCancellable              *cancellable,
+						    GError                   **error);
+static void     g_output_stream_real_writev_async  (GOutputStream             *stream,
+						    const GOutputVector       *vectors,
+						    gint                       n_vectors,
+						    int                        io_priority,
+						    GCancellable              *cancellable,
+						    GAsyncReadyCallback        callback,
+						    gpointer                   user_data);
+static gssize   g_output_stream_real_writev_finish (GOutputStream             *stream,
+						    GAsyncResult              *result,
+						    GError                   **error);
 
 static void
 g_output_stream_finalize (GObject *object)
@@ -140,6 +156,9 @@ g_output_stream_class_init (GOutputStreamClass *klass)
   klass->flush_finish = g_output_stream_real_flush_finish;
   klass->close_async = g_output_stream_real_close_async;
   klass->close_finish = g_output_stream_real_close_finish;
+  klass->writev_fn = g_output_stream_real_writev;
+  klass->writev_async = g_output_stream_real_writev_async;
+  klass->writev_finish = g_output_stream_real_writev_finish;
 }
 
 static void
@@ -291,6 +310,154 @@ g_output_stream_write_all (GOutputStream  *stream,
   return TRUE;
 }
 
+/* Returns the total size of @vectors, or -1 if it doesn't fit a gssize */
+static gssize
+output_vectors_size (const GOutputVector *vectors,
+		     gint                 n_vectors)
+{
+  gsize total = 0;
+  gint i;
+
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (vectors[i].size > (gsize) G_MAXSSIZE - total)
+	return -1;
+      total += vectors[i].size;
+    }
+
+  return total;
+}
+
+/**
+ * g_output_stream_writev:
+ * @stream: a #GOutputStream.
+ * @vectors: an array of #GOutputVector<!-- -->s holding the data to write
+ * @n_vectors: the number of elements in @vectors
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @error: location to store the error occuring, or %NULL to ignore
+ *
+ * Tries to write the data of all the buffers in @vectors into the
+ * stream, one after the other. Will block during the operation.
+ *
+ * This works like g_output_stream_write() on the concatenation of
+ * the buffers, but without copying them together first. Streams that
+ * can do gather writes, such as local files and #GUnixOutputStream,
+ * write all the buffers with a single system call.
+ *
+ * If the vectors add up to zero bytes, returns zero and does nothing.
+ * A total size larger than %G_MAXSSIZE will cause a
+ * %G_IO_ERROR_INVALID_ARGUMENT error.
+ *
+ * On success, the number of bytes written to the stream is returned.
+ * It is not an error if this is less than the total size of @vectors,
+ * callers have to write the rest of the data again.
+ *
+ * If @cancellable is not NULL, then the operation can be cancelled by
+ * triggering the cancellable object from another thread. If the operation
+ * was cancelled, the error G_IO_ERROR_CANCELLED will be returned. If an
+ * operation was partially finished when the operation was cancelled the
+ * partial result will be returned, without an error.
+ *
+ * On error -1 is returned and @error is set accordingly.
+ *
+ * Return value: Number of bytes written, or -1 on error
+ *
+ * Since: 2.20
+ **/
+gssize
+g_output_stream_writev (GOutputStream        *stream,
+			const GOutputVector  *vectors,
+			gint                  n_vectors,
+			GCancellable         *cancellable,
+			GError              **error)
+{
+  GOutputStreamClass *class;
+  gssize size, res;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), -1);
+  g_return_val_if_fail (vectors != NULL || n_vectors == 0, -1);
+  g_return_val_if_fail (n_vectors >= 0, -1);
+
+  size = output_vectors_size (vectors, n_vectors);
+  if (size == 0)
+    return 0;
+
+  if (size < 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+		   _("Too large count value passed to %s"), G_STRFUNC);
+      return -1;
+    }
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  if (!g_output_stream_set_pending (stream, error))
+    return -1;
+
+  if (cancellable)
+    g_cancellable_push_current (cancellable);
+
+  res = class->writev_fn (stream, vectors, n_vectors, cancellable, error);
+
+  if (cancellable)
+    g_cancellable_pop_current (cancellable);
+
+  g_output_stream_clear_pending (stream);
+
+  return res;
+}
+
+static gssize
+g_output_stream_real_writev (GOutputStream        *stream,
+			     const GOutputVector  *vectors,
+			     gint                  n_vectors,
+			     GCancellable         *cancellable,
+			     GError              **error)
+{
+  GOutputStreamClass *class;
+  GError *my_error = NULL;
+  gssize res, total;
+  gint i;
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  if (class->write_fn == NULL)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                           _("Output stream doesn't implement write"));
+      return -1;
+    }
+
+  total = 0;
+  for (i = 0; i < n_vectors; i++)
+    {
+      if (vectors[i].size == 0)
+	continue;
+
+      res = class->write_fn (stream, vectors[i].buffer, vectors[i].size,
+			     cancellable, &my_error);
+      if (res == -1)
+	{
+	  /* Report what was written so far, the error will come up
+	   * again on the next write */
+	  if (total > 0)
+	    g_error_free (my_error);
+	  else
+	    {
+	      g_propagate_error (error, my_error);
+	      total = -1;
+	    }
+	  break;
+	}
+
+      total += res;
+      if (res < vectors[i].size)
+	break;
+    }
+
+  return total;
+}
+
 /**
  * g_output_stream_flush:
  * @stream: a #GOutputStream.
@@ -713,6 +880,127 @@ g_output_stream_write_finish (GOutputStream  *stream,
   return class->write_finish (stream, result, error);
 }
 
+/**
+ * g_output_stream_writev_async:
+ * @stream: A #GOutputStream.
+ * @vectors: an array of #GOutputVector<!-- -->s holding the data to write
+ * @n_vectors: the number of elements in @vectors
+ * @io_priority: the io priority of the request.
+ * @cancellable: optional #GCancellable object, %NULL to ignore.
+ * @callback: callback to call when the request is satisfied
+ * @user_data: the data to pass to callback function
+ *
+ * Request an asynchronous write of the data in @vectors into the
+ * stream. When the operation is finished @callback will be called.
+ * You can then call g_output_stream_writev_finish() to get the result
+ * of the operation.
+ *
+ * Both @vectors and the buffers must stay valid until @callback
+ * is called.
+ *
+ * This works like g_output_stream_write_async(), see
+ * g_output_stream_writev() for how the buffers are written.
+ *
+ * Since: 2.20
+ **/
+void
+g_output_stream_writev_async (GOutputStream       *stream,
+			      const GOutputVector *vectors,
+			      gint                 n_vectors,
+			      int                  io_priority,
+			      GCancellable        *cancellable,
+			      GAsyncReadyCallback  callback,
+			      gpointer             user_data)
+{
+  GOutputStreamClass *class;
+  GSimpleAsyncResult *simple;
+  GError *error = NULL;
+  gssize size;
+
+  g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+  g_return_if_fail (vectors != NULL || n_vectors == 0);
+  g_return_if_fail (n_vectors >= 0);
+
+  size = output_vectors_size (vectors, n_vectors);
+  if (size == 0)
+    {
+      simple = g_simple_async_result_new (G_OBJECT (stream),
+					  callback,
+					  user_data,
+					  g_output_stream_writev_async);
+      g_simple_async_result_complete_in_idle (simple);
+      g_object_unref (simple);
+      return;
+    }
+
+  if (size < 0)
+    {
+      g_simple_async_report_error_in_idle (G_OBJECT (stream),
+					   callback,
+					   user_data,
+					   G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+					   _("Too large count value passed to %s"),
+					   G_STRFUNC);
+      return;
+    }
+
+  if (!g_output_stream_set_pending (stream, &error))
+    {
+      g_simple_async_report_gerror_in_idle (G_OBJECT (stream),
+					    callback,
+					    user_data,
+					    error);
+      g_error_free (error);
+      return;
+    }
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  stream->priv->outstanding_callback = callback;
+  g_object_ref (stream);
+  class->writev_async (stream, vectors, n_vectors, io_priority, cancellable,
+		       async_ready_callback_wrapper, user_data);
+}
+
+/**
+ * g_output_stream_writev_finish:
+ * @stream: a #GOutputStream.
+ * @result: a #GAsyncResult.
+ * @error: a #GError location to store the error occuring, or %NULL to
+ * ignore.
+ *
+ * Finishes a vectored write started with g_output_stream_writev_async().
+ *
+ * Returns: a #gssize containing the number of bytes written to the stream.
+ *
+ * Since: 2.20
+ **/
+gssize
+g_output_stream_writev_finish (GOutputStream  *stream,
+			       GAsyncResult   *result,
+			       GError        **error)
+{
+  GSimpleAsyncResult *simple;
+  GOutputStreamClass *class;
+
+  g_return_val_if_fail (G_IS_OUTPUT_STREAM (stream), -1);
+  g_return_val_if_fail (G_IS_ASYNC_RESULT (result), -1);
+
+  if (G_IS_SIMPLE_ASYNC_RESULT (result))
+    {
+      simple = G_SIMPLE_ASYNC_RESULT (result);
+      if (g_simple_async_result_propagate_error (simple, error))
+	return -1;
+
+      /* Special case writes of 0 bytes */
+      if (g_simple_async_result_get_source_tag (simple) == g_output_stream_writev_async)
+	return 0;
+    }
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+  return class->writev_finish (stream, result, error);
+}
+
 typedef struct {
   GInputStream *source;
   gpointer user_data;
@@ -1345,5 +1633,168 @@ g_output_stream_real_close_finish (GOutputStream  *stream,
   return TRUE;
 }
 
+typedef struct {
+  const GOutputVector *vectors;
+  gint n_vectors;
+  gssize count_written;
+} WritevData;
+
+static void
+writev_async_thread (GSimpleAsyncResult *res,
+		     GObject            *object,
+		     GCancellable       *cancellable)
+{
+  WritevData *op;
+  GOutputStreamClass *class;
+  GError *error = NULL;
+
+  class = G_OUTPUT_STREAM_GET_CLASS (object);
+  op = g_simple_async_result_get_op_res_gpointer (res);
+  op->count_written = class->writev_fn (G_OUTPUT_STREAM (object),
+					op->vectors, op->n_vectors,
+					cancellable, &error);
+  if (op->count_written == -1)
+    {
+      g_simple_async_result_set_from_error (res, error);
+      g_error_free (error);
+    }
+}
+
+typedef struct {
+  GSimpleAsyncResult *res;
+  int io_prio;
+  GCancellable *cancellable;
+  gint current;
+} WritevFallbackAsyncData;
+
+static void
+writev_next_vector (GOutputStream           *stream,
+		    WritevFallbackAsyncData *data);
+
+static void
+writev_callback_wrapper (GObject      *source_object,
+			 GAsyncResult *result,
+			 gpointer      user_data)
+{
+  WritevFallbackAsyncData *data = user_data;
+  WritevData *op;
+  GError *error = NULL;
+  gssize ret;
+
+  op = g_simple_async_result_get_op_res_gpointer (data->res);
+  ret = g_output_stream_write_finish (G_OUTPUT_STREAM (source_object), result, &error);
+
+  if (ret == -1)
+    {
+      /* Report what was written so far, as the sync version does */
+      if (op->count_written == 0)
+	g_simple_async_result_set_from_error (data->res, error);
+      g_error_free (error);
+    }
+  else
+    {
+      op->count_written += ret;
+      if (ret == op->vectors[data->current].size)
+	{
+	  data->current++;
+	  writev_next_vector (G_OUTPUT_STREAM (source_object), data);
+	  return;
+	}
+    }
+
+  /* Complete immediately, not in idle, since we're already in a mainloop callout */
+  g_simple_async_result_complete (data->res);
+  g_object_unref (data->res);
+  g_free (data);
+}
+
+static void
+writev_next_vector (GOutputStream           *stream,
+		    WritevFallbackAsyncData *data)
+{
+  GOutputStreamClass *class;
+  WritevData *op;
+
+  op = g_simple_async_result_get_op_res_gpointer (data->res);
+
+  while (data->current < op->n_vectors &&
+	 op->vectors[data->current].size == 0)
+    data->current++;
+
+  if (data->current == op->n_vectors)
+    {
+      g_simple_async_result_complete (data->res);
+      g_object_unref (data->res);
+      g_free (data);
+      return;
+    }
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+  class->write_async (stream,
+		      op->vectors[data->current].buffer,
+		      op->vectors[data->current].size,
+		      data->io_prio, data->cancellable,
+		      writev_callback_wrapper, data);
+}
+
+static void
+g_output_stream_real_writev_async (GOutputStream       *stream,
+				   const GOutputVector *vectors,
+				   gint                 n_vectors,
+				   int                  io_priority,
+				   GCancellable        *cancellable,
+				   GAsyncReadyCallback  callback,
+				   gpointer             user_data)
+{
+  GOutputStreamClass *class;
+  GSimpleAsyncResult *res;
+  WritevFallbackAsyncData *data;
+  WritevData *op;
+
+  class = G_OUTPUT_STREAM_GET_CLASS (stream);
+
+  op = g_new0 (WritevData, 1);
+  res = g_simple_async_result_new (G_OBJECT (stream), callback, user_data,
+				   g_output_stream_real_writev_async);
+  g_simple_async_result_set_op_res_gpointer (res, op, g_free);
+  op->vectors = vectors;
+  op->n_vectors = n_vectors;
+
+  if (class->write_async == g_output_stream_real_write_async ||
+      class->writev_fn != g_output_stream_real_writev)
+    {
+      /* Write is thread-using async fallback, or there is a sync
+       * gather write. Use threads, so that we get to do the whole
+       * write in one go. */
+      g_simple_async_result_run_in_thread (res, writev_async_thread, io_priority, cancellable);
+      g_object_unref (res);
+    }
+  else
+    {
+      /* There is a custom async write function, lets write one
+       * vector at a time with that. */
+      data = g_new (WritevFallbackAsyncData, 1);
+      data->res = res;
+      data->io_prio = io_priority;
+      data->cancellable = cancellable;
+      data->current = 0;
+      writev_next_vector (stream, data);
+    }
+}
+
+static gssize
+g_output_stream_real_writev_finish (GOutputStream  *stream,
+				    GAsyncResult   *result,
+				    GError        **error)
+{
+  GSimpleAsyncResult *simple = G_SIMPLE_ASYNC_RESULT (result);
+  WritevData *op;
+
+  g_warn_if_fail (g_simple_async_result_get_source_tag (simple) ==
+		  g_output_stream_real_writev_async);
+  op = g_simple_async_result_get_op_res_gpointer (simple);
+  return op->count_written;
+}
+
 #define __G_OUTPUT_STREAM_C__
 #include "gioaliasdef.c"
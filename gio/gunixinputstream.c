@@ -28,6 +28,10 @@
 #include <errno.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <limits.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -40,6 +44,14 @@
 
 #include "gioalias.h"
 
+#ifndef IOV_MAX
+#ifdef UIO_MAXIOV
+#define IOV_MAX UIO_MAXIOV
+#else
+#define IOV_MAX 16
+#endif
+#endif
+
 /**
  * SECTION:gunixinputstream
  * @short_description: Streaming input operations for UNIX file descriptors
@@ -81,6 +93,13 @@ static gssize   g_unix_input_stream_read         (GInputStream         *stream,
 						  gsize                 count,
 						  GCancellable         *cancellable,
 						  GError              **error);
+#ifdef HAVE_READV
+static gssize   g_unix_input_stream_readv        (GInputStream         *stream,
+						  GInputVector         *vectors,
+						  gint                  n_vectors,
+						  GCancellable         *cancellable,
+						  GError              **error);
+#endif
 static gboolean g_unix_input_stream_close        (GInputStream         *stream,
 						  GCancellable         *cancellable,
 						  GError              **error);
@@ -136,6 +155,9 @@ g_unix_input_stream_class_init (GUnixInputStreamClass *klass)
   gobject_class->finalize = g_unix_input_stream_finalize;
 
   stream_class->read_fn = g_unix_input_stream_read;
+#ifdef HAVE_READV
+  stream_class->readv_fn = g_unix_input_stream_readv;
+#endif
   stream_class->close_fn = g_unix_input_stream_close;
   stream_class->read_async = g_unix_input_stream_read_async;
   stream_class->read_finish = g_unix_input_stream_read_finish;
@@ -385,6 +407,71 @@ g_unix_input_stream_read (GInputStream  *stream,
   return res;
 }
 
+#ifdef HAVE_READV
+static gssize
+g_unix_input_stream_readv (GInputStream  *stream,
+			   GInputVector  *vectors,
+			   gint           n_vectors,
+			   GCancellable  *cancellable,
+			   GError       **error)
+{
+  GUnixInputStream *unix_stream;
+  gssize res;
+  GPollFD poll_fds[2];
+  int poll_ret;
+
+  unix_stream = G_UNIX_INPUT_STREAM (stream);
+
+  if (cancellable)
+    {
+      poll_fds[0].fd = unix_stream->priv->fd;
+      poll_fds[0].events = G_IO_IN;
+      g_cancellable_make_pollfd (cancellable, &poll_fds[1]);
+      do
+	poll_ret = g_poll (poll_fds, 2, -1);
+      while (poll_ret == -1 && errno == EINTR);
+      
+      if (poll_ret == -1)
+	{
+          int errsv = errno;
+
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error reading from unix: %s"),
+		       g_strerror (errsv));
+	  return -1;
+	}
+    }
+
+  /* The rest of the vectors are left for the next read */
+  n_vectors = MIN (n_vectors, IOV_MAX);
+
+  while (1)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	return -1;
+      /* GInputVector has the layout of struct iovec */
+      res = readv (unix_stream->priv->fd, (struct iovec *) vectors, n_vectors);
+      if (res == -1)
+	{
+          int errsv = errno;
+
+	  if (errsv == EINTR)
+	    continue;
+	  
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error reading from unix: %s"),
+		       g_strerror (errsv));
+	}
+      
+      break;
+    }
+
+  return res;
+}
+#endif
+
 static gboolean
 g_unix_input_stream_close (GInputStream  *stream,
 			   GCancellable  *cancellable,
@@ -28,6 +28,10 @@
 #include <errno.h>
 #include <stdio.h>
 #include <fcntl.h>
+#include <limits.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #include <glib.h>
 #include <glib/gstdio.h>
@@ -40,6 +44,14 @@
 
 #include "gioalias.h"
 
+#ifndef IOV_MAX
+#ifdef UIO_MAXIOV
+#define IOV_MAX UIO_MAXIOV
+#else
+#define IOV_MAX 16
+#endif
+#endif
+
 /**
  * SECTION:gunixoutputstream
  * @short_description: Streaming output operations for Unix file descriptors
@@ -82,6 +94,13 @@ static gssize   g_unix_output_stream_write        (GOutputStream        *stream,
 						   gsize                 count,
 						   GCancellable         *cancellable,
 						   GError              **error);
+#ifdef HAVE_WRITEV
+static gssize   g_unix_output_stream_writev       (GOutputStream        *stream,
+						   const GOutputVector  *vectors,
+						   gint                  n_vectors,
+						   GCancellable         *cancellable,
+						   GError              **error);
+#endif
 static gboolean g_unix_output_stream_close        (GOutputStream        *stream,
 						   GCancellable         *cancellable,
 						   GError              **error);
@@ -128,6 +147,9 @@ g_unix_output_stream_class_init (GUnixOutputStreamClass *klass)
   gobject_class->finalize = g_unix_output_stream_finalize;
 
   stream_class->write_fn = g_unix_output_stream_write;
+#ifdef HAVE_WRITEV
+  stream_class->writev_fn = g_unix_output_stream_writev;
+#endif
   stream_class->close_fn = g_unix_output_stream_close;
   stream_class->write_async = g_unix_output_stream_write_async;
   stream_class->write_finish = g_unix_output_stream_write_finish;
@@ -372,6 +394,72 @@ g_unix_output_stream_write (GOutputStream  *stream,
   return res;
 }
 
+#ifdef HAVE_WRITEV
+static gssize
+g_unix_output_stream_writev (GOutputStream        *stream,
+			     const GOutputVector  *vectors,
+			     gint                  n_vectors,
+			     GCancellable         *cancellable,
+			     GError              **error)
+{
+  GUnixOutputStream *unix_stream;
+  gssize res;
+  GPollFD poll_fds[2];
+  int poll_ret;
+
+  unix_stream = G_UNIX_OUTPUT_STREAM (stream);
+
+  if (cancellable)
+    {
+      poll_fds[0].fd = unix_stream->priv->fd;
+      poll_fds[0].events = G_IO_OUT;
+      g_cancellable_make_pollfd (cancellable, &poll_fds[1]);
+      do
+	poll_ret = g_poll (poll_fds, 2, -1);
+      while (poll_ret == -1 && errno == EINTR);
+      
+      if (poll_ret == -1)
+	{
+          int errsv = errno;
+
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error writing to unix: %s"),
+		       g_strerror (errsv));
+	  return -1;
+	}
+    }
+
+  /* The rest of the vectors are left for the next write */
+  n_vectors = MIN (n_vectors, IOV_MAX);
+
+  while (1)
+    {
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+	return -1;
+
+      /* GOutputVector has the layout of struct iovec */
+      res = writev (unix_stream->priv->fd, (const struct iovec *) vectors, n_vectors);
+      if (res == -1)
+	{
+          int errsv = errno;
+
+	  if (errsv == EINTR)
+	    continue;
+	  
+	  g_set_error (error, G_IO_ERROR,
+		       g_io_error_from_errno (errsv),
+		       _("Error writing to unix: %s"),
+		       g_strerror (errsv));
+	}
+      
+      break;
+    }
+  
+  return res;
+}
+#endif
+
 static gboolean
 g_unix_output_stream_close (GOutputStream  *stream,
 			    GCancellable   *cancellable,
@@ -147,6 +147,12 @@ ih_event_callback (ik_event_t  *event,
   GFileMonitorEvent eflags;
   GFile* parent;
   GFile* child;
+
+  if (event->mask & IN_Q_OVERFLOW)
+    {
+      g_file_monitor_report_dropped (G_FILE_MONITOR (sub->user_data), 1);
+      return;
+    }
   
   eflags = ih_mask_to_EventFlags (event->mask);
   parent = g_file_new_for_path (sub->dirname);
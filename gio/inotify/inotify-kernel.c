@@ -50,6 +50,7 @@ static gboolean ik_process_eq_callback (gpointer user_data);
 
 static guint32 ik_move_matches = 0;
 static guint32 ik_move_misses = 0;
+static guint32 ik_overflows = 0;
 
 static gboolean process_eq_running = FALSE;
 
@@ -104,6 +105,26 @@ ik_source_timeout (gpointer data)
 #define AVERAGE_EVENT_SIZE sizeof (struct inotify_event) + 16
 #define TIMEOUT_MILLISECONDS 10
 
+/* The size of the kernel queue, read from /proc at startup */
+static unsigned int max_queued_events = MAX_QUEUED_EVENTS;
+
+static void
+ik_read_max_queued_events (void)
+{
+  gchar *contents;
+  guint64 value;
+
+  if (!g_file_get_contents ("/proc/sys/fs/inotify/max_queued_events",
+			    &contents, NULL, NULL))
+    return;
+
+  value = g_ascii_strtoull (contents, NULL, 10);
+  if (value > 0 && value <= G_MAXUINT)
+    max_queued_events = value;
+
+  g_free (contents);
+}
+
 static gboolean
 ik_source_check (GSource *source)
 {
@@ -126,7 +147,7 @@ ik_source_check (GSource *source)
       /* Don't wait if the number of pending events is too close
        * to the maximum queue size.
        */
-      if (pending > PENDING_THRESHOLD (MAX_QUEUED_EVENTS))
+      if (pending > PENDING_THRESHOLD (max_queued_events))
 	goto do_read;
       
       /* With each successive iteration, the minimum rate for
@@ -194,6 +215,8 @@ gboolean _ik_startup (void (*cb)(ik_event_t *event))
   if (inotify_instance_fd < 0)
     return FALSE;
 
+  ik_read_max_queued_events ();
+
   inotify_read_ioc = g_io_channel_unix_new (inotify_instance_fd);
   ik_poll_fd.fd = inotify_instance_fd;
   ik_poll_fd.events = G_IO_IN | G_IO_HUP | G_IO_ERR;
@@ -319,6 +342,13 @@ _ik_ignore (const char *path,
   return 0;
 }
 
+void
+_ik_overflow_stats (guint32 *overflows)
+{
+  if (overflows)
+    *overflows = ik_overflows;
+}
+
 void
 _ik_move_stats (guint32 *matches, 
                 guint32 *misses)
@@ -417,6 +447,7 @@ ik_read_events (gsize  *buffer_size_out,
 {
   static gchar *buffer = NULL;
   static gsize buffer_size;
+  unsigned int pending;
   
   /* Initialize the buffer on our first call */
   if (buffer == NULL)
@@ -426,10 +457,19 @@ ik_read_events (gsize  *buffer_size_out,
       buffer = g_malloc (buffer_size);
     }
 
+  /* Grow the buffer so that everything the kernel has queued is read
+   * at once; events left behind in the kernel make it more likely that
+   * the queue overflows before we come back.
+   */
+  if (ioctl (inotify_instance_fd, FIONREAD, &pending) != -1 &&
+      pending > buffer_size)
+    {
+      buffer_size = pending;
+      buffer = g_realloc (buffer, buffer_size);
+    }
+
   *buffer_size_out = 0;
   *buffer_out = NULL;
-  
-  memset (buffer, 0, buffer_size);
 
   if (g_io_channel_read_chars (inotify_read_ioc, (char *)buffer, buffer_size, buffer_size_out, NULL) != G_IO_STATUS_NORMAL) {
     /* error reading */
@@ -454,6 +494,8 @@ ik_read_callback (gpointer user_data)
       gsize event_size;
       event = (struct inotify_event *)&buffer[buffer_i];
       event_size = sizeof(struct inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW)
+	ik_overflows++;
       g_queue_push_tail (events_to_process, ik_event_internal_new (ik_event_new (&buffer[buffer_i])));
       buffer_i += event_size;
       events++;
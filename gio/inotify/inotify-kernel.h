@@ -49,6 +49,8 @@ int         _ik_ignore          (const char *path,
 /* The miss count will probably be enflated */
 void        _ik_move_stats     (guint32 *matches,
 				guint32 *misses);
+/* The number of times the kernel queue overflowed */
+void        _ik_overflow_stats (guint32 *overflows);
 const char *_ik_mask_to_string (guint32  mask);
 
 
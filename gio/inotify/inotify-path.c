@@ -383,12 +383,30 @@ ip_event_dispatch (GList      *dir_list,
     }
 }
 
+static void
+ip_overflow_sub (gpointer key,
+                 gpointer value,
+                 gpointer user_data)
+{
+  event_callback (user_data, key);
+}
+
 static void
 ip_event_callback (ik_event_t *event)
 {
   GList* dir_list = NULL;
   GList* pair_dir_list = NULL;
   
+  /* The kernel dropped events, and we can't tell whose, so
+   * every watching subscription gets to know.
+   */
+  if (event->mask & IN_Q_OVERFLOW)
+    {
+      g_hash_table_foreach (sub_dir_hash, ip_overflow_sub, event);
+      _ik_event_free (event);
+      return;
+    }
+
   dir_list = g_hash_table_lookup (wd_dir_hash, GINT_TO_POINTER (event->wd));
   
   /* We can ignore the IGNORED events */
@@ -45,6 +45,88 @@ test_read_byte (void)
   g_assert_cmpint (g_buffered_input_stream_read_byte (G_BUFFERED_INPUT_STREAM (in), NULL, NULL), ==, 'g');
 }
 
+static void
+test_borrow (void)
+{
+  GInputStream *base;
+  GInputStream *in;
+  GError *error = NULL;
+  const char *buffer;
+  gsize available;
+
+  base = g_memory_input_stream_new_from_data ("abcdefghijklmnopqrstuvwxyz", -1, NULL);
+  in = g_buffered_input_stream_new_sized (base, 4);
+
+  buffer = g_buffered_input_stream_borrow (G_BUFFERED_INPUT_STREAM (in), 2,
+                                           &available, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (available, >=, 2);
+  g_assert (strncmp (buffer, "ab", 2) == 0);
+  g_buffered_input_stream_consume (G_BUFFERED_INPUT_STREAM (in), 2);
+  g_assert_cmpint (g_buffered_input_stream_get_available (G_BUFFERED_INPUT_STREAM (in)), ==, available - 2);
+
+  /* Borrowing more than fits grows the buffer */
+  buffer = g_buffered_input_stream_borrow (G_BUFFERED_INPUT_STREAM (in), 10,
+                                           &available, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (available, >=, 10);
+  g_assert_cmpint (g_buffered_input_stream_get_buffer_size (G_BUFFERED_INPUT_STREAM (in)), >=, 10);
+  g_assert (strncmp (buffer, "cdefghijkl", 10) == 0);
+  g_buffered_input_stream_consume (G_BUFFERED_INPUT_STREAM (in), 10);
+
+  g_assert_cmpint (g_buffered_input_stream_read_byte (G_BUFFERED_INPUT_STREAM (in), NULL, NULL), ==, 'm');
+
+  /* At the end of the stream, less than asked for is returned */
+  buffer = g_buffered_input_stream_borrow (G_BUFFERED_INPUT_STREAM (in), 100,
+                                           &available, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (available, ==, 13);
+  g_assert (strncmp (buffer, "nopqrstuvwxyz", 13) == 0);
+  g_buffered_input_stream_consume (G_BUFFERED_INPUT_STREAM (in), available);
+
+  buffer = g_buffered_input_stream_borrow (G_BUFFERED_INPUT_STREAM (in), 1,
+                                           &available, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (buffer != NULL);
+  g_assert_cmpint (available, ==, 0);
+
+  g_object_unref (in);
+  g_object_unref (base);
+}
+
+static void
+test_adaptive_size (void)
+{
+  GInputStream *base;
+  GInputStream *in;
+  char *data;
+  char buffer[100];
+  gsize size;
+
+  size = 1024 * 1024;
+  data = g_malloc0 (size);
+  base = g_memory_input_stream_new_from_data (data, size, NULL);
+
+  /* A reader that keeps draining the buffer makes it grow */
+  in = g_buffered_input_stream_new (base);
+  g_assert_cmpint (g_buffered_input_stream_get_buffer_size (G_BUFFERED_INPUT_STREAM (in)), ==, 4096);
+  while (g_input_stream_read (in, buffer, sizeof (buffer), NULL, NULL) > 0)
+    ;
+  g_assert_cmpint (g_buffered_input_stream_get_buffer_size (G_BUFFERED_INPUT_STREAM (in)), >, 4096);
+  g_assert_cmpint (g_buffered_input_stream_get_buffer_size (G_BUFFERED_INPUT_STREAM (in)), <=, 256 * 1024);
+  g_object_unref (in);
+
+  /* An explicit size is kept */
+  g_seekable_seek (G_SEEKABLE (base), 0, G_SEEK_SET, NULL, NULL);
+  in = g_buffered_input_stream_new_sized (base, 512);
+  while (g_input_stream_read (in, buffer, sizeof (buffer), NULL, NULL) > 0)
+    ;
+  g_assert_cmpint (g_buffered_input_stream_get_buffer_size (G_BUFFERED_INPUT_STREAM (in)), ==, 512);
+  g_object_unref (in);
+
+  g_object_unref (base);
+  g_free (data);
+}
 
 int
 main (int   argc,
@@ -55,6 +137,8 @@ main (int   argc,
   g_test_bug_base ("http://bugzilla.gnome.org/");
 
   g_test_add_func ("/buffered-input-stream/read-byte", test_read_byte);
+  g_test_add_func ("/buffered-input-stream/borrow", test_borrow);
+  g_test_add_func ("/buffered-input-stream/adaptive-size", test_adaptive_size);
 
   return g_test_run();
 }
@@ -117,6 +117,111 @@ test_read_lines_CR_LF (void)
   test_read_lines (G_DATA_STREAM_NEWLINE_TYPE_CR_LF);
 }
 
+static void
+test_read_lines_any (void)
+{
+  GInputStream *stream;
+  GInputStream *base_stream;
+  GError *error = NULL;
+  const char *expected[] = { "a", "b", "", "c", "d", NULL, "e", "" };
+  char *long_line;
+  char *data;
+  gsize length;
+  int i;
+
+  long_line = g_strnfill (1000, 'x');
+  expected[5] = long_line;
+
+  base_stream = g_memory_input_stream_new ();
+  g_memory_input_stream_add_data (G_MEMORY_INPUT_STREAM (base_stream),
+                                  "a\rb\r\n\nc\nd\r", -1, NULL);
+  g_memory_input_stream_add_data (G_MEMORY_INPUT_STREAM (base_stream),
+                                  long_line, -1, NULL);
+  g_memory_input_stream_add_data (G_MEMORY_INPUT_STREAM (base_stream),
+                                  "\r\ne\r\r\n", -1, NULL);
+
+  /* A tiny buffer puts the line ends across buffer boundaries */
+  stream = G_INPUT_STREAM (g_data_input_stream_new (base_stream));
+  g_buffered_input_stream_set_buffer_size (G_BUFFERED_INPUT_STREAM (stream), 2);
+  g_data_input_stream_set_newline_type (G_DATA_INPUT_STREAM (stream),
+                                        G_DATA_STREAM_NEWLINE_TYPE_ANY);
+
+  for (i = 0; i < G_N_ELEMENTS (expected); i++)
+    {
+      data = g_data_input_stream_read_line (G_DATA_INPUT_STREAM (stream),
+                                            &length, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpstr (data, ==, expected[i]);
+      g_assert_cmpint (length, ==, strlen (expected[i]));
+      g_free (data);
+    }
+
+  data = g_data_input_stream_read_line (G_DATA_INPUT_STREAM (stream),
+                                        &length, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (data == NULL);
+  g_assert_cmpint (length, ==, 0);
+
+  g_object_unref (base_stream);
+  g_object_unref (stream);
+  g_free (long_line);
+}
+
+static void
+test_read_lines_utf8 (void)
+{
+  GInputStream *stream;
+  GInputStream *base_stream;
+  GError *error = NULL;
+  char *data;
+  gsize length;
+
+  base_stream = g_memory_input_stream_new ();
+  g_memory_input_stream_add_data (G_MEMORY_INPUT_STREAM (base_stream),
+                                  "gr\xc3\xbc\xc3\x9f\xe2\x82\xac\n"
+                                  "bad\xc3\n"
+                                  "\xf0\x9f\x98\x80\n"
+                                  "tail\xe2\x82", -1, NULL);
+
+  /* A tiny buffer cuts the multibyte characters in two */
+  stream = G_INPUT_STREAM (g_data_input_stream_new (base_stream));
+  g_buffered_input_stream_set_buffer_size (G_BUFFERED_INPUT_STREAM (stream), 2);
+
+  data = g_data_input_stream_read_line_utf8 (G_DATA_INPUT_STREAM (stream),
+                                             &length, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (data, ==, "gr\xc3\xbc\xc3\x9f\xe2\x82\xac");
+  g_assert_cmpint (length, ==, 9);
+  g_free (data);
+
+  /* An invalid line is skipped with an error */
+  data = g_data_input_stream_read_line_utf8 (G_DATA_INPUT_STREAM (stream),
+                                             &length, NULL, &error);
+  g_assert_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_ILLEGAL_SEQUENCE);
+  g_assert (data == NULL);
+  g_clear_error (&error);
+
+  data = g_data_input_stream_read_line_utf8 (G_DATA_INPUT_STREAM (stream),
+                                             &length, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpstr (data, ==, "\xf0\x9f\x98\x80");
+  g_free (data);
+
+  /* A character cut off by the end of the stream is invalid */
+  data = g_data_input_stream_read_line_utf8 (G_DATA_INPUT_STREAM (stream),
+                                             &length, NULL, &error);
+  g_assert_error (error, G_CONVERT_ERROR, G_CONVERT_ERROR_ILLEGAL_SEQUENCE);
+  g_assert (data == NULL);
+  g_clear_error (&error);
+
+  data = g_data_input_stream_read_line_utf8 (G_DATA_INPUT_STREAM (stream),
+                                             &length, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (data == NULL);
+
+  g_object_unref (base_stream);
+  g_object_unref (stream);
+}
 
 static void
 test_read_until (void)
@@ -323,6 +428,8 @@ main (int   argc,
   g_test_add_func ("/data-input-stream/read-lines-LF", test_read_lines_LF);
   g_test_add_func ("/data-input-stream/read-lines-CR", test_read_lines_CR);
   g_test_add_func ("/data-input-stream/read-lines-CR-LF", test_read_lines_CR_LF);
+  g_test_add_func ("/data-input-stream/read-lines-any", test_read_lines_any);
+  g_test_add_func ("/data-input-stream/read-lines-utf8", test_read_lines_utf8);
   g_test_add_func ("/data-input-stream/read-until", test_read_until);
   g_test_add_func ("/data-input-stream/read-int", test_read_int);
 
@@ -0,0 +1,262 @@
+/* GLib testing framework examples and tests
+ * Copyright (C) 2026 agent
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib/glib.h>
+#include <gio/gio.h>
+
+/* A monitor that only reports what the test feeds it */
+typedef GFileMonitor TestMonitor;
+typedef GFileMonitorClass TestMonitorClass;
+
+G_DEFINE_TYPE (TestMonitor, test_monitor, G_TYPE_FILE_MONITOR);
+
+static gboolean
+test_monitor_cancel (GFileMonitor *monitor)
+{
+  return TRUE;
+}
+
+static void
+test_monitor_class_init (TestMonitorClass *klass)
+{
+  klass->cancel = test_monitor_cancel;
+}
+
+static void
+test_monitor_init (TestMonitor *monitor)
+{
+}
+
+static GMainLoop *loop;
+
+typedef struct {
+  int n_batches;
+  GArray *batched;
+  GArray *changed;
+} Events;
+
+static void
+events_init (Events *events)
+{
+  events->n_batches = 0;
+  events->batched = g_array_new (FALSE, FALSE, sizeof (GFileMonitorEvent));
+  events->changed = g_array_new (FALSE, FALSE, sizeof (GFileMonitorEvent));
+}
+
+static void
+events_clear (Events *events)
+{
+  g_array_free (events->batched, TRUE);
+  g_array_free (events->changed, TRUE);
+}
+
+static void
+changes_cb (GFileMonitor             *monitor,
+	    const GFileMonitorChange *changes,
+	    guint                     n_changes,
+	    gpointer                  user_data)
+{
+  Events *events = user_data;
+  guint i;
+
+  events->n_batches++;
+  for (i = 0; i < n_changes; i++)
+    {
+      g_assert (G_IS_FILE (changes[i].file));
+      g_array_append_val (events->batched, changes[i].event_type);
+    }
+}
+
+static void
+changed_cb (GFileMonitor      *monitor,
+	    GFile             *file,
+	    GFile             *other_file,
+	    GFileMonitorEvent  event_type,
+	    gpointer           user_data)
+{
+  Events *events = user_data;
+
+  g_array_append_val (events->changed, event_type);
+}
+
+static gboolean
+quit_loop (gpointer data)
+{
+  g_main_loop_quit (loop);
+  return FALSE;
+}
+
+static void
+run_loop (int msecs)
+{
+  g_timeout_add (msecs, quit_loop, NULL);
+  g_main_loop_run (loop);
+}
+
+static void
+test_batch (void)
+{
+  static const GFileMonitorEvent expected[] = {
+    G_FILE_MONITOR_EVENT_CREATED,
+    G_FILE_MONITOR_EVENT_CHANGED,
+    G_FILE_MONITOR_EVENT_CHANGED,
+    G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT,
+    G_FILE_MONITOR_EVENT_CHANGED
+  };
+  GFileMonitor *monitor;
+  GFile *a, *a2, *b;
+  Events events;
+  guint n_coalesced, i;
+
+  monitor = g_object_new (test_monitor_get_type (), NULL);
+  g_file_monitor_set_rate_limit (monitor, 0);
+  g_file_monitor_set_batch_window (monitor, 50);
+
+  events_init (&events);
+  g_signal_connect (monitor, "changes", G_CALLBACK (changes_cb), &events);
+  g_signal_connect (monitor, "changed", G_CALLBACK (changed_cb), &events);
+
+  a = g_file_new_for_path ("/tmp/a");
+  a2 = g_file_new_for_path ("/tmp/a");
+  b = g_file_new_for_path ("/tmp/b");
+
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CREATED);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, a2, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, b, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+
+  /* Nothing is delivered before the window ends */
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (events.n_batches, ==, 0);
+
+  run_loop (200);
+
+  g_assert_cmpint (events.n_batches, ==, 1);
+  g_assert_cmpint (events.batched->len, ==, G_N_ELEMENTS (expected));
+  g_assert_cmpint (events.changed->len, ==, G_N_ELEMENTS (expected));
+  for (i = 0; i < G_N_ELEMENTS (expected); i++)
+    {
+      g_assert_cmpint (g_array_index (events.batched, GFileMonitorEvent, i), ==, expected[i]);
+      g_assert_cmpint (g_array_index (events.changed, GFileMonitorEvent, i), ==, expected[i]);
+    }
+
+  g_file_monitor_get_stats (monitor, &n_coalesced, NULL);
+  g_assert_cmpint (n_coalesced, ==, 2);
+
+  events_clear (&events);
+  g_object_unref (a);
+  g_object_unref (a2);
+  g_object_unref (b);
+  g_object_unref (monitor);
+}
+
+static void
+test_unbatched (void)
+{
+  GFileMonitor *monitor;
+  GFile *a;
+  Events events;
+  guint n_coalesced, n_dropped;
+
+  monitor = g_object_new (test_monitor_get_type (), NULL);
+
+  events_init (&events);
+  g_signal_connect (monitor, "changes", G_CALLBACK (changes_cb), &events);
+  g_signal_connect (monitor, "changed", G_CALLBACK (changed_cb), &events);
+
+  a = g_file_new_for_path ("/tmp/a");
+
+  /* The default rate limit holds back the second change and folds
+   * the third into it; the deletion flushes it, along with a virtual
+   * changes-done hint.
+   */
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CHANGED);
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_DELETED);
+  while (g_main_context_iteration (NULL, FALSE));
+
+  g_assert_cmpint (events.n_batches, ==, 0);
+  g_assert_cmpint (events.changed->len, ==, 4);
+  g_assert_cmpint (g_array_index (events.changed, GFileMonitorEvent, 3), ==,
+		   G_FILE_MONITOR_EVENT_DELETED);
+
+  g_file_monitor_report_dropped (monitor, 1);
+  g_file_monitor_report_dropped (monitor, 2);
+  g_file_monitor_get_stats (monitor, &n_coalesced, &n_dropped);
+  g_assert_cmpint (n_coalesced, ==, 1);
+  g_assert_cmpint (n_dropped, ==, 3);
+
+  events_clear (&events);
+  g_object_unref (a);
+  g_object_unref (monitor);
+}
+
+static void
+test_batch_window_change (void)
+{
+  GFileMonitor *monitor;
+  GFile *a;
+  Events events;
+  int window;
+
+  monitor = g_object_new (test_monitor_get_type (),
+			  "batch-window", 10000,
+			  NULL);
+  g_object_get (monitor, "batch-window", &window, NULL);
+  g_assert_cmpint (window, ==, 10000);
+
+  events_init (&events);
+  g_signal_connect (monitor, "changes", G_CALLBACK (changes_cb), &events);
+
+  a = g_file_new_for_path ("/tmp/a");
+  g_file_monitor_emit_event (monitor, a, NULL, G_FILE_MONITOR_EVENT_CREATED);
+
+  /* Turning batching off delivers what was collected right away */
+  g_file_monitor_set_batch_window (monitor, 0);
+  while (g_main_context_iteration (NULL, FALSE));
+
+  g_assert_cmpint (events.n_batches, ==, 1);
+  g_assert_cmpint (events.batched->len, ==, 1);
+
+  events_clear (&events);
+  g_object_unref (a);
+  g_object_unref (monitor);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  g_test_add_func ("/file-monitor/batch", test_batch);
+  g_test_add_func ("/file-monitor/unbatched", test_unbatched);
+  g_test_add_func ("/file-monitor/batch-window-change", test_batch_window_change);
+
+  return g_test_run ();
+}
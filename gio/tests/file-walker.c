@@ -0,0 +1,491 @@
+/* GLib testing framework examples and tests
+ * Copyright (C) 2026 agent
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib/glib.h>
+#include <glib/gstdio.h>
+#include <gio/gio.h>
+#include <string.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+#include <io.h>
+#endif
+
+#define N_FILES 30
+
+/* The number of entries make_tree() creates with a depth of 2 */
+#define N_ENTRIES (N_FILES * 7 + 6)
+
+static char *root_path;
+static GMainLoop *loop;
+
+typedef struct {
+  GHashTable *found;
+  GPtrArray *directories;
+  gboolean ok;
+  GError *error;
+} WalkData;
+
+/* Builds a tree with two subdirectories per level, named d<depth>
+ * and e<depth>, and some files in each directory, so that there is
+ * something to walk in parallel and some depth to it.
+ */
+static int
+make_tree (const char *path,
+	   int         depth)
+{
+  char *child;
+  char name[32];
+  int i, n;
+
+  n = 0;
+  for (i = 0; i < N_FILES; i++)
+    {
+      g_snprintf (name, sizeof (name), "file-%d", i);
+      child = g_build_filename (path, name, NULL);
+      g_assert (g_file_set_contents (child, name, -1, NULL));
+      g_free (child);
+      n++;
+    }
+
+  if (depth == 0)
+    return n;
+
+  for (i = 0; i < 2; i++)
+    {
+      g_snprintf (name, sizeof (name), "%c%d", "de"[i], depth);
+      child = g_build_filename (path, name, NULL);
+      g_assert (g_mkdir (child, 0700) == 0);
+      n += 1 + make_tree (child, depth - 1);
+      g_free (child);
+    }
+
+  return n;
+}
+
+static void
+remove_tree (GFile *file)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GFile *child;
+
+  enumerator = g_file_enumerate_children (file, G_FILE_ATTRIBUTE_STANDARD_NAME,
+					  G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+					  NULL, NULL);
+  if (enumerator != NULL)
+    {
+      while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL)) != NULL)
+	{
+	  child = g_file_get_child (file, g_file_info_get_name (info));
+	  remove_tree (child);
+	  g_object_unref (child);
+	  g_object_unref (info);
+	}
+      g_object_unref (enumerator);
+    }
+
+  g_file_delete (file, NULL, NULL);
+}
+
+static void
+got_batch (GFileWalker *walker,
+	   GFile       *directory,
+	   GList       *infos,
+	   gpointer     user_data)
+{
+  WalkData *data = user_data;
+  GList *l;
+  char *path;
+
+  g_assert (infos != NULL);
+  g_ptr_array_add (data->directories, g_file_get_path (directory));
+
+  for (l = infos; l != NULL; l = l->next)
+    {
+      g_assert (g_file_info_has_attribute (l->data, G_FILE_ATTRIBUTE_STANDARD_TYPE));
+      path = g_build_filename (g_ptr_array_index (data->directories,
+						  data->directories->len - 1),
+			       g_file_info_get_name (l->data), NULL);
+      g_assert (g_hash_table_lookup (data->found, path) == NULL);
+      g_hash_table_insert (data->found, path, path);
+    }
+}
+
+static void
+walk_done (GObject      *source,
+	   GAsyncResult *result,
+	   gpointer      user_data)
+{
+  WalkData *data = user_data;
+
+  data->ok = g_file_walker_walk_finish (G_FILE_WALKER (source), result,
+					&data->error);
+  g_main_loop_quit (loop);
+}
+
+static void
+walk_data_init (WalkData *data)
+{
+  data->found = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  data->directories = g_ptr_array_new ();
+  data->ok = FALSE;
+  data->error = NULL;
+}
+
+static void
+walk_data_clear (WalkData *data)
+{
+  g_hash_table_destroy (data->found);
+  g_ptr_array_foreach (data->directories, (GFunc)g_free, NULL);
+  g_ptr_array_free (data->directories, TRUE);
+  g_clear_error (&data->error);
+}
+
+static void
+walk (GFileWalker  *walker,
+      GCancellable *cancellable,
+      WalkData     *data)
+{
+  g_file_walker_walk_async (walker, G_PRIORITY_DEFAULT, cancellable,
+			    got_batch, data, walk_done, data);
+  g_main_loop_run (loop);
+}
+
+static void
+test_walk (void)
+{
+  GFileWalker *walker;
+  GFile *root;
+  WalkData data;
+
+  root = g_file_new_for_path (root_path);
+  walker = g_file_walker_new (root, G_FILE_ATTRIBUTE_STANDARD_SIZE, 0);
+
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert_no_error (data.error);
+  g_assert (data.ok);
+  g_assert_cmpint (g_hash_table_size (data.found), ==, N_ENTRIES);
+  walk_data_clear (&data);
+
+  /* The walker can be used again */
+  g_file_walker_set_max_jobs (walker, 1);
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert (data.ok);
+  g_assert_cmpint (g_hash_table_size (data.found), ==, N_ENTRIES);
+  walk_data_clear (&data);
+
+  g_object_unref (walker);
+  g_object_unref (root);
+}
+
+static gboolean
+is_parent_path (const char *parent,
+		const char *path)
+{
+  char *dir;
+  gboolean res;
+
+  dir = g_path_get_dirname (path);
+  res = strcmp (dir, parent) == 0;
+  g_free (dir);
+
+  return res;
+}
+
+static void
+test_ordered (void)
+{
+  GFileWalker *walker;
+  GFile *root;
+  WalkData data;
+  GPtrArray *stack;
+  const char *dir, *last;
+  int i;
+
+  root = g_file_new_for_path (root_path);
+  walker = g_file_walker_new (root, NULL, 0);
+  g_file_walker_set_ordered (walker, TRUE);
+  g_file_walker_set_max_jobs (walker, 16);
+
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert (data.ok);
+
+  /* The directories must come in depth-first order, each of them
+   * after its parent, and in one piece.
+   */
+  stack = g_ptr_array_new ();
+  last = NULL;
+  for (i = 0; i < data.directories->len; i++)
+    {
+      dir = g_ptr_array_index (data.directories, i);
+      if (last != NULL && strcmp (dir, last) == 0)
+	continue;
+      last = dir;
+
+      if (stack->len == 0)
+	g_assert_cmpstr (dir, ==, root_path);
+      else
+	{
+	  while (stack->len > 0 &&
+		 !is_parent_path (g_ptr_array_index (stack, stack->len - 1), dir))
+	    g_ptr_array_remove_index (stack, stack->len - 1);
+	  g_assert_cmpint (stack->len, >, 0);
+	}
+      g_ptr_array_add (stack, (gpointer) dir);
+    }
+  g_ptr_array_free (stack, TRUE);
+  g_assert_cmpint (g_hash_table_size (data.found), ==, N_ENTRIES);
+  walk_data_clear (&data);
+
+  g_object_unref (walker);
+  g_object_unref (root);
+}
+
+static gboolean
+skip_d_dirs (GFile     *directory,
+	     GFileInfo *info,
+	     gpointer   user_data)
+{
+  return g_file_info_get_name (info)[0] != 'd';
+}
+
+static void
+test_depth_and_filter (void)
+{
+  GFileWalker *walker;
+  GFile *root;
+  WalkData data;
+
+  root = g_file_new_for_path (root_path);
+  walker = g_file_walker_new (root, NULL, 0);
+
+  g_file_walker_set_max_depth (walker, 0);
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert (data.ok);
+  g_assert_cmpint (g_hash_table_size (data.found), ==, N_FILES + 2);
+  walk_data_clear (&data);
+
+  g_file_walker_set_max_depth (walker, -1);
+  g_file_walker_set_filter (walker, skip_d_dirs, NULL, NULL);
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert (data.ok);
+  /* e2, e2/file-*, e2/e1 and e2/e1/file-* */
+  g_assert_cmpint (g_hash_table_size (data.found), ==, N_FILES * 3 + 2);
+  walk_data_clear (&data);
+
+  g_object_unref (walker);
+  g_object_unref (root);
+}
+
+/* A directory that can't be read to the end: its enumerator returns
+ * two files, an error, one more file and another error.
+ */
+typedef struct {
+  GFileEnumerator parent_instance;
+  int n_calls;
+} FailingEnumerator;
+
+typedef GFileEnumeratorClass FailingEnumeratorClass;
+
+G_DEFINE_TYPE (FailingEnumerator, failing_enumerator, G_TYPE_FILE_ENUMERATOR);
+
+static GFileInfo *
+failing_enumerator_next_file (GFileEnumerator  *enumerator,
+			      GCancellable     *cancellable,
+			      GError          **error)
+{
+  FailingEnumerator *failing = (FailingEnumerator *) enumerator;
+  GFileInfo *info;
+  char name[32];
+  int n;
+
+  n = failing->n_calls++;
+  if (n == 2 || n == 4)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED,
+			   "Can't read the entry");
+      return NULL;
+    }
+  if (n > 4)
+    return NULL;
+
+  g_snprintf (name, sizeof (name), "file%d", n);
+  info = g_file_info_new ();
+  g_file_info_set_name (info, name);
+  g_file_info_set_file_type (info, G_FILE_TYPE_REGULAR);
+
+  return info;
+}
+
+static gboolean
+failing_enumerator_close (GFileEnumerator  *enumerator,
+			  GCancellable     *cancellable,
+			  GError          **error)
+{
+  return TRUE;
+}
+
+static void
+failing_enumerator_class_init (FailingEnumeratorClass *klass)
+{
+  klass->next_file = failing_enumerator_next_file;
+  klass->close_fn = failing_enumerator_close;
+}
+
+static void
+failing_enumerator_init (FailingEnumerator *enumerator)
+{
+}
+
+typedef GObject      FailingDir;
+typedef GObjectClass FailingDirClass;
+
+static void failing_dir_file_iface_init (GFileIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (FailingDir, failing_dir, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (G_TYPE_FILE,
+						failing_dir_file_iface_init));
+
+static char *
+failing_dir_get_path (GFile *file)
+{
+  return g_strdup ("/failing-dir");
+}
+
+static GFileEnumerator *
+failing_dir_enumerate_children (GFile                *file,
+				const char           *attributes,
+				GFileQueryInfoFlags   flags,
+				GCancellable         *cancellable,
+				GError              **error)
+{
+  return g_object_new (failing_enumerator_get_type (), "container", file, NULL);
+}
+
+static void
+failing_dir_file_iface_init (GFileIface *iface)
+{
+  iface->get_path = failing_dir_get_path;
+  iface->enumerate_children = failing_dir_enumerate_children;
+}
+
+static void
+failing_dir_class_init (FailingDirClass *klass)
+{
+}
+
+static void
+failing_dir_init (FailingDir *dir)
+{
+}
+
+static void
+test_errors (void)
+{
+  GFileWalker *walker;
+  GCancellable *cancellable;
+  GFile *root;
+  WalkData data;
+  char *path;
+
+  path = g_build_filename (root_path, "nonexistent", NULL);
+  root = g_file_new_for_path (path);
+  g_free (path);
+  walker = g_file_walker_new (root, NULL, 0);
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert (!data.ok);
+  g_assert_error (data.error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND);
+  walk_data_clear (&data);
+  g_object_unref (walker);
+  g_object_unref (root);
+
+  root = g_file_new_for_path (root_path);
+  walker = g_file_walker_new (root, NULL, 0);
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+  walk_data_init (&data);
+  walk (walker, cancellable, &data);
+  g_assert (!data.ok);
+  g_assert_error (data.error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_cmpint (g_hash_table_size (data.found), ==, 0);
+  walk_data_clear (&data);
+  g_object_unref (cancellable);
+  g_object_unref (walker);
+  g_object_unref (root);
+
+  /* Reading stops at the first error, after delivering what was read */
+  root = g_object_new (failing_dir_get_type (), NULL);
+  walker = g_file_walker_new (root, NULL, 0);
+  walk_data_init (&data);
+  walk (walker, NULL, &data);
+  g_assert (!data.ok);
+  g_assert_error (data.error, G_IO_ERROR, G_IO_ERROR_PERMISSION_DENIED);
+  g_assert_cmpint (g_hash_table_size (data.found), ==, 2);
+  g_assert (g_hash_table_lookup (data.found, "/failing-dir/file0") != NULL);
+  g_assert (g_hash_table_lookup (data.found, "/failing-dir/file1") != NULL);
+  walk_data_clear (&data);
+  g_object_unref (walker);
+  g_object_unref (root);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  GFile *root;
+  int fd, ret;
+
+  g_type_init ();
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  loop = g_main_loop_new (NULL, FALSE);
+
+  fd = g_file_open_tmp ("file-walker-XXXXXX", &root_path, NULL);
+  g_assert (fd != -1);
+  close (fd);
+  g_remove (root_path);
+  g_assert (g_mkdir (root_path, 0700) == 0);
+  make_tree (root_path, 2);
+
+  g_test_add_func ("/file-walker/walk", test_walk);
+  g_test_add_func ("/file-walker/ordered", test_ordered);
+  g_test_add_func ("/file-walker/depth-and-filter", test_depth_and_filter);
+  g_test_add_func ("/file-walker/errors", test_errors);
+
+  ret = g_test_run ();
+
+  root = g_file_new_for_path (root_path);
+  remove_tree (root);
+  g_object_unref (root);
+  g_free (root_path);
+  g_main_loop_unref (loop);
+
+  return ret;
+}
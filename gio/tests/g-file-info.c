@@ -112,6 +112,63 @@ test_g_file_info (void)
   g_object_unref (info_copy);
 }
 
+static void
+test_g_file_info_mask (void)
+{
+  GFileAttributeMatcher *matcher;
+  GFileInfo *info;
+  char **attr_list;
+  char name[32];
+  int i;
+
+  info = g_file_info_new ();
+  matcher = g_file_attribute_matcher_new ("standard::name,unix::*,test::*");
+  g_file_info_set_attribute_mask (info, matcher);
+  g_file_attribute_matcher_unref (matcher);
+
+  g_file_info_set_name (info, TEST_NAME);
+  g_file_info_set_file_type (info, G_FILE_TYPE_DIRECTORY);
+  g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE, 0755);
+  g_file_info_set_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID, 1000);
+  g_file_info_set_attribute_string (info, G_FILE_ATTRIBUTE_OWNER_USER, "user");
+
+  /*  More attributes than the mask would make room for */
+  for (i = 0; i < 20; i++)
+    {
+      g_snprintf (name, sizeof (name), "test::attribute-%d", i);
+      g_file_info_set_attribute_int32 (info, name, i);
+    }
+
+  g_assert_cmpstr (g_file_info_get_name (info), ==, TEST_NAME);
+  g_assert (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_TYPE));
+  g_assert (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_OWNER_USER));
+  g_assert_cmpint (g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_MODE), ==, 0755);
+  g_assert_cmpint (g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_UNIX_UID), ==, 1000);
+
+  for (i = 0; i < 20; i++)
+    {
+      g_snprintf (name, sizeof (name), "test::attribute-%d", i);
+      g_assert_cmpint (g_file_info_get_attribute_int32 (info, name), ==, i);
+    }
+
+  attr_list = g_file_info_list_attributes (info, "unix");
+  g_assert_cmpint (g_strv_length (attr_list), ==, 2);
+  g_assert (strcmp (attr_list[0], G_FILE_ATTRIBUTE_UNIX_MODE) == 0 ||
+	    strcmp (attr_list[1], G_FILE_ATTRIBUTE_UNIX_MODE) == 0);
+  g_strfreev (attr_list);
+
+  attr_list = g_file_info_list_attributes (info, "test");
+  g_assert_cmpint (g_strv_length (attr_list), ==, 20);
+  g_strfreev (attr_list);
+
+  g_file_info_unset_attribute_mask (info);
+  g_file_info_set_file_type (info, G_FILE_TYPE_REGULAR);
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_REGULAR);
+  g_assert_cmpint (g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_STANDARD_TYPE), ==, G_FILE_TYPE_REGULAR);
+
+  g_object_unref (info);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -120,6 +177,7 @@ main (int   argc,
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/g-file-info/test_g_file_info", test_g_file_info);
+  g_test_add_func ("/g-file-info/test_g_file_info_mask", test_g_file_info_mask);
   
   return g_test_run();
 }
@@ -21,9 +21,16 @@
  */
 
 #include <glib/glib.h>
+#include <glib/gstdio.h>
 #include <gio/gio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef G_OS_UNIX
+#include <unistd.h>
+#endif
+#ifdef G_OS_WIN32
+#include <io.h>
+#endif
 
 struct TestPathsWithOper {
   const char *path1;
@@ -502,6 +509,573 @@ test_g_file_get_parent_child (void)
     roundtrip_parent_child (paths[i].use_uri, paths[i].equal, paths[i].path1, paths[i].path2);
 }
 
+static void
+copy_progress (goffset  current_num_bytes,
+               goffset  total_num_bytes,
+               gpointer user_data)
+{
+  goffset *last = user_data;
+
+  g_assert_cmpint (current_num_bytes, >=, last[0]);
+  last[0] = current_num_bytes;
+  last[1] = total_num_bytes;
+}
+
+static void
+copy_and_compare (const char *source_path,
+                  const char *destination_path,
+                  GFileCopyFlags flags)
+{
+  GFile *source, *destination;
+  gchar *contents, *copied;
+  gsize length, copied_length;
+  goffset last[2] = { 0, 0 };
+  GError *error = NULL;
+  gboolean res;
+
+  source = g_file_new_for_path (source_path);
+  destination = g_file_new_for_path (destination_path);
+
+  res = g_file_copy (source, destination, flags, NULL,
+                     copy_progress, last, &error);
+  g_assert_no_error (error);
+  g_assert (res);
+
+  g_assert (g_file_get_contents (source_path, &contents, &length, NULL));
+  g_assert (g_file_get_contents (destination_path, &copied, &copied_length, NULL));
+  g_assert_cmpuint (copied_length, ==, length);
+  g_assert (memcmp (copied, contents, length) == 0);
+
+  /* the last callback has the full size */
+  g_assert_cmpint (last[0], ==, length);
+
+  g_free (contents);
+  g_free (copied);
+  g_object_unref (source);
+  g_object_unref (destination);
+}
+
+/*  Testing g_file_copy() between local files, which may happen in the kernel */
+static void
+test_g_file_copy (void)
+{
+  gchar *source_path, *destination_path, *data;
+  gsize length, i;
+  GFile *source, *destination;
+  GError *error = NULL;
+  int fd;
+
+  fd = g_file_open_tmp ("g-file-copy-XXXXXX", &source_path, NULL);
+  g_assert (fd != -1);
+  close (fd);
+  destination_path = g_strconcat (source_path, ".copy", NULL);
+
+  /* large enough for a few rounds of every way of copying */
+  length = 20 * 1024 * 1024 + 17;
+  data = g_malloc (length);
+  for (i = 0; i < length; i++)
+    data[i] = (i * 7 + i / 4096) & 0xff;
+  g_assert (g_file_set_contents (source_path, data, length, NULL));
+  g_free (data);
+
+  copy_and_compare (source_path, destination_path, G_FILE_COPY_NONE);
+
+  /* the destination exists now */
+  source = g_file_new_for_path (source_path);
+  destination = g_file_new_for_path (destination_path);
+  g_assert (!g_file_copy (source, destination, G_FILE_COPY_NONE, NULL, NULL, NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_EXISTS);
+  g_clear_error (&error);
+  g_object_unref (source);
+  g_object_unref (destination);
+
+  g_assert (g_file_set_contents (source_path, "short", -1, NULL));
+  copy_and_compare (source_path, destination_path, G_FILE_COPY_OVERWRITE);
+
+  g_assert (g_file_set_contents (source_path, "", 0, NULL));
+  copy_and_compare (source_path, destination_path, G_FILE_COPY_OVERWRITE);
+
+  /* files that claim to be empty, but aren't */
+  if (g_file_test ("/proc/self/stat", G_FILE_TEST_EXISTS))
+    {
+      GFile *proc;
+      gchar *copied;
+
+      proc = g_file_new_for_path ("/proc/self/stat");
+      destination = g_file_new_for_path (destination_path);
+      g_assert (g_file_copy (proc, destination, G_FILE_COPY_OVERWRITE, NULL, NULL, NULL, &error));
+      g_assert_no_error (error);
+      g_assert (g_file_get_contents (destination_path, &copied, &length, NULL));
+      g_assert_cmpuint (length, >, 0);
+      g_free (copied);
+      g_object_unref (proc);
+      g_object_unref (destination);
+    }
+
+  g_unlink (destination_path);
+  g_unlink (source_path);
+  g_free (destination_path);
+  g_free (source_path);
+}
+
+#define N_STREAMS 40
+#define N_CHUNKS  16
+#define CHUNK_SIZE 4096
+
+typedef struct {
+  GFile *file;
+  GInputStream *in;
+  GOutputStream *out;
+  guchar buffer[CHUNK_SIZE];
+  int chunk;
+} AsyncStreamData;
+
+static GMainLoop *async_loop;
+static int n_async_pending;
+
+static void
+fill_chunk (AsyncStreamData *data,
+            guchar          *buffer,
+            int              chunk)
+{
+  int i;
+
+  for (i = 0; i < CHUNK_SIZE; i++)
+    buffer[i] = (GPOINTER_TO_UINT (data) + chunk * 31 + i) & 0xff;
+}
+
+static void
+async_stream_done (void)
+{
+  if (--n_async_pending == 0)
+    g_main_loop_quit (async_loop);
+}
+
+static void
+in_closed (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  GError *error = NULL;
+
+  g_assert (g_input_stream_close_finish (G_INPUT_STREAM (source), result, &error));
+  g_assert_no_error (error);
+  async_stream_done ();
+}
+
+static void
+chunk_read (GObject      *source,
+            GAsyncResult *result,
+            gpointer      user_data)
+{
+  AsyncStreamData *data = user_data;
+  guchar expected[CHUNK_SIZE];
+  GError *error = NULL;
+  gssize n;
+
+  n = g_input_stream_read_finish (data->in, result, &error);
+  g_assert_no_error (error);
+
+  if (data->chunk == N_CHUNKS)
+    {
+      g_assert_cmpint (n, ==, 0);
+      g_input_stream_close_async (data->in, 0, NULL, in_closed, data);
+      return;
+    }
+
+  g_assert_cmpint (n, ==, CHUNK_SIZE);
+  fill_chunk (data, expected, data->chunk);
+  g_assert (memcmp (data->buffer, expected, CHUNK_SIZE) == 0);
+
+  data->chunk++;
+  g_input_stream_read_async (data->in, data->buffer, CHUNK_SIZE, 0, NULL,
+                             chunk_read, data);
+}
+
+static void
+chunk_skipped (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  AsyncStreamData *data = user_data;
+  GError *error = NULL;
+
+  g_assert_cmpint (g_input_stream_skip_finish (data->in, result, &error), ==, CHUNK_SIZE);
+  g_assert_no_error (error);
+
+  data->chunk = 1;
+  g_input_stream_read_async (data->in, data->buffer, CHUNK_SIZE, 0, NULL,
+                             chunk_read, data);
+}
+
+static void
+out_closed (GObject      *source,
+            GAsyncResult *result,
+            gpointer      user_data)
+{
+  AsyncStreamData *data = user_data;
+  GError *error = NULL;
+
+  g_assert (g_output_stream_close_finish (data->out, result, &error));
+  g_assert_no_error (error);
+  g_assert (g_file_output_stream_get_etag (G_FILE_OUTPUT_STREAM (data->out)) != NULL);
+
+  /* read it back, skipping the first chunk */
+  data->in = G_INPUT_STREAM (g_file_read (data->file, NULL, &error));
+  g_assert_no_error (error);
+  g_input_stream_skip_async (data->in, CHUNK_SIZE, 0, NULL, chunk_skipped, data);
+}
+
+static void
+chunk_written (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  AsyncStreamData *data = user_data;
+  GError *error = NULL;
+
+  g_assert_cmpint (g_output_stream_write_finish (data->out, result, &error), ==, CHUNK_SIZE);
+  g_assert_no_error (error);
+
+  if (++data->chunk == N_CHUNKS)
+    {
+      g_output_stream_close_async (data->out, 0, NULL, out_closed, data);
+      return;
+    }
+
+  fill_chunk (data, data->buffer, data->chunk);
+  g_output_stream_write_async (data->out, data->buffer, CHUNK_SIZE, 0, NULL,
+                               chunk_written, data);
+}
+
+/*  Testing asynchronous reads and writes of many local files at once  */
+static void
+test_g_file_async_streams (void)
+{
+  AsyncStreamData data[N_STREAMS];
+  GError *error = NULL;
+  char *path;
+  int i, fd;
+
+  async_loop = g_main_loop_new (NULL, FALSE);
+  n_async_pending = N_STREAMS;
+
+  for (i = 0; i < N_STREAMS; i++)
+    {
+      fd = g_file_open_tmp ("g-file-async-XXXXXX", &path, NULL);
+      g_assert (fd != -1);
+      close (fd);
+      data[i].file = g_file_new_for_path (path);
+      g_free (path);
+
+      /* replacing closes differently from creating */
+      if (i % 2)
+        data[i].out = G_OUTPUT_STREAM (g_file_replace (data[i].file, NULL, FALSE,
+                                                       G_FILE_CREATE_NONE, NULL, &error));
+      else
+        {
+          g_file_delete (data[i].file, NULL, NULL);
+          data[i].out = G_OUTPUT_STREAM (g_file_create (data[i].file, G_FILE_CREATE_NONE,
+                                                        NULL, &error));
+        }
+      g_assert_no_error (error);
+      data[i].in = NULL;
+      data[i].chunk = 0;
+
+      fill_chunk (&data[i], data[i].buffer, 0);
+      g_output_stream_write_async (data[i].out, data[i].buffer, CHUNK_SIZE, 0, NULL,
+                                   chunk_written, &data[i]);
+    }
+
+  g_main_loop_run (async_loop);
+
+  for (i = 0; i < N_STREAMS; i++)
+    {
+      g_file_delete (data[i].file, NULL, NULL);
+      g_object_unref (data[i].out);
+      g_object_unref (data[i].in);
+      g_object_unref (data[i].file);
+    }
+
+  g_main_loop_unref (async_loop);
+}
+
+static void
+vectored_written (GObject      *source,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  GError *error = NULL;
+
+  g_assert_cmpint (g_output_stream_writev_finish (G_OUTPUT_STREAM (source), result, &error), ==, 12);
+  g_assert_no_error (error);
+  g_main_loop_quit (user_data);
+}
+
+static void
+vectored_read (GObject      *source,
+               GAsyncResult *result,
+               gpointer      user_data)
+{
+  GError *error = NULL;
+
+  g_assert_cmpint (g_input_stream_readv_finish (G_INPUT_STREAM (source), result, &error), ==, 10);
+  g_assert_no_error (error);
+  g_main_loop_quit (user_data);
+}
+
+/*  Testing scatter reads and gather writes of local files  */
+static void
+test_g_file_vectored_io (void)
+{
+  GOutputVector out_vectors[3] = {
+    { "head", 4 }, { "", 0 }, { "body", 4 }
+  };
+  GInputVector in_vectors[2];
+  char buffer1[3], buffer2[32];
+  GFile *file;
+  GOutputStream *out;
+  GInputStream *in;
+  GMainLoop *loop;
+  GError *error = NULL;
+  char *path;
+  int fd;
+
+  fd = g_file_open_tmp ("g-file-vectored-XXXXXX", &path, NULL);
+  g_assert (fd != -1);
+  close (fd);
+  file = g_file_new_for_path (path);
+  g_free (path);
+  loop = g_main_loop_new (NULL, FALSE);
+
+  out = G_OUTPUT_STREAM (g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, &error));
+  g_assert_no_error (error);
+  g_assert_cmpint (g_output_stream_writev (out, out_vectors, 3, NULL, &error), ==, 8);
+  g_assert_no_error (error);
+
+  out_vectors[1].buffer = "tail";
+  out_vectors[1].size = 4;
+  g_output_stream_writev_async (out, out_vectors, 3, 0, NULL, vectored_written, loop);
+  g_main_loop_run (loop);
+  g_assert (g_output_stream_close (out, NULL, &error));
+  g_assert_no_error (error);
+  g_object_unref (out);
+
+  in = G_INPUT_STREAM (g_file_read (file, NULL, &error));
+  g_assert_no_error (error);
+
+  in_vectors[0].buffer = buffer1;
+  in_vectors[0].size = sizeof (buffer1);
+  in_vectors[1].buffer = buffer2;
+  in_vectors[1].size = 7;
+  g_assert_cmpint (g_input_stream_readv (in, in_vectors, 2, NULL, &error), ==, 10);
+  g_assert_no_error (error);
+  g_assert (memcmp (buffer1, "hea", 3) == 0);
+  g_assert (memcmp (buffer2, "dbodyhe", 7) == 0);
+
+  in_vectors[1].size = sizeof (buffer2);
+  g_input_stream_readv_async (in, in_vectors, 2, 0, NULL, vectored_read, loop);
+  g_main_loop_run (loop);
+  g_assert (memcmp (buffer1, "adt", 3) == 0);
+  g_assert (memcmp (buffer2, "ailbody", 7) == 0);
+
+  g_assert (g_input_stream_close (in, NULL, &error));
+  g_assert_no_error (error);
+  g_object_unref (in);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+  g_main_loop_unref (loop);
+}
+
+static void
+test_g_file_read_mapped (void)
+{
+  GFile *file;
+  GFileInputStream *in;
+  GFileInfo *info;
+  GError *error = NULL;
+  const char *borrowed;
+  char buffer[16];
+  gsize available;
+  char *path;
+  int fd;
+
+  fd = g_file_open_tmp ("g-file-mapped-XXXXXX", &path, NULL);
+  g_assert (fd != -1);
+  close (fd);
+  g_assert (g_file_set_contents (path, "0123456789abcdef", 16, NULL));
+  file = g_file_new_for_path (path);
+  g_free (path);
+
+  /* A plain stream can't lend its contents */
+  in = g_file_read (file, NULL, &error);
+  g_assert_no_error (error);
+  g_assert (g_file_input_stream_borrow (in, 4, &available) == NULL);
+  g_assert_cmpint (available, ==, 0);
+  g_object_unref (in);
+
+  in = g_file_read_mapped (file, NULL, &error);
+  g_assert_no_error (error);
+
+  g_assert_cmpint (g_input_stream_read (G_INPUT_STREAM (in), buffer, 4, NULL, &error), ==, 4);
+  g_assert_no_error (error);
+  g_assert (memcmp (buffer, "0123", 4) == 0);
+  g_assert_cmpint (g_seekable_tell (G_SEEKABLE (in)), ==, 4);
+
+  borrowed = g_file_input_stream_borrow (in, 4, &available);
+  g_assert (borrowed != NULL);
+  g_assert_cmpint (available, ==, 4);
+  g_assert (memcmp (borrowed, "4567", 4) == 0);
+  g_assert_cmpint (g_input_stream_skip (G_INPUT_STREAM (in), 4, NULL, &error), ==, 4);
+  g_assert_no_error (error);
+
+  g_assert (g_seekable_seek (G_SEEKABLE (in), -2, G_SEEK_END, NULL, &error));
+  g_assert_no_error (error);
+  borrowed = g_file_input_stream_borrow (in, 100, &available);
+  g_assert_cmpint (available, ==, 2);
+  g_assert (memcmp (borrowed, "ef", 2) == 0);
+
+  g_assert (g_seekable_seek (G_SEEKABLE (in), 10, G_SEEK_CUR, NULL, &error));
+  g_assert_cmpint (g_input_stream_read (G_INPUT_STREAM (in), buffer, 4, NULL, &error), ==, 0);
+  g_assert (!g_seekable_seek (G_SEEKABLE (in), -100, G_SEEK_CUR, NULL, &error));
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT);
+  g_clear_error (&error);
+
+  g_assert (g_seekable_seek (G_SEEKABLE (in), 8, G_SEEK_SET, NULL, &error));
+  g_assert_cmpint (g_input_stream_read (G_INPUT_STREAM (in), buffer, sizeof (buffer), NULL, &error), ==, 8);
+  g_assert (memcmp (buffer, "89abcdef", 8) == 0);
+
+  info = g_file_input_stream_query_info (in, G_FILE_ATTRIBUTE_STANDARD_SIZE, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (g_file_info_get_size (info), ==, 16);
+  g_object_unref (info);
+
+  g_assert (g_input_stream_close (G_INPUT_STREAM (in), NULL, &error));
+  g_assert_no_error (error);
+  g_assert (g_file_input_stream_borrow (in, 4, &available) == NULL);
+  g_object_unref (in);
+
+  g_file_delete (file, NULL, NULL);
+  g_object_unref (file);
+}
+
+static GHashTable *
+enumerate_to_table (GFile               *dir,
+		    const char          *attributes,
+		    GFileQueryInfoFlags  flags)
+{
+  GFileEnumerator *enumerator;
+  GFileInfo *info;
+  GHashTable *infos;
+  GError *error = NULL;
+
+  infos = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+
+  enumerator = g_file_enumerate_children (dir, attributes, flags, NULL, &error);
+  g_assert_no_error (error);
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, &error)) != NULL)
+    g_hash_table_insert (infos, g_strdup (g_file_info_get_name (info)), info);
+  g_assert_no_error (error);
+  g_object_unref (enumerator);
+
+  return infos;
+}
+
+static void
+test_g_file_enumerate_types (void)
+{
+  const char *names[] = { "file", "dir", ".hidden", "backup~", "link", "dangling" };
+  GHashTable *infos;
+  GFileInfo *info;
+  GFile *dir;
+  char *path, *child;
+  int fd, i;
+
+  fd = g_file_open_tmp ("g-file-enumerate-XXXXXX", &path, NULL);
+  g_assert (fd != -1);
+  close (fd);
+  g_remove (path);
+  g_assert (g_mkdir (path, 0700) == 0);
+  dir = g_file_new_for_path (path);
+
+  child = g_build_filename (path, "file", NULL);
+  g_assert (g_file_set_contents (child, "12345", 5, NULL));
+  g_free (child);
+  child = g_build_filename (path, "dir", NULL);
+  g_assert (g_mkdir (child, 0700) == 0);
+  g_free (child);
+  child = g_build_filename (path, ".hidden", NULL);
+  g_assert (g_file_set_contents (child, "", 0, NULL));
+  g_free (child);
+  child = g_build_filename (path, "backup~", NULL);
+  g_assert (g_file_set_contents (child, "", 0, NULL));
+  g_free (child);
+#ifdef G_OS_UNIX
+  child = g_build_filename (path, "link", NULL);
+  g_assert (symlink ("file", child) == 0);
+  g_free (child);
+  child = g_build_filename (path, "dangling", NULL);
+  g_assert (symlink ("nonexistent", child) == 0);
+  g_free (child);
+#endif
+
+  /* Names and types only, which need no stat of regular entries */
+  infos = enumerate_to_table (dir, "standard::name,standard::type,"
+			      "standard::is-hidden,standard::is-backup,"
+			      "standard::is-symlink", 0);
+  info = g_hash_table_lookup (infos, "file");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_REGULAR);
+  g_assert (!g_file_info_get_is_hidden (info));
+  g_assert (!g_file_info_get_is_symlink (info));
+  g_assert (!g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_SIZE));
+  info = g_hash_table_lookup (infos, "dir");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_DIRECTORY);
+  info = g_hash_table_lookup (infos, ".hidden");
+  g_assert (g_file_info_get_is_hidden (info));
+  info = g_hash_table_lookup (infos, "backup~");
+  g_assert (g_file_info_get_is_backup (info));
+#ifdef G_OS_UNIX
+  info = g_hash_table_lookup (infos, "link");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_REGULAR);
+  g_assert (g_file_info_get_is_symlink (info));
+  info = g_hash_table_lookup (infos, "dangling");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_SYMBOLIC_LINK);
+  g_assert (g_file_info_get_is_symlink (info));
+#endif
+  g_hash_table_destroy (infos);
+
+#ifdef G_OS_UNIX
+  infos = enumerate_to_table (dir, "standard::name,standard::type",
+			      G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS);
+  info = g_hash_table_lookup (infos, "link");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_SYMBOLIC_LINK);
+  g_hash_table_destroy (infos);
+#endif
+
+  /* Anything else needs the files to be stated */
+  infos = enumerate_to_table (dir, "standard::name,standard::type,standard::size", 0);
+  info = g_hash_table_lookup (infos, "file");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_REGULAR);
+  g_assert_cmpint (g_file_info_get_size (info), ==, 5);
+#ifdef G_OS_UNIX
+  info = g_hash_table_lookup (infos, "link");
+  g_assert_cmpint (g_file_info_get_file_type (info), ==, G_FILE_TYPE_REGULAR);
+  g_assert_cmpint (g_file_info_get_size (info), ==, 5);
+#endif
+  g_hash_table_destroy (infos);
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    {
+      child = g_build_filename (path, names[i], NULL);
+      g_remove (child);
+      g_free (child);
+    }
+  g_rmdir (path);
+  g_free (path);
+  g_object_unref (dir);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -533,6 +1107,21 @@ main (int   argc,
   
   /*  Testing g_file_get_parent() and g_file_get_child()            */
   g_test_add_func ("/g-file/test_g_file_get_parent_child", test_g_file_get_parent_child);
+
+  /*  Testing g_file_copy() of local files, with progress  */
+  g_test_add_func ("/g-file/test_g_file_copy", test_g_file_copy);
+
+  /*  Testing asynchronous reads and writes of many local files at once  */
+  g_test_add_func ("/g-file/test_g_file_async_streams", test_g_file_async_streams);
+
+  /*  Testing scatter reads and gather writes of local files  */
+  g_test_add_func ("/g-file/test_g_file_vectored_io", test_g_file_vectored_io);
+
+  /*  Testing reading through a memory mapping with g_file_read_mapped() */
+  g_test_add_func ("/g-file/test_g_file_read_mapped", test_g_file_read_mapped);
+
+  /*  Testing enumeration of the types of directory entries  */
+  g_test_add_func ("/g-file/test_g_file_enumerate_types", test_g_file_enumerate_types);
   
   return g_test_run();
 }
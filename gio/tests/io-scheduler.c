@@ -0,0 +1,195 @@
+/* GLib testing framework examples and tests
+ * Copyright (C) 2026 agent
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib/glib.h>
+#include <gio/gio.h>
+
+static GMutex *mutex;
+static GCond *cond;
+static gboolean released;
+static gint n_done;
+
+static gboolean
+blocking_job (GIOSchedulerJob *job,
+              GCancellable    *cancellable,
+              gpointer         user_data)
+{
+  g_mutex_lock (mutex);
+  while (!released)
+    g_cond_wait (cond, mutex);
+  n_done++;
+  g_cond_broadcast (cond);
+  g_mutex_unlock (mutex);
+
+  return FALSE;
+}
+
+static gboolean
+quick_job (GIOSchedulerJob *job,
+           GCancellable    *cancellable,
+           gpointer         user_data)
+{
+  g_mutex_lock (mutex);
+  n_done++;
+  g_cond_broadcast (cond);
+  g_mutex_unlock (mutex);
+
+  return FALSE;
+}
+
+static void
+wait_for_jobs (gint n)
+{
+  GTimeVal timeout;
+
+  g_get_current_time (&timeout);
+  g_time_val_add (&timeout, 10 * G_USEC_PER_SEC);
+
+  g_mutex_lock (mutex);
+  while (n_done < n)
+    g_assert (g_cond_timed_wait (cond, mutex, &timeout));
+  g_mutex_unlock (mutex);
+}
+
+static void
+wait_for_completed (GIOSchedulerLane lane,
+                    guint64          n)
+{
+  GIOSchedulerStats stats;
+  gint i;
+
+  for (i = 0; i < 1000; i++)
+    {
+      g_io_scheduler_get_stats (lane, &stats);
+      if (stats.n_completed >= n)
+        return;
+      g_usleep (10 * 1000);
+    }
+
+  g_assert_not_reached ();
+}
+
+static guint64
+histogram_total (const guint64 *histogram)
+{
+  guint64 total = 0;
+  gint i;
+
+  for (i = 0; i < G_IO_SCHEDULER_N_LATENCY_BUCKETS; i++)
+    total += histogram[i];
+
+  return total;
+}
+
+static void
+test_lanes (void)
+{
+  GIOSchedulerStats stats, before_low, before_high;
+  gint n_blocking, i;
+
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_LOW, &before_low);
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_HIGH, &before_high);
+  g_assert_cmpuint (before_low.max_threads, >, 0);
+  g_assert_cmpuint (before_high.max_threads, >=, before_low.max_threads);
+
+  /* Fill the low priority lane with more jobs than it has threads */
+  released = FALSE;
+  n_done = 0;
+  n_blocking = 2 * before_low.max_threads;
+  for (i = 0; i < n_blocking; i++)
+    g_io_scheduler_push_job (blocking_job, NULL, NULL,
+                             G_PRIORITY_LOW, NULL);
+
+  /* Jobs of a higher priority still get to run */
+  g_io_scheduler_push_job (quick_job, NULL, NULL, G_PRIORITY_HIGH, NULL);
+  g_io_scheduler_push_job (quick_job, NULL, NULL, G_PRIORITY_DEFAULT, NULL);
+  wait_for_jobs (2);
+
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_LOW, &stats);
+  g_assert_cmpuint (stats.n_queued + stats.n_running, >=,
+                    n_blocking - stats.max_threads);
+  g_assert_cmpuint (stats.n_queued, >, 0);
+  g_assert_cmpuint (stats.n_threads, <=, stats.max_threads);
+  g_assert_cmpuint (stats.n_completed, ==, before_low.n_completed);
+
+  g_mutex_lock (mutex);
+  released = TRUE;
+  g_cond_broadcast (cond);
+  g_mutex_unlock (mutex);
+  wait_for_jobs (n_blocking + 2);
+
+  wait_for_completed (G_IO_SCHEDULER_LANE_LOW,
+                      before_low.n_completed + n_blocking);
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_LOW, &stats);
+  g_assert_cmpuint (stats.n_completed, ==,
+                    before_low.n_completed + n_blocking);
+  g_assert_cmpuint (stats.n_queued, ==, 0);
+  g_assert_cmpuint (histogram_total (stats.run_histogram), ==,
+                    stats.n_completed);
+  g_assert_cmpuint (histogram_total (stats.wait_histogram), ==,
+                    stats.n_completed);
+  g_assert_cmpuint (stats.busy_time, >=, before_low.busy_time);
+
+  wait_for_completed (G_IO_SCHEDULER_LANE_HIGH,
+                      before_high.n_completed + 1);
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_HIGH, &stats);
+  g_assert_cmpuint (stats.n_completed, ==, before_high.n_completed + 1);
+}
+
+static void
+test_many_jobs (void)
+{
+  GIOSchedulerStats before, stats;
+  gint i;
+
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_DEFAULT, &before);
+
+  n_done = 0;
+  for (i = 0; i < 1000; i++)
+    g_io_scheduler_push_job (quick_job, NULL, NULL,
+                             G_PRIORITY_DEFAULT + i % 10, NULL);
+  wait_for_jobs (1000);
+
+  wait_for_completed (G_IO_SCHEDULER_LANE_DEFAULT, before.n_completed + 1000);
+  g_io_scheduler_get_stats (G_IO_SCHEDULER_LANE_DEFAULT, &stats);
+  g_assert_cmpuint (stats.n_completed, ==, before.n_completed + 1000);
+  g_assert_cmpuint (stats.n_running, ==, 0);
+  g_assert_cmpuint (stats.max_threads, >, 0);
+  g_assert_cmpuint (histogram_total (stats.run_histogram), ==,
+                    stats.n_completed);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_type_init ();
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  mutex = g_mutex_new ();
+  cond = g_cond_new ();
+
+  g_test_add_func ("/io-scheduler/lanes", test_lanes);
+  g_test_add_func ("/io-scheduler/many-jobs", test_many_jobs);
+
+  return g_test_run ();
+}
@@ -65,6 +65,81 @@ test_read_chunks (void)
     }
 }
 
+static void
+readv_done (GObject      *source,
+            GAsyncResult *result,
+            gpointer      user_data)
+{
+  GMainLoop *loop = user_data;
+  GError *error = NULL;
+  gssize n;
+
+  n = g_input_stream_readv_finish (G_INPUT_STREAM (source), result, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 26);
+  g_main_loop_quit (loop);
+}
+
+static void
+test_readv (void)
+{
+  const char *data1 = "abcdefghijklmnopqrstuvwxyz";
+  const char *data2 = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  char buffer1[10], buffer2[20], buffer3[30];
+  GInputVector vectors[4];
+  GError *error = NULL;
+  GInputStream *stream;
+  GMainLoop *loop;
+  gssize n;
+
+  stream = g_memory_input_stream_new ();
+  g_memory_input_stream_add_data (G_MEMORY_INPUT_STREAM (stream),
+                                  data1, -1, NULL);
+  g_memory_input_stream_add_data (G_MEMORY_INPUT_STREAM (stream),
+                                  data2, -1, NULL);
+
+  vectors[0].buffer = buffer1;
+  vectors[0].size = sizeof (buffer1);
+  vectors[1].buffer = NULL;
+  vectors[1].size = 0;
+  vectors[2].buffer = buffer2;
+  vectors[2].size = sizeof (buffer2);
+  vectors[3].buffer = buffer3;
+  vectors[3].size = sizeof (buffer3);
+
+  /* the buffers are filled in order, and reading stops at the
+   * end of the stream */
+  n = g_input_stream_readv (stream, vectors, 4, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 52);
+  g_assert (strncmp (buffer1, "abcdefghij", 10) == 0);
+  g_assert (strncmp (buffer2, "klmnopqrstuvwxyzABCD", 20) == 0);
+  g_assert (strncmp (buffer3, "EFGHIJKLMNOPQRSTUVWXYZ", 22) == 0);
+
+  n = g_input_stream_readv (stream, vectors, 4, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 0);
+
+  n = g_input_stream_readv (stream, vectors, 0, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 0);
+
+  g_seekable_seek (G_SEEKABLE (stream), 26, G_SEEK_SET, NULL, &error);
+  g_assert_no_error (error);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  memset (buffer2, 0, sizeof (buffer2));
+  memset (buffer3, 0, sizeof (buffer3));
+  g_input_stream_readv_async (stream, vectors + 1, 3, G_PRIORITY_DEFAULT,
+                              NULL, readv_done, loop);
+  g_main_loop_run (loop);
+  g_assert (strncmp (buffer2, data2, 20) == 0);
+  g_assert (strncmp (buffer3, data2 + 20, 6) == 0);
+
+  g_main_loop_unref (loop);
+  g_object_unref (stream);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -73,6 +148,7 @@ main (int   argc,
   g_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/memory-input-stream/read-chunks", test_read_chunks);
+  g_test_add_func ("/memory-input-stream/readv", test_readv);
 
   return g_test_run();
 }
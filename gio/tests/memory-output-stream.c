@@ -76,6 +76,56 @@ test_data_size (void)
   g_object_unref (mo);
 }
 
+static void
+writev_done (GObject      *source,
+             GAsyncResult *result,
+             gpointer      user_data)
+{
+  GMainLoop *loop = user_data;
+  GError *error = NULL;
+  gssize n;
+
+  n = g_output_stream_writev_finish (G_OUTPUT_STREAM (source), result, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 8);
+  g_main_loop_quit (loop);
+}
+
+static void
+test_writev (void)
+{
+  GOutputStream *mo;
+  GOutputVector vectors[3];
+  GError *error = NULL;
+  GMainLoop *loop;
+  gssize n;
+
+  mo = g_memory_output_stream_new (NULL, 0, g_realloc, g_free);
+
+  vectors[0].buffer = "head";
+  vectors[0].size = 4;
+  vectors[1].buffer = NULL;
+  vectors[1].size = 0;
+  vectors[2].buffer = "body";
+  vectors[2].size = 4;
+
+  n = g_output_stream_writev (mo, vectors, 3, NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (n, ==, 8);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_output_stream_writev_async (mo, vectors, 3, G_PRIORITY_DEFAULT,
+                                NULL, writev_done, loop);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+
+  g_assert_cmpint (g_memory_output_stream_get_data_size (G_MEMORY_OUTPUT_STREAM (mo)), ==, 16);
+  g_assert (memcmp (g_memory_output_stream_get_data (G_MEMORY_OUTPUT_STREAM (mo)),
+                    "headbodyheadbody", 16) == 0);
+
+  g_object_unref (mo);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -86,6 +136,7 @@ main (int   argc,
 
   g_test_add_func ("/memory-output-stream/truncate", test_truncate);
   g_test_add_func ("/memory-output-stream/get-data-size", test_data_size);
+  g_test_add_func ("/memory-output-stream/writev", test_writev);
 
   return g_test_run();
 }
@@ -26,9 +26,21 @@
 
 #include "config.h"
 
+#ifdef HAVE_LINUX_FUTEX_H
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
 #include "glib.h"
 #include "galias.h"
 
+#if defined (HAVE_LINUX_FUTEX_H) && defined (__NR_futex)
+#define USE_FUTEX 1
+#endif
+
 
 struct _GAsyncQueue
 {
@@ -45,6 +57,58 @@ typedef struct {
   gpointer         user_data;
 } SortData;
 
+typedef struct _GAsyncRingCell GAsyncRingCell;
+
+/* The ring is the bounded multi-producer multi-consumer queue by
+ * Dmitry Vyukov. Each cell carries a sequence number, which tells
+ * producers and consumers whose turn it is: a cell at position pos
+ * is free for the producer of pos when its sequence is pos, and full
+ * for the consumer of pos when it is pos + 1. Producers and
+ * consumers claim positions with a compare-and-exchange on
+ * enqueue_pos and dequeue_pos respectively, several at once for the
+ * _many() variants.
+ *
+ * Threads only sleep when the ring is empty or full. They announce
+ * that in n_pop_waiters or n_push_waiters before they look at the
+ * ring a last time, and sleep as long as pop_event or push_event
+ * don't change. The other side looks at the waiter counts after
+ * having changed the ring and bumps the event in that case.
+ */
+struct _GAsyncRingCell
+{
+  volatile gint sequence;
+  volatile gpointer data;
+};
+
+struct _GAsyncRing
+{
+  /* Keep producers and consumers off each other's cache line */
+  volatile gint enqueue_pos;
+  gchar pad1[64 - sizeof (gint)];
+  volatile gint dequeue_pos;
+  gchar pad2[64 - sizeof (gint)];
+
+  GAsyncRingCell *cells;
+  guint mask;
+
+  volatile gint n_pop_waiters;
+  volatile gint pop_event;
+  volatile gint n_push_waiters;
+  volatile gint push_event;
+
+#ifndef USE_FUTEX
+  GMutex *mutex;
+  GCond *cond;
+#endif
+
+  GDestroyNotify item_free_func;
+  gint32 ref_count;
+};
+
+static guint g_async_ring_try_pop_intern (GAsyncRing *ring,
+					  gpointer   *data,
+					  guint       n_data);
+
 /**
  * g_async_queue_new:
  * 
@@ -649,6 +713,649 @@ g_async_queue_sort_unlocked (GAsyncQueue      *queue,
 		&sd);
 }
 
+/**
+ * g_async_ring_new:
+ * @capacity: the maximal number of items in the ring
+ *
+ * Creates a new asynchronous ring with the initial reference count
+ * of 1. A #GAsyncRing is a bounded queue to pass data between
+ * threads, like a #GAsyncQueue, but without a lock. Only threads that
+ * have to wait for the ring to become non-empty or non-full block.
+ *
+ * @capacity is rounded up to a power of two.
+ *
+ * Return value: the new #GAsyncRing.
+ *
+ * Since: 2.20
+ **/
+GAsyncRing *
+g_async_ring_new (guint capacity)
+{
+  GAsyncRing *ring;
+  guint i;
+
+  g_return_val_if_fail (capacity > 0 && capacity <= G_MAXINT / 2, NULL);
+
+  /* Sequence numbers can not tell a full cell from a free one in a
+   * ring of one.
+   */
+  capacity = MAX (capacity, 2);
+  capacity = 1 << g_bit_storage (capacity - 1);
+
+  ring = g_new0 (GAsyncRing, 1);
+  ring->cells = g_new (GAsyncRingCell, capacity);
+  ring->mask = capacity - 1;
+  ring->ref_count = 1;
+
+  for (i = 0; i < capacity; i++)
+    {
+      ring->cells[i].sequence = i;
+      ring->cells[i].data = NULL;
+    }
+
+#ifndef USE_FUTEX
+  ring->mutex = g_mutex_new ();
+  ring->cond = g_cond_new ();
+#endif
+
+  return ring;
+}
+
+/**
+ * g_async_ring_new_full:
+ * @capacity: the maximal number of items in the ring
+ * @item_free_func: function to free ring elements
+ *
+ * Creates a new asynchronous ring like g_async_ring_new() and sets
+ * up a destroy notify function that is used to free any remaining
+ * items when the ring is destroyed after the final unref.
+ *
+ * Return value: the new #GAsyncRing.
+ *
+ * Since: 2.20
+ **/
+GAsyncRing *
+g_async_ring_new_full (guint          capacity,
+		       GDestroyNotify item_free_func)
+{
+  GAsyncRing *ring;
+
+  ring = g_async_ring_new (capacity);
+  if (ring)
+    ring->item_free_func = item_free_func;
+
+  return ring;
+}
+
+/**
+ * g_async_ring_ref:
+ * @ring: a #GAsyncRing.
+ *
+ * Increases the reference count of @ring by 1.
+ *
+ * Returns: the @ring that was passed in
+ *
+ * Since: 2.20
+ **/
+GAsyncRing *
+g_async_ring_ref (GAsyncRing *ring)
+{
+  g_return_val_if_fail (ring, NULL);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, NULL);
+
+  g_atomic_int_inc (&ring->ref_count);
+
+  return ring;
+}
+
+/**
+ * g_async_ring_unref:
+ * @ring: a #GAsyncRing.
+ *
+ * Decreases the reference count of @ring by 1. If the reference
+ * count went to 0, @ring will be destroyed and the memory allocated
+ * will be freed. The remaining items are freed with the
+ * @item_free_func passed to g_async_ring_new_full(), if any.
+ *
+ * Since: 2.20
+ **/
+void
+g_async_ring_unref (GAsyncRing *ring)
+{
+  gpointer item;
+
+  g_return_if_fail (ring);
+  g_return_if_fail (g_atomic_int_get (&ring->ref_count) > 0);
+
+  if (!g_atomic_int_dec_and_test (&ring->ref_count))
+    return;
+
+  while (g_async_ring_try_pop_intern (ring, &item, 1))
+    if (ring->item_free_func)
+      ring->item_free_func (item);
+
+#ifndef USE_FUTEX
+  g_mutex_free (ring->mutex);
+  g_cond_free (ring->cond);
+#endif
+
+  g_free (ring->cells);
+  g_free (ring);
+}
+
+/* Wakes up threads sleeping on @event, if @n_waiters says there are
+ * some. n_wakeup is the number of threads that could make progress.
+ */
+static void
+g_async_ring_wakeup (GAsyncRing    *ring,
+		     volatile gint *n_waiters,
+		     volatile gint *event,
+		     guint          n_wakeup)
+{
+  /* Not g_atomic_int_get(): this has to be a full barrier, so the
+   * waiter count is read after the ring was changed.
+   */
+  if (g_atomic_int_exchange_and_add (n_waiters, 0) == 0)
+    return;
+
+#ifdef USE_FUTEX
+  g_atomic_int_inc (event);
+  syscall (__NR_futex, event, FUTEX_WAKE, (gint) n_wakeup, NULL, NULL, 0);
+#else
+  g_mutex_lock (ring->mutex);
+  g_atomic_int_inc (event);
+  g_cond_broadcast (ring->cond);
+  g_mutex_unlock (ring->mutex);
+#endif
+}
+
+/* Sleeps as long as @event has the @value. Returns %FALSE if @end_time
+ * passed.
+ */
+static gboolean
+g_async_ring_wait (GAsyncRing    *ring,
+		   volatile gint *event,
+		   gint           value,
+		   GTimeVal      *end_time)
+{
+  GTimeVal now;
+
+  if (end_time)
+    {
+      g_get_current_time (&now);
+      if (end_time->tv_sec < now.tv_sec ||
+	  (end_time->tv_sec == now.tv_sec && end_time->tv_usec <= now.tv_usec))
+	return FALSE;
+    }
+
+#ifdef USE_FUTEX
+  if (end_time)
+    {
+      struct timespec timeout;
+      glong usec;
+
+      usec = end_time->tv_usec - now.tv_usec;
+      timeout.tv_sec = end_time->tv_sec - now.tv_sec;
+      if (usec < 0)
+	{
+	  usec += G_USEC_PER_SEC;
+	  timeout.tv_sec--;
+	}
+      timeout.tv_nsec = usec * 1000;
+
+      /* Returns early on a wakeup, a signal or a changed @event */
+      if (syscall (__NR_futex, event, FUTEX_WAIT, value,
+		   &timeout, NULL, 0) < 0 && errno == ETIMEDOUT)
+	return FALSE;
+    }
+  else
+    syscall (__NR_futex, event, FUTEX_WAIT, value, NULL, NULL, 0);
+#else
+  g_mutex_lock (ring->mutex);
+  while (g_atomic_int_get (event) == value)
+    {
+      if (!end_time)
+	g_cond_wait (ring->cond, ring->mutex);
+      else if (!g_cond_timed_wait (ring->cond, ring->mutex, end_time))
+	{
+	  g_mutex_unlock (ring->mutex);
+	  return FALSE;
+	}
+    }
+  g_mutex_unlock (ring->mutex);
+#endif
+
+  return TRUE;
+}
+
+static guint
+g_async_ring_try_push_intern (GAsyncRing *ring,
+			      gpointer   *data,
+			      guint       n_data)
+{
+  GAsyncRingCell *cell;
+  guint pos, n, i;
+  gint diff;
+
+  pos = g_atomic_int_get (&ring->enqueue_pos);
+
+  while (TRUE)
+    {
+      /* Count the free cells from pos on */
+      diff = 0;
+      for (n = 0; n < n_data && n <= ring->mask; n++)
+	{
+	  cell = &ring->cells[(pos + n) & ring->mask];
+	  diff = (gint) ((guint) g_atomic_int_get (&cell->sequence) - (pos + n));
+	  if (diff != 0)
+	    break;
+	}
+
+      if (n == 0)
+	{
+	  /* The cell still holds the item of the previous round */
+	  if (diff < 0)
+	    return 0;
+
+	  /* Another producer was faster */
+	  pos = g_atomic_int_get (&ring->enqueue_pos);
+	  continue;
+	}
+
+      if (g_atomic_int_compare_and_exchange (&ring->enqueue_pos, pos, pos + n))
+	break;
+
+      pos = g_atomic_int_get (&ring->enqueue_pos);
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      cell = &ring->cells[(pos + i) & ring->mask];
+      g_atomic_pointer_set (&cell->data, data[i]);
+      g_atomic_int_set (&cell->sequence, pos + i + 1);
+    }
+
+  g_async_ring_wakeup (ring, &ring->n_pop_waiters, &ring->pop_event, n);
+
+  return n;
+}
+
+static guint
+g_async_ring_try_pop_intern (GAsyncRing *ring,
+			     gpointer   *data,
+			     guint       n_data)
+{
+  GAsyncRingCell *cell;
+  guint pos, n, i;
+  gint diff;
+
+  pos = g_atomic_int_get (&ring->dequeue_pos);
+
+  while (TRUE)
+    {
+      /* Count the full cells from pos on */
+      diff = 0;
+      for (n = 0; n < n_data && n <= ring->mask; n++)
+	{
+	  cell = &ring->cells[(pos + n) & ring->mask];
+	  diff = (gint) ((guint) g_atomic_int_get (&cell->sequence) - (pos + n + 1));
+	  if (diff != 0)
+	    break;
+	}
+
+      if (n == 0)
+	{
+	  /* The cell has not been filled yet */
+	  if (diff < 0)
+	    return 0;
+
+	  /* Another consumer was faster */
+	  pos = g_atomic_int_get (&ring->dequeue_pos);
+	  continue;
+	}
+
+      if (g_atomic_int_compare_and_exchange (&ring->dequeue_pos, pos, pos + n))
+	break;
+
+      pos = g_atomic_int_get (&ring->dequeue_pos);
+    }
+
+  for (i = 0; i < n; i++)
+    {
+      cell = &ring->cells[(pos + i) & ring->mask];
+      data[i] = g_atomic_pointer_get (&cell->data);
+      g_atomic_int_set (&cell->sequence, pos + i + ring->mask + 1);
+    }
+
+  g_async_ring_wakeup (ring, &ring->n_push_waiters, &ring->push_event, n);
+
+  return n;
+}
+
+static guint
+g_async_ring_push_intern (GAsyncRing *ring,
+			  gpointer   *data,
+			  guint       n_data,
+			  GTimeVal   *end_time)
+{
+  guint n = 0;
+
+  while (n < n_data)
+    {
+      gint event;
+      gboolean timed_out = FALSE;
+
+      n += g_async_ring_try_push_intern (ring, data + n, n_data - n);
+      if (n == n_data)
+	break;
+
+      event = g_atomic_int_get (&ring->push_event);
+      g_atomic_int_inc (&ring->n_push_waiters);
+
+      n += g_async_ring_try_push_intern (ring, data + n, n_data - n);
+      if (n < n_data)
+	timed_out = !g_async_ring_wait (ring, &ring->push_event, event, end_time);
+
+      g_atomic_int_add (&ring->n_push_waiters, -1);
+
+      if (timed_out)
+	break;
+    }
+
+  return n;
+}
+
+static guint
+g_async_ring_pop_intern (GAsyncRing *ring,
+			 gpointer   *data,
+			 guint       n_data,
+			 GTimeVal   *end_time)
+{
+  guint n;
+
+  while (TRUE)
+    {
+      gint event;
+      gboolean timed_out = FALSE;
+
+      n = g_async_ring_try_pop_intern (ring, data, n_data);
+      if (n > 0)
+	break;
+
+      event = g_atomic_int_get (&ring->pop_event);
+      g_atomic_int_inc (&ring->n_pop_waiters);
+
+      n = g_async_ring_try_pop_intern (ring, data, n_data);
+      if (n == 0)
+	timed_out = !g_async_ring_wait (ring, &ring->pop_event, event, end_time);
+
+      g_atomic_int_add (&ring->n_pop_waiters, -1);
+
+      if (n > 0 || timed_out)
+	break;
+    }
+
+  return n;
+}
+
+/**
+ * g_async_ring_push:
+ * @ring: a #GAsyncRing.
+ * @data: @data to push into the @ring.
+ *
+ * Pushes the @data into the @ring. @data must not be %NULL. This
+ * function blocks while the @ring is full.
+ *
+ * Since: 2.20
+ **/
+void
+g_async_ring_push (GAsyncRing *ring,
+		   gpointer    data)
+{
+  g_return_if_fail (ring);
+  g_return_if_fail (g_atomic_int_get (&ring->ref_count) > 0);
+  g_return_if_fail (data);
+
+  g_async_ring_push_intern (ring, &data, 1, NULL);
+}
+
+/**
+ * g_async_ring_try_push:
+ * @ring: a #GAsyncRing.
+ * @data: @data to push into the @ring.
+ *
+ * Tries to push the @data into the @ring. @data must not be %NULL.
+ *
+ * Return value: %TRUE if @data was pushed, %FALSE if the @ring was
+ * full.
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_async_ring_try_push (GAsyncRing *ring,
+		       gpointer    data)
+{
+  g_return_val_if_fail (ring, FALSE);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, FALSE);
+  g_return_val_if_fail (data, FALSE);
+
+  return g_async_ring_try_push_intern (ring, &data, 1) == 1;
+}
+
+/**
+ * g_async_ring_push_many:
+ * @ring: a #GAsyncRing.
+ * @data: an array of items to push into the @ring.
+ * @n_data: the number of items in @data.
+ *
+ * Pushes the @n_data items in @data into the @ring, in order. None
+ * of them may be %NULL. This function blocks until all of them have
+ * been pushed.
+ *
+ * As many items as there is room for are pushed at once, so this is
+ * cheaper than calling g_async_ring_push() @n_data times. Items
+ * pushed by other threads at the same time may be interleaved with
+ * the ones in @data if the @ring runs full.
+ *
+ * Since: 2.20
+ **/
+void
+g_async_ring_push_many (GAsyncRing *ring,
+			gpointer   *data,
+			guint       n_data)
+{
+  g_return_if_fail (ring);
+  g_return_if_fail (g_atomic_int_get (&ring->ref_count) > 0);
+  g_return_if_fail (data != NULL || n_data == 0);
+
+  g_async_ring_push_intern (ring, data, n_data, NULL);
+}
+
+/**
+ * g_async_ring_pop:
+ * @ring: a #GAsyncRing.
+ *
+ * Pops data from the @ring. This function blocks until data become
+ * available.
+ *
+ * Return value: data from the ring.
+ *
+ * Since: 2.20
+ **/
+gpointer
+g_async_ring_pop (GAsyncRing *ring)
+{
+  gpointer data;
+
+  g_return_val_if_fail (ring, NULL);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, NULL);
+
+  g_async_ring_pop_intern (ring, &data, 1, NULL);
+
+  return data;
+}
+
+/**
+ * g_async_ring_try_pop:
+ * @ring: a #GAsyncRing.
+ *
+ * Tries to pop data from the @ring. If no data is available, %NULL is
+ * returned.
+ *
+ * Return value: data from the ring or %NULL, when no data is
+ * available immediately.
+ *
+ * Since: 2.20
+ **/
+gpointer
+g_async_ring_try_pop (GAsyncRing *ring)
+{
+  gpointer data;
+
+  g_return_val_if_fail (ring, NULL);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, NULL);
+
+  if (g_async_ring_try_pop_intern (ring, &data, 1) == 0)
+    return NULL;
+
+  return data;
+}
+
+/**
+ * g_async_ring_timed_pop:
+ * @ring: a #GAsyncRing.
+ * @end_time: a #GTimeVal, determining the final time.
+ *
+ * Pops data from the @ring. If no data is received before @end_time,
+ * %NULL is returned.
+ *
+ * To easily calculate @end_time a combination of g_get_current_time()
+ * and g_time_val_add() can be used.
+ *
+ * Return value: data from the ring or %NULL, when no data is
+ * received before @end_time.
+ *
+ * Since: 2.20
+ **/
+gpointer
+g_async_ring_timed_pop (GAsyncRing *ring,
+			GTimeVal   *end_time)
+{
+  gpointer data;
+
+  g_return_val_if_fail (ring, NULL);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, NULL);
+
+  if (g_async_ring_pop_intern (ring, &data, 1, end_time) == 0)
+    return NULL;
+
+  return data;
+}
+
+/**
+ * g_async_ring_pop_many:
+ * @ring: a #GAsyncRing.
+ * @data: an array to store the items in.
+ * @n_data: the number of items that fit into @data.
+ *
+ * Pops up to @n_data items from the @ring into @data, in order. This
+ * function blocks until at least one item is available, and then
+ * takes as many as it can get at once.
+ *
+ * Return value: the number of items stored in @data.
+ *
+ * Since: 2.20
+ **/
+guint
+g_async_ring_pop_many (GAsyncRing *ring,
+		       gpointer   *data,
+		       guint       n_data)
+{
+  g_return_val_if_fail (ring, 0);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, 0);
+  g_return_val_if_fail (data != NULL, 0);
+  g_return_val_if_fail (n_data > 0, 0);
+
+  return g_async_ring_pop_intern (ring, data, n_data, NULL);
+}
+
+/**
+ * g_async_ring_try_pop_many:
+ * @ring: a #GAsyncRing.
+ * @data: an array to store the items in.
+ * @n_data: the number of items that fit into @data.
+ *
+ * Pops up to @n_data items from the @ring into @data, in order,
+ * without blocking.
+ *
+ * Return value: the number of items stored in @data, 0 if the @ring
+ * was empty.
+ *
+ * Since: 2.20
+ **/
+guint
+g_async_ring_try_pop_many (GAsyncRing *ring,
+			   gpointer   *data,
+			   guint       n_data)
+{
+  g_return_val_if_fail (ring, 0);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, 0);
+  g_return_val_if_fail (data != NULL || n_data == 0, 0);
+
+  if (n_data == 0)
+    return 0;
+
+  return g_async_ring_try_pop_intern (ring, data, n_data);
+}
+
+/**
+ * g_async_ring_length:
+ * @ring: a #GAsyncRing.
+ *
+ * Returns the number of items in the @ring. Other threads may change
+ * the @ring at any time, so this is only a snapshot.
+ *
+ * Return value: the number of items in the @ring.
+ *
+ * Since: 2.20
+ **/
+guint
+g_async_ring_length (GAsyncRing *ring)
+{
+  guint enqueue_pos, dequeue_pos;
+  gint length;
+
+  g_return_val_if_fail (ring, 0);
+  g_return_val_if_fail (g_atomic_int_get (&ring->ref_count) > 0, 0);
+
+  dequeue_pos = g_atomic_int_get (&ring->dequeue_pos);
+  enqueue_pos = g_atomic_int_get (&ring->enqueue_pos);
+
+  /* Both positions may move between the two reads */
+  length = (gint) (enqueue_pos - dequeue_pos);
+
+  return CLAMP (length, 0, (gint) ring->mask + 1);
+}
+
+/**
+ * g_async_ring_get_capacity:
+ * @ring: a #GAsyncRing.
+ *
+ * Returns the maximal number of items in the @ring, which is the
+ * capacity passed to g_async_ring_new() rounded up to a power of two.
+ *
+ * Return value: the capacity of the @ring.
+ *
+ * Since: 2.20
+ **/
+guint
+g_async_ring_get_capacity (GAsyncRing *ring)
+{
+  g_return_val_if_fail (ring, 0);
+
+  return ring->mask + 1;
+}
+
 /*
  * Private API
  */
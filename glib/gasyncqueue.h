@@ -36,6 +36,7 @@
 G_BEGIN_DECLS
 
 typedef struct _GAsyncQueue GAsyncQueue;
+typedef struct _GAsyncRing GAsyncRing;
 
 /* Asyncronous Queues, can be used to communicate between threads */
 
@@ -112,6 +113,39 @@ void         g_async_queue_sort_unlocked        (GAsyncQueue      *queue,
 						 GCompareDataFunc  func,
 						 gpointer          user_data);
 
+/* Asynchronous rings are bounded queues, which don't need a lock. Threads
+ * only block when the ring is empty or full. */
+GAsyncRing*  g_async_ring_new                   (guint             capacity);
+GAsyncRing*  g_async_ring_new_full              (guint             capacity,
+						 GDestroyNotify    item_free_func);
+GAsyncRing*  g_async_ring_ref                   (GAsyncRing       *ring);
+void         g_async_ring_unref                 (GAsyncRing       *ring);
+
+/* Push data into the async ring, blocking while it is full. Must not
+ * be NULL. */
+void         g_async_ring_push                  (GAsyncRing       *ring,
+						 gpointer          data);
+gboolean     g_async_ring_try_push              (GAsyncRing       *ring,
+						 gpointer          data);
+void         g_async_ring_push_many             (GAsyncRing       *ring,
+						 gpointer         *data,
+						 guint             n_data);
+
+/* Pop data from the async ring, blocking while it is empty. */
+gpointer     g_async_ring_pop                   (GAsyncRing       *ring);
+gpointer     g_async_ring_try_pop               (GAsyncRing       *ring);
+gpointer     g_async_ring_timed_pop             (GAsyncRing       *ring,
+						 GTimeVal         *end_time);
+guint        g_async_ring_pop_many              (GAsyncRing       *ring,
+						 gpointer         *data,
+						 guint             n_data);
+guint        g_async_ring_try_pop_many          (GAsyncRing       *ring,
+						 gpointer         *data,
+						 guint             n_data);
+
+guint        g_async_ring_length                (GAsyncRing       *ring);
+guint        g_async_ring_get_capacity          (GAsyncRing       *ring);
+
 /* Private API */
 GMutex*      _g_async_queue_get_mutex           (GAsyncQueue      *queue);
 
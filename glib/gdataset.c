@@ -42,6 +42,13 @@
 /* --- defines --- */
 #define	G_QUARK_BLOCK_SIZE			(512)
 
+/* datalists are protected by one of a number of locks, chosen by
+ * their address, so that unrelated datalists rarely contend
+ */
+#define G_DATALIST_N_LOCKS			(16)
+#define G_DATALIST_LOCK_FOR(datalist)					\
+  (&g_datalist_locks[((guint) ((gsize) (datalist) >> 3) * 2654435769u) >> 28])
+
 /* datalist pointer accesses have to be carried out atomically */
 #define G_DATALIST_GET_POINTER(datalist)						\
   ((GData*) ((gsize) g_atomic_pointer_get ((gpointer*) datalist) & ~(gsize) G_DATALIST_FLAGS_MASK))
@@ -56,24 +63,61 @@
 
 /* --- structures --- */
 typedef struct _GDataset GDataset;
-struct _GData
+typedef struct _GDataElt GDataElt;
+typedef struct _GQuarkEntry GQuarkEntry;
+typedef struct _GQuarkTable GQuarkTable;
+struct _GDataElt
 {
-  GData *next;
   GQuark id;
   gpointer data;
   GDestroyNotify destroy_func;
 };
 
+/* Most datalists hold only a few entries, so they are kept in an
+ * array that is searched linearly, and grows by doubling.
+ */
+struct _GData
+{
+  guint32 len;
+  guint32 alloc;
+  GDataElt data[1];
+};
+
 struct _GDataset
 {
   gconstpointer location;
   GData        *datalist;
 };
 
+/* The quark table is an open addressing hash table, which is only
+ * ever appended to. An entry is published by setting its string
+ * last, so lookups need no lock. When the table gets too full it is
+ * replaced as a whole; readers may still be using the old one, so
+ * it is kept around.
+ *
+ * Publishing is done with compare-and-exchange, which unlike
+ * g_atomic_pointer_set() is a barrier everywhere.
+ */
+struct _GQuarkEntry
+{
+  volatile gpointer string;
+  volatile guint hash;
+  volatile GQuark quark;
+};
+
+struct _GQuarkTable
+{
+  GQuarkTable *old_table;
+  guint mask;
+  guint n_entries;
+  GQuarkEntry entries[1];
+};
+
 
 /* --- prototypes --- */
 static inline GDataset*	g_dataset_lookup		(gconstpointer	  dataset_location);
-static inline void	g_datalist_clear_i		(GData		**datalist);
+static inline void	g_datalist_clear_i		(GData		**datalist,
+							 GDataset	 *dataset);
 static void		g_dataset_destroy_internal	(GDataset	 *dataset);
 static inline gpointer	g_data_set_internal		(GData     	**datalist,
 							 GQuark   	  key_id,
@@ -82,47 +126,80 @@ static inline gpointer	g_data_set_internal		(GData     	**datalist,
 							 GDataset	 *dataset);
 static void		g_data_initialize		(void);
 static inline GQuark	g_quark_new			(gchar  	*string);
+static inline GQuark	g_quark_lookup			(const gchar	 *string,
+							 const gchar	**interned);
 
 
 /* --- variables --- */
+#define G_DATALIST_LOCK_INIT4						\
+  G_STATIC_MUTEX_INIT, G_STATIC_MUTEX_INIT, G_STATIC_MUTEX_INIT, G_STATIC_MUTEX_INIT
+static GStaticMutex  g_datalist_locks[G_DATALIST_N_LOCKS] = {
+  G_DATALIST_LOCK_INIT4, G_DATALIST_LOCK_INIT4,
+  G_DATALIST_LOCK_INIT4, G_DATALIST_LOCK_INIT4
+};
 G_LOCK_DEFINE_STATIC (g_dataset_global);
 static GHashTable   *g_dataset_location_ht = NULL;
 static GDataset     *g_dataset_cached = NULL; /* should this be
 						 threadspecific? */
-G_LOCK_DEFINE_STATIC (g_quark_global);
-static GHashTable   *g_quark_ht = NULL;
+G_LOCK_DEFINE_STATIC (g_quark_global); /* only taken to add quarks */
+static GQuarkTable  *g_quark_table = NULL;
 static gchar       **g_quarks = NULL;
+static guint         g_quarks_size = 0;
+static GSList       *g_quarks_old = NULL;
 static GQuark        g_quark_seq_id = 0;
 
 /* --- functions --- */
 
-/* HOLDS: g_dataset_global_lock */
+/* The datalists of datasets are protected by g_dataset_global, all
+ * others by the lock for their address.
+ */
+static inline void
+g_data_lock (GData    **datalist,
+	     GDataset  *dataset)
+{
+  if (dataset)
+    G_LOCK (g_dataset_global);
+  else
+    g_static_mutex_lock (G_DATALIST_LOCK_FOR (datalist));
+}
+
+static inline void
+g_data_unlock (GData    **datalist,
+	       GDataset  *dataset)
+{
+  if (dataset)
+    G_UNLOCK (g_dataset_global);
+  else
+    g_static_mutex_unlock (G_DATALIST_LOCK_FOR (datalist));
+}
+
+/* HOLDS: the datalist's lock */
 static inline void
-g_datalist_clear_i (GData **datalist)
+g_datalist_clear_i (GData    **datalist,
+		    GDataset  *dataset)
 {
-  register GData *list;
+  GData *d;
+  guint i;
   
   /* unlink *all* items before walking their destructors
    */
-  list = G_DATALIST_GET_POINTER (datalist);
+  d = G_DATALIST_GET_POINTER (datalist);
   G_DATALIST_SET_POINTER (datalist, NULL);
+
+  if (!d)
+    return;
   
-  while (list)
+  for (i = 0; i < d->len; i++)
     {
-      register GData *prev;
-      
-      prev = list;
-      list = prev->next;
-      
-      if (prev->destroy_func)
+      if (d->data[i].destroy_func)
 	{
-	  G_UNLOCK (g_dataset_global);
-	  prev->destroy_func (prev->data);
-	  G_LOCK (g_dataset_global);
+	  g_data_unlock (datalist, dataset);
+	  d->data[i].destroy_func (d->data[i].data);
+	  g_data_lock (datalist, dataset);
 	}
-      
-      g_slice_free (GData, prev);
     }
+
+  g_free (d);
 }
 
 void
@@ -130,13 +207,10 @@ g_datalist_clear (GData **datalist)
 {
   g_return_if_fail (datalist != NULL);
   
-  G_LOCK (g_dataset_global);
-  if (!g_dataset_location_ht)
-    g_data_initialize ();
-
+  g_data_lock (datalist, NULL);
   while (G_DATALIST_GET_POINTER (datalist))
-    g_datalist_clear_i (datalist);
-  G_UNLOCK (g_dataset_global);
+    g_datalist_clear_i (datalist, NULL);
+  g_data_unlock (datalist, NULL);
 }
 
 /* HOLDS: g_dataset_global_lock */
@@ -173,7 +247,7 @@ g_dataset_destroy_internal (GDataset *dataset)
 	  break;
 	}
       
-      g_datalist_clear_i (&dataset->datalist);
+      g_datalist_clear_i (&dataset->datalist, dataset);
       dataset = g_dataset_lookup (dataset_location);
     }
 }
@@ -195,7 +269,7 @@ g_dataset_destroy (gconstpointer  dataset_location)
   G_UNLOCK (g_dataset_global);
 }
 
-/* HOLDS: g_dataset_global_lock */
+/* HOLDS: the datalist's lock */
 static inline gpointer
 g_data_set_internal (GData	  **datalist,
 		     GQuark         key_id,
@@ -203,103 +277,225 @@ g_data_set_internal (GData	  **datalist,
 		     GDestroyNotify destroy_func,
 		     GDataset	   *dataset)
 {
-  register GData *list;
+  GData *d, *old_d;
+  GDataElt old, *elt, *elt_end;
   
-  list = G_DATALIST_GET_POINTER (datalist);
+  d = G_DATALIST_GET_POINTER (datalist);
   if (!data)
     {
-      register GData *prev;
-      
-      prev = NULL;
-      while (list)
+      if (!d)
+	return NULL;
+
+      elt_end = d->data + d->len;
+      for (elt = d->data; elt < elt_end; elt++)
 	{
-	  if (list->id == key_id)
+	  if (elt->id == key_id)
 	    {
 	      gpointer ret_data = NULL;
 
-	      if (prev)
-		prev->next = list->next;
-	      else
+	      old = *elt;
+	      d->len--;
+	      memmove (elt, elt + 1, (elt_end - elt - 1) * sizeof (GDataElt));
+
+	      if (d->len == 0)
 		{
-		  G_DATALIST_SET_POINTER (datalist, list->next);
+		  G_DATALIST_SET_POINTER (datalist, NULL);
+		  g_free (d);
 		  
 		  /* the dataset destruction *must* be done
 		   * prior to invocation of the data destroy function
 		   */
-		  if (!list->next && dataset)
+		  if (dataset)
 		    g_dataset_destroy_internal (dataset);
 		}
+	      else if (d->alloc > 4 && d->len <= d->alloc / 4)
+		{
+		  d->alloc /= 2;
+		  old_d = d;
+		  d = g_realloc (d, sizeof (GData) + (d->alloc - 1) * sizeof (GDataElt));
+		  if (d != old_d)
+		    G_DATALIST_SET_POINTER (datalist, d);
+		}
 	      
-	      /* the GData struct *must* already be unlinked
+	      /* the element *must* already be removed
 	       * when invoking the destroy function.
 	       * we use (data==NULL && destroy_func!=NULL) as
 	       * a special hint combination to "steal"
 	       * data without destroy notification
 	       */
-	      if (list->destroy_func && !destroy_func)
+	      if (old.destroy_func && !destroy_func)
 		{
-		  G_UNLOCK (g_dataset_global);
-		  list->destroy_func (list->data);
-		  G_LOCK (g_dataset_global);
+		  g_data_unlock (datalist, dataset);
+		  old.destroy_func (old.data);
+		  g_data_lock (datalist, dataset);
 		}
 	      else
-		ret_data = list->data;
-	      
-              g_slice_free (GData, list);
+		ret_data = old.data;
 	      
 	      return ret_data;
 	    }
-	  
-	  prev = list;
-	  list = list->next;
 	}
     }
   else
     {
-      while (list)
+      if (d)
 	{
-	  if (list->id == key_id)
+	  elt_end = d->data + d->len;
+	  for (elt = d->data; elt < elt_end; elt++)
 	    {
-	      if (!list->destroy_func)
-		{
-		  list->data = data;
-		  list->destroy_func = destroy_func;
-		}
-	      else
+	      if (elt->id == key_id)
 		{
-		  register GDestroyNotify dfunc;
-		  register gpointer ddata;
+		  if (!elt->destroy_func)
+		    {
+		      elt->data = data;
+		      elt->destroy_func = destroy_func;
+		    }
+		  else
+		    {
+		      register GDestroyNotify dfunc;
+		      register gpointer ddata;
+		      
+		      dfunc = elt->destroy_func;
+		      ddata = elt->data;
+		      elt->data = data;
+		      elt->destroy_func = destroy_func;
+		      
+		      /* we need to have updated all structures prior to
+		       * invocation of the destroy function
+		       */
+		      g_data_unlock (datalist, dataset);
+		      dfunc (ddata);
+		      g_data_lock (datalist, dataset);
+		    }
 		  
-		  dfunc = list->destroy_func;
-		  ddata = list->data;
-		  list->data = data;
-		  list->destroy_func = destroy_func;
-		  
-		  /* we need to have updated all structures prior to
-		   * invocation of the destroy function
-		   */
-		  G_UNLOCK (g_dataset_global);
-		  dfunc (ddata);
-		  G_LOCK (g_dataset_global);
+		  return NULL;
 		}
-	      
-	      return NULL;
 	    }
-	  
-	  list = list->next;
 	}
-      
-      list = g_slice_new (GData);
-      list->next = G_DATALIST_GET_POINTER (datalist);
-      list->id = key_id;
-      list->data = data;
-      list->destroy_func = destroy_func;
-      G_DATALIST_SET_POINTER (datalist, list);
+
+      old_d = d;
+      if (!d)
+	{
+	  d = g_malloc (sizeof (GData));
+	  d->len = 0;
+	  d->alloc = 1;
+	}
+      else if (d->len == d->alloc)
+	{
+	  d->alloc *= 2;
+	  d = g_realloc (d, sizeof (GData) + (d->alloc - 1) * sizeof (GDataElt));
+	}
+
+      elt = &d->data[d->len++];
+      elt->id = key_id;
+      elt->data = data;
+      elt->destroy_func = destroy_func;
+
+      if (d != old_d)
+	G_DATALIST_SET_POINTER (datalist, d);
     }
 
   return NULL;
 }
 
+/* HOLDS: the datalist's lock */
+static inline gpointer
+g_data_get_internal (GData  **datalist,
+		     GQuark   key_id)
+{
+  GData *d;
+  GDataElt *elt, *elt_end;
+
+  d = G_DATALIST_GET_POINTER (datalist);
+  if (!d)
+    return NULL;
+
+  elt_end = d->data + d->len;
+  for (elt = d->data; elt < elt_end; elt++)
+    if (elt->id == key_id)
+      return elt->data;
+
+  return NULL;
+}
+
+/* Calls @func for every entry of @datalist, or of the dataset at
+ * @dataset_location, newest entry first like the linked lists of
+ * old. The keys are collected first, and the lock is not held while
+ * @func runs, so @func may change the datalist, or even destroy the
+ * dataset.
+ */
+static void
+g_data_foreach_internal (GData           **datalist,
+			 gconstpointer     dataset_location,
+			 GDataForeachFunc  func,
+			 gpointer          user_data)
+{
+  GDataset *dataset = NULL;
+  GData *d;
+  GQuark *keys = NULL;
+  guint i, len = 0;
+
+  if (dataset_location)
+    {
+      G_LOCK (g_dataset_global);
+      if (g_dataset_location_ht)
+	dataset = g_dataset_lookup (dataset_location);
+      datalist = dataset ? &dataset->datalist : NULL;
+    }
+  else
+    g_data_lock (datalist, NULL);
+
+  d = datalist ? G_DATALIST_GET_POINTER (datalist) : NULL;
+  if (d)
+    {
+      len = d->len;
+      keys = g_new (GQuark, len);
+      for (i = 0; i < len; i++)
+	keys[i] = d->data[len - 1 - i].id;
+    }
+
+  if (dataset_location)
+    G_UNLOCK (g_dataset_global);
+  else
+    g_data_unlock (datalist, NULL);
+
+  for (i = 0; i < len; i++)
+    {
+      gboolean found = FALSE;
+      gpointer data = NULL;
+      guint j;
+
+      /* the entry may have gone away in the meantime */
+      if (dataset_location)
+	{
+	  G_LOCK (g_dataset_global);
+	  dataset = g_dataset_lookup (dataset_location);
+	  datalist = dataset ? &dataset->datalist : NULL;
+	}
+      else
+	g_data_lock (datalist, NULL);
+
+      d = datalist ? G_DATALIST_GET_POINTER (datalist) : NULL;
+      for (j = 0; d && j < d->len; j++)
+	if (d->data[j].id == keys[i])
+	  {
+	    data = d->data[j].data;
+	    found = TRUE;
+	    break;
+	  }
+
+      if (dataset_location)
+	G_UNLOCK (g_dataset_global);
+      else
+	g_data_unlock (datalist, NULL);
+
+      if (found)
+	func (keys[i], data, user_data);
+    }
+
+  g_free (keys);
+}
+
 void
 g_dataset_id_set_data_full (gconstpointer  dataset_location,
 			    GQuark         key_id,
@@ -355,12 +551,9 @@ g_datalist_id_set_data_full (GData	  **datalist,
 	return;
     }
 
-  G_LOCK (g_dataset_global);
-  if (!g_dataset_location_ht)
-    g_data_initialize ();
-  
+  g_data_lock (datalist, NULL);
   g_data_set_internal (datalist, key_id, data, destroy_func, NULL);
-  G_UNLOCK (g_dataset_global);
+  g_data_unlock (datalist, NULL);
 }
 
 gpointer
@@ -393,10 +586,12 @@ g_datalist_id_remove_no_notify (GData	**datalist,
 
   g_return_val_if_fail (datalist != NULL, NULL);
 
-  G_LOCK (g_dataset_global);
-  if (key_id && g_dataset_location_ht)
-    ret_data = g_data_set_internal (datalist, key_id, NULL, (GDestroyNotify) 42, NULL);
-  G_UNLOCK (g_dataset_global);
+  if (key_id)
+    {
+      g_data_lock (datalist, NULL);
+      ret_data = g_data_set_internal (datalist, key_id, NULL, (GDestroyNotify) 42, NULL);
+      g_data_unlock (datalist, NULL);
+    }
 
   return ret_data;
 }
@@ -405,6 +600,8 @@ gpointer
 g_dataset_id_get_data (gconstpointer  dataset_location,
 		       GQuark         key_id)
 {
+  gpointer data = NULL;
+
   g_return_val_if_fail (dataset_location != NULL, NULL);
   
   G_LOCK (g_dataset_global);
@@ -414,20 +611,11 @@ g_dataset_id_get_data (gconstpointer  dataset_location,
       
       dataset = g_dataset_lookup (dataset_location);
       if (dataset)
-	{
-	  register GData *list;
-	  
-	  for (list = dataset->datalist; list; list = list->next)
-	    if (list->id == key_id)
-	      {
-		G_UNLOCK (g_dataset_global);
-		return list->data;
-	      }
-	}
+	data = g_data_get_internal (&dataset->datalist, key_id);
     }
   G_UNLOCK (g_dataset_global);
  
-  return NULL;
+  return data;
 }
 
 gpointer
@@ -438,15 +626,9 @@ g_datalist_id_get_data (GData	 **datalist,
   g_return_val_if_fail (datalist != NULL, NULL);
   if (key_id)
     {
-      register GData *list;
-      G_LOCK (g_dataset_global);
-      for (list = G_DATALIST_GET_POINTER (datalist); list; list = list->next)
-	if (list->id == key_id)
-	  {
-            data = list->data;
-            break;
-          }
-      G_UNLOCK (g_dataset_global);
+      g_data_lock (datalist, NULL);
+      data = g_data_get_internal (datalist, key_id);
+      g_data_unlock (datalist, NULL);
     }
   return data;
 }
@@ -456,31 +638,10 @@ g_dataset_foreach (gconstpointer    dataset_location,
 		   GDataForeachFunc func,
 		   gpointer         user_data)
 {
-  register GDataset *dataset;
-  
   g_return_if_fail (dataset_location != NULL);
   g_return_if_fail (func != NULL);
 
-  G_LOCK (g_dataset_global);
-  if (g_dataset_location_ht)
-    {
-      dataset = g_dataset_lookup (dataset_location);
-      G_UNLOCK (g_dataset_global);
-      if (dataset)
-	{
-	  register GData *list, *next;
-	  
-	  for (list = dataset->datalist; list; list = next)
-	    {
-	      next = list->next;
-	      func (list->id, list->data, user_data);
-	    }
-	}
-    }
-  else
-    {
-      G_UNLOCK (g_dataset_global);
-    }
+  g_data_foreach_internal (NULL, dataset_location, func, user_data);
 }
 
 void
@@ -488,16 +649,10 @@ g_datalist_foreach (GData	   **datalist,
 		    GDataForeachFunc func,
 		    gpointer         user_data)
 {
-  register GData *list, *next;
-
   g_return_if_fail (datalist != NULL);
   g_return_if_fail (func != NULL);
   
-  for (list = G_DATALIST_GET_POINTER (datalist); list; list = next)
-    {
-      next = list->next;
-      func (list->id, list->data, user_data);
-    }
+  g_data_foreach_internal (datalist, NULL, func, user_data);
 }
 
 void
@@ -600,32 +755,75 @@ g_data_initialize (void)
   g_dataset_cached = NULL;
 }
 
+/* Returns the quark for @string, if there is one, without taking a
+ * lock, and its interned string in @interned.
+ */
+static inline GQuark
+g_quark_lookup (const gchar  *string,
+		const gchar **interned)
+{
+  GQuarkTable *table;
+  GQuarkEntry *entry;
+  const gchar *entry_string;
+  guint hash, i;
+
+  table = g_atomic_pointer_get (&g_quark_table);
+  if (!table)
+    return 0;
+
+  hash = g_str_hash (string);
+
+  for (i = hash & table->mask; ; i = (i + 1) & table->mask)
+    {
+      entry = &table->entries[i];
+      entry_string = g_atomic_pointer_get (&entry->string);
+
+      if (!entry_string)
+	return 0;
+
+      if (entry->hash == hash && strcmp (entry_string, string) == 0)
+	{
+	  if (interned)
+	    *interned = entry_string;
+	  return entry->quark;
+	}
+    }
+}
+
 GQuark
 g_quark_try_string (const gchar *string)
 {
-  GQuark quark = 0;
   g_return_val_if_fail (string != NULL, 0);
   
-  G_LOCK (g_quark_global);
-  if (g_quark_ht)
-    quark = GPOINTER_TO_UINT (g_hash_table_lookup (g_quark_ht, string));
-  G_UNLOCK (g_quark_global);
-  
-  return quark;
+  return g_quark_lookup (string, NULL);
 }
 
-/* HOLDS: g_quark_global_lock */
+/* Looks @string up, and adds it if it isn't there yet. Only adding
+ * takes the lock.
+ */
 static inline GQuark
-g_quark_from_string_internal (const gchar *string, 
-			      gboolean     duplicate)
+g_quark_from_string_internal (const gchar  *string, 
+			      gboolean      duplicate,
+			      const gchar **interned)
 {
-  GQuark quark = 0;
-  
-  if (g_quark_ht)
-    quark = GPOINTER_TO_UINT (g_hash_table_lookup (g_quark_ht, string));
+  GQuark quark;
   
+  quark = g_quark_lookup (string, interned);
+  if (quark)
+    return quark;
+
+  G_LOCK (g_quark_global);
+
+  /* Someone else may have added it in the meantime */
+  quark = g_quark_lookup (string, interned);
   if (!quark)
-    quark = g_quark_new (duplicate ? g_strdup (string) : (gchar *)string);
+    {
+      quark = g_quark_new (duplicate ? g_strdup (string) : (gchar *)string);
+      if (interned)
+	*interned = g_quarks[quark];
+    }
+
+  G_UNLOCK (g_quark_global);
   
   return quark;
 }
@@ -633,44 +831,83 @@ g_quark_from_string_internal (const gchar *string,
 GQuark
 g_quark_from_string (const gchar *string)
 {
-  GQuark quark;
-  
   if (!string)
     return 0;
   
-  G_LOCK (g_quark_global);
-  quark = g_quark_from_string_internal (string, TRUE);
-  G_UNLOCK (g_quark_global);
-  
-  return quark;
+  return g_quark_from_string_internal (string, TRUE, NULL);
 }
 
 GQuark
 g_quark_from_static_string (const gchar *string)
 {
-  GQuark quark;
-  
   if (!string)
     return 0;
   
-  G_LOCK (g_quark_global);
-  quark = g_quark_from_string_internal (string, FALSE);
-  G_UNLOCK (g_quark_global);
-
-  return quark;
+  return g_quark_from_string_internal (string, FALSE, NULL);
 }
 
 G_CONST_RETURN gchar*
 g_quark_to_string (GQuark quark)
 {
-  gchar* result = NULL;
+  gchar **quarks;
 
-  G_LOCK (g_quark_global);
-  if (quark < g_quark_seq_id)
-    result = g_quarks[quark];
-  G_UNLOCK (g_quark_global);
+  /* g_quark_new() stores the string before it counts the quark, and
+   * any array it stores it in stays valid.
+   */
+  if (quark >= (GQuark) g_atomic_int_get ((gint *) &g_quark_seq_id))
+    return NULL;
 
-  return result;
+  quarks = g_atomic_pointer_get (&g_quarks);
+
+  return quarks[quark];
+}
+
+/* HOLDS: g_quark_global_lock */
+static void
+g_quark_table_insert (GQuarkTable *table,
+		      gchar       *string,
+		      guint        hash,
+		      GQuark       quark)
+{
+  GQuarkEntry *entry;
+  guint i;
+
+  for (i = hash & table->mask; table->entries[i].string; i = (i + 1) & table->mask)
+    ;
+
+  entry = &table->entries[i];
+  entry->hash = hash;
+  entry->quark = quark;
+  g_atomic_pointer_compare_and_exchange (&entry->string, NULL, string);
+
+  table->n_entries++;
+}
+
+/* HOLDS: g_quark_global_lock */
+static void
+g_quark_table_grow (void)
+{
+  GQuarkTable *table, *old_table;
+  guint size, i;
+
+  old_table = g_quark_table;
+  size = old_table ? (old_table->mask + 1) * 2 : 2 * G_QUARK_BLOCK_SIZE;
+
+  table = g_malloc0 (sizeof (GQuarkTable) + (size - 1) * sizeof (GQuarkEntry));
+  table->mask = size - 1;
+  table->old_table = old_table;
+
+  if (old_table)
+    for (i = 0; i <= old_table->mask; i++)
+      {
+	GQuarkEntry *entry = &old_table->entries[i];
+
+	if (entry->string)
+	  g_quark_table_insert (table, entry->string, entry->hash, entry->quark);
+      }
+
+  g_atomic_pointer_compare_and_exchange ((gpointer *) &g_quark_table,
+					 old_table, table);
 }
 
 /* HOLDS: g_quark_global_lock */
@@ -679,18 +916,35 @@ g_quark_new (gchar *string)
 {
   GQuark quark;
   
-  if (g_quark_seq_id % G_QUARK_BLOCK_SIZE == 0)
-    g_quarks = g_renew (gchar*, g_quarks, g_quark_seq_id + G_QUARK_BLOCK_SIZE);
-  if (!g_quark_ht)
+  if (g_quark_seq_id + 1 >= g_quarks_size)
+    {
+      gchar **quarks;
+
+      /* Readers may still look at the old array, it stays around */
+      g_quarks_size = MAX (g_quarks_size * 2, G_QUARK_BLOCK_SIZE);
+      quarks = g_new (gchar*, g_quarks_size);
+      if (g_quarks)
+	memcpy (quarks, g_quarks, g_quark_seq_id * sizeof (gchar*));
+      if (g_quarks)
+	g_quarks_old = g_slist_prepend (g_quarks_old, g_quarks);
+      g_atomic_pointer_compare_and_exchange ((gpointer *) &g_quarks,
+					     g_quarks, quarks);
+    }
+  if (!g_quark_table)
     {
       g_assert (g_quark_seq_id == 0);
-      g_quark_ht = g_hash_table_new (g_str_hash, g_str_equal);
+      g_quark_table_grow ();
       g_quarks[g_quark_seq_id++] = NULL;
     }
 
-  quark = g_quark_seq_id++;
+  quark = g_quark_seq_id;
   g_quarks[quark] = string;
-  g_hash_table_insert (g_quark_ht, string, GUINT_TO_POINTER (quark));
+  g_atomic_int_inc ((gint *) &g_quark_seq_id);
+
+  /* Keep the table at most half full */
+  if ((g_quark_table->n_entries + 1) * 2 > g_quark_table->mask + 1)
+    g_quark_table_grow ();
+  g_quark_table_insert (g_quark_table, string, g_str_hash (string), quark);
   
   return quark;
 }
@@ -710,15 +964,11 @@ G_CONST_RETURN gchar*
 g_intern_string (const gchar *string)
 {
   const gchar *result;
-  GQuark quark;
 
   if (!string)
     return NULL;
 
-  G_LOCK (g_quark_global);
-  quark = g_quark_from_string_internal (string, TRUE);
-  result = g_quarks[quark];
-  G_UNLOCK (g_quark_global);
+  g_quark_from_string_internal (string, TRUE, &result);
 
   return result;
 }
@@ -739,16 +989,12 @@ g_intern_string (const gchar *string)
 G_CONST_RETURN gchar*
 g_intern_static_string (const gchar *string)
 {
-  GQuark quark;
   const gchar *result;
 
   if (!string)
     return NULL;
 
-  G_LOCK (g_quark_global);
-  quark = g_quark_from_string_internal (string, FALSE);
-  result = g_quarks[quark];
-  G_UNLOCK (g_quark_global);
+  g_quark_from_string_internal (string, FALSE, &result);
 
   return result;
 }
@@ -32,32 +32,53 @@
 
 #include <string.h>  /* memset */
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #include "glib.h"
 #include "galias.h"
 
 #define HASH_TABLE_MIN_SHIFT 3  /* 1 << 3 == 8 buckets */
 
-typedef struct _GHashNode      GHashNode;
+/* The table is probed a group of buckets at a time. Each bucket has
+ * a control byte, which is either CTRL_EMPTY, CTRL_DELETED (a
+ * tombstone) or, for buckets in use, 7 bits of the key's hash. The
+ * control bytes of a group are compared all at once, so that keys
+ * only need to be looked at when those 7 bits match.
+ *
+ * The first GROUP_WIDTH control bytes are repeated after the last
+ * one, so that a group can start at any bucket.
+ */
+#define GROUP_WIDTH   16
+
+#define CTRL_EMPTY    ((guint8) 0x80)
+#define CTRL_DELETED  ((guint8) 0xfe)
+#define CTRL_IS_FULL(c) (((c) & 0x80) == 0)
 
-struct _GHashNode
-{
-  gpointer   key;
-  gpointer   value;
+#if defined (__GNUC__) && __GNUC__ >= 4
+#define GROUP_FIRST(match) ((guint) __builtin_ctz (match))
+#else
+#define GROUP_FIRST(match) ((guint) g_bit_nth_lsf ((match), -1))
+#endif
 
-  /* If key_hash == 0, node is not in use
-   * If key_hash == 1, node is a tombstone
-   * If key_hash >= 2, node contains data */
-  guint      key_hash;
-};
+/* Each bucket holds a key and its value next to each other, or only
+ * the key while every value stored in the table is its own key.
+ */
+#define NODE_KEY(hash_table, i) \
+  ((hash_table)->slots[(i) * (hash_table)->stride])
+#define NODE_VALUE(hash_table, i) \
+  ((hash_table)->slots[(i) * (hash_table)->stride + (hash_table)->stride - 1])
 
 struct _GHashTable
 {
   gint             size;
-  gint             mod;
   guint            mask;
   gint             nnodes;
   gint             noccupied;  /* nnodes + tombstones */
-  GHashNode       *nodes;
+  guint8          *ctrl;       /* size + GROUP_WIDTH control bytes */
+  gpointer        *slots;
+  guint            stride;     /* 1 while keys are their own values, else 2 */
   GHashFunc        hash_func;
   GEqualFunc       key_equal_func;
   volatile gint    ref_count;
@@ -83,45 +104,81 @@ typedef struct
   int          version;
 } RealIter;
 
-/* Each table size has an associated prime modulo (the first prime
- * lower than the table size) used to find the initial bucket. Probing
- * then works modulo 2^n. The prime modulo is necessary to get a
- * good distribution with poor hash functions. */
-static const gint prime_mod [] =
-{
-  1,          /* For 1 << 0 */
-  2,
-  3,
-  7,
-  13,
-  31,
-  61,
-  127,
-  251,
-  509,
-  1021,
-  2039,
-  4093,
-  8191,
-  16381,
-  32749,
-  65521,      /* For 1 << 16 */
-  131071,
-  262139,
-  524287,
-  1048573,
-  2097143,
-  4194301,
-  8388593,
-  16777213,
-  33554393,
-  67108859,
-  134217689,
-  268435399,
-  536870909,
-  1073741789,
-  2147483647  /* For 1 << 31 */
-};
+/* Returns a bit for each control byte in the group equal to @c */
+static inline guint
+g_hash_group_match (const guint8 *group,
+                    guint8        c)
+{
+#ifdef __SSE2__
+  __m128i ctrl = _mm_loadu_si128 ((const __m128i *) group);
+
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (ctrl, _mm_set1_epi8 ((gchar) c)));
+#else
+  guint match = 0;
+  gint i;
+
+  for (i = 0; i < GROUP_WIDTH; i++)
+    if (group[i] == c)
+      match |= 1 << i;
+
+  return match;
+#endif
+}
+
+/* Returns a bit for each empty or deleted bucket in the group */
+static inline guint
+g_hash_group_match_free (const guint8 *group)
+{
+#ifdef __SSE2__
+  return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *) group));
+#else
+  guint match = 0;
+  gint i;
+
+  for (i = 0; i < GROUP_WIDTH; i++)
+    if (!CTRL_IS_FULL (group[i]))
+      match |= 1 << i;
+
+  return match;
+#endif
+}
+
+/* Hash functions like g_direct_hash() leave the low bits unused, so
+ * the hash is mixed before its low bits pick the first bucket and its
+ * top 7 bits go into the control byte.
+ */
+static inline guint
+g_hash_table_hash (GHashTable    *hash_table,
+                   gconstpointer  key)
+{
+  guint hash_value = (* hash_table->hash_func) (key);
+
+  hash_value *= 0x9e3779b1;
+
+  return hash_value ^ (hash_value >> 15);
+}
+
+#define HASH_CTRL(hash_value) ((guint8) ((hash_value) >> 25))
+
+static inline void
+g_hash_table_set_ctrl (GHashTable *hash_table,
+                       guint       node_index,
+                       guint8      c)
+{
+  guint i;
+
+  hash_table->ctrl[node_index] = c;
+
+  /* keep the copies after the end up to date */
+  for (i = node_index; i < GROUP_WIDTH; i += hash_table->size)
+    hash_table->ctrl[hash_table->size + i] = c;
+}
+
+/* Probing goes from group to group, with growing steps, until a
+ * group with an empty bucket is found; there always is one.
+ */
+#define PROBE_NEXT(pos, step, mask) \
+  ((step) += GROUP_WIDTH, (pos) = ((pos) + (step)) & (mask))
 
 static void
 g_hash_table_set_shift (GHashTable *hash_table, gint shift)
@@ -130,7 +187,6 @@ g_hash_table_set_shift (GHashTable *hash_table, gint shift)
   guint mask = 0;
 
   hash_table->size = 1 << shift;
-  hash_table->mod  = prime_mod [shift];
 
   for (i = 0; i < shift; i++)
     {
@@ -163,12 +219,86 @@ g_hash_table_set_shift_from_size (GHashTable *hash_table, gint size)
   g_hash_table_set_shift (hash_table, shift);
 }
 
+/*
+ * g_hash_table_alloc_nodes:
+ * @hash_table: our #GHashTable
+ * @stride: 1 for buckets without values, 2 for buckets with values
+ *
+ * Allocates empty buckets for the current size of @hash_table.
+ */
+static void
+g_hash_table_alloc_nodes (GHashTable *hash_table,
+                          guint       stride)
+{
+  hash_table->ctrl = g_malloc (hash_table->size + GROUP_WIDTH);
+  memset (hash_table->ctrl, CTRL_EMPTY, hash_table->size + GROUP_WIDTH);
+  hash_table->slots = g_new0 (gpointer, hash_table->size * stride);
+  hash_table->stride = stride;
+}
+
+static void
+g_hash_table_free_nodes (GHashTable *hash_table)
+{
+  g_free (hash_table->slots);
+  g_free (hash_table->ctrl);
+}
+
+/*
+ * g_hash_table_ensure_values:
+ * @hash_table: our #GHashTable
+ * @key: a key about to be stored
+ * @value: the value to be stored with @key
+ *
+ * Makes room for values in the buckets of @hash_table, the first
+ * time a value is stored that isn't its key.
+ */
+static inline void
+g_hash_table_ensure_values (GHashTable *hash_table,
+                            gpointer    key,
+                            gpointer    value)
+{
+  gpointer *slots;
+  gint i;
+
+  if (G_LIKELY (hash_table->stride == 2 || key == value))
+    return;
+
+  slots = g_new (gpointer, hash_table->size * 2);
+  for (i = 0; i < hash_table->size; i++)
+    slots[i * 2] = slots[i * 2 + 1] = hash_table->slots[i];
+
+  g_free (hash_table->slots);
+  hash_table->slots = slots;
+  hash_table->stride = 2;
+}
+
+/*
+ * g_hash_table_find_free:
+ * @hash_table: our #GHashTable
+ * @hash_value: the mixed hash value of a key
+ * Return value: index of the first empty or deleted bucket
+ *
+ * Finds the bucket where a key that is not in @hash_table goes.
+ */
+static inline guint
+g_hash_table_find_free (GHashTable *hash_table,
+                        guint       hash_value)
+{
+  guint pos = hash_value & hash_table->mask;
+  guint step = 0;
+  guint match;
+
+  while (!(match = g_hash_group_match_free (hash_table->ctrl + pos)))
+    PROBE_NEXT (pos, step, hash_table->mask);
+
+  return (pos + GROUP_FIRST (match)) & hash_table->mask;
+}
+
 /*
  * g_hash_table_lookup_node:
  * @hash_table: our #GHashTable
  * @key: the key to lookup against
- * @hash_return: optional key hash return location
- * Return value: index of the described #GHashNode
+ * Return value: index of the described node, or -1
  *
  * Performs a lookup in the hash table.  Virtually all hash operations
  * will use this function internally.
@@ -177,55 +307,58 @@ g_hash_table_set_shift_from_size (GHashTable *hash_table, gint size)
  * user's hash function.
  *
  * If an entry in the table matching @key is found then this function
- * returns the index of that entry in the table, and if not, the
- * index of an empty node (never a tombstone).
+ * returns the index of that entry in the table, and if not, -1.
  */
-static inline guint
+static inline gint
 g_hash_table_lookup_node (GHashTable    *hash_table,
                           gconstpointer  key)
 {
-  GHashNode *node;
-  guint node_index;
   guint hash_value;
+  guint pos;
   guint step = 0;
 
-  /* Empty buckets have hash_value set to 0, and for tombstones, it's 1.
-   * We need to make sure our hash value is not one of these. */
-
-  hash_value = (* hash_table->hash_func) (key);
-  if (G_UNLIKELY (hash_value <= 1))
-    hash_value = 2;
+  hash_value = g_hash_table_hash (hash_table, key);
+  pos = hash_value & hash_table->mask;
 
-  node_index = hash_value % hash_table->mod;
-  node = &hash_table->nodes [node_index];
+#if defined (__GNUC__) && __GNUC__ >= 4
+  /* the key is most likely at the start of the first group, so its
+   * bucket can be loaded while the control bytes are looked at
+   */
+  __builtin_prefetch (&NODE_KEY (hash_table, pos));
+#endif
 
-  while (node->key_hash)
+  while (TRUE)
     {
-      /*  We first check if our full hash values
-       *  are equal so we can avoid calling the full-blown
-       *  key equality function in most cases.
-       */
+      const guint8 *group = hash_table->ctrl + pos;
+      guint match = g_hash_group_match (group, HASH_CTRL (hash_value));
 
-      if (node->key_hash == hash_value)
+      /*  The control bytes already tell apart all but one in 128
+       *  of the other keys, so the full-blown key equality function
+       *  mostly gets called for the key we are looking for.
+       */
+      while (match)
         {
+          guint node_index = (pos + GROUP_FIRST (match)) & hash_table->mask;
+          gpointer node_key = NODE_KEY (hash_table, node_index);
+
           if (hash_table->key_equal_func)
             {
-              if (hash_table->key_equal_func (node->key, key))
-                break;
+              if (hash_table->key_equal_func (node_key, key))
+                return node_index;
             }
-          else if (node->key == key)
+          else if (node_key == key)
             {
-              break;
+              return node_index;
             }
+
+          match &= match - 1;
         }
 
-      step++;
-      node_index += step;
-      node_index &= hash_table->mask;
-      node = &hash_table->nodes [node_index];
-    }
+      if (g_hash_group_match (group, CTRL_EMPTY))
+        return -1;
 
-  return node_index;
+      PROBE_NEXT (pos, step, hash_table->mask);
+    }
 }
 
 /*
@@ -233,7 +366,7 @@ g_hash_table_lookup_node (GHashTable    *hash_table,
  * @hash_table: our #GHashTable
  * @key: the key to lookup against
  * @hash_return: key hash return location
- * Return value: index of the described #GHashNode
+ * Return value: index of the described node
  *
  * Performs a lookup in the hash table, preserving extra information
  * usually needed for insertion.
@@ -255,93 +388,106 @@ g_hash_table_lookup_node_for_insertion (GHashTable    *hash_table,
                                         gconstpointer  key,
                                         guint         *hash_return)
 {
-  GHashNode *node;
-  guint node_index;
   guint hash_value;
-  guint first_tombstone;
-  gboolean have_tombstone = FALSE;
+  guint pos;
+  guint first_free = 0;
+  gboolean have_free = FALSE;
   guint step = 0;
 
-  /* Empty buckets have hash_value set to 0, and for tombstones, it's 1.
-   * We need to make sure our hash value is not one of these. */
-
-  hash_value = (* hash_table->hash_func) (key);
-  if (G_UNLIKELY (hash_value <= 1))
-    hash_value = 2;
+  hash_value = g_hash_table_hash (hash_table, key);
+  pos = hash_value & hash_table->mask;
 
   *hash_return = hash_value;
 
-  node_index = hash_value % hash_table->mod;
-  node = &hash_table->nodes [node_index];
-
-  while (node->key_hash)
+  while (TRUE)
     {
-      /*  We first check if our full hash values
-       *  are equal so we can avoid calling the full-blown
-       *  key equality function in most cases.
-       */
+      const guint8 *group = hash_table->ctrl + pos;
+      guint match = g_hash_group_match (group, HASH_CTRL (hash_value));
 
-      if (node->key_hash == hash_value)
+      while (match)
         {
+          guint node_index = (pos + GROUP_FIRST (match)) & hash_table->mask;
+          gpointer node_key = NODE_KEY (hash_table, node_index);
+
           if (hash_table->key_equal_func)
             {
-              if (hash_table->key_equal_func (node->key, key))
+              if (hash_table->key_equal_func (node_key, key))
                 return node_index;
             }
-          else if (node->key == key)
+          else if (node_key == key)
             {
               return node_index;
             }
+
+          match &= match - 1;
         }
-      else if (node->key_hash == 1 && !have_tombstone)
+
+      match = g_hash_group_match_free (group);
+      if (match && !have_free)
         {
-          first_tombstone = node_index;
-          have_tombstone = TRUE;
+          first_free = (pos + GROUP_FIRST (match)) & hash_table->mask;
+          have_free = TRUE;
         }
 
-      step++;
-      node_index += step;
-      node_index &= hash_table->mask;
-      node = &hash_table->nodes [node_index];
-    }
-
-  if (have_tombstone)
-    return first_tombstone;
+      if (g_hash_group_match (group, CTRL_EMPTY))
+        return first_free;
 
-  return node_index;
+      PROBE_NEXT (pos, step, hash_table->mask);
+    }
 }
 
 /*
  * g_hash_table_remove_node:
  * @hash_table: our #GHashTable
- * @node: pointer to node to remove
+ * @node_index: index of the node to remove
  * @notify: %TRUE if the destroy notify handlers are to be called
  *
  * Removes a node from the hash table and updates the node count.
- * The node is replaced by a tombstone. No table resize is performed.
+ * No table resize is performed.
+ *
+ * The node only becomes a tombstone if a lookup could have probed
+ * past it, that is, if it is in a run of at least GROUP_WIDTH
+ * buckets that are not empty. Otherwise it is simply emptied.
  *
  * If @notify is %TRUE then the destroy notify functions are called
  * for the key and value of the hash node.
  */
 static void
 g_hash_table_remove_node (GHashTable   *hash_table,
-                          GHashNode    *node,
+                          guint         node_index,
                           gboolean      notify)
 {
-  if (notify && hash_table->key_destroy_func)
-    hash_table->key_destroy_func (node->key);
+  gpointer key = NODE_KEY (hash_table, node_index);
+  gpointer value = NODE_VALUE (hash_table, node_index);
+  guint empty_before, empty_after;
 
-  if (notify && hash_table->value_destroy_func)
-    hash_table->value_destroy_func (node->value);
+  empty_before = g_hash_group_match (hash_table->ctrl + ((node_index - GROUP_WIDTH) & hash_table->mask),
+                                     CTRL_EMPTY);
+  empty_after = g_hash_group_match (hash_table->ctrl + node_index, CTRL_EMPTY);
 
-  /* Erect tombstone */
-  node->key_hash = 1;
+  if (empty_before && empty_after &&
+      GROUP_FIRST (empty_after) + (GROUP_WIDTH - g_bit_storage (empty_before)) < GROUP_WIDTH)
+    {
+      g_hash_table_set_ctrl (hash_table, node_index, CTRL_EMPTY);
+      hash_table->noccupied--;
+    }
+  else
+    {
+      /* Erect tombstone */
+      g_hash_table_set_ctrl (hash_table, node_index, CTRL_DELETED);
+    }
 
   /* Be GC friendly */
-  node->key = NULL;
-  node->value = NULL;
+  NODE_KEY (hash_table, node_index) = NULL;
+  NODE_VALUE (hash_table, node_index) = NULL;
 
   hash_table->nnodes--;
+
+  if (notify && hash_table->key_destroy_func)
+    hash_table->key_destroy_func (key);
+
+  if (notify && hash_table->value_destroy_func)
+    hash_table->value_destroy_func (value);
 }
 
 /*
@@ -361,23 +507,27 @@ g_hash_table_remove_all_nodes (GHashTable *hash_table,
 {
   int i;
 
-  for (i = 0; i < hash_table->size; i++)
+  if (notify &&
+      (hash_table->key_destroy_func || hash_table->value_destroy_func))
     {
-      GHashNode *node = &hash_table->nodes [i];
-
-      if (node->key_hash > 1)
+      for (i = 0; i < hash_table->size; i++)
         {
-          if (notify && hash_table->key_destroy_func)
-            hash_table->key_destroy_func (node->key);
+          if (CTRL_IS_FULL (hash_table->ctrl[i]))
+            {
+              if (hash_table->key_destroy_func)
+                hash_table->key_destroy_func (NODE_KEY (hash_table, i));
 
-          if (notify && hash_table->value_destroy_func)
-            hash_table->value_destroy_func (node->value);
+              if (hash_table->value_destroy_func)
+                hash_table->value_destroy_func (NODE_VALUE (hash_table, i));
+            }
         }
     }
 
-  /* We need to set node->key_hash = 0 for all nodes - might as well be GC
+  /* We need to empty all control bytes - might as well be GC
    * friendly and clear everything */
-  memset (hash_table->nodes, 0, hash_table->size * sizeof (GHashNode));
+  memset (hash_table->ctrl, CTRL_EMPTY, hash_table->size + GROUP_WIDTH);
+  memset (hash_table->slots, 0,
+          hash_table->size * hash_table->stride * sizeof (gpointer));
 
   hash_table->nnodes = 0;
   hash_table->noccupied = 0;
@@ -399,41 +549,96 @@ g_hash_table_remove_all_nodes (GHashTable *hash_table,
 static void
 g_hash_table_resize (GHashTable *hash_table)
 {
-  GHashNode *new_nodes;
-  gint old_size;
+  GHashTable old_table = *hash_table;
   gint i;
 
-  old_size = hash_table->size;
   g_hash_table_set_shift_from_size (hash_table, hash_table->nnodes * 2);
+  g_hash_table_alloc_nodes (hash_table, old_table.stride);
+
+  for (i = 0; i < old_table.size; i++)
+    {
+      guint hash_value;
+      guint node_index;
+
+      if (!CTRL_IS_FULL (old_table.ctrl[i]))
+        continue;
+
+      hash_value = g_hash_table_hash (hash_table, NODE_KEY (&old_table, i));
+      node_index = g_hash_table_find_free (hash_table, hash_value);
+
+      g_hash_table_set_ctrl (hash_table, node_index, HASH_CTRL (hash_value));
+      NODE_KEY (hash_table, node_index) = NODE_KEY (&old_table, i);
+      NODE_VALUE (hash_table, node_index) = NODE_VALUE (&old_table, i);
+    }
+
+  g_hash_table_free_nodes (&old_table);
+  hash_table->noccupied = hash_table->nnodes;
+}
+
+/*
+ * g_hash_table_rehash_in_place:
+ * @hash_table: our #GHashTable
+ *
+ * Gets rid of all tombstones without reallocating the buckets, by
+ * moving each node to the first bucket it can go to. Nodes that are
+ * still waiting to be moved are marked as CTRL_DELETED meanwhile.
+ */
+static void
+g_hash_table_rehash_in_place (GHashTable *hash_table)
+{
+  guint mask = hash_table->mask;
+  gint i;
 
-  new_nodes = g_new0 (GHashNode, hash_table->size);
+  for (i = 0; i < hash_table->size; i++)
+    hash_table->ctrl[i] = CTRL_IS_FULL (hash_table->ctrl[i]) ? CTRL_DELETED : CTRL_EMPTY;
+  for (i = 0; i < GROUP_WIDTH; i++)
+    hash_table->ctrl[hash_table->size + i] = hash_table->ctrl[i & mask];
 
-  for (i = 0; i < old_size; i++)
+  for (i = 0; i < hash_table->size; i++)
     {
-      GHashNode *node = &hash_table->nodes [i];
-      GHashNode *new_node;
-      guint hash_val;
-      guint step = 0;
+      guint hash_value, probe_start, node_index;
+      gpointer key, value;
 
-      if (node->key_hash <= 1)
+      if (hash_table->ctrl[i] != CTRL_DELETED)
         continue;
 
-      hash_val = node->key_hash % hash_table->mod;
-      new_node = &new_nodes [hash_val];
+      key = NODE_KEY (hash_table, i);
+      value = NODE_VALUE (hash_table, i);
+      hash_value = g_hash_table_hash (hash_table, key);
+      probe_start = hash_value & mask;
+      node_index = g_hash_table_find_free (hash_table, hash_value);
+
+      /* if the node already is in the group it would be put in,
+       * it can stay where it is
+       */
+      if (((node_index - probe_start) & mask) / GROUP_WIDTH ==
+          ((i - probe_start) & mask) / GROUP_WIDTH)
+        {
+          g_hash_table_set_ctrl (hash_table, i, HASH_CTRL (hash_value));
+          continue;
+        }
 
-      while (new_node->key_hash)
+      if (hash_table->ctrl[node_index] == CTRL_EMPTY)
+        {
+          g_hash_table_set_ctrl (hash_table, i, CTRL_EMPTY);
+          NODE_KEY (hash_table, i) = NULL;
+          NODE_VALUE (hash_table, i) = NULL;
+        }
+      else
         {
-          step++;
-          hash_val += step;
-          hash_val &= hash_table->mask;
-          new_node = &new_nodes [hash_val];
+          /* swap with a node that still has to be moved, and
+           * look at this bucket again
+           */
+          NODE_KEY (hash_table, i) = NODE_KEY (hash_table, node_index);
+          NODE_VALUE (hash_table, i) = NODE_VALUE (hash_table, node_index);
+          i--;
         }
 
-      *new_node = *node;
+      g_hash_table_set_ctrl (hash_table, node_index, HASH_CTRL (hash_value));
+      NODE_KEY (hash_table, node_index) = key;
+      NODE_VALUE (hash_table, node_index) = value;
     }
 
-  g_free (hash_table->nodes);
-  hash_table->nodes = new_nodes;
   hash_table->noccupied = hash_table->nnodes;
 }
 
@@ -444,7 +649,8 @@ g_hash_table_resize (GHashTable *hash_table)
  * Resizes the hash table, if needed.
  *
  * Essentially, calls g_hash_table_resize() if the table has strayed
- * too far from its ideal size for its number of nodes.
+ * too far from its ideal size for its number of nodes, or cleans
+ * up tombstones in place if the size is still right.
  */
 static inline void
 g_hash_table_maybe_resize (GHashTable *hash_table)
@@ -452,9 +658,15 @@ g_hash_table_maybe_resize (GHashTable *hash_table)
   gint noccupied = hash_table->noccupied;
   gint size = hash_table->size;
 
-  if ((size > hash_table->nnodes * 4 && size > 1 << HASH_TABLE_MIN_SHIFT) ||
-      (size <= noccupied + (noccupied / 16)))
+  if (size > hash_table->nnodes * 4 && size > 1 << HASH_TABLE_MIN_SHIFT)
     g_hash_table_resize (hash_table);
+  else if (noccupied >= size - size / 8)
+    {
+      if (hash_table->nnodes * 2 < size)
+        g_hash_table_rehash_in_place (hash_table);
+      else
+        g_hash_table_resize (hash_table);
+    }
 }
 
 /**
@@ -520,7 +732,7 @@ g_hash_table_new_full (GHashFunc       hash_func,
 #endif
   hash_table->key_destroy_func   = key_destroy_func;
   hash_table->value_destroy_func = value_destroy_func;
-  hash_table->nodes              = g_new0 (GHashNode, hash_table->size);
+  g_hash_table_alloc_nodes (hash_table, 1);
 
   return hash_table;
 }
@@ -582,7 +794,6 @@ g_hash_table_iter_next (GHashTableIter *iter,
 			gpointer       *value)
 {
   RealIter *ri = (RealIter *) iter;
-  GHashNode *node;
   gint position;
 
   g_return_val_if_fail (iter != NULL, FALSE);
@@ -601,15 +812,13 @@ g_hash_table_iter_next (GHashTableIter *iter,
           ri->position = position;
           return FALSE;
         }
-
-      node = &ri->hash_table->nodes [position];
     }
-  while (node->key_hash <= 1);
+  while (!CTRL_IS_FULL (ri->hash_table->ctrl[position]));
 
   if (key != NULL)
-    *key = node->key;
+    *key = NODE_KEY (ri->hash_table, position);
   if (value != NULL)
-    *value = node->value;
+    *value = NODE_VALUE (ri->hash_table, position);
 
   ri->position = position;
   return TRUE;
@@ -643,7 +852,7 @@ iter_remove_or_steal (RealIter *ri, gboolean notify)
   g_return_if_fail (ri->position >= 0);
   g_return_if_fail (ri->position < ri->hash_table->size);
 
-  g_hash_table_remove_node (ri->hash_table, &ri->hash_table->nodes [ri->position], notify);
+  g_hash_table_remove_node (ri->hash_table, ri->position, notify);
 
 #ifndef G_DISABLE_ASSERT
   ri->version++;
@@ -733,7 +942,7 @@ g_hash_table_unref (GHashTable *hash_table)
   if (g_atomic_int_exchange_and_add (&hash_table->ref_count, -1) - 1 == 0)
     {
       g_hash_table_remove_all_nodes (hash_table, TRUE);
-      g_free (hash_table->nodes);
+      g_hash_table_free_nodes (hash_table);
       g_slice_free (GHashTable, hash_table);
     }
 }
@@ -775,15 +984,13 @@ gpointer
 g_hash_table_lookup (GHashTable   *hash_table,
                      gconstpointer key)
 {
-  GHashNode *node;
-  guint      node_index;
+  gint node_index;
 
   g_return_val_if_fail (hash_table != NULL, NULL);
 
   node_index = g_hash_table_lookup_node (hash_table, key);
-  node = &hash_table->nodes [node_index];
 
-  return node->key_hash ? node->value : NULL;
+  return node_index >= 0 ? NODE_VALUE (hash_table, node_index) : NULL;
 }
 
 /**
@@ -809,22 +1016,20 @@ g_hash_table_lookup_extended (GHashTable    *hash_table,
                               gpointer      *orig_key,
                               gpointer      *value)
 {
-  GHashNode *node;
-  guint      node_index;
+  gint node_index;
 
   g_return_val_if_fail (hash_table != NULL, FALSE);
 
   node_index = g_hash_table_lookup_node (hash_table, lookup_key);
-  node = &hash_table->nodes [node_index];
 
-  if (!node->key_hash)
+  if (node_index < 0)
     return FALSE;
 
   if (orig_key)
-    *orig_key = node->key;
+    *orig_key = NODE_KEY (hash_table, node_index);
 
   if (value)
-    *value = node->value;
+    *value = NODE_VALUE (hash_table, node_index);
 
   return TRUE;
 }
@@ -851,47 +1056,43 @@ g_hash_table_insert_internal (GHashTable *hash_table,
                               gpointer    value,
                               gboolean    keep_new_key)
 {
-  GHashNode *node;
   guint node_index;
   guint key_hash;
-  guint old_hash;
+  guint8 old_ctrl;
 
   g_return_if_fail (hash_table != NULL);
   g_return_if_fail (hash_table->ref_count > 0);
 
   node_index = g_hash_table_lookup_node_for_insertion (hash_table, key, &key_hash);
-  node = &hash_table->nodes [node_index];
 
-  old_hash = node->key_hash;
+  old_ctrl = hash_table->ctrl[node_index];
 
-  if (old_hash > 1)
+  if (CTRL_IS_FULL (old_ctrl))
     {
-      if (keep_new_key)
-        {
-          if (hash_table->key_destroy_func)
-            hash_table->key_destroy_func (node->key);
-          node->key = key;
-        }
-      else
-        {
-          if (hash_table->key_destroy_func)
-            hash_table->key_destroy_func (key);
-        }
+      gpointer old_key = NODE_KEY (hash_table, node_index);
+      gpointer old_value = NODE_VALUE (hash_table, node_index);
+      gpointer new_key = keep_new_key ? key : old_key;
 
-      if (hash_table->value_destroy_func)
-        hash_table->value_destroy_func (node->value);
+      g_hash_table_ensure_values (hash_table, new_key, value);
+      NODE_KEY (hash_table, node_index) = new_key;
+      NODE_VALUE (hash_table, node_index) = value;
+
+      if (hash_table->key_destroy_func)
+        hash_table->key_destroy_func (keep_new_key ? old_key : key);
 
-      node->value = value;
+      if (hash_table->value_destroy_func)
+        hash_table->value_destroy_func (old_value);
     }
   else
     {
-      node->key = key;
-      node->value = value;
-      node->key_hash = key_hash;
+      g_hash_table_ensure_values (hash_table, key, value);
+      g_hash_table_set_ctrl (hash_table, node_index, HASH_CTRL (key_hash));
+      NODE_KEY (hash_table, node_index) = key;
+      NODE_VALUE (hash_table, node_index) = value;
 
       hash_table->nnodes++;
 
-      if (old_hash == 0)
+      if (old_ctrl == CTRL_EMPTY)
         {
           /* We replaced an empty node, and not a tombstone */
           hash_table->noccupied++;
@@ -965,19 +1166,16 @@ g_hash_table_remove_internal (GHashTable    *hash_table,
                               gconstpointer  key,
                               gboolean       notify)
 {
-  GHashNode *node;
-  guint node_index;
+  gint node_index;
 
   g_return_val_if_fail (hash_table != NULL, FALSE);
 
   node_index = g_hash_table_lookup_node (hash_table, key);
-  node = &hash_table->nodes [node_index];
 
-  /* g_hash_table_lookup_node() never returns a tombstone, so this is safe */
-  if (!node->key_hash)
+  if (node_index < 0)
     return FALSE;
 
-  g_hash_table_remove_node (hash_table, node, notify);
+  g_hash_table_remove_node (hash_table, node_index, notify);
   g_hash_table_maybe_resize (hash_table);
 
 #ifndef G_DISABLE_ASSERT
@@ -1103,11 +1301,10 @@ g_hash_table_foreach_remove_or_steal (GHashTable *hash_table,
 
   for (i = 0; i < hash_table->size; i++)
     {
-      GHashNode *node = &hash_table->nodes [i];
-
-      if (node->key_hash > 1 && (* func) (node->key, node->value, user_data))
+      if (CTRL_IS_FULL (hash_table->ctrl[i]) &&
+          (* func) (NODE_KEY (hash_table, i), NODE_VALUE (hash_table, i), user_data))
         {
-          g_hash_table_remove_node (hash_table, node, notify);
+          g_hash_table_remove_node (hash_table, i, notify);
           deleted++;
         }
     }
@@ -1204,10 +1401,8 @@ g_hash_table_foreach (GHashTable *hash_table,
 
   for (i = 0; i < hash_table->size; i++)
     {
-      GHashNode *node = &hash_table->nodes [i];
-
-      if (node->key_hash > 1)
-        (* func) (node->key, node->value, user_data);
+      if (CTRL_IS_FULL (hash_table->ctrl[i]))
+        (* func) (NODE_KEY (hash_table, i), NODE_VALUE (hash_table, i), user_data);
     }
 }
 
@@ -1249,10 +1444,9 @@ g_hash_table_find (GHashTable      *hash_table,
 
   for (i = 0; i < hash_table->size; i++)
     {
-      GHashNode *node = &hash_table->nodes [i];
-
-      if (node->key_hash > 1 && predicate (node->key, node->value, user_data))
-        return node->value;
+      if (CTRL_IS_FULL (hash_table->ctrl[i]) &&
+          predicate (NODE_KEY (hash_table, i), NODE_VALUE (hash_table, i), user_data))
+        return NODE_VALUE (hash_table, i);
     }
 
   return NULL;
@@ -1299,10 +1493,8 @@ g_hash_table_get_keys (GHashTable *hash_table)
   retval = NULL;
   for (i = 0; i < hash_table->size; i++)
     {
-      GHashNode *node = &hash_table->nodes [i];
-
-      if (node->key_hash > 1)
-        retval = g_list_prepend (retval, node->key);
+      if (CTRL_IS_FULL (hash_table->ctrl[i]))
+        retval = g_list_prepend (retval, NODE_KEY (hash_table, i));
     }
 
   return retval;
@@ -1333,14 +1525,1191 @@ g_hash_table_get_values (GHashTable *hash_table)
   retval = NULL;
   for (i = 0; i < hash_table->size; i++)
     {
-      GHashNode *node = &hash_table->nodes [i];
-
-      if (node->key_hash > 1)
-        retval = g_list_prepend (retval, node->value);
+      if (CTRL_IS_FULL (hash_table->ctrl[i]))
+        retval = g_list_prepend (retval, NODE_VALUE (hash_table, i));
     }
 
   return retval;
 }
 
+/* --- GConcurrentHashTable --- */
+
+/* Buckets are chains of nodes. Lookups don't take a lock, writers
+ * take the lock of the stripe their bucket belongs to. Nodes are
+ * never changed once they can be seen; replacing a value links in
+ * a new node instead.
+ *
+ * Unlinked nodes are "retired" and only freed once no lookup can
+ * still be looking at them: every thread announces the epoch it
+ * saw while it is in a lookup, and the global epoch only moves on
+ * once all threads in a lookup have seen it. Nodes retired in an
+ * epoch can be freed two epochs later.
+ *
+ * The table grows by doubling. The new bucket array is installed
+ * right away, and the nodes of each old bucket are copied over when
+ * a writer first touches the bucket, or by writers helping out a
+ * few buckets at a time. Copied buckets are marked CHASH_MOVED.
+ */
+
+#define CHASH_N_STRIPES      32
+#define CHASH_MIN_SHIFT      5   /* at least a bucket for each stripe */
+#define CHASH_MIGRATE_BATCH  4
+#define CHASH_RECLAIM_BATCH  64
+
+#define CHASH_DESTROY_KEY    (1 << 0)
+#define CHASH_DESTROY_VALUE  (1 << 1)
+
+typedef struct _GConcurrentHashNode    GConcurrentHashNode;
+typedef struct _GConcurrentHashBuckets GConcurrentHashBuckets;
+typedef struct _GConcurrentHashReader  GConcurrentHashReader;
+
+struct _GConcurrentHashNode
+{
+  GConcurrentHashNode * volatile next;
+  gpointer                       key;
+  gpointer                       value;
+  guint                          hash;
+
+  /* set when the node is retired */
+  guint                          retired_epoch;
+  guint                          destroy_flags;
+  GConcurrentHashNode           *retired_next;
+};
+
+struct _GConcurrentHashBuckets
+{
+  guint                             size;
+  guint                             mask;
+  /* the array the nodes are being copied from, until they all are */
+  GConcurrentHashBuckets * volatile old;
+  /* the array the nodes are copied to, once there is one */
+  GConcurrentHashBuckets * volatile next;
+  volatile gint                     migrate_pos;
+  volatile gint                     n_migrated;
+
+  guint                             retired_epoch;
+  GConcurrentHashBuckets           *retired_next;
+
+  GConcurrentHashNode * volatile    heads[1];
+};
+
+typedef struct
+{
+  GStaticMutex  mutex;
+  volatile gint nnodes;
+} GConcurrentHashStripe;
+
+struct _GConcurrentHashTable
+{
+  GConcurrentHashBuckets * volatile buckets;
+  GConcurrentHashStripe             stripes[CHASH_N_STRIPES];
+  GHashFunc                         hash_func;
+  GEqualFunc                        key_equal_func;
+  GDestroyNotify                    key_destroy_func;
+  GDestroyNotify                    value_destroy_func;
+  volatile gint                     ref_count;
+  volatile gint                     n_iterators;
+
+  /* nodes and bucket arrays waiting to be freed, newest first */
+  GStaticMutex                      retired_lock;
+  GConcurrentHashNode              *retired_nodes;
+  GConcurrentHashBuckets           *retired_buckets;
+  volatile gint                     n_retired;
+  gint                              reclaim_at;
+};
+
+struct _GConcurrentHashReader
+{
+  volatile gint          state;    /* epoch << 1 | 1 while reading, else 0 */
+  guint                  nesting;
+  volatile gint          in_use;
+  GConcurrentHashReader *next;
+};
+
+typedef struct
+{
+  GConcurrentHashTable   *table;
+  GConcurrentHashBuckets *root;
+  GConcurrentHashNode    *node;
+  int                     level;
+  int                     position;
+  gpointer                dummy6;
+} RealConcurrentIter;
+
+static GConcurrentHashNode             chash_moved_node;
+#define CHASH_MOVED                    (&chash_moved_node)
+
+static GConcurrentHashReader * volatile chash_readers = NULL;
+static volatile gint                    chash_epoch = 0;
+static GStaticPrivate                   chash_reader_private = G_STATIC_PRIVATE_INIT;
+
+static void
+g_concurrent_hash_reader_release (gpointer data)
+{
+  GConcurrentHashReader *reader = data;
+
+  g_atomic_int_set (&reader->in_use, FALSE);
+}
+
+static GConcurrentHashReader *
+g_concurrent_hash_reader_get (void)
+{
+  GConcurrentHashReader *reader;
+
+  reader = g_static_private_get (&chash_reader_private);
+  if (G_LIKELY (reader))
+    return reader;
+
+  /* take over the record of a thread that is gone, if any */
+  for (reader = g_atomic_pointer_get (&chash_readers); reader; reader = reader->next)
+    if (g_atomic_int_compare_and_exchange (&reader->in_use, FALSE, TRUE))
+      break;
+
+  if (!reader)
+    {
+      reader = g_new0 (GConcurrentHashReader, 1);
+      reader->in_use = TRUE;
+
+      do
+        reader->next = g_atomic_pointer_get (&chash_readers);
+      while (!g_atomic_pointer_compare_and_exchange ((volatile gpointer *) &chash_readers,
+                                                     reader->next, reader));
+    }
+
+  g_static_private_set (&chash_reader_private, reader,
+                        g_concurrent_hash_reader_release);
+
+  return reader;
+}
+
+static inline GConcurrentHashReader *
+g_concurrent_hash_enter (void)
+{
+  GConcurrentHashReader *reader = g_concurrent_hash_reader_get ();
+
+  if (reader->nesting++ == 0)
+    {
+      guint epoch = g_atomic_int_get (&chash_epoch);
+
+      /* a full barrier, so that this is seen before anything is read */
+      g_atomic_int_compare_and_exchange (&reader->state, 0, (gint) (epoch << 1 | 1));
+    }
+
+  return reader;
+}
+
+static inline void
+g_concurrent_hash_leave (GConcurrentHashReader *reader)
+{
+  if (--reader->nesting == 0)
+    {
+#if defined (__GNUC__) && !defined (G_ATOMIC_OP_MEMORY_BARRIER_NEEDED)
+      /* the CPU keeps earlier reads before this store, the compiler
+       * has to be told to do the same
+       */
+      __asm__ __volatile__ ("" : : : "memory");
+      reader->state = 0;
+#else
+      g_atomic_int_add (&reader->state, -reader->state);
+#endif
+    }
+}
+
+/* Moves the epoch on if every thread in a lookup has seen the
+ * current one, and returns the epoch.
+ */
+static guint
+g_concurrent_hash_advance_epoch (void)
+{
+  GConcurrentHashReader *reader;
+  guint epoch;
+  gint active;
+
+  epoch = g_atomic_int_get (&chash_epoch);
+  active = (gint) (epoch << 1 | 1);
+
+  for (reader = g_atomic_pointer_get (&chash_readers); reader; reader = reader->next)
+    {
+      gint state = g_atomic_int_get (&reader->state);
+
+      if (state != 0 && state != active)
+        return epoch;
+    }
+
+  g_atomic_int_compare_and_exchange (&chash_epoch, epoch, epoch + 1);
+
+  return g_atomic_int_get (&chash_epoch);
+}
+
+/* Like a plain store, but the node is fully initialized before it
+ * can be seen.
+ */
+static inline void
+g_concurrent_hash_publish (GConcurrentHashNode * volatile *location,
+                           GConcurrentHashNode            *node)
+{
+  GConcurrentHashNode *old;
+
+  do
+    old = *location;
+  while (!g_atomic_pointer_compare_and_exchange ((volatile gpointer *) location, old, node));
+}
+
+static inline guint
+g_concurrent_hash_table_hash (GConcurrentHashTable *table,
+                              gconstpointer         key)
+{
+  guint hash_value = (* table->hash_func) (key);
+
+  hash_value *= 0x9e3779b1;
+
+  return hash_value ^ (hash_value >> 15);
+}
+
+static inline gboolean
+g_concurrent_hash_table_node_matches (GConcurrentHashTable *table,
+                                      GConcurrentHashNode  *node,
+                                      gconstpointer         key,
+                                      guint                 hash)
+{
+  if (node->hash != hash)
+    return FALSE;
+
+  if (table->key_equal_func)
+    return table->key_equal_func (node->key, key);
+
+  return node->key == key;
+}
+
+static GConcurrentHashBuckets *
+g_concurrent_hash_buckets_new (guint size)
+{
+  GConcurrentHashBuckets *buckets;
+
+  buckets = g_malloc0 (sizeof (GConcurrentHashBuckets) +
+                       (size - 1) * sizeof (GConcurrentHashNode *));
+  buckets->size = size;
+  buckets->mask = size - 1;
+
+  return buckets;
+}
+
+static void
+g_concurrent_hash_table_free_node (GConcurrentHashTable *table,
+                                   GConcurrentHashNode  *node,
+                                   guint                 destroy_flags)
+{
+  if ((destroy_flags & CHASH_DESTROY_KEY) && table->key_destroy_func)
+    table->key_destroy_func (node->key);
+
+  if ((destroy_flags & CHASH_DESTROY_VALUE) && table->value_destroy_func)
+    table->value_destroy_func (node->value);
+
+  g_slice_free (GConcurrentHashNode, node);
+}
+
+/* Called with the stripe lock held, after @node has been unlinked */
+static void
+g_concurrent_hash_table_retire_node (GConcurrentHashTable *table,
+                                     GConcurrentHashNode  *node,
+                                     guint                 destroy_flags)
+{
+  node->destroy_flags = destroy_flags;
+
+  g_static_mutex_lock (&table->retired_lock);
+  node->retired_epoch = g_atomic_int_get (&chash_epoch);
+  node->retired_next = table->retired_nodes;
+  table->retired_nodes = node;
+  table->n_retired++;
+  g_static_mutex_unlock (&table->retired_lock);
+}
+
+/*
+ * g_concurrent_hash_table_reclaim:
+ * @table: our #GConcurrentHashTable
+ *
+ * Frees the retired nodes and bucket arrays that no lookup can reach
+ * anymore, unless an iterator is in progress, and calls the destroy
+ * notifies for them. Must not be called from inside a lookup.
+ */
+static void
+g_concurrent_hash_table_reclaim (GConcurrentHashTable *table)
+{
+  GConcurrentHashNode *nodes = NULL, **node_link, *node;
+  GConcurrentHashBuckets *buckets = NULL, **buckets_link;
+  guint epoch;
+
+  epoch = g_concurrent_hash_advance_epoch ();
+
+  g_static_mutex_lock (&table->retired_lock);
+
+  if (g_atomic_int_get (&table->n_iterators) == 0)
+    {
+      /* the lists are sorted by epoch, cut off the old enough tails;
+       * other threads may have retired things in a later epoch than
+       * @epoch since it was read
+       */
+      for (node_link = &table->retired_nodes; *node_link; node_link = &(*node_link)->retired_next)
+        if ((gint) (epoch - (*node_link)->retired_epoch) >= 2)
+          break;
+      nodes = *node_link;
+      *node_link = NULL;
+
+      for (buckets_link = &table->retired_buckets; *buckets_link; buckets_link = &(*buckets_link)->retired_next)
+        if ((gint) (epoch - (*buckets_link)->retired_epoch) >= 2)
+          break;
+      buckets = *buckets_link;
+      *buckets_link = NULL;
+
+      for (node = nodes; node; node = node->retired_next)
+        table->n_retired--;
+    }
+
+  table->reclaim_at = table->n_retired + CHASH_RECLAIM_BATCH;
+
+  g_static_mutex_unlock (&table->retired_lock);
+
+  while (nodes)
+    {
+      node = nodes;
+      nodes = node->retired_next;
+      g_concurrent_hash_table_free_node (table, node, node->destroy_flags);
+    }
+
+  while (buckets)
+    {
+      GConcurrentHashBuckets *next = buckets->retired_next;
+
+      g_free (buckets);
+      buckets = next;
+    }
+}
+
+static inline void
+g_concurrent_hash_table_maybe_reclaim (GConcurrentHashTable *table)
+{
+  if (g_atomic_int_get (&table->n_retired) >= table->reclaim_at)
+    g_concurrent_hash_table_reclaim (table);
+}
+
+/*
+ * g_concurrent_hash_table_migrate:
+ * @table: our #GConcurrentHashTable
+ * @old: the bucket array being moved away from
+ * @index: a bucket of @old
+ *
+ * Copies the nodes of a bucket of @old to the next bucket array,
+ * and marks the bucket as moved. The stripe lock for the bucket
+ * must be held.
+ */
+static void
+g_concurrent_hash_table_migrate (GConcurrentHashTable   *table,
+                                 GConcurrentHashBuckets *old,
+                                 guint                   index)
+{
+  GConcurrentHashBuckets *buckets = g_atomic_pointer_get (&old->next);
+  GConcurrentHashNode *head, *node;
+
+  head = g_atomic_pointer_get (&old->heads[index]);
+
+  /* nobody looks at the new buckets before this one is marked as
+   * moved, so they can be filled in with plain stores
+   */
+  for (node = head; node; node = node->next)
+    {
+      GConcurrentHashNode *copy = g_slice_new (GConcurrentHashNode);
+      guint new_index = node->hash & buckets->mask;
+
+      copy->key = node->key;
+      copy->value = node->value;
+      copy->hash = node->hash;
+      copy->next = buckets->heads[new_index];
+      buckets->heads[new_index] = copy;
+    }
+
+  g_concurrent_hash_publish (&old->heads[index], CHASH_MOVED);
+
+  while (head)
+    {
+      node = head;
+      head = node->next;
+      g_concurrent_hash_table_retire_node (table, node, 0);
+    }
+
+  if (g_atomic_int_exchange_and_add (&old->n_migrated, 1) + 1 == (gint) old->size)
+    {
+      g_atomic_pointer_compare_and_exchange ((volatile gpointer *) &buckets->old, old, NULL);
+
+      g_static_mutex_lock (&table->retired_lock);
+      old->retired_epoch = g_atomic_int_get (&chash_epoch);
+      old->retired_next = table->retired_buckets;
+      table->retired_buckets = old;
+      g_static_mutex_unlock (&table->retired_lock);
+    }
+}
+
+/* Moves a few more buckets to the new array, if the table is being
+ * resized. Called from inside a lookup, without any stripe lock.
+ */
+static void
+g_concurrent_hash_table_help_migrate (GConcurrentHashTable *table)
+{
+  GConcurrentHashBuckets *buckets, *old;
+  gint i;
+
+  buckets = g_atomic_pointer_get (&table->buckets);
+  old = g_atomic_pointer_get (&buckets->old);
+  if (!old)
+    return;
+
+  for (i = 0; i < CHASH_MIGRATE_BATCH; i++)
+    {
+      GStaticMutex *mutex;
+      gint index;
+
+      index = g_atomic_int_exchange_and_add (&old->migrate_pos, 1);
+      if (index >= (gint) old->size)
+        break;
+
+      mutex = &table->stripes[index & (CHASH_N_STRIPES - 1)].mutex;
+      g_static_mutex_lock (mutex);
+      if (g_atomic_pointer_get (&old->heads[index]) != CHASH_MOVED)
+        g_concurrent_hash_table_migrate (table, old, index);
+      g_static_mutex_unlock (mutex);
+    }
+}
+
+/* Starts doubling the number of buckets, unless the table is
+ * already being resized.
+ */
+static void
+g_concurrent_hash_table_maybe_grow (GConcurrentHashTable *table)
+{
+  GConcurrentHashBuckets *buckets, *new_buckets;
+
+  buckets = g_atomic_pointer_get (&table->buckets);
+  if (g_atomic_pointer_get (&buckets->old) ||
+      g_concurrent_hash_table_size (table) <= buckets->size)
+    return;
+
+  new_buckets = g_concurrent_hash_buckets_new (buckets->size * 2);
+  new_buckets->old = buckets;
+
+  if (!g_atomic_pointer_compare_and_exchange ((volatile gpointer *) &buckets->next,
+                                              NULL, new_buckets))
+    {
+      g_free (new_buckets);
+      return;
+    }
+
+  g_atomic_pointer_compare_and_exchange ((volatile gpointer *) &table->buckets,
+                                         buckets, new_buckets);
+}
+
+/*
+ * g_concurrent_hash_table_lock_bucket:
+ * @table: our #GConcurrentHashTable
+ * @hash: the hash value of a key
+ * @stripe_return: return location for the stripe that was locked
+ * Return value: the current bucket array
+ *
+ * Takes the lock for the bucket of @hash. If the bucket hasn't been
+ * copied to the current bucket array yet, it is copied first.
+ */
+static GConcurrentHashBuckets *
+g_concurrent_hash_table_lock_bucket (GConcurrentHashTable   *table,
+                                     guint                   hash,
+                                     GConcurrentHashStripe **stripe_return)
+{
+  GConcurrentHashStripe *stripe;
+  GConcurrentHashBuckets *buckets, *old;
+
+  stripe = &table->stripes[hash & (CHASH_N_STRIPES - 1)];
+  g_static_mutex_lock (&stripe->mutex);
+
+  buckets = g_atomic_pointer_get (&table->buckets);
+  old = g_atomic_pointer_get (&buckets->old);
+  if (old && g_atomic_pointer_get (&old->heads[hash & old->mask]) != CHASH_MOVED)
+    g_concurrent_hash_table_migrate (table, old, hash & old->mask);
+
+  *stripe_return = stripe;
+
+  return buckets;
+}
+
+/* Must be called from inside a lookup */
+static GConcurrentHashNode *
+g_concurrent_hash_table_lookup_node (GConcurrentHashTable *table,
+                                     gconstpointer         key)
+{
+  GConcurrentHashBuckets *buckets, *old;
+  GConcurrentHashNode *node;
+  guint hash;
+
+  hash = g_concurrent_hash_table_hash (table, key);
+  buckets = g_atomic_pointer_get (&table->buckets);
+
+  /* buckets that haven't been copied yet are still authoritative */
+  old = g_atomic_pointer_get (&buckets->old);
+  node = old ? g_atomic_pointer_get (&old->heads[hash & old->mask]) : CHASH_MOVED;
+
+  if (node == CHASH_MOVED)
+    {
+      node = g_atomic_pointer_get (&buckets->heads[hash & buckets->mask]);
+
+      /* the table may have been resized again in the meantime */
+      while (node == CHASH_MOVED)
+        {
+          buckets = g_atomic_pointer_get (&buckets->next);
+          node = g_atomic_pointer_get (&buckets->heads[hash & buckets->mask]);
+        }
+    }
+
+  for (; node; node = g_atomic_pointer_get (&node->next))
+    if (g_concurrent_hash_table_node_matches (table, node, key, hash))
+      return node;
+
+  return NULL;
+}
+
+/**
+ * g_concurrent_hash_table_new:
+ * @hash_func: a function to create a hash value from a key, or %NULL
+ *   for g_direct_hash()
+ * @key_equal_func: a function to check two keys for equality, or
+ *   %NULL to compare keys directly
+ *
+ * Creates a new #GConcurrentHashTable with a reference count of 1.
+ * See g_hash_table_new() for the meaning of the functions.
+ *
+ * Return value: a new #GConcurrentHashTable.
+ *
+ * Since: 2.20
+ **/
+GConcurrentHashTable *
+g_concurrent_hash_table_new (GHashFunc  hash_func,
+                             GEqualFunc key_equal_func)
+{
+  return g_concurrent_hash_table_new_full (hash_func, key_equal_func, NULL, NULL);
+}
+
+/**
+ * g_concurrent_hash_table_new_full:
+ * @hash_func: a function to create a hash value from a key, or %NULL
+ *   for g_direct_hash()
+ * @key_equal_func: a function to check two keys for equality, or
+ *   %NULL to compare keys directly
+ * @key_destroy_func: a function to free keys that are removed from
+ *   the table, or %NULL
+ * @value_destroy_func: a function to free values that are removed
+ *   from the table, or %NULL
+ *
+ * Creates a new #GConcurrentHashTable like g_concurrent_hash_table_new()
+ * with a reference count of 1, and functions to free keys and values.
+ *
+ * Keys and values that are removed or replaced are not freed right
+ * away, but once no lookup in another thread can be looking at them
+ * anymore. The destroy functions may be called from any thread that
+ * modifies the table.
+ *
+ * Return value: a new #GConcurrentHashTable.
+ *
+ * Since: 2.20
+ **/
+GConcurrentHashTable *
+g_concurrent_hash_table_new_full (GHashFunc      hash_func,
+                                  GEqualFunc     key_equal_func,
+                                  GDestroyNotify key_destroy_func,
+                                  GDestroyNotify value_destroy_func)
+{
+  GConcurrentHashTable *table;
+  gint i;
+
+  table = g_new0 (GConcurrentHashTable, 1);
+  table->buckets = g_concurrent_hash_buckets_new (1 << CHASH_MIN_SHIFT);
+  for (i = 0; i < CHASH_N_STRIPES; i++)
+    g_static_mutex_init (&table->stripes[i].mutex);
+  table->hash_func = hash_func ? hash_func : g_direct_hash;
+  table->key_equal_func = key_equal_func;
+  table->key_destroy_func = key_destroy_func;
+  table->value_destroy_func = value_destroy_func;
+  table->ref_count = 1;
+  g_static_mutex_init (&table->retired_lock);
+  table->reclaim_at = CHASH_RECLAIM_BATCH;
+
+  return table;
+}
+
+/**
+ * g_concurrent_hash_table_ref:
+ * @table: a #GConcurrentHashTable
+ *
+ * Atomically increments the reference count of @table by one.
+ *
+ * Return value: the passed in #GConcurrentHashTable.
+ *
+ * Since: 2.20
+ **/
+GConcurrentHashTable *
+g_concurrent_hash_table_ref (GConcurrentHashTable *table)
+{
+  g_return_val_if_fail (table != NULL, NULL);
+  g_return_val_if_fail (table->ref_count > 0, table);
+
+  g_atomic_int_inc (&table->ref_count);
+
+  return table;
+}
+
+static void
+g_concurrent_hash_table_free_chain (GConcurrentHashTable *table,
+                                    GConcurrentHashNode  *node)
+{
+  while (node && node != CHASH_MOVED)
+    {
+      GConcurrentHashNode *next = node->next;
+
+      g_concurrent_hash_table_free_node (table, node,
+                                         CHASH_DESTROY_KEY | CHASH_DESTROY_VALUE);
+      node = next;
+    }
+}
+
+/**
+ * g_concurrent_hash_table_unref:
+ * @table: a #GConcurrentHashTable
+ *
+ * Atomically decrements the reference count of @table by one.
+ * If the reference count drops to 0, all keys and values are
+ * destroyed, and all memory allocated by the table is released.
+ *
+ * Since: 2.20
+ **/
+void
+g_concurrent_hash_table_unref (GConcurrentHashTable *table)
+{
+  GConcurrentHashBuckets *buckets, *old;
+  GConcurrentHashNode *node;
+  guint i;
+
+  g_return_if_fail (table != NULL);
+  g_return_if_fail (table->ref_count > 0);
+
+  if (!g_atomic_int_dec_and_test (&table->ref_count))
+    return;
+
+  buckets = table->buckets;
+  old = buckets->old;
+
+  if (old)
+    {
+      for (i = 0; i < old->size; i++)
+        g_concurrent_hash_table_free_chain (table, old->heads[i]);
+      g_free (old);
+    }
+
+  for (i = 0; i < buckets->size; i++)
+    g_concurrent_hash_table_free_chain (table, buckets->heads[i]);
+  g_free (buckets);
+
+  while (table->retired_nodes)
+    {
+      node = table->retired_nodes;
+      table->retired_nodes = node->retired_next;
+      g_concurrent_hash_table_free_node (table, node, node->destroy_flags);
+    }
+
+  while (table->retired_buckets)
+    {
+      old = table->retired_buckets;
+      table->retired_buckets = old->retired_next;
+      g_free (old);
+    }
+
+  for (i = 0; i < CHASH_N_STRIPES; i++)
+    g_static_mutex_free (&table->stripes[i].mutex);
+  g_static_mutex_free (&table->retired_lock);
+
+  g_free (table);
+}
+
+/**
+ * g_concurrent_hash_table_lookup:
+ * @table: a #GConcurrentHashTable
+ * @key: the key to look up
+ *
+ * Looks up a key in a #GConcurrentHashTable, without taking a lock.
+ *
+ * As with a #GHashTable, the value belongs to the table. If other
+ * threads may remove or replace @key, and the table frees its values,
+ * the value must not be used after the key may have been removed.
+ *
+ * Return value: the associated value, or %NULL if the key is not found.
+ *
+ * Since: 2.20
+ **/
+gpointer
+g_concurrent_hash_table_lookup (GConcurrentHashTable *table,
+                                gconstpointer         key)
+{
+  GConcurrentHashReader *reader;
+  GConcurrentHashNode *node;
+  gpointer value;
+
+  g_return_val_if_fail (table != NULL, NULL);
+
+  reader = g_concurrent_hash_enter ();
+  node = g_concurrent_hash_table_lookup_node (table, key);
+  value = node ? node->value : NULL;
+  g_concurrent_hash_leave (reader);
+
+  return value;
+}
+
+/**
+ * g_concurrent_hash_table_lookup_extended:
+ * @table: a #GConcurrentHashTable
+ * @lookup_key: the key to look up
+ * @orig_key: return location for the original key, or %NULL
+ * @value: return location for the value associated with the key, or %NULL
+ *
+ * Looks up a key in a #GConcurrentHashTable like
+ * g_concurrent_hash_table_lookup(), returning the original key and
+ * the associated value, which always belong together.
+ *
+ * Return value: %TRUE if the key was found in the #GConcurrentHashTable.
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_concurrent_hash_table_lookup_extended (GConcurrentHashTable *table,
+                                         gconstpointer         lookup_key,
+                                         gpointer             *orig_key,
+                                         gpointer             *value)
+{
+  GConcurrentHashReader *reader;
+  GConcurrentHashNode *node;
+
+  g_return_val_if_fail (table != NULL, FALSE);
+
+  reader = g_concurrent_hash_enter ();
+  node = g_concurrent_hash_table_lookup_node (table, lookup_key);
+  if (node)
+    {
+      if (orig_key)
+        *orig_key = node->key;
+      if (value)
+        *value = node->value;
+    }
+  g_concurrent_hash_leave (reader);
+
+  return node != NULL;
+}
+
+/*
+ * g_concurrent_hash_table_insert_internal:
+ * @table: our #GConcurrentHashTable
+ * @key: the key to insert
+ * @value: the value to insert
+ * @keep_new_key: if %TRUE and this key already exists in the table
+ *   then destroy the old key, else destroy the new key.
+ *
+ * Implements the common logic for g_concurrent_hash_table_insert()
+ * and g_concurrent_hash_table_replace().
+ */
+static void
+g_concurrent_hash_table_insert_internal (GConcurrentHashTable *table,
+                                         gpointer              key,
+                                         gpointer              value,
+                                         gboolean              keep_new_key)
+{
+  GConcurrentHashReader *reader;
+  GConcurrentHashStripe *stripe;
+  GConcurrentHashBuckets *buckets;
+  GConcurrentHashNode * volatile *head;
+  GConcurrentHashNode * volatile *location;
+  GConcurrentHashNode *node, *new_node;
+  gboolean grow = FALSE;
+  guint hash;
+
+  g_return_if_fail (table != NULL);
+  g_return_if_fail (table->ref_count > 0);
+
+  reader = g_concurrent_hash_enter ();
+
+  hash = g_concurrent_hash_table_hash (table, key);
+  buckets = g_concurrent_hash_table_lock_bucket (table, hash, &stripe);
+  head = &buckets->heads[hash & buckets->mask];
+
+  for (location = head; (node = *location); location = &node->next)
+    if (g_concurrent_hash_table_node_matches (table, node, key, hash))
+      break;
+
+  new_node = g_slice_new (GConcurrentHashNode);
+  new_node->value = value;
+  new_node->hash = hash;
+
+  if (node)
+    {
+      new_node->key = keep_new_key ? key : node->key;
+      new_node->next = node->next;
+      g_concurrent_hash_publish (location, new_node);
+
+      g_concurrent_hash_table_retire_node (table, node,
+                                           keep_new_key ?
+                                           CHASH_DESTROY_KEY | CHASH_DESTROY_VALUE :
+                                           CHASH_DESTROY_VALUE);
+    }
+  else
+    {
+      new_node->key = key;
+      new_node->next = *head;
+      g_concurrent_hash_publish (head, new_node);
+
+      stripe->nnodes++;
+      grow = stripe->nnodes * CHASH_N_STRIPES > (gint) buckets->size;
+    }
+
+  g_static_mutex_unlock (&stripe->mutex);
+
+  if (node && !keep_new_key && table->key_destroy_func)
+    table->key_destroy_func (key);
+
+  if (grow)
+    g_concurrent_hash_table_maybe_grow (table);
+  g_concurrent_hash_table_help_migrate (table);
+
+  g_concurrent_hash_leave (reader);
+
+  g_concurrent_hash_table_maybe_reclaim (table);
+}
+
+/**
+ * g_concurrent_hash_table_insert:
+ * @table: a #GConcurrentHashTable
+ * @key: a key to insert
+ * @value: the value to associate with the key
+ *
+ * Inserts a new key and value into a #GConcurrentHashTable, like
+ * g_hash_table_insert(). If the key already exists, its value is
+ * replaced and the passed key is freed right away.
+ *
+ * Since: 2.20
+ **/
+void
+g_concurrent_hash_table_insert (GConcurrentHashTable *table,
+                                gpointer              key,
+                                gpointer              value)
+{
+  g_concurrent_hash_table_insert_internal (table, key, value, FALSE);
+}
+
+/**
+ * g_concurrent_hash_table_replace:
+ * @table: a #GConcurrentHashTable
+ * @key: a key to insert
+ * @value: the value to associate with the key
+ *
+ * Inserts a new key and value into a #GConcurrentHashTable, like
+ * g_hash_table_replace(). If the key already exists, it is replaced
+ * by the new key as well.
+ *
+ * Since: 2.20
+ **/
+void
+g_concurrent_hash_table_replace (GConcurrentHashTable *table,
+                                 gpointer              key,
+                                 gpointer              value)
+{
+  g_concurrent_hash_table_insert_internal (table, key, value, TRUE);
+}
+
+/*
+ * g_concurrent_hash_table_remove_internal:
+ * @table: our #GConcurrentHashTable
+ * @key: the key to remove
+ * @notify: %TRUE if the destroy notify handlers are to be called
+ * Return value: %TRUE if a node was found and removed, else %FALSE
+ *
+ * Implements the common logic for g_concurrent_hash_table_remove()
+ * and g_concurrent_hash_table_steal().
+ */
+static gboolean
+g_concurrent_hash_table_remove_internal (GConcurrentHashTable *table,
+                                         gconstpointer         key,
+                                         gboolean              notify)
+{
+  GConcurrentHashReader *reader;
+  GConcurrentHashStripe *stripe;
+  GConcurrentHashBuckets *buckets;
+  GConcurrentHashNode * volatile *location;
+  GConcurrentHashNode *node;
+  guint hash;
+
+  g_return_val_if_fail (table != NULL, FALSE);
+
+  reader = g_concurrent_hash_enter ();
+
+  hash = g_concurrent_hash_table_hash (table, key);
+  buckets = g_concurrent_hash_table_lock_bucket (table, hash, &stripe);
+
+  for (location = &buckets->heads[hash & buckets->mask];
+       (node = *location);
+       location = &node->next)
+    if (g_concurrent_hash_table_node_matches (table, node, key, hash))
+      break;
+
+  if (node)
+    {
+      g_concurrent_hash_publish (location, node->next);
+      stripe->nnodes--;
+
+      g_concurrent_hash_table_retire_node (table, node,
+                                           notify ?
+                                           CHASH_DESTROY_KEY | CHASH_DESTROY_VALUE :
+                                           0);
+    }
+
+  g_static_mutex_unlock (&stripe->mutex);
+
+  g_concurrent_hash_table_help_migrate (table);
+
+  g_concurrent_hash_leave (reader);
+
+  g_concurrent_hash_table_maybe_reclaim (table);
+
+  return node != NULL;
+}
+
+/**
+ * g_concurrent_hash_table_remove:
+ * @table: a #GConcurrentHashTable
+ * @key: the key to remove
+ *
+ * Removes a key and its associated value from a #GConcurrentHashTable.
+ * The destroy functions passed to g_concurrent_hash_table_new_full()
+ * are called for them once no other thread can be looking at them.
+ *
+ * Return value: %TRUE if the key was found and removed.
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_concurrent_hash_table_remove (GConcurrentHashTable *table,
+                                gconstpointer         key)
+{
+  return g_concurrent_hash_table_remove_internal (table, key, TRUE);
+}
+
+/**
+ * g_concurrent_hash_table_steal:
+ * @table: a #GConcurrentHashTable
+ * @key: the key to remove
+ *
+ * Removes a key and its associated value from a #GConcurrentHashTable
+ * without calling the key and value destroy functions.
+ *
+ * Return value: %TRUE if the key was found and removed.
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_concurrent_hash_table_steal (GConcurrentHashTable *table,
+                               gconstpointer         key)
+{
+  return g_concurrent_hash_table_remove_internal (table, key, FALSE);
+}
+
+/**
+ * g_concurrent_hash_table_size:
+ * @table: a #GConcurrentHashTable
+ *
+ * Returns the number of elements contained in the #GConcurrentHashTable.
+ * While other threads modify the table, this is only an estimate.
+ *
+ * Return value: the number of key/value pairs.
+ *
+ * Since: 2.20
+ **/
+guint
+g_concurrent_hash_table_size (GConcurrentHashTable *table)
+{
+  gint nnodes = 0;
+  gint i;
+
+  g_return_val_if_fail (table != NULL, 0);
+
+  for (i = 0; i < CHASH_N_STRIPES; i++)
+    nnodes += g_atomic_int_get (&table->stripes[i].nnodes);
+
+  return MAX (nnodes, 0);
+}
+
+/**
+ * g_concurrent_hash_table_iter_init:
+ * @iter: an uninitialized #GConcurrentHashTableIter
+ * @table: a #GConcurrentHashTable
+ *
+ * Initializes a key/value pair iterator and associates it with
+ * @table. Unlike a #GHashTableIter, the iterator stays valid while
+ * the table is modified, also by other threads. Every key that is in
+ * the table for the whole iteration is returned exactly once; keys
+ * that are added or removed meanwhile may or may not be returned.
+ *
+ * The keys and values returned stay valid until the iteration is
+ * over, even if they are removed from the table. Until then, removed
+ * keys and values are not freed at all, so the iteration should be
+ * finished soon: either until g_concurrent_hash_table_iter_next()
+ * returns %FALSE, or with g_concurrent_hash_table_iter_clear().
+ *
+ * Since: 2.20
+ **/
+void
+g_concurrent_hash_table_iter_init (GConcurrentHashTableIter *iter,
+                                   GConcurrentHashTable     *table)
+{
+  RealConcurrentIter *ri = (RealConcurrentIter *) iter;
+  GConcurrentHashBuckets *buckets, *old;
+
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (table != NULL);
+
+  ri->table = g_concurrent_hash_table_ref (table);
+
+  /* a full barrier: nothing retired from now on is freed */
+  g_atomic_int_inc (&table->n_iterators);
+
+  /* start from the array the nodes are being copied from, its buckets
+   * lead on to the new ones once they have been copied
+   */
+  buckets = g_atomic_pointer_get (&table->buckets);
+  old = g_atomic_pointer_get (&buckets->old);
+  ri->root = old ? old : buckets;
+  ri->node = NULL;
+  ri->level = 0;
+  ri->position = -1;
+}
+
+/* Moves on to the next bucket that hasn't been moved, visiting the
+ * buckets of the root array in order, and for a moved bucket the
+ * two buckets of the next array it was copied to.
+ */
+static gboolean
+g_concurrent_hash_table_iter_next_bucket (RealConcurrentIter   *ri,
+                                          GConcurrentHashNode **head)
+{
+  GConcurrentHashBuckets *buckets;
+  gint level;
+
+  if (ri->position < 0)
+    ri->position = 0;
+  else
+    {
+      while (ri->level > 0)
+        {
+          guint parent_size = ri->root->size << (ri->level - 1);
+
+          if (!(ri->position & parent_size))
+            {
+              ri->position |= parent_size;
+              break;
+            }
+
+          ri->position &= ~parent_size;
+          ri->level--;
+        }
+
+      if (ri->level == 0 && ++ri->position >= (gint) ri->root->size)
+        return FALSE;
+    }
+
+  buckets = ri->root;
+  for (level = 0; level < ri->level; level++)
+    buckets = g_atomic_pointer_get (&buckets->next);
+
+  while ((*head = g_atomic_pointer_get (&buckets->heads[ri->position])) == CHASH_MOVED)
+    {
+      buckets = g_atomic_pointer_get (&buckets->next);
+      ri->level++;
+    }
+
+  return TRUE;
+}
+
+/**
+ * g_concurrent_hash_table_iter_next:
+ * @iter: an initialized #GConcurrentHashTableIter
+ * @key: a location to store the key, or %NULL
+ * @value: a location to store the value, or %NULL
+ *
+ * Advances @iter and retrieves the key and/or value that are now
+ * pointed to as a result of this advancement. If %FALSE is returned,
+ * @key and @value are not set, and the iteration is over.
+ *
+ * Return value: %FALSE if the end of the table has been reached.
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_concurrent_hash_table_iter_next (GConcurrentHashTableIter *iter,
+                                   gpointer                 *key,
+                                   gpointer                 *value)
+{
+  RealConcurrentIter *ri = (RealConcurrentIter *) iter;
+  GConcurrentHashNode *node;
+
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  if (ri->table == NULL)
+    return FALSE;
+
+  node = ri->node ? g_atomic_pointer_get (&ri->node->next) : NULL;
+
+  while (node == NULL)
+    if (!g_concurrent_hash_table_iter_next_bucket (ri, &node))
+      {
+        g_concurrent_hash_table_iter_clear (iter);
+        return FALSE;
+      }
+
+  ri->node = node;
+
+  if (key != NULL)
+    *key = node->key;
+  if (value != NULL)
+    *value = node->value;
+
+  return TRUE;
+}
+
+/**
+ * g_concurrent_hash_table_iter_clear:
+ * @iter: a #GConcurrentHashTableIter
+ *
+ * Ends an iteration before g_concurrent_hash_table_iter_next() has
+ * returned %FALSE, so that removed keys and values can be freed
+ * again. Calling it after the end of the iteration does nothing.
+ *
+ * Since: 2.20
+ **/
+void
+g_concurrent_hash_table_iter_clear (GConcurrentHashTableIter *iter)
+{
+  RealConcurrentIter *ri = (RealConcurrentIter *) iter;
+  GConcurrentHashTable *table;
+
+  g_return_if_fail (iter != NULL);
+
+  table = ri->table;
+  if (table == NULL)
+    return;
+
+  ri->table = NULL;
+  ri->node = NULL;
+
+  g_atomic_int_add (&table->n_iterators, -1);
+  g_concurrent_hash_table_unref (table);
+}
+
 #define __G_HASH_C__
 #include "galiasdef.c"
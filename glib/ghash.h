@@ -120,6 +120,55 @@ void        g_hash_table_unref             (GHashTable     *hash_table);
 
 #endif /* G_DISABLE_DEPRECATED */
 
+/* Concurrent hash tables
+ */
+typedef struct _GConcurrentHashTable     GConcurrentHashTable;
+typedef struct _GConcurrentHashTableIter GConcurrentHashTableIter;
+
+struct _GConcurrentHashTableIter
+{
+  /*< private >*/
+  gpointer	dummy1;
+  gpointer	dummy2;
+  gpointer	dummy3;
+  int		dummy4;
+  int		dummy5;
+  gpointer	dummy6;
+};
+
+GConcurrentHashTable* g_concurrent_hash_table_new      (GHashFunc             hash_func,
+							GEqualFunc            key_equal_func);
+GConcurrentHashTable* g_concurrent_hash_table_new_full (GHashFunc             hash_func,
+							GEqualFunc            key_equal_func,
+							GDestroyNotify        key_destroy_func,
+							GDestroyNotify        value_destroy_func);
+GConcurrentHashTable* g_concurrent_hash_table_ref      (GConcurrentHashTable *table);
+void                  g_concurrent_hash_table_unref    (GConcurrentHashTable *table);
+void                  g_concurrent_hash_table_insert   (GConcurrentHashTable *table,
+							gpointer              key,
+							gpointer              value);
+void                  g_concurrent_hash_table_replace  (GConcurrentHashTable *table,
+							gpointer              key,
+							gpointer              value);
+gboolean              g_concurrent_hash_table_remove   (GConcurrentHashTable *table,
+							gconstpointer         key);
+gboolean              g_concurrent_hash_table_steal    (GConcurrentHashTable *table,
+							gconstpointer         key);
+gpointer              g_concurrent_hash_table_lookup   (GConcurrentHashTable *table,
+							gconstpointer         key);
+gboolean              g_concurrent_hash_table_lookup_extended (GConcurrentHashTable *table,
+							gconstpointer         lookup_key,
+							gpointer             *orig_key,
+							gpointer             *value);
+guint                 g_concurrent_hash_table_size     (GConcurrentHashTable *table);
+
+void                  g_concurrent_hash_table_iter_init  (GConcurrentHashTableIter *iter,
+							  GConcurrentHashTable     *table);
+gboolean              g_concurrent_hash_table_iter_next  (GConcurrentHashTableIter *iter,
+							  gpointer                 *key,
+							  gpointer                 *value);
+void                  g_concurrent_hash_table_iter_clear (GConcurrentHashTableIter *iter);
+
 /* Hash Functions
  */
 gboolean g_str_equal (gconstpointer  v1,
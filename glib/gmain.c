@@ -75,6 +75,10 @@
 #include <sys/wait.h>
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+
 #include "galias.h"
 
 /* Types */
@@ -83,6 +87,9 @@ typedef struct _GTimeoutSource GTimeoutSource;
 typedef struct _GChildWatchSource GChildWatchSource;
 typedef struct _GPollRec GPollRec;
 typedef struct _GSourceCallback GSourceCallback;
+#ifdef HAVE_SYS_EPOLL_H
+typedef struct _GEpollRec GEpollRec;
+#endif
 
 typedef enum
 {
@@ -159,6 +166,21 @@ struct _GMainContext
 
   GTimeVal current_time;
   gboolean time_is_current;
+
+#ifdef HAVE_SYS_EPOLL_H
+  /* epoll backend, see g_main_context_set_epoll_enabled().
+   * Once created, the epoll set is kept in sync with poll_records
+   * until the context is freed.
+   */
+  gint epoll_fd;
+  gboolean epoll_enabled;
+  GHashTable *epoll_records;	/* fd -> GEpollRec */
+  GSList *epoll_unpollable;	/* GEpollRec's that epoll refused */
+  GSList *epoll_removed;	/* GEpollRec's waiting to be removed */
+  struct epoll_event *epoll_events;
+  guint epoll_events_size;
+  GPtrArray *epoll_ready;	/* GPollRec's with revents set by last check */
+#endif
 };
 
 struct _GSourceCallback
@@ -202,8 +224,26 @@ struct _GPollRec
   GPollFD *fd;
   GPollRec *next;
   gint priority;
+#ifdef HAVE_SYS_EPOLL_H
+  GEpollRec *epoll_rec;
+#endif
 };
 
+#ifdef HAVE_SYS_EPOLL_H
+/* All GPollRec's watching the same file descriptor share one
+ * registration in the epoll set, since epoll refuses duplicates.
+ */
+struct _GEpollRec
+{
+  gint fd;
+  gushort events;	/* union of the events of all poll_records */
+  gushort revents;	/* fixed result if unpollable */
+  guint registered : 1;
+  guint unpollable : 1;
+  GSList *poll_records;
+};
+#endif
+
 #ifdef G_THREADS_ENABLED
 #define LOCK_CONTEXT(context) g_static_mutex_lock (&context->mutex)
 #define UNLOCK_CONTEXT(context) g_static_mutex_unlock (&context->mutex)
@@ -246,6 +286,20 @@ static void g_main_context_add_poll_unlocked    (GMainContext *context,
 static void g_main_context_remove_poll_unlocked (GMainContext *context,
 						 GPollFD      *fd);
 static void g_main_context_wakeup_unlocked      (GMainContext *context);
+static gboolean g_main_context_check_begin      (GMainContext *context);
+static gboolean g_main_context_check_sources    (GMainContext *context,
+						 gint          max_priority);
+#ifdef HAVE_SYS_EPOLL_H
+static void g_main_context_epoll_register       (GMainContext *context,
+						 GPollRec     *pollrec);
+static void g_main_context_epoll_unregister     (GMainContext *context,
+						 GPollRec     *pollrec);
+static void g_main_context_epoll_flush_removed  (GMainContext *context);
+static void g_main_context_epoll_free           (GMainContext *context);
+static gboolean g_main_context_iterate_epoll    (GMainContext *context,
+						 gboolean      block,
+						 gint          max_priority);
+#endif
 
 static gboolean g_timeout_prepare  (GSource     *source,
 				    gint        *timeout);
@@ -372,6 +426,10 @@ g_main_context_unref (GMainContext *context)
   g_ptr_array_free (context->pending_dispatches, TRUE);
   g_free (context->cached_poll_array);
 
+#ifdef HAVE_SYS_EPOLL_H
+  g_main_context_epoll_free (context);
+#endif
+
   poll_rec_list_free (context, context->poll_records);
   
 #ifdef G_THREADS_ENABLED
@@ -490,6 +548,10 @@ g_main_context_new (void)
   
   context->cached_poll_array = NULL;
   context->cached_poll_array_size = 0;
+
+#ifdef HAVE_SYS_EPOLL_H
+  context->epoll_fd = -1;
+#endif
   
   context->pending_dispatches = g_ptr_array_new ();
   
@@ -2252,18 +2314,45 @@ g_main_context_check (GMainContext *context,
 		      GPollFD      *fds,
 		      gint          n_fds)
 {
-  GSource *source;
   GPollRec *pollrec;
-  gint n_ready = 0;
+  gboolean some_ready;
   gint i;
    
   LOCK_CONTEXT (context);
 
+  if (!g_main_context_check_begin (context))
+    {
+      UNLOCK_CONTEXT (context);
+      return FALSE;
+    }
+  
+  pollrec = context->poll_records;
+  i = 0;
+  while (i < n_fds)
+    {
+      if (pollrec->fd->events)
+	pollrec->fd->revents = fds[i].revents;
+
+      pollrec = pollrec->next;
+      i++;
+    }
+
+  some_ready = g_main_context_check_sources (context, max_priority);
+
+  UNLOCK_CONTEXT (context);
+
+  return some_ready;
+}
+
+/* HOLDS: context's lock */
+/* Returns FALSE if the results of the last poll must be discarded */
+static gboolean
+g_main_context_check_begin (GMainContext *context)
+{
   if (context->in_check_or_prepare)
     {
       g_warning ("g_main_context_check() called recursively from within a source's check() or "
 		 "prepare() member.");
-      UNLOCK_CONTEXT (context);
       return FALSE;
     }
   
@@ -2282,22 +2371,19 @@ g_main_context_check (GMainContext *context,
    * and let the main loop rerun
    */
   if (context->poll_changed)
-    {
-      UNLOCK_CONTEXT (context);
-      return FALSE;
-    }
+    return FALSE;
 #endif /* G_THREADS_ENABLED */
-  
-  pollrec = context->poll_records;
-  i = 0;
-  while (i < n_fds)
-    {
-      if (pollrec->fd->events)
-	pollrec->fd->revents = fds[i].revents;
 
-      pollrec = pollrec->next;
-      i++;
-    }
+  return TRUE;
+}
+
+/* HOLDS: context's lock */
+static gboolean
+g_main_context_check_sources (GMainContext *context,
+			      gint          max_priority)
+{
+  GSource *source;
+  gint n_ready = 0;
 
   source = next_valid_source (context, NULL);
   while (source)
@@ -2346,8 +2432,6 @@ g_main_context_check (GMainContext *context,
       source = next_valid_source (context, source);
     }
 
-  UNLOCK_CONTEXT (context);
-
   return n_ready > 0;
 }
 
@@ -2382,6 +2466,9 @@ g_main_context_iterate (GMainContext *context,
   gboolean some_ready;
   gint nfds, allocated_nfds;
   GPollFD *fds = NULL;
+#ifdef HAVE_SYS_EPOLL_H
+  gboolean use_epoll;
+#endif
   
   UNLOCK_CONTEXT (context);
 
@@ -2413,36 +2500,52 @@ g_main_context_iterate (GMainContext *context,
   else
     LOCK_CONTEXT (context);
 #endif /* G_THREADS_ENABLED */
-  
-  if (!context->cached_poll_array)
+
+#ifdef HAVE_SYS_EPOLL_H
+  /* A custom poll function needs to see the full GPollFD array */
+  use_epoll = context->epoll_enabled && context->poll_func == g_poll;
+
+  if (use_epoll)
     {
-      context->cached_poll_array_size = context->n_poll_records;
-      context->cached_poll_array = g_new (GPollFD, context->n_poll_records);
+      UNLOCK_CONTEXT (context);
+
+      g_main_context_prepare (context, &max_priority);
+
+      some_ready = g_main_context_iterate_epoll (context, block, max_priority);
     }
+  else
+#endif
+    {
+      if (!context->cached_poll_array)
+	{
+	  context->cached_poll_array_size = context->n_poll_records;
+	  context->cached_poll_array = g_new (GPollFD, context->n_poll_records);
+	}
 
-  allocated_nfds = context->cached_poll_array_size;
-  fds = context->cached_poll_array;
+      allocated_nfds = context->cached_poll_array_size;
+      fds = context->cached_poll_array;
   
-  UNLOCK_CONTEXT (context);
+      UNLOCK_CONTEXT (context);
 
-  g_main_context_prepare (context, &max_priority); 
+      g_main_context_prepare (context, &max_priority); 
   
-  while ((nfds = g_main_context_query (context, max_priority, &timeout, fds, 
-				       allocated_nfds)) > allocated_nfds)
-    {
-      LOCK_CONTEXT (context);
-      g_free (fds);
-      context->cached_poll_array_size = allocated_nfds = nfds;
-      context->cached_poll_array = fds = g_new (GPollFD, nfds);
-      UNLOCK_CONTEXT (context);
-    }
+      while ((nfds = g_main_context_query (context, max_priority, &timeout, fds, 
+					   allocated_nfds)) > allocated_nfds)
+	{
+	  LOCK_CONTEXT (context);
+	  g_free (fds);
+	  context->cached_poll_array_size = allocated_nfds = nfds;
+	  context->cached_poll_array = fds = g_new (GPollFD, nfds);
+	  UNLOCK_CONTEXT (context);
+	}
 
-  if (!block)
-    timeout = 0;
+      if (!block)
+	timeout = 0;
   
-  g_main_context_poll (context, timeout, max_priority, fds, nfds);
+      g_main_context_poll (context, timeout, max_priority, fds, nfds);
   
-  some_ready = g_main_context_check (context, max_priority, fds, nfds);
+      some_ready = g_main_context_check (context, max_priority, fds, nfds);
+    }
   
   if (dispatch)
     g_main_context_dispatch (context);
@@ -2876,6 +2979,12 @@ g_main_context_add_poll_unlocked (GMainContext *context,
 
   context->n_poll_records++;
 
+#ifdef HAVE_SYS_EPOLL_H
+  newrec->epoll_rec = NULL;
+  if (context->epoll_fd >= 0)
+    g_main_context_epoll_register (context, newrec);
+#endif
+
 #ifdef G_THREADS_ENABLED
   context->poll_changed = TRUE;
 
@@ -2925,6 +3034,11 @@ g_main_context_remove_poll_unlocked (GMainContext *context,
 	  else
 	    context->poll_records = pollrec->next;
 
+#ifdef HAVE_SYS_EPOLL_H
+	  if (pollrec->epoll_rec)
+	    g_main_context_epoll_unregister (context, pollrec);
+#endif
+
 	  g_slice_free (GPollRec, pollrec);
 
 	  context->n_poll_records--;
@@ -3033,6 +3147,435 @@ g_main_context_get_poll_func (GMainContext *context)
   return result;
 }
 
+/**
+ * g_main_context_set_epoll_enabled:
+ * @context: a #GMainContext (if %NULL, the default context will be used)
+ * @enabled: whether to watch file descriptors with epoll
+ * 
+ * Switches @context between polling its file descriptors with the
+ * function set by g_main_context_set_poll_func() and watching them
+ * through an epoll(7) set.
+ *
+ * With the default poll function, each iteration of the main loop
+ * hands an array of all file descriptors to poll(), so its cost grows
+ * with the number of file descriptors. The epoll set is instead
+ * updated as file descriptors are added with g_source_add_poll() and
+ * removed with g_source_remove_poll(), and an iteration only looks at
+ * the file descriptors that are ready. This pays off for contexts
+ * that watch a large number of file descriptors.
+ *
+ * epoll is only used while no custom poll function has been set with
+ * g_main_context_set_poll_func(); g_main_context_query() and
+ * g_main_context_check() always work on #GPollFD arrays. Changes to
+ * the @events field of a #GPollFD after it has been added are not
+ * seen by epoll, remove and re-add the #GPollFD instead.
+ *
+ * Once created, the epoll set is kept up to date until @context
+ * is freed, even if epoll is disabled again.
+ *
+ * Return value: %TRUE if @context now uses epoll, %FALSE if @enabled
+ *   was %FALSE or epoll is not available on this system
+ *
+ * Since: 2.20
+ **/
+gboolean
+g_main_context_set_epoll_enabled (GMainContext *context,
+				  gboolean      enabled)
+{
+  gboolean result = FALSE;
+
+  if (!context)
+    context = g_main_context_default ();
+  
+  g_return_val_if_fail (g_atomic_int_get (&context->ref_count) > 0, FALSE);
+
+#ifdef HAVE_SYS_EPOLL_H
+  LOCK_CONTEXT (context);
+
+  if (enabled && context->epoll_fd < 0)
+    {
+      GPollRec *pollrec;
+
+#ifdef HAVE_EPOLL_CREATE1
+      context->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+#else
+      context->epoll_fd = epoll_create (64);
+      if (context->epoll_fd >= 0)
+	fcntl (context->epoll_fd, F_SETFD, FD_CLOEXEC);
+#endif
+
+      if (context->epoll_fd >= 0)
+	{
+	  context->epoll_records = g_hash_table_new (NULL, NULL);
+	  context->epoll_ready = g_ptr_array_new ();
+
+	  for (pollrec = context->poll_records; pollrec; pollrec = pollrec->next)
+	    g_main_context_epoll_register (context, pollrec);
+	}
+      else
+	g_warning ("epoll_create(2) failed due to: %s.", g_strerror (errno));
+    }
+
+  context->epoll_enabled = enabled && context->epoll_fd >= 0;
+  result = context->epoll_enabled;
+
+  if (!context->epoll_enabled && context->epoll_fd >= 0)
+    g_main_context_epoll_flush_removed (context);
+
+#ifdef G_THREADS_ENABLED
+  /* Make a loop that is currently polling pick up the change */
+  context->poll_changed = TRUE;
+  g_main_context_wakeup_unlocked (context);
+#endif
+
+  UNLOCK_CONTEXT (context);
+#endif /* HAVE_SYS_EPOLL_H */
+
+  return result;
+}
+
+#ifdef HAVE_SYS_EPOLL_H
+static guint32
+epoll_events_from_io (gushort events)
+{
+  guint32 result = 0;
+
+  if (events & G_IO_IN)
+    result |= EPOLLIN;
+  if (events & G_IO_OUT)
+    result |= EPOLLOUT;
+  if (events & G_IO_PRI)
+    result |= EPOLLPRI;
+
+  return result;
+}
+
+static gushort
+io_events_from_epoll (guint32 events)
+{
+  gushort result = 0;
+
+  if (events & EPOLLIN)
+    result |= G_IO_IN;
+  if (events & EPOLLOUT)
+    result |= G_IO_OUT;
+  if (events & EPOLLPRI)
+    result |= G_IO_PRI;
+  if (events & EPOLLERR)
+    result |= G_IO_ERR;
+  if (events & EPOLLHUP)
+    result |= G_IO_HUP;
+
+  return result;
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_update (GMainContext *context,
+			     GEpollRec    *epollrec,
+			     gboolean      force)
+{
+  struct epoll_event event;
+  gushort events = 0;
+  GSList *l;
+
+  for (l = epollrec->poll_records; l; l = l->next)
+    events |= ((GPollRec *)l->data)->fd->events;
+  events &= ~(G_IO_ERR|G_IO_HUP|G_IO_NVAL);
+
+  if (!force && events == epollrec->events)
+    return;
+
+  epollrec->events = events;
+
+  if (epollrec->unpollable)
+    return;
+
+  event.events = epoll_events_from_io (events);
+  event.data.u64 = 0;
+  event.data.fd = epollrec->fd;
+
+  /* The kernel silently drops closed file descriptors from the set,
+   * so a failed modification is retried as an addition.
+   */
+  if (epollrec->registered &&
+      epoll_ctl (context->epoll_fd, EPOLL_CTL_MOD, epollrec->fd, &event) == 0)
+    return;
+
+  if (epoll_ctl (context->epoll_fd, EPOLL_CTL_ADD, epollrec->fd, &event) == 0 ||
+      errno == EEXIST)
+    {
+      epollrec->registered = TRUE;
+      return;
+    }
+
+  /* epoll refuses regular files, which poll() reports as always
+   * ready, and invalid file descriptors, which poll() reports as
+   * G_IO_NVAL. Emulate poll() for these.
+   */
+  epollrec->registered = FALSE;
+  epollrec->unpollable = TRUE;
+  epollrec->revents = (errno == EPERM) ? (G_IO_IN | G_IO_OUT) : G_IO_NVAL;
+  context->epoll_unpollable = g_slist_prepend (context->epoll_unpollable,
+					       epollrec);
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_register (GMainContext *context,
+			       GPollRec     *pollrec)
+{
+  GEpollRec *epollrec;
+  gboolean force = FALSE;
+
+  epollrec = g_hash_table_lookup (context->epoll_records,
+				  GINT_TO_POINTER (pollrec->fd->fd));
+  if (!epollrec)
+    {
+      epollrec = g_slice_new0 (GEpollRec);
+      epollrec->fd = pollrec->fd->fd;
+      g_hash_table_insert (context->epoll_records,
+			   GINT_TO_POINTER (epollrec->fd), epollrec);
+      force = TRUE;
+    }
+  else if (!epollrec->poll_records)
+    {
+      /* Revived before its removal was flushed. The fd may have been
+       * closed and reused in the meantime, so talk to the kernel again.
+       */
+      context->epoll_removed = g_slist_remove (context->epoll_removed, epollrec);
+      if (epollrec->unpollable)
+	{
+	  context->epoll_unpollable = g_slist_remove (context->epoll_unpollable,
+						      epollrec);
+	  epollrec->unpollable = FALSE;
+	}
+      force = TRUE;
+    }
+
+  epollrec->poll_records = g_slist_prepend (epollrec->poll_records, pollrec);
+  pollrec->epoll_rec = epollrec;
+
+  g_main_context_epoll_update (context, epollrec, force);
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_remove (GMainContext *context,
+			     GEpollRec    *epollrec)
+{
+  struct epoll_event event = { 0, };
+
+  if (epollrec->unpollable)
+    context->epoll_unpollable = g_slist_remove (context->epoll_unpollable,
+						epollrec);
+  else if (epollrec->registered)
+    epoll_ctl (context->epoll_fd, EPOLL_CTL_DEL, epollrec->fd, &event);
+
+  g_hash_table_remove (context->epoll_records,
+		       GINT_TO_POINTER (epollrec->fd));
+  g_slice_free (GEpollRec, epollrec);
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_unregister (GMainContext *context,
+				 GPollRec     *pollrec)
+{
+  GEpollRec *epollrec = pollrec->epoll_rec;
+
+  pollrec->epoll_rec = NULL;
+  g_ptr_array_remove_fast (context->epoll_ready, pollrec);
+
+  epollrec->poll_records = g_slist_remove (epollrec->poll_records, pollrec);
+  if (epollrec->poll_records)
+    g_main_context_epoll_update (context, epollrec, FALSE);
+  else if (context->epoll_enabled)
+    {
+      /* Sources are blocked and unblocked around every dispatch, which
+       * removes and re-adds their fds. Defer the removal to the next
+       * iteration, so this doesn't cost two syscalls each time.
+       */
+      context->epoll_removed = g_slist_prepend (context->epoll_removed,
+						epollrec);
+    }
+  else
+    g_main_context_epoll_remove (context, epollrec);
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_flush_removed (GMainContext *context)
+{
+  GSList *l;
+
+  for (l = context->epoll_removed; l; l = l->next)
+    g_main_context_epoll_remove (context, l->data);
+
+  g_slist_free (context->epoll_removed);
+  context->epoll_removed = NULL;
+}
+
+static void
+epoll_rec_free (gpointer key,
+		gpointer value,
+		gpointer user_data)
+{
+  GEpollRec *epollrec = value;
+
+  g_slist_free (epollrec->poll_records);
+  g_slice_free (GEpollRec, epollrec);
+}
+
+static void
+g_main_context_epoll_free (GMainContext *context)
+{
+  if (context->epoll_fd < 0)
+    return;
+
+  g_hash_table_foreach (context->epoll_records, epoll_rec_free, NULL);
+  g_hash_table_destroy (context->epoll_records);
+  g_slist_free (context->epoll_unpollable);
+  g_slist_free (context->epoll_removed);
+  g_ptr_array_free (context->epoll_ready, TRUE);
+  g_free (context->epoll_events);
+
+  close (context->epoll_fd);
+  context->epoll_fd = -1;
+}
+
+/* HOLDS: context's lock */
+static void
+g_main_context_epoll_mark_ready (GMainContext *context,
+				 GEpollRec    *epollrec,
+				 gushort       revents,
+				 gint          max_priority)
+{
+  GSList *l;
+
+  for (l = epollrec->poll_records; l; l = l->next)
+    {
+      GPollRec *pollrec = l->data;
+
+      if (pollrec->priority > max_priority || !pollrec->fd->events)
+	continue;
+
+      pollrec->fd->revents = revents & (pollrec->fd->events |
+					G_IO_ERR | G_IO_HUP | G_IO_NVAL);
+      if (pollrec->fd->revents)
+	g_ptr_array_add (context->epoll_ready, pollrec);
+    }
+}
+
+/* Does the query, poll and check steps of an iteration of
+ * g_main_context_iterate() on the epoll set. Unlike
+ * g_main_context_query() and g_main_context_check(), this only
+ * touches the file descriptors that are actually ready.
+ */
+static gboolean
+g_main_context_iterate_epoll (GMainContext *context,
+			      gboolean      block,
+			      gint          max_priority)
+{
+  struct epoll_event *events;
+  gint epoll_fd;
+  gint n_events;
+  gint timeout;
+  gboolean some_ready;
+  GSList *l;
+  gint i;
+
+  LOCK_CONTEXT (context);
+
+#ifdef G_THREADS_ENABLED
+  context->poll_changed = FALSE;
+#endif
+
+  g_main_context_epoll_flush_removed (context);
+
+  timeout = context->timeout;
+  if (timeout != 0)
+    context->time_is_current = FALSE;
+
+  /* Unpollable file descriptors are always ready */
+  if (!block || context->epoll_unpollable)
+    timeout = 0;
+
+  if (context->epoll_events_size < MAX (g_hash_table_size (context->epoll_records), 1))
+    {
+      context->epoll_events_size = MAX (g_hash_table_size (context->epoll_records), 1);
+      context->epoll_events = g_renew (struct epoll_event,
+				       context->epoll_events,
+				       context->epoll_events_size);
+    }
+
+  events = context->epoll_events;
+  n_events = context->epoll_events_size;
+  epoll_fd = context->epoll_fd;
+
+  UNLOCK_CONTEXT (context);
+
+#ifdef G_MAIN_POLL_DEBUG
+  if (_g_main_poll_debug)
+    g_print ("epolling context=%p timeout=%d\n", context, timeout);
+#endif
+
+  n_events = epoll_wait (epoll_fd, events, n_events, timeout);
+  if (n_events < 0)
+    {
+      if (errno != EINTR)
+	g_warning ("epoll_wait(2) failed due to: %s.", g_strerror (errno));
+      n_events = 0;
+    }
+
+  LOCK_CONTEXT (context);
+
+  if (!g_main_context_check_begin (context))
+    {
+      UNLOCK_CONTEXT (context);
+      return FALSE;
+    }
+
+  /* Forget the results of the previous iteration */
+  for (i = 0; i < context->epoll_ready->len; i++)
+    {
+      GPollRec *pollrec = context->epoll_ready->pdata[i];
+
+      pollrec->fd->revents = 0;
+    }
+  g_ptr_array_set_size (context->epoll_ready, 0);
+
+  for (i = 0; i < n_events; i++)
+    {
+      GEpollRec *epollrec;
+
+      /* Look the fd up instead of storing a pointer in the event, the
+       * record may have been removed while we were waiting.
+       */
+      epollrec = g_hash_table_lookup (context->epoll_records,
+				      GINT_TO_POINTER (events[i].data.fd));
+      if (epollrec && !epollrec->unpollable)
+	g_main_context_epoll_mark_ready (context, epollrec,
+					 io_events_from_epoll (events[i].events),
+					 max_priority);
+    }
+
+  for (l = context->epoll_unpollable; l; l = l->next)
+    {
+      GEpollRec *epollrec = l->data;
+
+      g_main_context_epoll_mark_ready (context, epollrec,
+				       epollrec->revents, max_priority);
+    }
+
+  some_ready = g_main_context_check_sources (context, max_priority);
+
+  UNLOCK_CONTEXT (context);
+
+  return some_ready;
+}
+#endif /* HAVE_SYS_EPOLL_H */
+
 /* HOLDS: context's lock */
 /* Wake the main loop up from a poll() */
 static void
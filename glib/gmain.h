@@ -146,6 +146,8 @@ void     g_main_context_dispatch (GMainContext *context);
 void     g_main_context_set_poll_func (GMainContext *context,
 				       GPollFunc     func);
 GPollFunc g_main_context_get_poll_func (GMainContext *context);
+gboolean g_main_context_set_epoll_enabled (GMainContext *context,
+					   gboolean      enabled);
 
 /* Low level functions for use by source implementations
  */
@@ -69,63 +69,29 @@ struct _GMappedFile
 #endif
 };
 
-/**
- * g_mapped_file_new:
- * @filename: The path of the file to load, in the GLib filename encoding
- * @writable: whether the mapping should be writable
- * @error: return location for a #GError, or %NULL
- *
- * Maps a file into memory. On UNIX, this is using the mmap() function.
- *
- * If @writable is %TRUE, the mapped buffer may be modified, otherwise
- * it is an error to modify the mapped buffer. Modifications to the buffer 
- * are not visible to other processes mapping the same file, and are not 
- * written back to the file.
- *
- * Note that modifications of the underlying file might affect the contents
- * of the #GMappedFile. Therefore, mapping should only be used if the file 
- * will not be modified, or if all modifications of the file are done
- * atomically (e.g. using g_file_set_contents()). 
- *
- * Return value: a newly allocated #GMappedFile which must be freed
- *    with g_mapped_file_free(), or %NULL if the mapping failed. 
- *
- * Since: 2.8
+/* Maps @fd, which is left open. @filename is only used in messages,
+ * and may be %NULL.
  */
-GMappedFile *
-g_mapped_file_new (const gchar  *filename,
-		   gboolean      writable,
-		   GError      **error)
+static GMappedFile *
+mapped_file_new_from_fd (int           fd,
+			 gboolean      writable,
+			 const gchar  *filename,
+			 GError      **error)
 {
   GMappedFile *file;
-  int fd;
   struct stat st;
-
-  g_return_val_if_fail (filename != NULL, NULL);
-  g_return_val_if_fail (!error || *error == NULL, NULL);
-
-  fd = g_open (filename, (writable ? O_RDWR : O_RDONLY) | _O_BINARY, 0);
-  if (fd == -1)
-    {
-      int save_errno = errno;
-      gchar *display_filename = g_filename_display_name (filename);
-      
-      g_set_error (error,
-                   G_FILE_ERROR,
-                   g_file_error_from_errno (save_errno),
-                   _("Failed to open file '%s': open() failed: %s"),
-                   display_filename, 
-		   g_strerror (save_errno));
-      g_free (display_filename);
-      return NULL;
-    }
+  gchar *display_filename;
 
   file = g_new0 (GMappedFile, 1);
 
   if (fstat (fd, &st) == -1)
     {
       int save_errno = errno;
-      gchar *display_filename = g_filename_display_name (filename);
+
+      if (filename)
+        display_filename = g_filename_display_name (filename);
+      else
+        display_filename = g_strdup_printf ("fd %d", fd);
 
       g_set_error (error,
                    G_FILE_ERROR,
@@ -141,7 +107,6 @@ g_mapped_file_new (const gchar  *filename,
     {
       file->length = 0;
       file->contents = "";
-      close (fd);
       return file;
     }
 
@@ -185,7 +150,11 @@ g_mapped_file_new (const gchar  *filename,
   if (file->contents == MAP_FAILED)
     {
       int save_errno = errno;
-      gchar *display_filename = g_filename_display_name (filename);
+
+      if (filename)
+        display_filename = g_filename_display_name (filename);
+      else
+        display_filename = g_strdup_printf ("fd %d", fd);
       
       g_set_error (error,
 		   G_FILE_ERROR,
@@ -197,16 +166,100 @@ g_mapped_file_new (const gchar  *filename,
       goto out;
     }
 
-  close (fd);
   return file;
 
  out:
-  close (fd);
   g_free (file);
 
   return NULL;
 }
 
+/**
+ * g_mapped_file_new:
+ * @filename: The path of the file to load, in the GLib filename encoding
+ * @writable: whether the mapping should be writable
+ * @error: return location for a #GError, or %NULL
+ *
+ * Maps a file into memory. On UNIX, this is using the mmap() function.
+ *
+ * If @writable is %TRUE, the mapped buffer may be modified, otherwise
+ * it is an error to modify the mapped buffer. Modifications to the buffer 
+ * are not visible to other processes mapping the same file, and are not 
+ * written back to the file.
+ *
+ * Note that modifications of the underlying file might affect the contents
+ * of the #GMappedFile. Therefore, mapping should only be used if the file 
+ * will not be modified, or if all modifications of the file are done
+ * atomically (e.g. using g_file_set_contents()). 
+ *
+ * Return value: a newly allocated #GMappedFile which must be freed
+ *    with g_mapped_file_free(), or %NULL if the mapping failed. 
+ *
+ * Since: 2.8
+ */
+GMappedFile *
+g_mapped_file_new (const gchar  *filename,
+		   gboolean      writable,
+		   GError      **error)
+{
+  GMappedFile *file;
+  int fd;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+  g_return_val_if_fail (!error || *error == NULL, NULL);
+
+  fd = g_open (filename, (writable ? O_RDWR : O_RDONLY) | _O_BINARY, 0);
+  if (fd == -1)
+    {
+      int save_errno = errno;
+      gchar *display_filename = g_filename_display_name (filename);
+      
+      g_set_error (error,
+                   G_FILE_ERROR,
+                   g_file_error_from_errno (save_errno),
+                   _("Failed to open file '%s': open() failed: %s"),
+                   display_filename, 
+		   g_strerror (save_errno));
+      g_free (display_filename);
+      return NULL;
+    }
+
+  file = mapped_file_new_from_fd (fd, writable, filename, error);
+
+  close (fd);
+
+  return file;
+}
+
+/**
+ * g_mapped_file_new_from_fd:
+ * @fd: The file descriptor of the file to load
+ * @writable: whether the mapping should be writable
+ * @error: return location for a #GError, or %NULL
+ *
+ * Maps a file into memory, like g_mapped_file_new(), but from a file
+ * descriptor that is already open, which spares opening the file again
+ * and makes sure that the same file is mapped. @fd is not closed, and
+ * can be closed while the mapping is still in use.
+ *
+ * The whole file is mapped, regardless of the file position of @fd.
+ *
+ * Return value: a newly allocated #GMappedFile which must be freed
+ *    with g_mapped_file_free(), or %NULL if the mapping failed. 
+ *
+ * Since: 2.20
+ */
+GMappedFile *
+g_mapped_file_new_from_fd (gint          fd,
+			   gboolean      writable,
+			   GError      **error)
+{
+  g_return_val_if_fail (fd >= 0, NULL);
+  g_return_val_if_fail (!error || *error == NULL, NULL);
+
+  return mapped_file_new_from_fd (fd, writable, NULL, error);
+}
+
 /**
  * g_mapped_file_get_length:
  * @file: a #GMappedFile
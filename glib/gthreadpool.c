@@ -26,6 +26,8 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "glib.h"
 #include "galias.h"
 
@@ -33,6 +35,8 @@
 /* #define DEBUG_MSG(args) g_printerr args ; g_printerr ("\n");    */
 
 typedef struct _GRealThreadPool GRealThreadPool;
+typedef struct _GThreadPoolWorker GThreadPoolWorker;
+typedef struct _GThreadPoolWorkers GThreadPoolWorkers;
 
 struct _GRealThreadPool
 {
@@ -46,6 +50,37 @@ struct _GRealThreadPool
   gboolean waiting;
   GCompareDataFunc sort_func;
   gpointer sort_user_data;
+
+  /* Work-stealing pools only. pool->queue then only holds tasks
+   * that could not be given to a worker, and its lock protects the
+   * fields above. */
+  gboolean work_stealing;
+  GThreadPoolWorkers *workers;
+  GSList *old_workers;
+  GCond *idle_cond;
+  gint n_pending;	/* tasks in the worker deques */
+  gint n_sleeping;
+  guint next_worker;
+};
+
+/* Each thread of a work-stealing pool has its own deque of tasks,
+ * protected by its own lock. A worker takes tasks from the head of
+ * its deque and steals from the tail of the others when it runs
+ * dry. */
+struct _GThreadPoolWorker
+{
+  GRealThreadPool *pool;
+  GMutex *mutex;
+  GQueue deque;
+  guint index;
+  gboolean active;
+};
+
+/* Only ever replaced as a whole, so it can be read without a lock */
+struct _GThreadPoolWorkers
+{
+  guint n_workers;
+  GThreadPoolWorker *worker[1];
 };
 
 /* The following is just an address to mark the wakeup order for a
@@ -64,12 +99,24 @@ static guint max_idle_time = 0;
 static void             g_thread_pool_queue_push_unlocked (GRealThreadPool  *pool,
 							   gpointer          data);
 static void             g_thread_pool_free_internal       (GRealThreadPool  *pool);
+static void             g_thread_pool_ws_free             (GRealThreadPool  *pool,
+							   gboolean          immediate,
+							   gboolean          wait_);
 static gpointer         g_thread_pool_thread_proxy        (gpointer          data);
 static void             g_thread_pool_start_thread        (GRealThreadPool  *pool,
 							   GError          **error);
 static void             g_thread_pool_wakeup_and_stop_all (GRealThreadPool  *pool);
 static GRealThreadPool* g_thread_pool_wait_for_new_pool   (void);
 static gpointer         g_thread_pool_wait_for_new_task   (GRealThreadPool  *pool);
+static gpointer         g_thread_pool_ws_thread_proxy     (gpointer          data);
+static void             g_thread_pool_ws_start_thread     (GRealThreadPool  *pool,
+							   GError          **error);
+static void             g_thread_pool_ws_push             (GRealThreadPool  *pool,
+							   gpointer         *data,
+							   guint             n_data);
+
+/* The worker the current thread belongs to, if any */
+static GStaticPrivate current_worker = G_STATIC_PRIVATE_INIT;
 
 static void
 g_thread_pool_queue_push_unlocked (GRealThreadPool *pool,
@@ -378,6 +425,318 @@ g_thread_pool_start_thread (GRealThreadPool  *pool,
   pool->num_threads++;
 }
 
+/* HOLDS: pool->queue's lock */
+static void
+g_thread_pool_ws_start_thread (GRealThreadPool  *pool,
+			       GError          **error)
+{
+  GThreadPoolWorkers *workers, *old_workers;
+  GThreadPoolWorker *worker = NULL;
+  GError *local_error = NULL;
+  guint i, n_workers;
+
+  old_workers = pool->workers;
+  n_workers = old_workers ? old_workers->n_workers : 0;
+
+  /* Reuse the slot of a thread that has left the pool */
+  for (i = 0; i < n_workers; i++)
+    if (!old_workers->worker[i]->active)
+      {
+	worker = old_workers->worker[i];
+	break;
+      }
+
+  if (!worker)
+    {
+      worker = g_new0 (GThreadPoolWorker, 1);
+      worker->pool = pool;
+      worker->mutex = g_mutex_new ();
+      g_queue_init (&worker->deque);
+      worker->index = n_workers;
+
+      workers = g_malloc (sizeof (GThreadPoolWorkers) +
+			  n_workers * sizeof (GThreadPoolWorker *));
+      workers->n_workers = n_workers + 1;
+      if (n_workers > 0)
+	memcpy (workers->worker, old_workers->worker,
+		n_workers * sizeof (GThreadPoolWorker *));
+      workers->worker[n_workers] = worker;
+
+      /* Other threads may still be stealing through the old array */
+      g_atomic_pointer_set (&pool->workers, workers);
+      if (old_workers)
+	pool->old_workers = g_slist_prepend (pool->old_workers, old_workers);
+    }
+
+  g_mutex_lock (worker->mutex);
+  worker->active = TRUE;
+  g_mutex_unlock (worker->mutex);
+
+  g_thread_create (g_thread_pool_ws_thread_proxy, worker, FALSE, &local_error);
+
+  if (local_error)
+    {
+      g_mutex_lock (worker->mutex);
+      worker->active = FALSE;
+      g_mutex_unlock (worker->mutex);
+
+      g_propagate_error (error, local_error);
+      return;
+    }
+
+  pool->num_threads++;
+}
+
+static void
+g_thread_pool_ws_wakeup (GRealThreadPool *pool,
+			 guint            n_tasks)
+{
+  if (g_atomic_int_get (&pool->n_sleeping) > 0)
+    {
+      g_async_queue_lock (pool->queue);
+      if (n_tasks > 1)
+	g_cond_broadcast (pool->idle_cond);
+      else
+	g_cond_signal (pool->idle_cond);
+      g_async_queue_unlock (pool->queue);
+    }
+}
+
+static void
+g_thread_pool_ws_push (GRealThreadPool *pool,
+		       gpointer        *data,
+		       guint            n_data)
+{
+  GThreadPoolWorkers *workers;
+  GThreadPoolWorker *worker;
+  guint i, j;
+
+  for (j = 0; j < n_data; j++)
+    g_return_if_fail (data[j] != NULL);
+
+  /* Tasks pushed from within the pool stay with the pushing thread */
+  worker = g_static_private_get (&current_worker);
+  if (worker && worker->pool != pool)
+    worker = NULL;
+
+  workers = g_atomic_pointer_get (&pool->workers);
+
+  /* A sort function needs all tasks in one queue */
+  for (i = 0; workers && !pool->sort_func && i < workers->n_workers; i++)
+    {
+      if (!worker)
+	{
+	  j = g_atomic_int_exchange_and_add ((gint *) &pool->next_worker, 1);
+	  worker = workers->worker[j % workers->n_workers];
+	}
+
+      g_mutex_lock (worker->mutex);
+
+      if (worker->active)
+	{
+	  for (j = 0; j < n_data; j++)
+	    g_queue_push_tail (&worker->deque, data[j]);
+	  g_atomic_int_add (&pool->n_pending, n_data);
+
+	  g_mutex_unlock (worker->mutex);
+
+	  g_thread_pool_ws_wakeup (pool, n_data);
+	  return;
+	}
+
+      g_mutex_unlock (worker->mutex);
+      worker = NULL;
+    }
+
+  /* No worker to give the tasks to, leave them to whichever
+   * thread asks for work next.
+   */
+  g_async_queue_lock (pool->queue);
+
+  for (j = 0; j < n_data; j++)
+    g_thread_pool_queue_push_unlocked (pool, data[j]);
+
+  if (pool->n_sleeping > 0)
+    {
+      if (n_data > 1)
+	g_cond_broadcast (pool->idle_cond);
+      else
+	g_cond_signal (pool->idle_cond);
+    }
+
+  g_async_queue_unlock (pool->queue);
+}
+
+static gpointer
+g_thread_pool_ws_pop (GRealThreadPool   *pool,
+		      GThreadPoolWorker *worker)
+{
+  GThreadPoolWorkers *workers;
+  gpointer task;
+  guint i;
+
+  g_mutex_lock (worker->mutex);
+  task = g_queue_pop_head (&worker->deque);
+  g_mutex_unlock (worker->mutex);
+
+  if (task)
+    {
+      g_atomic_int_add (&pool->n_pending, -1);
+      return task;
+    }
+
+  if (g_atomic_int_get (&pool->n_pending) == 0)
+    return NULL;
+
+  /* Our own deque is empty, but some other is not */
+  workers = g_atomic_pointer_get (&pool->workers);
+  for (i = 1; i < workers->n_workers; i++)
+    {
+      GThreadPoolWorker *victim;
+      GQueue stolen = G_QUEUE_INIT;
+      guint n_steal;
+
+      victim = workers->worker[(worker->index + i) % workers->n_workers];
+
+      /* Look before taking the lock, to leave busy workers alone */
+      if (victim->deque.length == 0)
+	continue;
+
+      /* Take half of the tasks, so the next steal is far away */
+      g_mutex_lock (victim->mutex);
+      n_steal = victim->deque.length / 2;
+      task = g_queue_pop_tail (&victim->deque);
+      while (n_steal-- > 1)
+	g_queue_push_head_link (&stolen, g_queue_pop_tail_link (&victim->deque));
+      g_mutex_unlock (victim->mutex);
+
+      n_steal = stolen.length;
+      if (n_steal > 0)
+	{
+	  GList *link;
+
+	  g_mutex_lock (worker->mutex);
+	  while ((link = g_queue_pop_head_link (&stolen)))
+	    g_queue_push_tail_link (&worker->deque, link);
+	  g_mutex_unlock (worker->mutex);
+	}
+
+      if (task)
+	{
+	  g_atomic_int_add (&pool->n_pending, -1);
+
+	  DEBUG_MSG (("thread %p in pool %p stole %d tasks from worker %d.",
+		      g_thread_self (), pool, n_steal + 1, victim->index));
+
+	  return task;
+	}
+    }
+
+  return NULL;
+}
+
+/* HOLDS: pool->queue's lock */
+static gboolean
+g_thread_pool_ws_should_stop (GRealThreadPool *pool)
+{
+  if (pool->max_threads != -1 && pool->num_threads > pool->max_threads)
+    return TRUE;
+
+  if (pool->running)
+    return FALSE;
+
+  return pool->immediate ||
+    (g_atomic_int_get (&pool->n_pending) == 0 &&
+     g_async_queue_length_unlocked (pool->queue) <= 0);
+}
+
+static gpointer
+g_thread_pool_ws_thread_proxy (gpointer data)
+{
+  GThreadPoolWorker *worker = data;
+  GRealThreadPool *pool = worker->pool;
+  gboolean free_pool = FALSE;
+  gpointer task;
+
+  g_static_private_set (&current_worker, worker, NULL);
+
+  DEBUG_MSG (("thread %p started for work-stealing pool %p.", 
+	      g_thread_self (), pool));
+
+  while (TRUE)
+    {
+      task = g_thread_pool_ws_pop (pool, worker);
+
+      if (!task)
+	{
+	  g_async_queue_lock (pool->queue);
+
+	  if (g_thread_pool_ws_should_stop (pool))
+	    break;
+
+	  task = g_async_queue_try_pop_unlocked (pool->queue);
+
+	  if (!task)
+	    {
+	      /* Announce that we sleep before looking at n_pending a
+	       * last time, g_thread_pool_ws_push() does it the other
+	       * way around. One of us sees what the other did.
+	       */
+	      g_atomic_int_inc (&pool->n_sleeping);
+	      if (g_atomic_int_get (&pool->n_pending) == 0)
+		g_cond_wait (pool->idle_cond,
+			     _g_async_queue_get_mutex (pool->queue));
+	      g_atomic_int_add (&pool->n_sleeping, -1);
+	    }
+
+	  g_async_queue_unlock (pool->queue);
+
+	  if (!task)
+	    continue;
+	}
+
+      if (pool->running || !pool->immediate)
+	{
+	  DEBUG_MSG (("thread %p in pool %p calling func.", 
+		      g_thread_self (), pool));
+	  pool->pool.func (task, pool->pool.user_data);
+	}
+    }
+
+  DEBUG_MSG (("thread %p leaving work-stealing pool %p.", 
+	      g_thread_self (), pool));
+
+  /* Hand the tasks left in our deque over to the others */
+  g_mutex_lock (worker->mutex);
+  worker->active = FALSE;
+  while ((task = g_queue_pop_head (&worker->deque)))
+    {
+      g_atomic_int_add (&pool->n_pending, -1);
+      g_thread_pool_queue_push_unlocked (pool, task);
+    }
+  g_mutex_unlock (worker->mutex);
+
+  g_static_private_set (&current_worker, NULL, NULL);
+
+  pool->num_threads--;
+  g_cond_broadcast (pool->idle_cond);
+
+  if (!pool->running)
+    {
+      if (!pool->waiting)
+	free_pool = pool->num_threads == 0;
+      else
+	g_cond_broadcast (pool->cond);
+    }
+
+  g_async_queue_unlock (pool->queue);
+
+  if (free_pool)
+    g_thread_pool_free_internal (pool);
+
+  return NULL;
+}
+
 /**
  * g_thread_pool_new: 
  * @func: a function to execute in the threads of the new thread pool
@@ -428,7 +787,7 @@ g_thread_pool_new (GFunc            func,
   g_return_val_if_fail (max_threads >= -1, NULL);
   g_return_val_if_fail (g_thread_supported (), NULL);
 
-  retval = g_new (GRealThreadPool, 1);
+  retval = g_new0 (GRealThreadPool, 1);
 
   retval->pool.func = func;
   retval->pool.user_data = user_data;
@@ -467,6 +826,83 @@ g_thread_pool_new (GFunc            func,
   return (GThreadPool*) retval;
 }
 
+/**
+ * g_thread_pool_new_work_stealing: 
+ * @func: a function to execute in the threads of the new thread pool
+ * @user_data: user data that is handed over to @func every time it 
+ *   is called
+ * @max_threads: the number of threads to start for the new thread pool
+ * @error: return location for error
+ *
+ * This function creates a new exclusive thread pool, like
+ * g_thread_pool_new() does, which schedules its tasks by work
+ * stealing.
+ *
+ * Instead of one queue of tasks shared by all threads, each thread of
+ * the pool has a queue of its own. g_thread_pool_push() hands tasks
+ * out to the threads in turn, or keeps them with the calling thread
+ * if that belongs to the pool. A thread that runs out of tasks takes
+ * over half of the tasks of another one. The threads therefore hardly
+ * ever contend for a lock, which makes such a pool a better fit for
+ * many small tasks on machines with many processors.
+ *
+ * The tasks of a work-stealing pool are not necessarily processed in
+ * the order in which they were pushed. Tasks pushed after a sort
+ * function has been set with g_thread_pool_set_sort_function() go
+ * through one sorted queue again, as in any other pool.
+ *
+ * The threads of a work-stealing pool are never shared with other
+ * pools, they exit when they are no longer needed.
+ *
+ * @error can be %NULL to ignore errors, or non-%NULL to report
+ * errors. An error can only occur when not all @max_threads threads
+ * could be created.
+ *
+ * Return value: the new #GThreadPool
+ *
+ * Since: 2.20
+ **/
+GThreadPool* 
+g_thread_pool_new_work_stealing (GFunc            func,
+				 gpointer         user_data,
+				 gint             max_threads,
+				 GError         **error)
+{
+  GRealThreadPool *retval;
+
+  g_return_val_if_fail (func, NULL);
+  g_return_val_if_fail (max_threads >= 0, NULL);
+  g_return_val_if_fail (g_thread_supported (), NULL);
+
+  retval = g_new0 (GRealThreadPool, 1);
+
+  retval->pool.func = func;
+  retval->pool.user_data = user_data;
+  retval->pool.exclusive = TRUE;
+  retval->queue = g_async_queue_new ();
+  retval->max_threads = max_threads;
+  retval->running = TRUE;
+  retval->work_stealing = TRUE;
+  retval->idle_cond = g_cond_new ();
+
+  g_async_queue_lock (retval->queue);
+  
+  while (retval->num_threads < retval->max_threads)
+    {
+      GError *local_error = NULL;
+      g_thread_pool_ws_start_thread (retval, &local_error);
+      if (local_error)
+	{
+	  g_propagate_error (error, local_error);
+	  break;
+	}
+    }
+
+  g_async_queue_unlock (retval->queue);
+
+  return (GThreadPool*) retval;
+}
+
 /**
  * g_thread_pool_push:
  * @pool: a #GThreadPool
@@ -497,6 +933,12 @@ g_thread_pool_push (GThreadPool  *pool,
   g_return_if_fail (real);
   g_return_if_fail (real->running);
 
+  if (real->work_stealing)
+    {
+      g_thread_pool_ws_push (real, &data, 1);
+      return;
+    }
+
   g_async_queue_lock (real->queue);
 
   if (g_async_queue_length_unlocked (real->queue) >= 0)
@@ -507,6 +949,66 @@ g_thread_pool_push (GThreadPool  *pool,
   g_async_queue_unlock (real->queue);
 }
 
+/**
+ * g_thread_pool_push_many:
+ * @pool: a #GThreadPool
+ * @data: an array of new tasks for @pool
+ * @n_data: the number of tasks in @data
+ * @error: return location for error
+ * 
+ * Inserts the @n_data tasks in @data into the list of tasks to be
+ * executed by @pool, like calling g_thread_pool_push() for each of
+ * them would, but takes the locks involved only once for all of them.
+ *
+ * @error can be %NULL to ignore errors, or non-%NULL to report
+ * errors. An error can only occur when a new thread couldn't be
+ * created. In that case the tasks are simply appended to the queue
+ * of work to do.
+ *
+ * Since: 2.20
+ **/
+void 
+g_thread_pool_push_many (GThreadPool  *pool,
+			 gpointer     *data,
+			 guint         n_data,
+			 GError      **error)
+{
+  GRealThreadPool *real;
+  GError *local_error = NULL;
+  guint i;
+
+  real = (GRealThreadPool*) pool;
+
+  g_return_if_fail (real);
+  g_return_if_fail (real->running);
+  g_return_if_fail (data != NULL || n_data == 0);
+
+  if (n_data == 0)
+    return;
+
+  if (real->work_stealing)
+    {
+      g_thread_pool_ws_push (real, data, n_data);
+      return;
+    }
+
+  g_async_queue_lock (real->queue);
+
+  for (i = 0; i < n_data; i++)
+    {
+      if (!local_error && g_async_queue_length_unlocked (real->queue) >= 0)
+	/* No thread is waiting in the queue */
+	g_thread_pool_start_thread (real, &local_error);
+
+      g_thread_pool_queue_push_unlocked (real, data[i]);
+    }
+
+  g_async_queue_unlock (real->queue);
+
+  if (local_error)
+    g_propagate_error (error, local_error);
+}
+
 /**
  * g_thread_pool_set_max_threads:
  * @pool: a #GThreadPool
@@ -558,13 +1060,20 @@ g_thread_pool_set_max_threads (GThreadPool  *pool,
     {
       GError *local_error = NULL;
 
-      g_thread_pool_start_thread (real, &local_error);
+      if (real->work_stealing)
+	g_thread_pool_ws_start_thread (real, &local_error);
+      else
+	g_thread_pool_start_thread (real, &local_error);
       if (local_error)
 	{
 	  g_propagate_error (error, local_error);
 	  break;
 	}
     }
+
+  /* Let superfluous threads of a work-stealing pool notice */
+  if (real->work_stealing)
+    g_cond_broadcast (real->idle_cond);
    
   g_async_queue_unlock (real->queue);
 }
@@ -641,8 +1150,12 @@ g_thread_pool_unprocessed (GThreadPool *pool)
   g_return_val_if_fail (real->running, 0);
 
   unprocessed = g_async_queue_length (real->queue);
+  unprocessed = MAX (unprocessed, 0);
+
+  if (real->work_stealing)
+    unprocessed += g_atomic_int_get (&real->n_pending);
 
-  return MAX (unprocessed, 0);
+  return unprocessed;
 }
 
 /**
@@ -677,6 +1190,12 @@ g_thread_pool_free (GThreadPool *pool,
   g_return_if_fail (real);
   g_return_if_fail (real->running);
 
+  if (real->work_stealing)
+    {
+      g_thread_pool_ws_free (real, immediate, wait_);
+      return;
+    }
+
   /* If there's no thread allowed here, there is not much sense in
    * not stopping this pool immediately, when it's not empty 
    */
@@ -720,6 +1239,47 @@ g_thread_pool_free (GThreadPool *pool,
   g_async_queue_unlock (real->queue);
 }
 
+static void
+g_thread_pool_ws_free (GRealThreadPool *pool,
+		       gboolean         immediate,
+		       gboolean         wait_)
+{
+  /* If there's no thread allowed here, there is not much sense in
+   * not stopping this pool immediately, when it's not empty 
+   */
+  g_return_if_fail (immediate || 
+		    pool->max_threads != 0 || 
+		    g_thread_pool_unprocessed ((GThreadPool *) pool) == 0);
+
+  g_async_queue_lock (pool->queue);
+
+  pool->running = FALSE;
+  pool->immediate = immediate;
+  pool->waiting = wait_;
+
+  /* Idle threads need to notice that they can stop */
+  g_cond_broadcast (pool->idle_cond);
+
+  if (wait_)
+    {
+      pool->cond = g_cond_new ();
+
+      while (pool->num_threads > 0)
+	g_cond_wait (pool->cond, _g_async_queue_get_mutex (pool->queue));
+    }
+
+  if (pool->num_threads == 0)
+    {
+      g_async_queue_unlock (pool->queue);
+      g_thread_pool_free_internal (pool);
+      return;
+    }
+
+  /* The last thread should cleanup the pool */
+  pool->waiting = FALSE; 
+  g_async_queue_unlock (pool->queue);
+}
+
 static void
 g_thread_pool_free_internal (GRealThreadPool* pool)
 {
@@ -732,6 +1292,26 @@ g_thread_pool_free_internal (GRealThreadPool* pool)
   if (pool->cond)
     g_cond_free (pool->cond);
 
+  if (pool->work_stealing)
+    {
+      guint i;
+
+      for (i = 0; pool->workers && i < pool->workers->n_workers; i++)
+	{
+	  GThreadPoolWorker *worker = pool->workers->worker[i];
+
+	  g_queue_clear (&worker->deque);
+	  g_mutex_free (worker->mutex);
+	  g_free (worker);
+	}
+
+      g_free (pool->workers);
+      g_slist_foreach (pool->old_workers, (GFunc) g_free, NULL);
+      g_slist_free (pool->old_workers);
+
+      g_cond_free (pool->idle_cond);
+    }
+
   g_free (pool);
 }
 
@@ -852,6 +1432,10 @@ g_thread_pool_stop_unused_threads (void)
  * cannot be assumed that threads are executed in the order they are
  * created. 
  *
+ * A pool created with g_thread_pool_new_work_stealing() keeps tasks
+ * pushed after a sort function was set in one shared queue, the
+ * tasks already given to its threads are not sorted.
+ *
  * Since: 2.10
  **/
 void 
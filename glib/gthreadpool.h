@@ -60,6 +60,14 @@ GThreadPool*    g_thread_pool_new             (GFunc            func,
                                                gboolean         exclusive,
                                                GError         **error);
 
+/* Get an exclusive thread pool of max_threads threads, each of which has
+ * its own queue of tasks and steals tasks from the others when it runs
+ * out of work */
+GThreadPool*    g_thread_pool_new_work_stealing (GFunc          func,
+                                                 gpointer       user_data,
+                                                 gint           max_threads,
+                                                 GError       **error);
+
 /* Push new data into the thread pool. This task is assigned to a thread later
  * (when the maximal number of threads is reached for that pool) or now
  * (otherwise). If necessary a new thread will be started. The function
@@ -68,6 +76,12 @@ void            g_thread_pool_push            (GThreadPool     *pool,
                                                gpointer         data,
                                                GError         **error);
 
+/* Push n_data new tasks into the thread pool at once */
+void            g_thread_pool_push_many       (GThreadPool     *pool,
+                                               gpointer        *data,
+                                               guint            n_data,
+                                               GError         **error);
+
 /* Set the number of threads, which can run concurrently for that pool, -1
  * means no limit. 0 means has the effect, that the pool won't process
  * requests until the limit is set higher again */
@@ -27,6 +27,14 @@
 #endif
 #include <string.h>
 
+#ifdef __SSE2__
+#define UTF8_VALIDATE_SIMD
+#include <emmintrin.h>
+#ifdef HAVE_AVX2_INTRINSICS
+#include <immintrin.h>
+#endif
+#endif
+
 #include "glib.h"
 
 #ifdef G_PLATFORM_WIN32
@@ -1705,6 +1713,302 @@ fast_validate_len (const char *str,
   return p;
 }
 
+#ifdef UTF8_VALIDATE_SIMD
+
+/* Vectorized validation
+ *
+ * The simd_validate_*() functions below go through the text a block of
+ * 16 or 32 bytes at a time, as long as the blocks are valid UTF-8 without
+ * nul bytes. Blocks they can't vouch for are handed to the scalar
+ * fast_validate_len(), which also finds the exact position of an error.
+ * Nul-terminated text is read a block at a time too, possibly past the
+ * terminating nul, but never across a page boundary.
+ */
+#define UTF8_PAGE_SIZE 4096
+
+#define UTF8_BLOCK_CROSSES_PAGE(p, size) \
+  (((gsize) (p) & (UTF8_PAGE_SIZE - 1)) > UTF8_PAGE_SIZE - (size))
+
+/* Validates the characters starting in [start, block_end) with the
+ * scalar code. Returns %TRUE and sets *p to where vectorized validation
+ * can continue, or returns %FALSE and sets *p to the end of valid text.
+ */
+static inline gboolean
+simd_validate_block_slow (const gchar  *start,
+			  const gchar  *block_end,
+			  const gchar **p)
+{
+  const gchar *q;
+
+  q = fast_validate_len (start, block_end - start);
+  *p = q;
+
+  /* a character that only ends in the next block is not an error
+   * yet; if it is one, this will return FALSE for the next block
+   */
+  return q == block_end || (q > start && block_end - q < 4);
+}
+
+static const gchar *
+simd_validate_sse2 (const gchar  *str,
+		    const gchar  *end,
+		    gboolean     *done)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const gchar *p = str;
+
+  /* only runs of ASCII are checked with SSE2, anything else goes
+   * through the scalar code
+   */
+  while (end ? end - p >= 16 : TRUE)
+    {
+      __m128i input;
+
+      if (!end && UTF8_BLOCK_CROSSES_PAGE (p, 16))
+	goto slow;
+
+      input = _mm_loadu_si128 ((const __m128i *) p);
+      if ((_mm_movemask_epi8 (input) | _mm_movemask_epi8 (_mm_cmpeq_epi8 (input, zero))) == 0)
+	{
+	  p += 16;
+	  continue;
+	}
+
+    slow:
+      if (!simd_validate_block_slow (p, p + 16, &p))
+	{
+	  *done = TRUE;
+	  break;
+	}
+    }
+
+  return p;
+}
+
+#ifdef HAVE_AVX2_INTRINSICS
+
+#define AVX2_TARGET __attribute__ ((target ("avx2")))
+
+/* the bytes of a block shifted right by n, with the last n bytes of
+ * the previous block shifted in
+ */
+#define AVX2_PREV(input, prev_input, n)	\
+  _mm256_alignr_epi8 ((input), _mm256_permute2x128_si256 ((prev_input), (input), 0x21), 16 - (n))
+
+#define AVX2_TABLE(a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p)				\
+  _mm256_setr_epi8 (a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p,a,b,c,d,e,f,g,h,i,j,k,l,m,n,o,p)
+
+/* Error classes of a pair of bytes, looked up by the high and low
+ * nibble of the first and the high nibble of the second byte; a pair
+ * is invalid if a class is in all three lookups. See "Validating UTF-8
+ * In Less Than One Instruction Per Byte" by John Keiser and Daniel Lemire.
+ */
+#define TOO_SHORT      (1 << 0)  /* lead byte or ASCII followed by lead byte */
+#define TOO_LONG       (1 << 1)  /* ASCII followed by continuation */
+#define OVERLONG_3     (1 << 2)
+#define TOO_LARGE      (1 << 3)
+#define SURROGATE      (1 << 4)
+#define OVERLONG_2     (1 << 5)
+#define TOO_LARGE_1000 (1 << 6)
+#define OVERLONG_4     (1 << 6)
+#define TWO_CONTS      (1 << 7)  /* two continuations in a row */
+#define CARRY          (TOO_SHORT | TOO_LONG | TWO_CONTS)
+
+static inline AVX2_TARGET __m256i
+avx2_check_block (__m256i input,
+		  __m256i prev_input)
+{
+  const __m256i nibble = _mm256_set1_epi8 (0x0f);
+  const __m256i byte_1_high_table =
+    AVX2_TABLE (TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+		TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+		TOO_SHORT | OVERLONG_2,
+		TOO_SHORT,
+		TOO_SHORT | OVERLONG_3 | SURROGATE,
+		TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+  const __m256i byte_1_low_table =
+    AVX2_TABLE (CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+		CARRY | OVERLONG_2,
+		CARRY,
+		CARRY,
+		CARRY | TOO_LARGE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+		CARRY | TOO_LARGE | TOO_LARGE_1000,
+		CARRY | TOO_LARGE | TOO_LARGE_1000);
+  const __m256i byte_2_high_table =
+    AVX2_TABLE (TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+		TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+  __m256i prev1, prev2, prev3;
+  __m256i byte_1_high, byte_1_low, byte_2_high;
+  __m256i special, must_be_continuation, nonchar;
+
+  prev1 = AVX2_PREV (input, prev_input, 1);
+  prev2 = AVX2_PREV (input, prev_input, 2);
+  prev3 = AVX2_PREV (input, prev_input, 3);
+
+  byte_1_high = _mm256_shuffle_epi8 (byte_1_high_table,
+				     _mm256_and_si256 (_mm256_srli_epi16 (prev1, 4), nibble));
+  byte_1_low = _mm256_shuffle_epi8 (byte_1_low_table,
+				    _mm256_and_si256 (prev1, nibble));
+  byte_2_high = _mm256_shuffle_epi8 (byte_2_high_table,
+				     _mm256_and_si256 (_mm256_srli_epi16 (input, 4), nibble));
+  special = _mm256_and_si256 (_mm256_and_si256 (byte_1_high, byte_1_low), byte_2_high);
+
+  /* the third and fourth bytes of 3 and 4 byte sequences must be
+   * continuations, which shows as TWO_CONTS above
+   */
+  must_be_continuation =
+    _mm256_or_si256 (_mm256_subs_epu8 (prev2, _mm256_set1_epi8 ((gchar) (0xe0 - 0x80))),
+		     _mm256_subs_epu8 (prev3, _mm256_set1_epi8 ((gchar) (0xf0 - 0x80))));
+  must_be_continuation = _mm256_and_si256 (must_be_continuation, _mm256_set1_epi8 ((gchar) 0x80));
+
+  /* UNICODE_VALID() also rules out the noncharacters U+FDD0..U+FDEF,
+   * which start with EF B7, and U+xFFFE and U+xFFFF, which end with
+   * ?F BF BE or ?F BF BF; blocks that may contain them take the slow
+   * path, which sorts them out
+   */
+  nonchar =
+    _mm256_and_si256 (_mm256_cmpeq_epi8 (prev1, _mm256_set1_epi8 ((gchar) 0xef)),
+		      _mm256_cmpeq_epi8 (input, _mm256_set1_epi8 ((gchar) 0xb7)));
+  nonchar =
+    _mm256_or_si256 (nonchar,
+		     _mm256_and_si256 (_mm256_and_si256 (_mm256_cmpeq_epi8 (_mm256_and_si256 (prev2, nibble), nibble),
+							 _mm256_cmpeq_epi8 (prev1, _mm256_set1_epi8 ((gchar) 0xbf))),
+				       _mm256_cmpeq_epi8 (_mm256_or_si256 (input, _mm256_set1_epi8 (1)),
+							  _mm256_set1_epi8 ((gchar) 0xbf))));
+
+  return _mm256_or_si256 (_mm256_xor_si256 (must_be_continuation, special), nonchar);
+}
+
+#undef TOO_SHORT
+#undef TOO_LONG
+#undef OVERLONG_3
+#undef TOO_LARGE
+#undef SURROGATE
+#undef OVERLONG_2
+#undef TOO_LARGE_1000
+#undef OVERLONG_4
+#undef TWO_CONTS
+#undef CARRY
+
+/* Returns the start of the character that the bytes just before @p
+ * belong to, assuming that [limit, p) has been validated up to a
+ * possibly incomplete last character.
+ */
+static inline const gchar *
+simd_char_start (const gchar *p,
+		 const gchar *limit)
+{
+  const gchar *q = p;
+
+  while (q > limit && p - q < 3 && (*(guchar *)(q - 1) & 0xc0) == 0x80)
+    q--;
+  if (q > limit && *(guchar *)(q - 1) >= 0xc0)
+    q--;
+
+  return q;
+}
+
+static AVX2_TARGET const gchar *
+simd_validate_avx2 (const gchar  *str,
+		    const gchar  *end,
+		    gboolean     *done)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  /* a sequence that began in the last three bytes may be incomplete */
+  const __m256i incomplete_max =
+    _mm256_setr_epi8 (-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		      (gchar) (0xf0 - 1), (gchar) (0xe0 - 1), (gchar) (0xc0 - 1));
+  __m256i prev_input = zero;
+  __m256i prev_incomplete = zero;
+  const gchar *run = str;	/* where the current run of blocks started */
+  const gchar *p = str;
+
+  while (end ? end - p >= 32 : TRUE)
+    {
+      __m256i input, error;
+
+      if (!end && UTF8_BLOCK_CROSSES_PAGE (p, 32))
+	goto slow;
+
+      input = _mm256_loadu_si256 ((const __m256i *) p);
+      if (_mm256_movemask_epi8 (_mm256_cmpeq_epi8 (input, zero)))
+	goto slow;
+
+      if (_mm256_movemask_epi8 (input) == 0)
+	{
+	  /* all ASCII, fine unless the previous block ended early */
+	  if (!_mm256_testz_si256 (prev_incomplete, prev_incomplete))
+	    goto slow;
+	}
+      else
+	{
+	  error = avx2_check_block (input, prev_input);
+	  if (!_mm256_testz_si256 (error, error))
+	    goto slow;
+	}
+
+      prev_incomplete = _mm256_subs_epu8 (input, incomplete_max);
+      prev_input = input;
+      p += 32;
+      continue;
+
+    slow:
+      if (!simd_validate_block_slow (simd_char_start (p, run), p + 32, &p))
+	{
+	  *done = TRUE;
+	  return p;
+	}
+      run = p;
+      prev_input = zero;
+      prev_incomplete = zero;
+    }
+
+  /* the scalar code takes over at a character boundary */
+  return simd_char_start (p, run);
+}
+
+#endif /* HAVE_AVX2_INTRINSICS */
+
+/* Validates the beginning of @str up to @end, or up to the
+ * terminating nul if @end is %NULL. Returns where the scalar code
+ * should continue, or sets *done and returns the end of valid text.
+ */
+static const gchar *
+simd_validate (const gchar *str,
+	       const gchar *end,
+	       gboolean    *done)
+{
+#ifdef HAVE_AVX2_INTRINSICS
+  static gint have_avx2 = -1;
+
+  if (G_UNLIKELY (have_avx2 < 0))
+    have_avx2 = __builtin_cpu_supports ("avx2") != 0;
+
+  if (have_avx2)
+    return simd_validate_avx2 (str, end, done);
+#endif
+
+  return simd_validate_sse2 (str, end, done);
+}
+
+#endif /* UTF8_VALIDATE_SIMD */
+
 /**
  * g_utf8_validate:
  * @str: a pointer to character data
@@ -1735,12 +2039,19 @@ g_utf8_validate (const char   *str,
 		 const gchar **end)
 
 {
-  const gchar *p;
+  const gchar *p = str;
+  gboolean done = FALSE;
+
+#ifdef UTF8_VALIDATE_SIMD
+  p = simd_validate (str, max_len < 0 ? NULL : str + max_len, &done);
+#endif
 
-  if (max_len < 0)
-    p = fast_validate (str);
+  if (done)
+    ;
+  else if (max_len < 0)
+    p = fast_validate (p);
   else
-    p = fast_validate_len (str, max_len);
+    p = fast_validate_len (p, max_len - (p - str));
 
   if (end)
     *end = p;
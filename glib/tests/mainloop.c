@@ -0,0 +1,240 @@
+/* Unit tests for GMainContext
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <unistd.h>
+
+typedef struct
+{
+  GSource source;
+  GPollFD pollfd;
+  gushort revents;
+  gint dispatched;
+} FdSource;
+
+static gboolean
+fd_source_prepare (GSource *source,
+                   gint    *timeout)
+{
+  *timeout = -1;
+  return FALSE;
+}
+
+static gboolean
+fd_source_check (GSource *source)
+{
+  FdSource *fd_source = (FdSource *)source;
+
+  return fd_source->pollfd.revents != 0;
+}
+
+static gboolean
+fd_source_dispatch (GSource     *source,
+                    GSourceFunc  callback,
+                    gpointer     user_data)
+{
+  FdSource *fd_source = (FdSource *)source;
+
+  /* revents is reset when the source is unblocked after dispatch */
+  fd_source->revents = fd_source->pollfd.revents;
+  fd_source->dispatched++;
+
+  return TRUE;
+}
+
+static GSourceFuncs fd_source_funcs = {
+  fd_source_prepare,
+  fd_source_check,
+  fd_source_dispatch,
+  NULL
+};
+
+static FdSource *
+fd_source_new (GMainContext *context,
+               gint          fd,
+               gushort       events)
+{
+  FdSource *fd_source;
+
+  fd_source = (FdSource *)g_source_new (&fd_source_funcs, sizeof (FdSource));
+  fd_source->pollfd.fd = fd;
+  fd_source->pollfd.events = events;
+  g_source_add_poll ((GSource *)fd_source, &fd_source->pollfd);
+  g_source_attach ((GSource *)fd_source, context);
+
+  return fd_source;
+}
+
+static void
+fd_source_free (FdSource *fd_source)
+{
+  g_source_destroy ((GSource *)fd_source);
+  g_source_unref ((GSource *)fd_source);
+}
+
+static void
+check_pipe (GMainContext *context)
+{
+  FdSource *a, *b;
+  gint fds[2];
+
+  g_assert (pipe (fds) == 0);
+
+  /* two sources watching the same fd share one registration */
+  a = fd_source_new (context, fds[0], G_IO_IN);
+  b = fd_source_new (context, fds[0], G_IO_IN);
+
+  g_assert (!g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (a->dispatched, ==, 0);
+  g_assert_cmpint (b->dispatched, ==, 0);
+
+  g_assert (write (fds[1], "x", 1) == 1);
+  g_assert (g_main_context_iteration (context, TRUE));
+  g_assert_cmpint (a->revents, ==, G_IO_IN);
+  g_assert_cmpint (a->dispatched, ==, 1);
+  g_assert_cmpint (b->dispatched, ==, 1);
+
+  /* the remaining source still sees the fd */
+  fd_source_free (a);
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (b->dispatched, ==, 2);
+
+  /* once drained, the fd is no longer reported */
+  g_assert (read (fds[0], fds, 1) == 1);
+  g_assert (!g_main_context_iteration (context, FALSE));
+  g_assert_cmpint (b->dispatched, ==, 2);
+
+  close (fds[1]);
+  g_assert (g_main_context_iteration (context, FALSE));
+  g_assert (b->revents & G_IO_HUP);
+
+  fd_source_free (b);
+  close (fds[0]);
+}
+
+static void
+test_poll (void)
+{
+  GMainContext *context;
+
+  context = g_main_context_new ();
+  check_pipe (context);
+  g_main_context_unref (context);
+}
+
+static void
+test_epoll (void)
+{
+  GMainContext *context;
+
+  context = g_main_context_new ();
+  if (!g_main_context_set_epoll_enabled (context, TRUE))
+    {
+      g_main_context_unref (context);
+      return;
+    }
+
+  check_pipe (context);
+
+  /* and back to poll() */
+  g_assert (!g_main_context_set_epoll_enabled (context, FALSE));
+  check_pipe (context);
+
+  g_main_context_unref (context);
+}
+
+static void
+test_epoll_regular_file (void)
+{
+  GMainContext *context;
+  FdSource *source;
+  gchar *name;
+  gint fd;
+
+  context = g_main_context_new ();
+  if (!g_main_context_set_epoll_enabled (context, TRUE))
+    {
+      g_main_context_unref (context);
+      return;
+    }
+
+  fd = g_file_open_tmp (NULL, &name, NULL);
+  g_assert (fd >= 0);
+
+  /* epoll can not watch regular files, but poll() reports them ready */
+  source = fd_source_new (context, fd, G_IO_IN);
+  g_assert (g_main_context_iteration (context, TRUE));
+  g_assert_cmpint (source->revents, ==, G_IO_IN);
+  g_assert_cmpint (source->dispatched, ==, 1);
+
+  fd_source_free (source);
+  close (fd);
+  g_unlink (name);
+  g_free (name);
+
+  g_main_context_unref (context);
+}
+
+static gint custom_poll_calls;
+
+static gint
+custom_poll (GPollFD *ufds,
+             guint    nfds,
+             gint     timeout_)
+{
+  custom_poll_calls++;
+
+  return g_poll (ufds, nfds, timeout_);
+}
+
+static void
+test_epoll_poll_func (void)
+{
+  GMainContext *context;
+
+  context = g_main_context_new ();
+  if (!g_main_context_set_epoll_enabled (context, TRUE))
+    {
+      g_main_context_unref (context);
+      return;
+    }
+
+  /* a custom poll function takes precedence over epoll */
+  g_main_context_set_poll_func (context, custom_poll);
+  check_pipe (context);
+  g_assert_cmpint (custom_poll_calls, >, 0);
+
+  g_main_context_unref (context);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/mainloop/poll", test_poll);
+  g_test_add_func ("/mainloop/epoll", test_epoll);
+  g_test_add_func ("/mainloop/epoll-regular-file", test_epoll_regular_file);
+  g_test_add_func ("/mainloop/epoll-poll-func", test_epoll_poll_func);
+
+  return g_test_run();
+}
@@ -102,6 +102,20 @@ typedef union {
   volatile gint vint;
 } ClosureInt;
 
+/* every closure is allocated with a hidden GRealClosure prefix which
+ * holds the optional va_list marshallers used by the signal system
+ * to invoke C closures without collecting the arguments into GValues
+ */
+typedef struct
+{
+  GVaClosureMarshal va_meta_marshal;
+  GVaClosureMarshal va_marshal;
+  GClosure          closure;
+} GRealClosure;
+
+#define G_REAL_CLOSURE(_c) \
+  ((GRealClosure*) G_STRUCT_MEMBER_P ((_c), -G_STRUCT_OFFSET (GRealClosure, closure)))
+
 #define CHANGE_FIELD(_closure, _field, _OP, _value, _must_set, _SET_OLD, _SET_NEW)      \
 G_STMT_START {                                                                          \
   ClosureInt *cunion = (ClosureInt*) _closure;                 		                \
@@ -193,11 +207,14 @@ GClosure*
 g_closure_new_simple (guint           sizeof_closure,
 		      gpointer        data)
 {
+  GRealClosure *real_closure;
   GClosure *closure;
 
   g_return_val_if_fail (sizeof_closure >= sizeof (GClosure), NULL);
 
-  closure = g_malloc0 (sizeof_closure);
+  sizeof_closure = sizeof_closure + sizeof (GRealClosure) - sizeof (GClosure);
+  real_closure = g_malloc0 (sizeof_closure);
+  closure = &real_closure->closure;
   SET (closure, ref_count, 1);
   SET (closure, meta_marshal, 0);
   SET (closure, n_guards, 0);
@@ -211,7 +228,7 @@ g_closure_new_simple (guint           sizeof_closure,
   closure->marshal = NULL;
   closure->data = data;
   closure->notifiers = NULL;
-  memset (G_STRUCT_MEMBER_P (closure, sizeof (*closure)), 0, sizeof_closure - sizeof (*closure));
+  memset (G_STRUCT_MEMBER_P (closure, sizeof (*closure)), 0, sizeof_closure - sizeof (*real_closure));
 
   return closure;
 }
@@ -594,7 +611,7 @@ g_closure_unref (GClosure *closure)
     {
       closure_invoke_notifiers (closure, FNOTIFY);
       g_free (closure->notifiers);
-      g_free (closure);
+      g_free (G_REAL_CLOSURE (closure));
     }
 }
 
@@ -776,6 +793,88 @@ g_closure_invoke (GClosure       *closure,
   g_closure_unref (closure);
 }
 
+void
+_g_closure_set_va_marshal (GClosure          *closure,
+			   GVaClosureMarshal  marshal)
+{
+  GRealClosure *real_closure;
+
+  g_return_if_fail (closure != NULL);
+  g_return_if_fail (marshal != NULL);
+
+  real_closure = G_REAL_CLOSURE (closure);
+  if (real_closure->va_marshal && real_closure->va_marshal != marshal)
+    g_warning ("attempt to override closure->va_marshal (%p) with new marshal (%p)",
+	       real_closure->va_marshal, marshal);
+  else
+    real_closure->va_marshal = marshal;
+}
+
+gboolean
+_g_closure_supports_invoke_va (GClosure *closure)
+{
+  GRealClosure *real_closure;
+
+  g_return_val_if_fail (closure != NULL, FALSE);
+
+  real_closure = G_REAL_CLOSURE (closure);
+
+  /* a custom meta marshaller can only be called with GValues */
+  return real_closure->va_marshal != NULL &&
+    (!closure->meta_marshal || real_closure->va_meta_marshal != NULL);
+}
+
+/* mirrors g_closure_invoke(), the caller has to make sure that
+ * _g_closure_supports_invoke_va() holds for @closure
+ */
+void
+_g_closure_invoke_va (GClosure       *closure,
+		      GValue /*out*/ *return_value,
+		      gpointer        instance,
+		      va_list         args,
+		      int             n_params,
+		      GType          *param_types)
+{
+  GRealClosure *real_closure;
+
+  g_return_if_fail (closure != NULL);
+
+  real_closure = G_REAL_CLOSURE (closure);
+
+  g_closure_ref (closure);      /* preserve floating flag */
+  if (!closure->is_invalid)
+    {
+      GVaClosureMarshal marshal;
+      gpointer marshal_data;
+      gboolean in_marshal = closure->in_marshal;
+
+      g_return_if_fail (real_closure->va_marshal != NULL);
+
+      SET (closure, in_marshal, TRUE);
+      if (real_closure->va_meta_marshal)
+	{
+	  marshal_data = closure->notifiers[0].data;
+	  marshal = real_closure->va_meta_marshal;
+	}
+      else
+	{
+	  marshal_data = NULL;
+	  marshal = real_closure->va_marshal;
+	}
+      if (!in_marshal)
+	closure_invoke_notifiers (closure, PRE_NOTIFY);
+      marshal (closure,
+	       return_value,
+	       instance, args,
+	       marshal_data,
+	       n_params, param_types);
+      if (!in_marshal)
+	closure_invoke_notifiers (closure, POST_NOTIFY);
+      SET (closure, in_marshal, in_marshal);
+    }
+  g_closure_unref (closure);
+}
+
 /**
  * g_closure_set_marshal:
  * @closure: a #GClosure
@@ -905,6 +1004,62 @@ g_type_iface_meta_marshal (GClosure       *closure,
 		      callback);
 }
 
+static void
+g_type_class_meta_marshalv (GClosure *closure,
+			    GValue   *return_value,
+			    gpointer  instance,
+			    va_list   args,
+			    gpointer  marshal_data,
+			    int       n_params,
+			    GType    *param_types)
+{
+  GRealClosure *real_closure;
+  GTypeClass *class;
+  gpointer callback;
+  /* GType itype = (GType) closure->data; */
+  guint offset = GPOINTER_TO_UINT (marshal_data);
+
+  real_closure = G_REAL_CLOSURE (closure);
+
+  class = G_TYPE_INSTANCE_GET_CLASS (instance, itype, GTypeClass);
+  callback = G_STRUCT_MEMBER (gpointer, class, offset);
+  if (callback)
+    real_closure->va_marshal (closure,
+			      return_value,
+			      instance, args,
+			      callback,
+			      n_params,
+			      param_types);
+}
+
+static void
+g_type_iface_meta_marshalv (GClosure *closure,
+			    GValue   *return_value,
+			    gpointer  instance,
+			    va_list   args,
+			    gpointer  marshal_data,
+			    int       n_params,
+			    GType    *param_types)
+{
+  GRealClosure *real_closure;
+  GTypeClass *class;
+  gpointer callback;
+  GType itype = (GType) closure->data;
+  guint offset = GPOINTER_TO_UINT (marshal_data);
+
+  real_closure = G_REAL_CLOSURE (closure);
+
+  class = G_TYPE_INSTANCE_GET_INTERFACE (instance, itype, GTypeClass);
+  callback = G_STRUCT_MEMBER (gpointer, class, offset);
+  if (callback)
+    real_closure->va_marshal (closure,
+			      return_value,
+			      instance, args,
+			      callback,
+			      n_params,
+			      param_types);
+}
+
 /**
  * g_signal_type_cclosure_new:
  * @itype: the #GType identifier of an interface or classed type
@@ -928,9 +1083,15 @@ g_signal_type_cclosure_new (GType    itype,
   
   closure = g_closure_new_simple (sizeof (GClosure), (gpointer) itype);
   if (G_TYPE_IS_INTERFACE (itype))
-    g_closure_set_meta_marshal (closure, GUINT_TO_POINTER (struct_offset), g_type_iface_meta_marshal);
+    {
+      g_closure_set_meta_marshal (closure, GUINT_TO_POINTER (struct_offset), g_type_iface_meta_marshal);
+      G_REAL_CLOSURE (closure)->va_meta_marshal = g_type_iface_meta_marshalv;
+    }
   else
-    g_closure_set_meta_marshal (closure, GUINT_TO_POINTER (struct_offset), g_type_class_meta_marshal);
+    {
+      g_closure_set_meta_marshal (closure, GUINT_TO_POINTER (struct_offset), g_type_class_meta_marshal);
+      G_REAL_CLOSURE (closure)->va_meta_marshal = g_type_class_meta_marshalv;
+    }
   
   return closure;
 }
@@ -117,6 +117,36 @@ typedef void  (*GClosureMarshal)	(GClosure	*closure,
 					 const GValue   *param_values,
 					 gpointer        invocation_hint,
 					 gpointer	 marshal_data);
+/**
+ * GVaClosureMarshal:
+ * @closure: the #GClosure to which the marshaller belongs
+ * @return_value: a #GValue to store the return value. May be %NULL if the
+ *  callback of @closure doesn't return a value.
+ * @instance: the instance on which the closure is invoked
+ * @args: va_list of the arguments to be passed to the closure, not
+ *  including the instance; the marshaller must not consume @args
+ *  itself, but work on a copy made with G_VA_COPY()
+ * @marshal_data: additional data specified when registering the marshaller,
+ *  see g_closure_set_marshal() and g_closure_set_meta_marshal()
+ * @n_params: the length of the @param_types array
+ * @param_types: the #GType of each argument in @args, possibly or-ed
+ *  with %G_SIGNAL_TYPE_STATIC_SCOPE
+ *
+ * This is the signature of va_list marshaller functions, an optional
+ * marshaller that can be used in some situations to avoid marshalling
+ * the signal argument into #GValue<!-- -->s. Such marshallers are
+ * generated by <link linkend="glib-genmarshal">glib-genmarshal</link>
+ * when invoked with <option>--valist-marshallers</option>.
+ *
+ * Since: 2.20
+ */
+typedef void (* GVaClosureMarshal)	(GClosure	*closure,
+					 GValue         *return_value,
+					 gpointer        instance,
+					 va_list         args,
+					 gpointer        marshal_data,
+					 int             n_params,
+					 GType          *param_types);
 /**
  * GCClosure:
  * @closure: the #GClosure
@@ -235,6 +265,17 @@ void	  g_closure_invoke			(GClosure 	*closure,
 						 const GValue	*param_values,
 						 gpointer	 invocation_hint);
 
+/*< private >*/
+G_GNUC_INTERNAL void     _g_closure_set_va_marshal      (GClosure          *closure,
+                                                         GVaClosureMarshal  marshal);
+G_GNUC_INTERNAL gboolean _g_closure_supports_invoke_va  (GClosure          *closure);
+G_GNUC_INTERNAL void     _g_closure_invoke_va           (GClosure          *closure,
+                                                         GValue /*out*/    *return_value,
+                                                         gpointer           instance,
+                                                         va_list            args,
+                                                         int                n_params,
+                                                         GType             *param_types);
+
 /* FIXME:
    OK:  data_object::destroy		-> closure_invalidate();
    MIS:	closure_invalidate()		-> disconnect(closure);
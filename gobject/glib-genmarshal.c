@@ -51,6 +51,7 @@ typedef struct
   const gchar *sig_name;	/* signature name [STRING] */
   const gchar *ctype;		/* C type name [gchar*] */
   const gchar *getter;		/* value getter function [g_value_get_string] */
+  const gchar *promoted_ctype;	/* promoted C type name for va_arg() [gpointer] */
 } InArgument;
 typedef struct
 {
@@ -122,6 +123,7 @@ static FILE             *fout = NULL;
 static gboolean		 gen_cheader = FALSE;
 static gboolean		 gen_cbody = FALSE;
 static gboolean          gen_internal = FALSE;
+static gboolean          gen_valist = FALSE;
 static gboolean		 skip_ploc = FALSE;
 static gboolean		 std_includes = TRUE;
 static gint              exit_status = 0;
@@ -182,29 +184,29 @@ static gboolean
 complete_in_arg (InArgument *iarg)
 {
   static const InArgument args[] = {
-    /* keyword		sig_name	ctype		getter			*/
-    { "VOID",		"VOID",		"void",		NULL,			},
-    { "BOOLEAN",	"BOOLEAN",	"gboolean",	"g_marshal_value_peek_boolean",	},
-    { "CHAR",		"CHAR",		"gchar",	"g_marshal_value_peek_char",	},
-    { "UCHAR",		"UCHAR",	"guchar",	"g_marshal_value_peek_uchar",	},
-    { "INT",		"INT",		"gint",		"g_marshal_value_peek_int",	},
-    { "UINT",		"UINT",		"guint",	"g_marshal_value_peek_uint",	},
-    { "LONG",		"LONG",		"glong",	"g_marshal_value_peek_long",	},
-    { "ULONG",		"ULONG",	"gulong",	"g_marshal_value_peek_ulong",	},
-    { "INT64",		"INT64",	"gint64",       "g_marshal_value_peek_int64",	},
-    { "UINT64",		"UINT64",	"guint64",	"g_marshal_value_peek_uint64",	},
-    { "ENUM",		"ENUM",		"gint",		"g_marshal_value_peek_enum",	},
-    { "FLAGS",		"FLAGS",	"guint",	"g_marshal_value_peek_flags",	},
-    { "FLOAT",		"FLOAT",	"gfloat",	"g_marshal_value_peek_float",	},
-    { "DOUBLE",		"DOUBLE",	"gdouble",	"g_marshal_value_peek_double",	},
-    { "STRING",		"STRING",	"gpointer",	"g_marshal_value_peek_string",	},
-    { "PARAM",		"PARAM",	"gpointer",	"g_marshal_value_peek_param",	},
-    { "BOXED",		"BOXED",	"gpointer",	"g_marshal_value_peek_boxed",	},
-    { "POINTER",	"POINTER",	"gpointer",	"g_marshal_value_peek_pointer",	},
-    { "OBJECT",		"OBJECT",	"gpointer",	"g_marshal_value_peek_object",	},
+    /* keyword		sig_name	ctype		getter				promoted ctype	*/
+    { "VOID",		"VOID",		"void",		NULL,			NULL,	},
+    { "BOOLEAN",	"BOOLEAN",	"gboolean",	"g_marshal_value_peek_boolean",	"gboolean",	},
+    { "CHAR",		"CHAR",		"gchar",	"g_marshal_value_peek_char",	"gint",	},
+    { "UCHAR",		"UCHAR",	"guchar",	"g_marshal_value_peek_uchar",	"guint",	},
+    { "INT",		"INT",		"gint",		"g_marshal_value_peek_int",	"gint",	},
+    { "UINT",		"UINT",		"guint",	"g_marshal_value_peek_uint",	"guint",	},
+    { "LONG",		"LONG",		"glong",	"g_marshal_value_peek_long",	"glong",	},
+    { "ULONG",		"ULONG",	"gulong",	"g_marshal_value_peek_ulong",	"gulong",	},
+    { "INT64",		"INT64",	"gint64",       "g_marshal_value_peek_int64",	"gint64",	},
+    { "UINT64",		"UINT64",	"guint64",	"g_marshal_value_peek_uint64",	"guint64",	},
+    { "ENUM",		"ENUM",		"gint",		"g_marshal_value_peek_enum",	"gint",	},
+    { "FLAGS",		"FLAGS",	"guint",	"g_marshal_value_peek_flags",	"guint",	},
+    { "FLOAT",		"FLOAT",	"gfloat",	"g_marshal_value_peek_float",	"gdouble",	},
+    { "DOUBLE",		"DOUBLE",	"gdouble",	"g_marshal_value_peek_double",	"gdouble",	},
+    { "STRING",		"STRING",	"gpointer",	"g_marshal_value_peek_string",	"gpointer",	},
+    { "PARAM",		"PARAM",	"gpointer",	"g_marshal_value_peek_param",	"gpointer",	},
+    { "BOXED",		"BOXED",	"gpointer",	"g_marshal_value_peek_boxed",	"gpointer",	},
+    { "POINTER",	"POINTER",	"gpointer",	"g_marshal_value_peek_pointer",	"gpointer",	},
+    { "OBJECT",		"OBJECT",	"gpointer",	"g_marshal_value_peek_object",	"gpointer",	},
     /* deprecated: */
-    { "NONE",		"VOID",		"void",		NULL,			},
-    { "BOOL",		"BOOLEAN",	"gboolean",	"g_marshal_value_peek_boolean",	},
+    { "NONE",		"VOID",		"void",		NULL,			NULL,	},
+    { "BOOL",		"BOOLEAN",	"gboolean",	"g_marshal_value_peek_boolean",	"gboolean",	},
   };
   guint i;
 
@@ -216,6 +218,7 @@ complete_in_arg (InArgument *iarg)
 	iarg->sig_name = args[i].sig_name;
 	iarg->ctype = args[i].ctype;
 	iarg->getter = args[i].getter;
+	iarg->promoted_ctype = args[i].promoted_ctype;
 
 	return TRUE;
       }
@@ -319,6 +322,201 @@ indent (guint n_spaces)
   return buffer;
 }
 
+static void
+put_marshal_callback_typedef (const gchar *signame,
+			      Signature   *sig)
+{
+  guint ind, a;
+  GList *node;
+
+  ind = g_fprintf (fout, "  typedef %s (*GMarshalFunc_%s) (", sig->rarg->ctype, signame);
+  g_fprintf (fout, "%s data1,\n", pad ("gpointer"));
+  for (a = 1, node = sig->args; node; node = node->next)
+    {
+      InArgument *iarg = node->data;
+
+      if (iarg->getter)
+	g_fprintf (fout, "%s%s arg_%d,\n", indent (ind), pad (iarg->ctype), a++);
+    }
+  g_fprintf (fout, "%s%s data2);\n", indent (ind), pad ("gpointer"));
+}
+
+static gboolean
+arg_needs_release (InArgument *iarg)
+{
+  return (strcmp (iarg->sig_name, "STRING") == 0 ||
+	  strcmp (iarg->sig_name, "BOXED") == 0 ||
+	  strcmp (iarg->sig_name, "PARAM") == 0 ||
+	  strcmp (iarg->sig_name, "OBJECT") == 0);
+}
+
+static void
+generate_marshal_va (const gchar *signame,
+		     Signature   *sig,
+		     gboolean     have_std_marshaller)
+{
+  guint ind, a, need_release = 0;
+  GList *node;
+
+  if (gen_cheader && have_std_marshaller)
+    {
+      g_fprintf (fout, "#define %s_%sv\t%s_%sv\n", marshaller_prefix, signame, std_marshaller_prefix, signame);
+    }
+  if (gen_cheader && !have_std_marshaller)
+    {
+      ind = g_fprintf (fout, gen_internal ? "G_GNUC_INTERNAL " : "extern ");
+      ind += g_fprintf (fout, "void ");
+      ind += g_fprintf (fout, "%s_%sv (", marshaller_prefix, signame);
+      g_fprintf (fout,   "GClosure *closure,\n");
+      g_fprintf (fout, "%sGValue   *return_value,\n", indent (ind));
+      g_fprintf (fout, "%sgpointer  instance,\n", indent (ind));
+      g_fprintf (fout, "%sva_list   args,\n", indent (ind));
+      g_fprintf (fout, "%sgpointer  marshal_data,\n", indent (ind));
+      g_fprintf (fout, "%sint       n_params,\n", indent (ind));
+      g_fprintf (fout, "%sGType    *param_types);\n", indent (ind));
+    }
+  if (gen_cbody && !have_std_marshaller)
+    {
+      /* cfile marshal header */
+      g_fprintf (fout, "\n");
+      g_fprintf (fout, "void\n");
+      ind = g_fprintf (fout, "%s_%sv (", marshaller_prefix, signame);
+      g_fprintf (fout,   "GClosure *closure,\n");
+      g_fprintf (fout, "%sGValue   *return_value G_GNUC_UNUSED,\n", indent (ind));
+      g_fprintf (fout, "%sgpointer  instance,\n", indent (ind));
+      g_fprintf (fout, "%sva_list   args,\n", indent (ind));
+      g_fprintf (fout, "%sgpointer  marshal_data,\n", indent (ind));
+      g_fprintf (fout, "%sint       n_params G_GNUC_UNUSED,\n", indent (ind));
+      g_fprintf (fout, "%sGType    *param_types G_GNUC_UNUSED)\n", indent (ind));
+      g_fprintf (fout, "{\n");
+
+      /* cfile GMarshalFunc typedef */
+      put_marshal_callback_typedef (signame, sig);
+
+      /* cfile marshal variables */
+      g_fprintf (fout, "  GCClosure *cc = (GCClosure*) closure;\n");
+      g_fprintf (fout, "  gpointer data1, data2;\n");
+      g_fprintf (fout, "  GMarshalFunc_%s callback;\n", signame);
+      if (sig->rarg->setter)
+	g_fprintf (fout, "  %s v_return;\n", sig->rarg->ctype);
+      for (a = 0, node = sig->args; node; node = node->next)
+	{
+	  InArgument *iarg = node->data;
+
+	  if (iarg->getter)
+	    g_fprintf (fout, "  %s arg%u;\n", iarg->ctype, a++);
+	}
+      if (a)
+	g_fprintf (fout, "  va_list args_copy;\n");
+
+      if (sig->rarg->setter)
+	{
+	  g_fprintf (fout, "\n");
+	  g_fprintf (fout, "  g_return_if_fail (return_value != NULL);\n");
+	}
+
+      /* cfile marshal argument collection, copying or referencing
+       * arguments like collecting them into GValues would
+       */
+      if (a)
+	{
+	  g_fprintf (fout, "\n");
+	  g_fprintf (fout, "  G_VA_COPY (args_copy, args);\n");
+	  for (a = 0, node = sig->args; node; node = node->next)
+	    {
+	      InArgument *iarg = node->data;
+
+	      if (!iarg->getter)
+		continue;
+	      g_fprintf (fout, "  arg%u = (%s) va_arg (args_copy, %s);\n",
+			 a, iarg->ctype, iarg->promoted_ctype);
+	      if (strcmp (iarg->sig_name, "STRING") == 0)
+		g_fprintf (fout,
+			   "  if ((param_types[%u] & G_SIGNAL_TYPE_STATIC_SCOPE) == 0 && arg%u != NULL)\n"
+			   "    arg%u = g_strdup (arg%u);\n", a, a, a, a);
+	      else if (strcmp (iarg->sig_name, "BOXED") == 0)
+		g_fprintf (fout,
+			   "  if ((param_types[%u] & G_SIGNAL_TYPE_STATIC_SCOPE) == 0 && arg%u != NULL)\n"
+			   "    arg%u = g_boxed_copy (param_types[%u] & ~G_SIGNAL_TYPE_STATIC_SCOPE, arg%u);\n",
+			   a, a, a, a, a);
+	      else if (strcmp (iarg->sig_name, "PARAM") == 0)
+		g_fprintf (fout,
+			   "  if (arg%u != NULL)\n"
+			   "    arg%u = g_param_spec_ref (arg%u);\n", a, a, a);
+	      else if (strcmp (iarg->sig_name, "OBJECT") == 0)
+		g_fprintf (fout,
+			   "  if (arg%u != NULL)\n"
+			   "    arg%u = g_object_ref (arg%u);\n", a, a, a);
+	      a++;
+	    }
+	  g_fprintf (fout, "  va_end (args_copy);\n");
+	}
+
+      /* cfile marshal data1, data2 and callback setup */
+      g_fprintf (fout, "\n");
+      g_fprintf (fout, "  if (G_CCLOSURE_SWAP_DATA (closure))\n    {\n");
+      g_fprintf (fout, "      data1 = closure->data;\n");
+      g_fprintf (fout, "      data2 = instance;\n");
+      g_fprintf (fout, "    }\n  else\n    {\n");
+      g_fprintf (fout, "      data1 = instance;\n");
+      g_fprintf (fout, "      data2 = closure->data;\n");
+      g_fprintf (fout, "    }\n");
+      g_fprintf (fout, "  callback = (GMarshalFunc_%s) (marshal_data ? marshal_data : cc->callback);\n", signame);
+
+      /* cfile marshal callback action */
+      g_fprintf (fout, "\n");
+      ind = g_fprintf (fout, " %s callback (", sig->rarg->setter ? " v_return =" : "");
+      g_fprintf (fout, "data1,\n");
+      for (a = 0, node = sig->args; node; node = node->next)
+	{
+	  InArgument *iarg = node->data;
+
+	  if (iarg->getter)
+	    g_fprintf (fout, "%sarg%u,\n", indent (ind), a++);
+	}
+      g_fprintf (fout, "%sdata2);\n", indent (ind));
+
+      /* cfile marshal argument release */
+      for (a = 0, node = sig->args; node; node = node->next)
+	{
+	  InArgument *iarg = node->data;
+
+	  if (!iarg->getter)
+	    continue;
+	  if (arg_needs_release (iarg) && need_release++ == 0)
+	    g_fprintf (fout, "\n");
+	  if (strcmp (iarg->sig_name, "STRING") == 0)
+	    g_fprintf (fout,
+		       "  if ((param_types[%u] & G_SIGNAL_TYPE_STATIC_SCOPE) == 0 && arg%u != NULL)\n"
+		       "    g_free (arg%u);\n", a, a, a);
+	  else if (strcmp (iarg->sig_name, "BOXED") == 0)
+	    g_fprintf (fout,
+		       "  if ((param_types[%u] & G_SIGNAL_TYPE_STATIC_SCOPE) == 0 && arg%u != NULL)\n"
+		       "    g_boxed_free (param_types[%u] & ~G_SIGNAL_TYPE_STATIC_SCOPE, arg%u);\n",
+		       a, a, a, a);
+	  else if (strcmp (iarg->sig_name, "PARAM") == 0)
+	    g_fprintf (fout,
+		       "  if (arg%u != NULL)\n"
+		       "    g_param_spec_unref (arg%u);\n", a, a);
+	  else if (strcmp (iarg->sig_name, "OBJECT") == 0)
+	    g_fprintf (fout,
+		       "  if (arg%u != NULL)\n"
+		       "    g_object_unref (arg%u);\n", a, a);
+	  a++;
+	}
+
+      /* cfile marshal return value storage */
+      if (sig->rarg->setter)
+	{
+	  g_fprintf (fout, "\n");
+	  g_fprintf (fout, "  %s (return_value, v_return);\n", sig->rarg->setter);
+	}
+
+      /* cfile marshal footer */
+      g_fprintf (fout, "}\n");
+    }
+}
+
 static void
 generate_marshal (const gchar *signame,
 		  Signature   *sig)
@@ -384,16 +582,7 @@ generate_marshal (const gchar *signame,
       g_fprintf (fout, "{\n");
 
       /* cfile GMarshalFunc typedef */
-      ind = g_fprintf (fout, "  typedef %s (*GMarshalFunc_%s) (", sig->rarg->ctype, signame);
-      g_fprintf (fout, "%s data1,\n", pad ("gpointer"));
-      for (a = 1, node = sig->args; node; node = node->next)
-	{
-	  InArgument *iarg = node->data;
-
-	  if (iarg->getter)
-	    g_fprintf (fout, "%s%s arg_%d,\n", indent (ind), pad (iarg->ctype), a++);
-	}
-      g_fprintf (fout, "%s%s data2);\n", indent (ind), pad ("gpointer"));
+      put_marshal_callback_typedef (signame, sig);
 
       /* cfile marshal variables */
       g_fprintf (fout, "  register GMarshalFunc_%s callback;\n", signame);
@@ -455,6 +644,9 @@ generate_marshal (const gchar *signame,
       /* cfile marshal footer */
       g_fprintf (fout, "}\n");
     }
+
+  if (gen_valist)
+    generate_marshal_va (signame, sig, have_std_marshaller);
 }
 
 static void
@@ -518,6 +710,8 @@ process_signature (Signature *sig)
   if (gen_cheader && !g_hash_table_lookup (marshallers, tmp))
     {
       g_fprintf (fout, "#define %s_%s\t%s_%s\n", marshaller_prefix, pname, marshaller_prefix, sname);
+      if (gen_valist)
+	g_fprintf (fout, "#define %s_%sv\t%s_%sv\n", marshaller_prefix, pname, marshaller_prefix, sname);
 
       g_hash_table_insert (marshallers, tmp, tmp);
     }
@@ -798,6 +992,11 @@ parse_args (gint    *argc_p,
 	  gen_internal = TRUE;
 	  argv[i] = NULL;
 	}
+      else if (strcmp ("--valist-marshallers", argv[i]) == 0)
+	{
+	  gen_valist = TRUE;
+	  argv[i] = NULL;
+	}
       else if ((strcmp ("--prefix", argv[i]) == 0) ||
 	       (strncmp ("--prefix=", argv[i], 9) == 0))
 	{
@@ -881,6 +1080,7 @@ print_blurb (FILE    *bout,
       g_fprintf (bout, "  --skip-source              skip source location comments\n");
       g_fprintf (bout, "  --stdinc, --nostdinc       include/use standard marshallers\n");
       g_fprintf (bout, "  --internal                 mark generated functions as internal\n");
+      g_fprintf (bout, "  --valist-marshallers       generate va_list marshallers\n");
       g_fprintf (bout, "  -h, --help                 show this help message\n");
       g_fprintf (bout, "  -v, --version              print version informations\n");
       g_fprintf (bout, "  --g-fatal-warnings         make warnings fatal (abort)\n");
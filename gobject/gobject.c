@@ -175,6 +175,10 @@ static guint               object_floating_flag_handler (GObject        *object,
 
 static void object_interface_check_properties           (gpointer        func_data,
 							 gpointer        g_iface);
+static void		   object_property_table_free	(gpointer        table);
+static void		   object_class_retire_property_table (GObjectClass *class);
+static inline GParamSpec*  object_class_lookup_property	(GObjectClass   *class,
+							 const gchar    *name);
 
 
 /* --- variables --- */
@@ -279,6 +283,7 @@ g_object_base_class_init (GObjectClass *class)
 
   /* reset instance specific fields and methods that don't get inherited */
   class->construct_properties = pclass ? g_slist_copy (pclass->construct_properties) : NULL;
+  class->property_table = NULL;
   class->get_property = NULL;
   class->set_property = NULL;
 }
@@ -290,6 +295,8 @@ g_object_base_class_finalize (GObjectClass *class)
   
   _g_signals_destroy (G_OBJECT_CLASS_TYPE (class));
 
+  object_property_table_free (class->property_table);
+  class->property_table = NULL;
   g_slist_free (class->construct_properties);
   class->construct_properties = NULL;
   list = g_param_spec_pool_list_owned (pspec_pool, G_OBJECT_CLASS_TYPE (class));
@@ -431,6 +438,11 @@ g_object_class_install_property (GObjectClass *class,
   pspec = g_param_spec_pool_lookup (pspec_pool, pspec->name, g_type_parent (G_OBJECT_CLASS_TYPE (class)), TRUE);
   if (pspec && pspec->flags & (G_PARAM_CONSTRUCT | G_PARAM_CONSTRUCT_ONLY))
     class->construct_properties = g_slist_remove (class->construct_properties, pspec);
+
+  /* a lookup from within class_init, or a subclass, may have built
+   * a table already
+   */
+  object_class_retire_property_table (class);
 }
 
 /**
@@ -490,10 +502,7 @@ g_object_class_find_property (GObjectClass *class,
   g_return_val_if_fail (G_IS_OBJECT_CLASS (class), NULL);
   g_return_val_if_fail (property_name != NULL, NULL);
   
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_CLASS_TYPE (class),
-				    TRUE);
+  pspec = object_class_lookup_property (class, property_name);
   if (pspec)
     {
       redirect = g_param_spec_get_redirect_target (pspec);
@@ -838,10 +847,7 @@ g_object_notify (GObject     *object,
    * (by, e.g. calling g_object_class_find_property())
    * because g_object_notify_queue_add() does that
    */
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_TYPE (object),
-				    TRUE);
+  pspec = object_class_lookup_property (G_OBJECT_GET_CLASS (object), property_name);
 
   if (!pspec)
     g_warning ("%s: object class `%s' has no property named `%s'",
@@ -1095,64 +1101,203 @@ object_in_construction_list (GObject *object)
   return in_construction;
 }
 
-/**
- * g_object_newv:
- * @object_type: the type id of the #GObject subtype to instantiate
- * @n_parameters: the length of the @parameters array
- * @parameters: an array of #GParameter
- *
- * Creates a new instance of a #GObject subtype and sets its properties.
- *
- * Construction parameters (see #G_PARAM_CONSTRUCT, #G_PARAM_CONSTRUCT_ONLY)
- * which are not explicitly specified are set to their default values.
- *
- * Returns: a new instance of @object_type
+/* property names are resolved against a table that is built once per
+ * class and never changes afterwards, so it can be read without a lock.
+ * this spares g_object_new(), g_object_set() and friends the pspec pool
+ * mutex and the walk of the type ancestry for every property.
  */
-gpointer
-g_object_newv (GType       object_type,
-	       guint       n_parameters,
-	       GParameter *parameters)
+typedef struct {
+  GHashTable  *pspecs;		/* canonical name -> GParamSpec */
+  guint        n_construct_pspecs;
+  GParamSpec **construct_pspecs;
+} ObjectPropertyTable;
+
+static ObjectPropertyTable*
+object_property_table_new (GObjectClass *class)
 {
-  GObjectConstructParam *cparams, *oparams;
-  GObjectNotifyQueue *nqueue = NULL; /* shouldn't be initialized, just to silence compiler */
-  GObject *object;
-  GObjectClass *class, *unref_class = NULL;
+  ObjectPropertyTable *table = g_new (ObjectPropertyTable, 1);
   GSList *slist;
-  guint n_total_cparams = 0, n_cparams = 0, n_oparams = 0, n_cvalues;
-  GValue *cvalues;
-  GList *clist = NULL;
-  gboolean newly_constructed;
+  GType type;
   guint i;
 
-  g_return_val_if_fail (G_TYPE_IS_OBJECT (object_type), NULL);
+  /* the property of the nearest ancestor wins, like with walk_ancestors */
+  table->pspecs = g_hash_table_new (g_str_hash, g_str_equal);
+  for (type = G_OBJECT_CLASS_TYPE (class); type; type = g_type_parent (type))
+    {
+      GList *list, *node;
 
-  class = g_type_class_peek_static (object_type);
-  if (!class)
-    class = unref_class = g_type_class_ref (object_type);
+      list = g_param_spec_pool_list_owned (pspec_pool, type);
+      for (node = list; node; node = node->next)
+	{
+	  GParamSpec *pspec = node->data;
+
+	  if (!g_hash_table_lookup (table->pspecs, pspec->name))
+	    g_hash_table_insert (table->pspecs, (gchar*) pspec->name, pspec);
+	}
+      g_list_free (list);
+    }
+
+  /* construct properties, in the order their defaults are set in */
+  table->n_construct_pspecs = g_slist_length (class->construct_properties);
+  table->construct_pspecs = g_new (GParamSpec*, table->n_construct_pspecs);
+  i = table->n_construct_pspecs;
   for (slist = class->construct_properties; slist; slist = slist->next)
+    table->construct_pspecs[--i] = slist->data;
+
+  return table;
+}
+
+static void
+object_property_table_free (gpointer data)
+{
+  ObjectPropertyTable *table = data;
+
+  if (table)
     {
-      clist = g_list_prepend (clist, slist->data);
-      n_total_cparams += 1;
+      g_hash_table_destroy (table->pspecs);
+      g_free (table->construct_pspecs);
+      g_free (table);
     }
+}
 
-  /* collect parameters, sort into construction and normal ones */
-  oparams = g_new (GObjectConstructParam, n_parameters);
-  cparams = g_new (GObjectConstructParam, n_total_cparams);
-  for (i = 0; i < n_parameters; i++)
+static ObjectPropertyTable*
+object_class_get_property_table (GObjectClass *class)
+{
+  ObjectPropertyTable *table = g_atomic_pointer_get (&class->property_table);
+
+  if (G_UNLIKELY (!table))
     {
-      GValue *value = &parameters[i].value;
-      GParamSpec *pspec = g_param_spec_pool_lookup (pspec_pool,
-						    parameters[i].name,
-						    object_type,
-						    TRUE);
-      if (!pspec)
+      table = object_property_table_new (class);
+      if (!g_atomic_pointer_compare_and_exchange (&class->property_table, NULL, table))
 	{
-	  g_warning ("%s: object class `%s' has no property named `%s'",
-		     G_STRFUNC,
-		     g_type_name (object_type),
-		     parameters[i].name);
-	  continue;
+	  object_property_table_free (table);
+	  table = g_atomic_pointer_get (&class->property_table);
 	}
+    }
+
+  return table;
+}
+
+/* unpublishes the tables of @class and its subclasses, so they get
+ * rebuilt with the properties installed since. other threads may
+ * still be reading them without a lock, so they are leaked; this
+ * only happens to classes that were used before all their properties
+ * were installed.
+ */
+static void
+object_class_retire_property_table (GObjectClass *class)
+{
+  ObjectPropertyTable *table;
+  GType *children;
+  guint n_children, i;
+
+  do
+    table = g_atomic_pointer_get (&class->property_table);
+  while (table && !g_atomic_pointer_compare_and_exchange (&class->property_table, table, NULL));
+
+  /* a subclass can only have a class if this one has */
+  children = g_type_children (G_OBJECT_CLASS_TYPE (class), &n_children);
+  for (i = 0; i < n_children; i++)
+    {
+      GObjectClass *child_class = g_type_class_peek (children[i]);
+
+      if (child_class)
+	object_class_retire_property_table (child_class);
+    }
+  g_free (children);
+}
+
+static GParamSpec*
+object_property_table_lookup_slow (ObjectPropertyTable *table,
+				   GType                object_type,
+				   const gchar         *name)
+{
+  gchar stack_buffer[64], *buffer;
+  GParamSpec *pspec;
+  guint i, l;
+
+  /* type prefixed names are left to the pool */
+  if (strchr (name, ':'))
+    return g_param_spec_pool_lookup (pspec_pool, name, object_type, TRUE);
+
+  /* try the canonical form, like the pool does */
+  l = strlen (name);
+  buffer = l < sizeof (stack_buffer) ? stack_buffer : g_malloc (l + 1);
+  for (i = 0; i <= l; i++)
+    {
+      gchar c = name[i];
+
+      if (c != 0 && c != '-' &&
+	  (c < '0' || c > '9') &&
+	  (c < 'A' || c > 'Z') &&
+	  (c < 'a' || c > 'z'))
+	c = '-';
+      buffer[i] = c;
+    }
+  pspec = g_hash_table_lookup (table->pspecs, buffer);
+  if (buffer != stack_buffer)
+    g_free (buffer);
+
+  /* the table may predate a property installed on an ancestor */
+  if (!pspec)
+    pspec = g_param_spec_pool_lookup (pspec_pool, name, object_type, TRUE);
+
+  return pspec;
+}
+
+static inline GParamSpec*
+object_property_table_lookup (ObjectPropertyTable *table,
+			      GType                object_type,
+			      const gchar         *name)
+{
+  GParamSpec *pspec = g_hash_table_lookup (table->pspecs, name);
+
+  if (G_UNLIKELY (!pspec))
+    pspec = object_property_table_lookup_slow (table, object_type, name);
+
+  return pspec;
+}
+
+static inline GParamSpec*
+object_class_lookup_property (GObjectClass *class,
+			      const gchar  *name)
+{
+  return object_property_table_lookup (object_class_get_property_table (class),
+				       G_OBJECT_CLASS_TYPE (class),
+				       name);
+}
+
+/* constructs an object from resolved properties. @params is reused
+ * to hold the properties that are set after construction.
+ */
+static GObject*
+g_object_new_internal (GObjectClass          *class,
+		       ObjectPropertyTable   *table,
+		       guint                  n_params,
+		       GObjectConstructParam *params)
+{
+  GType object_type = G_OBJECT_CLASS_TYPE (class);
+  GObjectConstructParam *cparams;
+  GObjectNotifyQueue *nqueue = NULL; /* shouldn't be initialized, just to silence compiler */
+  GObject *object;
+  guint n_total_cparams, n_cparams = 0, n_oparams = 0, n_cvalues = 0;
+  GValue *cvalues;
+  gboolean *cparam_set;
+  gboolean newly_constructed;
+  guint i, j;
+
+  /* construct properties are few, so their arrays live on the stack */
+  n_total_cparams = table->n_construct_pspecs;
+  cparams = g_newa (GObjectConstructParam, n_total_cparams);
+  cvalues = g_newa (GValue, n_total_cparams);
+  cparam_set = g_newa (gboolean, n_total_cparams);
+  memset (cparam_set, 0, sizeof (gboolean) * n_total_cparams);
+
+  /* sort parameters into construction and normal ones */
+  for (i = 0; i < n_params; i++)
+    {
+      GParamSpec *pspec = params[i].pspec;
+
       if (!(pspec->flags & G_PARAM_WRITABLE))
 	{
 	  g_warning ("%s: property `%s' of object class `%s' is not writable",
@@ -1163,61 +1308,43 @@ g_object_newv (GType       object_type,
 	}
       if (pspec->flags & (G_PARAM_CONSTRUCT | G_PARAM_CONSTRUCT_ONLY))
 	{
-	  GList *list = g_list_find (clist, pspec);
-
-	  if (!list)
+	  for (j = 0; j < n_total_cparams; j++)
+	    if (table->construct_pspecs[j] == pspec)
+	      break;
+	  if (j == n_total_cparams || cparam_set[j])
 	    {
 	      g_warning ("%s: construct property \"%s\" for object `%s' can't be set twice",
                          G_STRFUNC, pspec->name, g_type_name (object_type));
 	      continue;
 	    }
-	  cparams[n_cparams].pspec = pspec;
-	  cparams[n_cparams].value = value;
-	  n_cparams++;
-	  if (!list->prev)
-	    clist = list->next;
-	  else
-	    list->prev->next = list->next;
-	  if (list->next)
-	    list->next->prev = list->prev;
-	  g_list_free_1 (list);
+	  cparam_set[j] = TRUE;
+	  cparams[n_cparams++] = params[i];
 	}
       else
-	{
-	  oparams[n_oparams].pspec = pspec;
-	  oparams[n_oparams].value = value;
-	  n_oparams++;
-	}
+	params[n_oparams++] = params[i];
     }
 
   /* set remaining construction properties to default values */
-  n_cvalues = n_total_cparams - n_cparams;
-  cvalues = g_new (GValue, n_cvalues);
-  while (clist)
-    {
-      GList *tmp = clist->next;
-      GParamSpec *pspec = clist->data;
-      GValue *value = cvalues + n_total_cparams - n_cparams - 1;
-
-      value->g_type = 0;
-      g_value_init (value, G_PARAM_SPEC_VALUE_TYPE (pspec));
-      g_param_value_set_default (pspec, value);
+  for (j = 0; j < n_total_cparams; j++)
+    if (!cparam_set[j])
+      {
+	GParamSpec *pspec = table->construct_pspecs[j];
+	GValue *value = cvalues + n_cvalues++;
 
-      cparams[n_cparams].pspec = pspec;
-      cparams[n_cparams].value = value;
-      n_cparams++;
+	value->g_type = 0;
+	g_value_init (value, G_PARAM_SPEC_VALUE_TYPE (pspec));
+	g_param_value_set_default (pspec, value);
 
-      g_list_free_1 (clist);
-      clist = tmp;
-    }
+	cparams[n_cparams].pspec = pspec;
+	cparams[n_cparams].value = value;
+	n_cparams++;
+      }
 
   /* construct object from construction parameters */
   object = class->constructor (object_type, n_total_cparams, cparams);
   /* free construction values */
-  g_free (cparams);
   while (n_cvalues--)
     g_value_unset (cvalues + n_cvalues);
-  g_free (cvalues);
 
   /* adjust freeze_count according to g_object_init() and remaining properties */
   G_LOCK (construction_mutex);
@@ -1234,13 +1361,144 @@ g_object_newv (GType       object_type,
 
   /* set remaining properties */
   for (i = 0; i < n_oparams; i++)
-    object_set_property (object, oparams[i].pspec, oparams[i].value, nqueue);
-  g_free (oparams);
+    object_set_property (object, params[i].pspec, params[i].value, nqueue);
 
   /* release our own freeze count and handle notifications */
   if (newly_constructed || n_oparams)
     g_object_notify_queue_thaw (object, nqueue);
 
+  return object;
+}
+
+/**
+ * g_object_newv:
+ * @object_type: the type id of the #GObject subtype to instantiate
+ * @n_parameters: the length of the @parameters array
+ * @parameters: an array of #GParameter
+ *
+ * Creates a new instance of a #GObject subtype and sets its properties.
+ *
+ * Construction parameters (see #G_PARAM_CONSTRUCT, #G_PARAM_CONSTRUCT_ONLY)
+ * which are not explicitly specified are set to their default values.
+ *
+ * Returns: a new instance of @object_type
+ */
+gpointer
+g_object_newv (GType       object_type,
+	       guint       n_parameters,
+	       GParameter *parameters)
+{
+  GObjectConstructParam stack_params[16], *params;
+  ObjectPropertyTable *table;
+  GObjectClass *class, *unref_class = NULL;
+  GObject *object;
+  guint n_params = 0;
+  guint i;
+
+  g_return_val_if_fail (G_TYPE_IS_OBJECT (object_type), NULL);
+
+  class = g_type_class_peek_static (object_type);
+  if (!class)
+    class = unref_class = g_type_class_ref (object_type);
+  table = object_class_get_property_table (class);
+
+  if (n_parameters <= G_N_ELEMENTS (stack_params))
+    params = stack_params;
+  else
+    params = g_new (GObjectConstructParam, n_parameters);
+  for (i = 0; i < n_parameters; i++)
+    {
+      GParamSpec *pspec = object_property_table_lookup (table, object_type, parameters[i].name);
+
+      if (!pspec)
+	{
+	  g_warning ("%s: object class `%s' has no property named `%s'",
+		     G_STRFUNC,
+		     g_type_name (object_type),
+		     parameters[i].name);
+	  continue;
+	}
+      params[n_params].pspec = pspec;
+      params[n_params].value = &parameters[i].value;
+      n_params++;
+    }
+
+  object = g_object_new_internal (class, table, n_params, params);
+
+  if (params != stack_params)
+    g_free (params);
+  if (unref_class)
+    g_type_class_unref (unref_class);
+
+  return object;
+}
+
+/**
+ * g_object_new_with_properties:
+ * @object_type: the type id of the #GObject subtype to instantiate
+ * @n_properties: the length of the @names and @values arrays
+ * @names: the names of the properties to set
+ * @values: the values of the properties to set
+ *
+ * Creates a new instance of a #GObject subtype and sets its properties,
+ * like g_object_newv(), but with the property names and values passed
+ * in separate arrays. This allows callers that create many objects to
+ * keep a single array of names around, and it saves the copying of
+ * #GValue<!-- -->s that g_object_new() needs.
+ *
+ * Construction parameters (see #G_PARAM_CONSTRUCT, #G_PARAM_CONSTRUCT_ONLY)
+ * which are not explicitly specified are set to their default values.
+ *
+ * Returns: a new instance of @object_type
+ *
+ * Since: 2.20
+ */
+GObject*
+g_object_new_with_properties (GType         object_type,
+			      guint         n_properties,
+			      const gchar  *names[],
+			      const GValue  values[])
+{
+  GObjectConstructParam stack_params[16], *params;
+  ObjectPropertyTable *table;
+  GObjectClass *class, *unref_class = NULL;
+  GObject *object;
+  guint n_params = 0;
+  guint i;
+
+  g_return_val_if_fail (G_TYPE_IS_OBJECT (object_type), NULL);
+  g_return_val_if_fail (n_properties == 0 || (names != NULL && values != NULL), NULL);
+
+  class = g_type_class_peek_static (object_type);
+  if (!class)
+    class = unref_class = g_type_class_ref (object_type);
+  table = object_class_get_property_table (class);
+
+  if (n_properties <= G_N_ELEMENTS (stack_params))
+    params = stack_params;
+  else
+    params = g_new (GObjectConstructParam, n_properties);
+  for (i = 0; i < n_properties; i++)
+    {
+      GParamSpec *pspec = object_property_table_lookup (table, object_type, names[i]);
+
+      if (!pspec)
+	{
+	  g_warning ("%s: object class `%s' has no property named `%s'",
+		     G_STRFUNC,
+		     g_type_name (object_type),
+		     names[i]);
+	  continue;
+	}
+      params[n_params].pspec = pspec;
+      params[n_params].value = (GValue*) &values[i];
+      n_params++;
+    }
+
+  object = g_object_new_internal (class, table, n_params, params);
+
+  if (params != stack_params)
+    g_free (params);
   if (unref_class)
     g_type_class_unref (unref_class);
 
@@ -1266,11 +1524,14 @@ g_object_new_valist (GType	  object_type,
 		     const gchar *first_property_name,
 		     va_list	  var_args)
 {
+  GObjectConstructParam stack_params[16], *params;
+  GValue stack_values[16], *values;
+  ObjectPropertyTable *table;
   GObjectClass *class;
-  GParameter *params;
   const gchar *name;
   GObject *object;
-  guint n_params = 0, n_alloced_params = 16;
+  guint n_params = 0, n_alloced_params = G_N_ELEMENTS (stack_params);
+  guint i;
   
   g_return_val_if_fail (G_TYPE_IS_OBJECT (object_type), NULL);
 
@@ -1278,16 +1539,16 @@ g_object_new_valist (GType	  object_type,
     return g_object_newv (object_type, 0, NULL);
 
   class = g_type_class_ref (object_type);
+  table = object_class_get_property_table (class);
 
-  params = g_new (GParameter, n_alloced_params);
+  params = stack_params;
+  values = stack_values;
   name = first_property_name;
   while (name)
     {
       gchar *error = NULL;
-      GParamSpec *pspec = g_param_spec_pool_lookup (pspec_pool,
-						    name,
-						    object_type,
-						    TRUE);
+      GParamSpec *pspec = object_property_table_lookup (table, object_type, name);
+
       if (!pspec)
 	{
 	  g_warning ("%s: object class `%s' has no property named `%s'",
@@ -1299,28 +1560,46 @@ g_object_new_valist (GType	  object_type,
       if (n_params >= n_alloced_params)
 	{
 	  n_alloced_params += 16;
-	  params = g_renew (GParameter, params, n_alloced_params);
+	  if (params == stack_params)
+	    {
+	      params = g_new (GObjectConstructParam, n_alloced_params);
+	      values = g_new (GValue, n_alloced_params);
+	      memcpy (values, stack_values, sizeof (stack_values));
+	    }
+	  else
+	    {
+	      params = g_renew (GObjectConstructParam, params, n_alloced_params);
+	      values = g_renew (GValue, values, n_alloced_params);
+	    }
 	}
-      params[n_params].name = name;
-      params[n_params].value.g_type = 0;
-      g_value_init (&params[n_params].value, G_PARAM_SPEC_VALUE_TYPE (pspec));
-      G_VALUE_COLLECT (&params[n_params].value, var_args, 0, &error);
+      params[n_params].pspec = pspec;
+      values[n_params].g_type = 0;
+      g_value_init (&values[n_params], G_PARAM_SPEC_VALUE_TYPE (pspec));
+      G_VALUE_COLLECT (&values[n_params], var_args, 0, &error);
       if (error)
 	{
 	  g_warning ("%s: %s", G_STRFUNC, error);
 	  g_free (error);
-          g_value_unset (&params[n_params].value);
+          g_value_unset (&values[n_params]);
 	  break;
 	}
       n_params++;
       name = va_arg (var_args, gchar*);
     }
 
-  object = g_object_newv (object_type, n_params, params);
+  /* values don't move anymore */
+  for (i = 0; i < n_params; i++)
+    params[i].value = &values[i];
+
+  object = g_object_new_internal (class, table, n_params, params);
 
   while (n_params--)
-    g_value_unset (&params[n_params].value);
-  g_free (params);
+    g_value_unset (&values[n_params]);
+  if (params != stack_params)
+    {
+      g_free (params);
+      g_free (values);
+    }
 
   g_type_class_unref (class);
 
@@ -1390,10 +1669,7 @@ g_object_set_valist (GObject	 *object,
       GParamSpec *pspec;
       gchar *error = NULL;
       
-      pspec = g_param_spec_pool_lookup (pspec_pool,
-					name,
-					G_OBJECT_TYPE (object),
-					TRUE);
+      pspec = object_class_lookup_property (G_OBJECT_GET_CLASS (object), name);
       if (!pspec)
 	{
 	  g_warning ("%s: object class `%s' has no property named `%s'",
@@ -1472,10 +1748,7 @@ g_object_get_valist (GObject	 *object,
       GParamSpec *pspec;
       gchar *error;
       
-      pspec = g_param_spec_pool_lookup (pspec_pool,
-					name,
-					G_OBJECT_TYPE (object),
-					TRUE);
+      pspec = object_class_lookup_property (G_OBJECT_GET_CLASS (object), name);
       if (!pspec)
 	{
 	  g_warning ("%s: object class `%s' has no property named `%s'",
@@ -1612,10 +1885,7 @@ g_object_set_property (GObject	    *object,
   g_object_ref (object);
   nqueue = g_object_notify_queue_freeze (object, &property_notify_context);
   
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_TYPE (object),
-				    TRUE);
+  pspec = object_class_lookup_property (G_OBJECT_GET_CLASS (object), property_name);
   if (!pspec)
     g_warning ("%s: object class `%s' has no property named `%s'",
 	       G_STRFUNC,
@@ -1663,10 +1933,7 @@ g_object_get_property (GObject	   *object,
   
   g_object_ref (object);
   
-  pspec = g_param_spec_pool_lookup (pspec_pool,
-				    property_name,
-				    G_OBJECT_TYPE (object),
-				    TRUE);
+  pspec = object_class_lookup_property (G_OBJECT_GET_CLASS (object), property_name);
   if (!pspec)
     g_warning ("%s: object class `%s' has no property named `%s'",
 	       G_STRFUNC,
@@ -344,8 +344,10 @@ struct  _GObjectClass
   void	     (*constructed)		(GObject	*object);
 
   /*< private >*/
+  gpointer	property_table;
+
   /* padding */
-  gpointer	pdummy[7];
+  gpointer	pdummy[6];
 };
 /**
  * GObjectConstructParam:
@@ -406,6 +408,10 @@ gpointer    g_object_newv		      (GType           object_type,
 GObject*    g_object_new_valist               (GType           object_type,
 					       const gchar    *first_property_name,
 					       va_list         var_args);
+GObject*    g_object_new_with_properties      (GType           object_type,
+					       guint           n_properties,
+					       const gchar    *names[],
+					       const GValue    values[]);
 void	    g_object_set                      (gpointer	       object,
 					       const gchar    *first_property_name,
 					       ...) G_GNUC_NULL_TERMINATED;
@@ -119,6 +119,7 @@ typedef struct _Emission     Emission;
 typedef struct _Handler      Handler;
 typedef struct _HandlerList  HandlerList;
 typedef struct _HandlerMatch HandlerMatch;
+typedef struct _HandlerBucket HandlerBucket;
 typedef enum
 {
   EMISSION_STOP,
@@ -136,12 +137,14 @@ static inline HandlerList*	handler_list_ensure	(guint		  signal_id,
 							 gpointer	  instance);
 static inline HandlerList*	handler_list_lookup	(guint		  signal_id,
 							 gpointer	  instance);
-static inline Handler*		handler_new		(gboolean	  after);
+static inline Handler*		handler_new		(HandlerBucket	 *bucket,
+							 gboolean	  after);
 static	      void		handler_insert		(guint		  signal_id,
 							 gpointer	  instance,
 							 Handler	 *handler);
 static	      Handler*		handler_lookup		(gpointer	  instance,
 							 gulong		  handler_id,
+							 GClosure	 *closure,
 							 guint		 *signal_id_p);
 static inline HandlerMatch*	handler_match_prepend	(HandlerMatch	 *list,
 							 Handler	 *handler,
@@ -170,6 +173,7 @@ static inline Emission*		emission_find		(Emission	 *emission_list,
 							 guint		  signal_id,
 							 GQuark		  detail,
 							 gpointer	  instance);
+static inline Emission*		emission_find_innermost	(gpointer	  instance);
 static gint			class_closures_cmp	(gconstpointer	  node1,
 							 gconstpointer	  node2);
 static gint			signal_key_cmp		(gconstpointer	  node1,
@@ -178,7 +182,8 @@ static	      gboolean		signal_emit_unlocked_R	(SignalNode	 *node,
 							 GQuark		  detail,
 							 gpointer	  instance,
 							 GValue		 *return_value,
-							 const GValue	 *instance_and_params);
+							 const GValue	 *instance_and_params,
+							 va_list	 *var_args);
 static const gchar *            type_debug_name         (GType            type);
 
 
@@ -212,10 +217,16 @@ struct _SignalNode
   GBSearchArray     *class_closure_bsa;
   SignalAccumulator *accumulator;
   GSignalCMarshaller c_marshaller;
+  GSignalCVaMarshaller va_marshaller;
   GHookList         *emission_hooks;
+
+  /* connected handlers, counted per bucket of instances; read without the lock */
+  gint              *handler_counts;
 };
 #define	MAX_TEST_CLASS_OFFSET	(4096)	/* 2^12, 12 bits for test_class_offset */
 #define	TEST_CLASS_MAGIC	(1)	/* indicates NULL class closure, candidate for NOP optimization */
+#define	N_HANDLER_BUCKETS	(64)
+#define	HANDLER_BUCKET(instance) ((((gsize) (instance) >> 3) * 2654435761u) % N_HANDLER_BUCKETS)
 
 struct _SignalKey
 {
@@ -251,6 +262,7 @@ struct _Handler
   guint         block_count : 16;
 #define HANDLER_MAX_BLOCK_COUNT (1 << 16)
   guint         after : 1;
+  guint         has_invalid_closure_notify : 1;
   GClosure     *closure;
 };
 struct _HandlerMatch
@@ -266,6 +278,22 @@ typedef struct
   GClosure *closure;
 } ClassClosure;
 
+/* handler lists and emission stacks are only ever looked at for one
+ * instance at a time, so they are spread over buckets of instances
+ * which are locked independently. emissions on instances in different
+ * buckets don't contend, and signal nodes are read without a lock.
+ * g_signal_mutex, when needed, is taken before a bucket lock, and
+ * neither is held while calling out of this file.
+ */
+struct _HandlerBucket
+{
+  GStaticMutex mutex;
+  GHashTable  *handler_list_bsa_ht;
+  Emission    *recursive_emissions;
+  Emission    *restart_emissions;
+  gulong       handler_sequential_number;
+};
+
 
 /* --- variables --- */
 static GBSearchArray *g_signal_key_bsa = NULL;
@@ -284,18 +312,19 @@ static GBSearchConfig g_class_closure_bconfig = {
   class_closures_cmp,
   0,
 };
-static GHashTable    *g_handler_list_bsa_ht = NULL;
-static Emission      *g_recursive_emissions = NULL;
-static Emission      *g_restart_emissions = NULL;
-static gulong         g_handler_sequential_number = 1;
+static HandlerBucket  g_handler_buckets[N_HANDLER_BUCKETS];
 G_LOCK_DEFINE_STATIC (g_signal_mutex);
 #define	SIGNAL_LOCK()		G_LOCK (g_signal_mutex)
 #define	SIGNAL_UNLOCK()		G_UNLOCK (g_signal_mutex)
+#define	INSTANCE_BUCKET(instance)	(&g_handler_buckets[HANDLER_BUCKET (instance)])
+#define	BUCKET_LOCK(bucket)		g_static_mutex_lock (&(bucket)->mutex)
+#define	BUCKET_UNLOCK(bucket)		g_static_mutex_unlock (&(bucket)->mutex)
 
 
 /* --- signal nodes --- */
 static guint          g_n_signal_nodes = 0;
 static SignalNode   **g_signal_nodes = NULL;
+static guint          g_signal_nodes_size = 0;
 
 static inline SignalNode*
 LOOKUP_SIGNAL_NODE (register guint signal_id)
@@ -306,6 +335,41 @@ LOOKUP_SIGNAL_NODE (register guint signal_id)
     return NULL;
 }
 
+/* The emission fast path looks nodes up without holding the lock,
+ * so the node array is never realloc()ed in place. A bigger copy is
+ * published instead and the old one is kept around, which costs at
+ * most as much memory as the final array.
+ */
+static inline SignalNode*
+peek_signal_node (guint signal_id)
+{
+  if (signal_id < (guint) g_atomic_int_get ((gint*) &g_n_signal_nodes))
+    return ((SignalNode**) g_atomic_pointer_get (&g_signal_nodes))[signal_id];
+  else
+    return NULL;
+}
+
+static guint
+signal_node_append (SignalNode *node)
+{
+  guint signal_id = g_n_signal_nodes;
+
+  if (signal_id == g_signal_nodes_size)
+    {
+      SignalNode **nodes;
+
+      g_signal_nodes_size = MAX (g_signal_nodes_size * 2, 64);
+      nodes = g_new (SignalNode*, g_signal_nodes_size);
+      if (signal_id)
+        memcpy (nodes, g_signal_nodes, sizeof (SignalNode*) * signal_id);
+      g_atomic_pointer_set (&g_signal_nodes, nodes);
+    }
+  g_signal_nodes[signal_id] = node;
+  g_atomic_int_set ((gint*) &g_n_signal_nodes, signal_id + 1);
+
+  return signal_id;
+}
+
 
 /* --- functions --- */
 static inline guint
@@ -375,9 +439,10 @@ static inline HandlerList*
 handler_list_ensure (guint    signal_id,
 		     gpointer instance)
 {
-  GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  GHashTable *ht = INSTANCE_BUCKET (instance)->handler_list_bsa_ht;
+  GBSearchArray *hlbsa = g_hash_table_lookup (ht, instance);
   HandlerList key;
-  
+
   key.signal_id = signal_id;
   key.handlers    = NULL;
   key.tail_before = NULL;
@@ -386,7 +451,7 @@ handler_list_ensure (guint    signal_id,
     {
       hlbsa = g_bsearch_array_create (&g_signal_hlbsa_bconfig);
       hlbsa = g_bsearch_array_insert (hlbsa, &g_signal_hlbsa_bconfig, &key);
-      g_hash_table_insert (g_handler_list_bsa_ht, instance, hlbsa);
+      g_hash_table_insert (ht, instance, hlbsa);
     }
   else
     {
@@ -394,7 +459,7 @@ handler_list_ensure (guint    signal_id,
 
       hlbsa = g_bsearch_array_insert (o, &g_signal_hlbsa_bconfig, &key);
       if (hlbsa != o)
-	g_hash_table_insert (g_handler_list_bsa_ht, instance, hlbsa);
+	g_hash_table_insert (ht, instance, hlbsa);
     }
   return g_bsearch_array_lookup (hlbsa, &g_signal_hlbsa_bconfig, &key);
 }
@@ -403,7 +468,7 @@ static inline HandlerList*
 handler_list_lookup (guint    signal_id,
 		     gpointer instance)
 {
-  GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  GBSearchArray *hlbsa = g_hash_table_lookup (INSTANCE_BUCKET (instance)->handler_list_bsa_ht, instance);
   HandlerList key;
   
   key.signal_id = signal_id;
@@ -412,11 +477,12 @@ handler_list_lookup (guint    signal_id,
 }
 
 static Handler*
-handler_lookup (gpointer instance,
-		gulong   handler_id,
-		guint   *signal_id_p)
+handler_lookup (gpointer  instance,
+		gulong    handler_id,
+		GClosure *closure,
+		guint    *signal_id_p)
 {
-  GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  GBSearchArray *hlbsa = g_hash_table_lookup (INSTANCE_BUCKET (instance)->handler_list_bsa_ht, instance);
   
   if (hlbsa)
     {
@@ -428,7 +494,9 @@ handler_lookup (gpointer instance,
           Handler *handler;
           
           for (handler = hlist->handlers; handler; handler = handler->next)
-            if (handler->sequential_number == handler_id)
+            if (closure ? (handler->closure == closure &&
+                           handler->has_invalid_closure_notify) :
+                handler->sequential_number == handler_id)
               {
                 if (signal_id_p)
                   *signal_id_p = hlist->signal_id;
@@ -488,7 +556,7 @@ handlers_find (gpointer         instance,
       
       if (mask & G_SIGNAL_MATCH_FUNC)
 	{
-	  node = LOOKUP_SIGNAL_NODE (signal_id);
+	  node = peek_signal_node (signal_id);
 	  if (!node || !node->c_marshaller)
 	    return NULL;
 	}
@@ -511,7 +579,7 @@ handlers_find (gpointer         instance,
     }
   else
     {
-      GBSearchArray *hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+      GBSearchArray *hlbsa = g_hash_table_lookup (INSTANCE_BUCKET (instance)->handler_list_bsa_ht, instance);
       
       mask = ~mask;
       if (hlbsa)
@@ -526,7 +594,7 @@ handlers_find (gpointer         instance,
               
 	      if (!(mask & G_SIGNAL_MATCH_FUNC))
 		{
-		  node = LOOKUP_SIGNAL_NODE (hlist->signal_id);
+		  node = peek_signal_node (hlist->signal_id);
 		  if (!node->c_marshaller)
 		    continue;
 		}
@@ -552,22 +620,34 @@ handlers_find (gpointer         instance,
   return mlist;
 }
 
+/* handler ids are allocated per bucket, with the bucket index in the
+ * low bits so they stay unique and increase for each instance
+ */
+static inline gulong
+bucket_next_handler_id (HandlerBucket *bucket)
+{
+  return bucket->handler_sequential_number * N_HANDLER_BUCKETS + (bucket - g_handler_buckets);
+}
+
 static inline Handler*
-handler_new (gboolean after)
+handler_new (HandlerBucket *bucket,
+	     gboolean       after)
 {
   Handler *handler = g_slice_new (Handler);
 #ifndef G_DISABLE_CHECKS
-  if (g_handler_sequential_number < 1)
+  if (bucket->handler_sequential_number > G_MAXULONG / N_HANDLER_BUCKETS - 1)
     g_error (G_STRLOC ": handler id overflow, %s", REPORT_BUG);
 #endif
-  
-  handler->sequential_number = g_handler_sequential_number++;
+
+  handler->sequential_number = bucket_next_handler_id (bucket);
+  bucket->handler_sequential_number++;
   handler->prev = NULL;
   handler->next = NULL;
   handler->detail = 0;
   handler->ref_count = 1;
   handler->block_count = 0;
   handler->after = after != FALSE;
+  handler->has_invalid_closure_notify = 0;
   handler->closure = NULL;
   
   return handler;
@@ -606,7 +686,7 @@ handler_unref_R (guint    signal_id,
           hlist->handlers = handler->next;
         }
 
-      if (instance)
+      if (signal_id)
         {
           /*  check if we are removing the handler pointed to by tail_before  */
           if (!handler->after && (!handler->next || handler->next->after))
@@ -633,13 +713,65 @@ handler_unref_R (guint    signal_id,
             }
         }
 
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (INSTANCE_BUCKET (instance));
       g_closure_unref (handler->closure);
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (INSTANCE_BUCKET (instance));
       g_slice_free (Handler, handler);
     }
 }
 
+static void
+handler_count_add (guint    signal_id,
+		   gpointer instance,
+		   gint     delta)
+{
+  SignalNode *node = peek_signal_node (signal_id);
+
+  /* handlers of different buckets may be connected concurrently */
+  if (!g_atomic_pointer_get (&node->handler_counts))
+    {
+      gint *counts = g_new0 (gint, N_HANDLER_BUCKETS);
+
+      if (!g_atomic_pointer_compare_and_exchange ((gpointer*) &node->handler_counts, NULL, counts))
+	g_free (counts);
+    }
+  g_atomic_int_add (&node->handler_counts[HANDLER_BUCKET (instance)], delta);
+}
+
+/* An invalidated closure is never invoked again, so its handler no
+ * longer counts as pending, though it stays connected.
+ */
+static void
+invalid_closure_notify (gpointer  instance,
+			GClosure *closure)
+{
+  HandlerBucket *bucket = INSTANCE_BUCKET (instance);
+  Handler *handler;
+  guint signal_id;
+
+  BUCKET_LOCK (bucket);
+  handler = handler_lookup (instance, 0, closure, &signal_id);
+  if (handler)
+    {
+      handler->has_invalid_closure_notify = 0;
+      handler_count_add (signal_id, instance, -1);
+    }
+  BUCKET_UNLOCK (bucket);
+}
+
+static void
+handler_uncount (guint    signal_id,
+		 gpointer instance,
+		 Handler *handler)
+{
+  if (handler->has_invalid_closure_notify)
+    {
+      handler->has_invalid_closure_notify = 0;
+      g_closure_remove_invalidate_notifier (handler->closure, instance, invalid_closure_notify);
+      handler_count_add (signal_id, instance, -1);
+    }
+}
+
 static void
 handler_insert (guint    signal_id,
 		gpointer instance,
@@ -649,6 +781,10 @@ handler_insert (guint    signal_id,
   
   g_assert (handler->prev == NULL && handler->next == NULL); /* paranoid */
   
+  handler_count_add (signal_id, instance, 1);
+  handler->has_invalid_closure_notify = 1;
+  g_closure_add_invalidate_notifier (handler->closure, instance, invalid_closure_notify);
+  
   hlist = handler_list_ensure (signal_id, instance);
   if (!hlist->handlers)
     {
@@ -730,15 +866,16 @@ emission_find (Emission *emission_list,
 static inline Emission*
 emission_find_innermost (gpointer instance)
 {
+  HandlerBucket *bucket = INSTANCE_BUCKET (instance);
   Emission *emission, *s = NULL, *c = NULL;
-  
-  for (emission = g_restart_emissions; emission; emission = emission->next)
+
+  for (emission = bucket->restart_emissions; emission; emission = emission->next)
     if (emission->instance == instance)
       {
 	s = emission;
 	break;
       }
-  for (emission = g_recursive_emissions; emission; emission = emission->next)
+  for (emission = bucket->recursive_emissions; emission; emission = emission->next)
     if (emission->instance == instance)
       {
 	c = emission;
@@ -770,14 +907,23 @@ g_signal_init (void)
   SIGNAL_LOCK ();
   if (!g_n_signal_nodes)
     {
-      /* setup handler list binary searchable array hash table (in german, that'd be one word ;) */
-      g_handler_list_bsa_ht = g_hash_table_new (g_direct_hash, NULL);
+      guint i;
+
+      /* setup handler list binary searchable array hash tables (in german, that'd be one word ;) */
+      for (i = 0; i < N_HANDLER_BUCKETS; i++)
+	{
+	  HandlerBucket *bucket = &g_handler_buckets[i];
+
+	  g_static_mutex_init (&bucket->mutex);
+	  bucket->handler_list_bsa_ht = g_hash_table_new (g_direct_hash, NULL);
+	  bucket->recursive_emissions = NULL;
+	  bucket->restart_emissions = NULL;
+	  bucket->handler_sequential_number = 1;
+	}
       g_signal_key_bsa = g_bsearch_array_create (&g_signal_key_bconfig);
       
       /* invalid (0) signal_id */
-      g_n_signal_nodes = 1;
-      g_signal_nodes = g_renew (SignalNode*, g_signal_nodes, g_n_signal_nodes);
-      g_signal_nodes[0] = NULL;
+      signal_node_append (NULL);
     }
   SIGNAL_UNLOCK ();
 }
@@ -824,22 +970,24 @@ g_signal_stop_emission (gpointer instance,
                         guint    signal_id,
 			GQuark   detail)
 {
+  HandlerBucket *bucket;
   SignalNode *node;
-  
+
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (signal_id > 0);
-  
-  SIGNAL_LOCK ();
-  node = LOOKUP_SIGNAL_NODE (signal_id);
+
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  node = peek_signal_node (signal_id);
   if (node && detail && !(node->flags & G_SIGNAL_DETAILED))
     {
       g_warning ("%s: signal id `%u' does not support detail (%u)", G_STRLOC, signal_id, detail);
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       return;
     }
   if (node && g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
     {
-      Emission *emission_list = node->flags & G_SIGNAL_NO_RECURSE ? g_restart_emissions : g_recursive_emissions;
+      Emission *emission_list = node->flags & G_SIGNAL_NO_RECURSE ? bucket->restart_emissions : bucket->recursive_emissions;
       Emission *emission = emission_find (emission_list, signal_id, detail, instance);
       
       if (emission)
@@ -856,7 +1004,7 @@ g_signal_stop_emission (gpointer instance,
     }
   else
     g_warning ("%s: signal id `%u' is invalid for instance `%p'", G_STRLOC, signal_id, instance);
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 static void
@@ -925,9 +1073,11 @@ g_signal_add_emission_hook (guint               signal_id,
     }
   if (!node->emission_hooks)
     {
-      node->emission_hooks = g_new (GHookList, 1);
-      g_hook_list_init (node->emission_hooks, sizeof (SignalHook));
-      node->emission_hooks->finalize_hook = signal_finalize_hook;
+      GHookList *hook_list = g_new (GHookList, 1);
+
+      g_hook_list_init (hook_list, sizeof (SignalHook));
+      hook_list->finalize_hook = signal_finalize_hook;
+      g_atomic_pointer_set (&node->emission_hooks, hook_list);
     }
   hook = g_hook_alloc (node->emission_hooks);
   hook->data = hook_data;
@@ -1091,8 +1241,13 @@ g_signal_stop_emission_by_name (gpointer     instance,
 	g_warning ("%s: signal `%s' is invalid for instance `%p'", G_STRLOC, detailed_signal, instance);
       else
 	{
-	  Emission *emission_list = node->flags & G_SIGNAL_NO_RECURSE ? g_restart_emissions : g_recursive_emissions;
-	  Emission *emission = emission_find (emission_list, signal_id, detail, instance);
+	  HandlerBucket *bucket = INSTANCE_BUCKET (instance);
+	  Emission *emission_list;
+	  Emission *emission;
+
+	  BUCKET_LOCK (bucket);
+	  emission_list = node->flags & G_SIGNAL_NO_RECURSE ? bucket->restart_emissions : bucket->recursive_emissions;
+	  emission = emission_find (emission_list, signal_id, detail, instance);
 	  
 	  if (emission)
 	    {
@@ -1105,6 +1260,7 @@ g_signal_stop_emission_by_name (gpointer     instance,
 	  else
 	    g_warning (G_STRLOC ": no emission of signal \"%s\" to stop for instance `%p'",
 		       node->name, instance);
+	  BUCKET_UNLOCK (bucket);
 	}
     }
   else
@@ -1419,7 +1575,7 @@ static inline ClassClosure*
 signal_find_class_closure (SignalNode *node,
 			   GType       itype)
 {
-  GBSearchArray *bsa = node->class_closure_bsa;
+  GBSearchArray *bsa = g_atomic_pointer_get (&node->class_closure_bsa);
   ClassClosure *cc;
 
   if (bsa)
@@ -1445,35 +1601,93 @@ static inline GClosure*
 signal_lookup_closure (SignalNode    *node,
 		       GTypeInstance *instance)
 {
+  GBSearchArray *bsa = g_atomic_pointer_get (&node->class_closure_bsa);
   ClassClosure *cc;
 
-  if (node->class_closure_bsa && g_bsearch_array_get_n_nodes (node->class_closure_bsa) == 1)
-    cc = g_bsearch_array_get_nth (node->class_closure_bsa, &g_class_closure_bconfig, 0);
+  if (bsa && g_bsearch_array_get_n_nodes (bsa) == 1)
+    cc = g_bsearch_array_get_nth (bsa, &g_class_closure_bconfig, 0);
   else
     cc = signal_find_class_closure (node, G_TYPE_FROM_INSTANCE (instance));
   return cc ? cc->closure : NULL;
 }
 
+static void
+node_set_closure_marshal (SignalNode *node,
+			  GClosure   *closure)
+{
+  if (node->c_marshaller && G_CLOSURE_NEEDS_MARSHAL (closure))
+    {
+      g_closure_set_marshal (closure, node->c_marshaller);
+      if (node->va_marshaller)
+	_g_closure_set_va_marshal (closure, node->va_marshaller);
+    }
+}
+
+static GSignalCVaMarshaller
+std_va_marshaller (GSignalCMarshaller c_marshaller)
+{
+  static const struct {
+    GSignalCMarshaller   c_marshaller;
+    GSignalCVaMarshaller va_marshaller;
+  } std_marshallers[] = {
+    { g_cclosure_marshal_VOID__VOID,          g_cclosure_marshal_VOID__VOIDv },
+    { g_cclosure_marshal_VOID__BOOLEAN,       g_cclosure_marshal_VOID__BOOLEANv },
+    { g_cclosure_marshal_VOID__CHAR,          g_cclosure_marshal_VOID__CHARv },
+    { g_cclosure_marshal_VOID__UCHAR,         g_cclosure_marshal_VOID__UCHARv },
+    { g_cclosure_marshal_VOID__INT,           g_cclosure_marshal_VOID__INTv },
+    { g_cclosure_marshal_VOID__UINT,          g_cclosure_marshal_VOID__UINTv },
+    { g_cclosure_marshal_VOID__LONG,          g_cclosure_marshal_VOID__LONGv },
+    { g_cclosure_marshal_VOID__ULONG,         g_cclosure_marshal_VOID__ULONGv },
+    { g_cclosure_marshal_VOID__ENUM,          g_cclosure_marshal_VOID__ENUMv },
+    { g_cclosure_marshal_VOID__FLAGS,         g_cclosure_marshal_VOID__FLAGSv },
+    { g_cclosure_marshal_VOID__FLOAT,         g_cclosure_marshal_VOID__FLOATv },
+    { g_cclosure_marshal_VOID__DOUBLE,        g_cclosure_marshal_VOID__DOUBLEv },
+    { g_cclosure_marshal_VOID__STRING,        g_cclosure_marshal_VOID__STRINGv },
+    { g_cclosure_marshal_VOID__PARAM,         g_cclosure_marshal_VOID__PARAMv },
+    { g_cclosure_marshal_VOID__BOXED,         g_cclosure_marshal_VOID__BOXEDv },
+    { g_cclosure_marshal_VOID__POINTER,       g_cclosure_marshal_VOID__POINTERv },
+    { g_cclosure_marshal_VOID__OBJECT,        g_cclosure_marshal_VOID__OBJECTv },
+    { g_cclosure_marshal_VOID__UINT_POINTER,  g_cclosure_marshal_VOID__UINT_POINTERv },
+    { g_cclosure_marshal_BOOLEAN__FLAGS,      g_cclosure_marshal_BOOLEAN__FLAGSv },
+    { g_cclosure_marshal_STRING__OBJECT_POINTER, g_cclosure_marshal_STRING__OBJECT_POINTERv },
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (std_marshallers); i++)
+    if (std_marshallers[i].c_marshaller == c_marshaller)
+      return std_marshallers[i].va_marshaller;
+
+  return NULL;
+}
+
 static void
 signal_add_class_closure (SignalNode *node,
 			  GType       itype,
 			  GClosure   *closure)
 {
+  GBSearchArray *bsa = node->class_closure_bsa;
   ClassClosure key;
 
   /* can't optimize NOP emissions with overridden class closures */
   node->test_class_offset = 0;
 
-  if (!node->class_closure_bsa)
-    node->class_closure_bsa = g_bsearch_array_create (&g_class_closure_bconfig);
+  /* emissions look up class closures without g_signal_mutex, so the
+   * array is copied before insertion. the old copy is leaked, like the
+   * node arrays in signal_node_append(), since a concurrent emission may
+   * still be reading it.
+   */
+  if (!bsa)
+    bsa = g_bsearch_array_create (&g_class_closure_bconfig);
+  else
+    bsa = g_memdup (bsa, sizeof (GBSearchArray) +
+		    g_bsearch_array_get_n_nodes (bsa) * g_class_closure_bconfig.sizeof_node);
   key.instance_type = itype;
   key.closure = g_closure_ref (closure);
-  node->class_closure_bsa = g_bsearch_array_insert (node->class_closure_bsa,
-						    &g_class_closure_bconfig,
-						    &key);
+  bsa = g_bsearch_array_insert (bsa, &g_class_closure_bconfig, &key);
+  g_atomic_pointer_set (&node->class_closure_bsa, bsa);
   g_closure_sink (closure);
-  if (node->c_marshaller && closure && G_CLOSURE_NEEDS_MARSHAL (closure))
-    g_closure_set_marshal (closure, node->c_marshaller);
+  if (closure)
+    node_set_closure_marshal (node, closure);
 }
 
 /**
@@ -1585,11 +1799,10 @@ g_signal_newv (const gchar       *signal_name,
     {
       SignalKey key;
       
-      signal_id = g_n_signal_nodes++;
       node = g_new (SignalNode, 1);
+      node->handler_counts = NULL;
+      signal_id = signal_node_append (node);
       node->signal_id = signal_id;
-      g_signal_nodes = g_renew (SignalNode*, g_signal_nodes, g_n_signal_nodes);
-      g_signal_nodes[signal_id] = node;
       node->itype = itype;
       node->name = name;
       key.itype = itype;
@@ -1619,6 +1832,7 @@ g_signal_newv (const gchar       *signal_name,
   else
     node->accumulator = NULL;
   node->c_marshaller = c_marshaller;
+  node->va_marshaller = std_va_marshaller (c_marshaller);
   node->emission_hooks = NULL;
   if (class_closure)
     signal_add_class_closure (node, 0, class_closure);
@@ -1634,6 +1848,58 @@ g_signal_newv (const gchar       *signal_name,
   return signal_id;
 }
 
+/**
+ * g_signal_set_va_marshaller:
+ * @signal_id: the signal id
+ * @instance_type: the instance type on which to set the marshaller
+ * @va_marshaller: the #GSignalCVaMarshaller to use for C closures
+ *  connected to the signal
+ *
+ * Sets a va_list marshaller for the signal, used by g_signal_emit()
+ * and g_signal_emit_valist() to invoke C closures without collecting
+ * the arguments into #GValue<!-- -->s. @va_marshaller has to match the
+ * @c_marshaller the signal was created with; such pairs are generated
+ * by <link linkend="glib-genmarshal">glib-genmarshal</link> with
+ * <option>--valist-marshallers</option>. Signals created with one of
+ * the g_cclosure_marshal_*() marshallers get the matching va_list
+ * marshaller automatically.
+ *
+ * Since: 2.20
+ */
+void
+g_signal_set_va_marshaller (guint                signal_id,
+			    GType                instance_type,
+			    GSignalCVaMarshaller va_marshaller)
+{
+  SignalNode *node;
+
+  g_return_if_fail (va_marshaller != NULL);
+
+  SIGNAL_LOCK ();
+  node = LOOKUP_SIGNAL_NODE (signal_id);
+  if (!node || node->destroyed)
+    g_warning ("%s: invalid signal id `%u'", G_STRLOC, signal_id);
+  else if (!g_type_is_a (instance_type, node->itype))
+    g_warning ("%s: type `%s' cannot be used for signal id `%u'", G_STRLOC, type_debug_name (instance_type), signal_id);
+  else
+    {
+      node->va_marshaller = va_marshaller;
+      if (node->class_closure_bsa)
+	{
+	  guint i;
+
+	  for (i = 0; i < g_bsearch_array_get_n_nodes (node->class_closure_bsa); i++)
+	    {
+	      ClassClosure *cc = g_bsearch_array_get_nth (node->class_closure_bsa, &g_class_closure_bconfig, i);
+
+	      if (cc->closure->marshal == node->c_marshaller)
+		_g_closure_set_va_marshal (cc->closure, va_marshaller);
+	    }
+	}
+    }
+  SIGNAL_UNLOCK ();
+}
+
 /**
  * g_signal_new_valist:
  * @signal_name: the name for the signal
@@ -1707,18 +1973,27 @@ signal_destroy_R (SignalNode *signal_node)
   signal_node->class_closure_bsa = NULL;
   signal_node->accumulator = NULL;
   signal_node->c_marshaller = NULL;
+  signal_node->va_marshaller = NULL;
   signal_node->emission_hooks = NULL;
   
 #ifdef	G_ENABLE_DEBUG
   /* check current emissions */
   {
     Emission *emission;
+    guint i;
     
-    for (emission = (node.flags & G_SIGNAL_NO_RECURSE) ? g_restart_emissions : g_recursive_emissions;
-         emission; emission = emission->next)
-      if (emission->ihint.signal_id == node.signal_id)
-        g_critical (G_STRLOC ": signal \"%s\" being destroyed is currently in emission (instance `%p')",
-                    node.name, emission->instance);
+    for (i = 0; i < N_HANDLER_BUCKETS; i++)
+      {
+        HandlerBucket *bucket = &g_handler_buckets[i];
+
+        BUCKET_LOCK (bucket);
+        for (emission = (node.flags & G_SIGNAL_NO_RECURSE) ? bucket->restart_emissions : bucket->recursive_emissions;
+             emission; emission = emission->next)
+          if (emission->ihint.signal_id == node.signal_id)
+            g_critical (G_STRLOC ": signal \"%s\" being destroyed is currently in emission (instance `%p')",
+                        node.name, emission->instance);
+        BUCKET_UNLOCK (bucket);
+      }
   }
 #endif
   
@@ -1844,6 +2119,7 @@ void
 g_signal_chain_from_overridden (const GValue *instance_and_params,
 				GValue       *return_value)
 {
+  HandlerBucket *bucket;
   GType chain_type = 0, restore_type = 0;
   Emission *emission = NULL;
   GClosure *closure = NULL;
@@ -1854,11 +2130,12 @@ g_signal_chain_from_overridden (const GValue *instance_and_params,
   instance = g_value_peek_pointer (instance_and_params);
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   
-  SIGNAL_LOCK ();
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
   emission = emission_find_innermost (instance);
   if (emission)
     {
-      SignalNode *node = LOOKUP_SIGNAL_NODE (emission->ihint.signal_id);
+      SignalNode *node = peek_signal_node (emission->ihint.signal_id);
       
       g_assert (node != NULL);	/* paranoid */
       
@@ -1888,16 +2165,16 @@ g_signal_chain_from_overridden (const GValue *instance_and_params,
   if (closure)
     {
       emission->chain_type = chain_type;
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       g_closure_invoke (closure,
 			return_value,
 			n_params + 1,
 			instance_and_params,
 			&emission->ihint);
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
       emission->chain_type = restore_type;
     }
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 /**
@@ -1918,6 +2195,7 @@ void
 g_signal_chain_from_overridden_handler (gpointer instance,
                                         ...)
 {
+  HandlerBucket *bucket;
   GType chain_type = 0, restore_type = 0;
   Emission *emission = NULL;
   GClosure *closure = NULL;
@@ -1926,11 +2204,12 @@ g_signal_chain_from_overridden_handler (gpointer instance,
 
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
 
-  SIGNAL_LOCK ();
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
   emission = emission_find_innermost (instance);
   if (emission)
     {
-      node = LOOKUP_SIGNAL_NODE (emission->ihint.signal_id);
+      node = peek_signal_node (emission->ihint.signal_id);
 
       g_assert (node != NULL);	/* paranoid */
 
@@ -1978,7 +2257,7 @@ g_signal_chain_from_overridden_handler (gpointer instance,
           gboolean static_scope = node->param_types[i] & G_SIGNAL_TYPE_STATIC_SCOPE;
 
           param_values[i].g_type = 0;
-          SIGNAL_UNLOCK ();
+          BUCKET_UNLOCK (bucket);
           g_value_init (param_values + i, ptype);
           G_VALUE_COLLECT (param_values + i,
                            var_args,
@@ -1999,17 +2278,17 @@ g_signal_chain_from_overridden_handler (gpointer instance,
               va_end (var_args);
               return;
             }
-          SIGNAL_LOCK ();
+          BUCKET_LOCK (bucket);
         }
 
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       instance_and_params->g_type = 0;
       g_value_init (instance_and_params, G_TYPE_FROM_INSTANCE (instance));
       g_value_set_instance (instance_and_params, instance);
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
 
       emission->chain_type = chain_type;
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
 
       if (signal_return_type == G_TYPE_NONE)
         {
@@ -2060,10 +2339,10 @@ g_signal_chain_from_overridden_handler (gpointer instance,
 
       va_end (var_args);
 
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
       emission->chain_type = restore_type;
     }
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 /**
@@ -2077,13 +2356,15 @@ g_signal_chain_from_overridden_handler (gpointer instance,
 GSignalInvocationHint*
 g_signal_get_invocation_hint (gpointer instance)
 {
+  HandlerBucket *bucket;
   Emission *emission = NULL;
   
   g_return_val_if_fail (G_TYPE_CHECK_INSTANCE (instance), NULL);
 
-  SIGNAL_LOCK ();
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
   emission = emission_find_innermost (instance);
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
   
   return emission ? &emission->ihint : NULL;
 }
@@ -2108,6 +2389,7 @@ g_signal_connect_closure_by_id (gpointer  instance,
 				GClosure *closure,
 				gboolean  after)
 {
+  HandlerBucket *bucket;
   SignalNode *node;
   gulong handler_seq_no = 0;
   
@@ -2115,8 +2397,9 @@ g_signal_connect_closure_by_id (gpointer  instance,
   g_return_val_if_fail (signal_id > 0, 0);
   g_return_val_if_fail (closure != NULL, 0);
   
-  SIGNAL_LOCK ();
-  node = LOOKUP_SIGNAL_NODE (signal_id);
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  node = peek_signal_node (signal_id);
   if (node)
     {
       if (detail && !(node->flags & G_SIGNAL_DETAILED))
@@ -2125,20 +2408,19 @@ g_signal_connect_closure_by_id (gpointer  instance,
 	g_warning ("%s: signal id `%u' is invalid for instance `%p'", G_STRLOC, signal_id, instance);
       else
 	{
-	  Handler *handler = handler_new (after);
+	  Handler *handler = handler_new (bucket, after);
 	  
 	  handler_seq_no = handler->sequential_number;
 	  handler->detail = detail;
 	  handler->closure = g_closure_ref (closure);
 	  g_closure_sink (closure);
 	  handler_insert (signal_id, instance, handler);
-	  if (node->c_marshaller && G_CLOSURE_NEEDS_MARSHAL (closure))
-	    g_closure_set_marshal (closure, node->c_marshaller);
+	  node_set_closure_marshal (node, closure);
 	}
     }
   else
     g_warning ("%s: signal id `%u' is invalid for instance `%p'", G_STRLOC, signal_id, instance);
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
   
   return handler_seq_no;
 }
@@ -2183,15 +2465,18 @@ g_signal_connect_closure (gpointer     instance,
 	g_warning ("%s: signal `%s' is invalid for instance `%p'", G_STRLOC, detailed_signal, instance);
       else
 	{
-	  Handler *handler = handler_new (after);
+	  HandlerBucket *bucket = INSTANCE_BUCKET (instance);
+	  Handler *handler;
 
+	  BUCKET_LOCK (bucket);
+	  handler = handler_new (bucket, after);
 	  handler_seq_no = handler->sequential_number;
 	  handler->detail = detail;
 	  handler->closure = g_closure_ref (closure);
 	  g_closure_sink (closure);
 	  handler_insert (signal_id, instance, handler);
-	  if (node->c_marshaller && G_CLOSURE_NEEDS_MARSHAL (handler->closure))
-	    g_closure_set_marshal (handler->closure, node->c_marshaller);
+	  node_set_closure_marshal (node, handler->closure);
+	  BUCKET_UNLOCK (bucket);
 	}
     }
   else
@@ -2252,15 +2537,18 @@ g_signal_connect_data (gpointer       instance,
 	g_warning ("%s: signal `%s' is invalid for instance `%p'", G_STRLOC, detailed_signal, instance);
       else
 	{
-	  Handler *handler = handler_new (after);
+	  HandlerBucket *bucket = INSTANCE_BUCKET (instance);
+	  Handler *handler;
 
+	  BUCKET_LOCK (bucket);
+	  handler = handler_new (bucket, after);
 	  handler_seq_no = handler->sequential_number;
 	  handler->detail = detail;
 	  handler->closure = g_closure_ref ((swapped ? g_cclosure_new_swap : g_cclosure_new) (c_handler, data, destroy_data));
 	  g_closure_sink (handler->closure);
 	  handler_insert (signal_id, instance, handler);
-	  if (node->c_marshaller && G_CLOSURE_NEEDS_MARSHAL (handler->closure))
-	    g_closure_set_marshal (handler->closure, node->c_marshaller);
+	  node_set_closure_marshal (node, handler->closure);
+	  BUCKET_UNLOCK (bucket);
 	}
     }
   else
@@ -2288,13 +2576,15 @@ void
 g_signal_handler_block (gpointer instance,
                         gulong   handler_id)
 {
+  HandlerBucket *bucket;
   Handler *handler;
   
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (handler_id > 0);
   
-  SIGNAL_LOCK ();
-  handler = handler_lookup (instance, handler_id, NULL);
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  handler = handler_lookup (instance, handler_id, NULL, NULL);
   if (handler)
     {
 #ifndef G_DISABLE_CHECKS
@@ -2305,7 +2595,7 @@ g_signal_handler_block (gpointer instance,
     }
   else
     g_warning ("%s: instance `%p' has no handler with id `%lu'", G_STRLOC, instance, handler_id);
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 /**
@@ -2331,13 +2621,15 @@ void
 g_signal_handler_unblock (gpointer instance,
                           gulong   handler_id)
 {
+  HandlerBucket *bucket;
   Handler *handler;
   
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (handler_id > 0);
   
-  SIGNAL_LOCK ();
-  handler = handler_lookup (instance, handler_id, NULL);
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  handler = handler_lookup (instance, handler_id, NULL, NULL);
   if (handler)
     {
       if (handler->block_count)
@@ -2347,7 +2639,7 @@ g_signal_handler_unblock (gpointer instance,
     }
   else
     g_warning ("%s: instance `%p' has no handler with id `%lu'", G_STRLOC, instance, handler_id);
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 /**
@@ -2366,23 +2658,26 @@ void
 g_signal_handler_disconnect (gpointer instance,
                              gulong   handler_id)
 {
+  HandlerBucket *bucket;
   Handler *handler;
   guint signal_id;
   
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (handler_id > 0);
   
-  SIGNAL_LOCK ();
-  handler = handler_lookup (instance, handler_id, &signal_id);
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  handler = handler_lookup (instance, handler_id, NULL, &signal_id);
   if (handler)
     {
       handler->sequential_number = 0;
       handler->block_count = 1;
+      handler_uncount (signal_id, instance, handler);
       handler_unref_R (signal_id, instance, handler);
     }
   else
     g_warning ("%s: instance `%p' has no handler with id `%lu'", G_STRLOC, instance, handler_id);
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 /**
@@ -2398,15 +2693,17 @@ gboolean
 g_signal_handler_is_connected (gpointer instance,
 			       gulong   handler_id)
 {
+  HandlerBucket *bucket;
   Handler *handler;
   gboolean connected;
 
   g_return_val_if_fail (G_TYPE_CHECK_INSTANCE (instance), FALSE);
 
-  SIGNAL_LOCK ();
-  handler = handler_lookup (instance, handler_id, NULL);
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  handler = handler_lookup (instance, handler_id, NULL, NULL);
   connected = handler != NULL;
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 
   return connected;
 }
@@ -2414,18 +2711,20 @@ g_signal_handler_is_connected (gpointer instance,
 void
 g_signal_handlers_destroy (gpointer instance)
 {
+  HandlerBucket *bucket;
   GBSearchArray *hlbsa;
   
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   
-  SIGNAL_LOCK ();
-  hlbsa = g_hash_table_lookup (g_handler_list_bsa_ht, instance);
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
+  hlbsa = g_hash_table_lookup (bucket->handler_list_bsa_ht, instance);
   if (hlbsa)
     {
       guint i;
       
       /* reentrancy caution, delete instance trace first */
-      g_hash_table_remove (g_handler_list_bsa_ht, instance);
+      g_hash_table_remove (bucket->handler_list_bsa_ht, instance);
       
       for (i = 0; i < hlbsa->n_nodes; i++)
         {
@@ -2443,14 +2742,15 @@ g_signal_handlers_destroy (gpointer instance)
               tmp->prev = tmp;
               if (tmp->sequential_number)
 		{
+		  handler_uncount (hlist->signal_id, instance, tmp);
 		  tmp->sequential_number = 0;
-		  handler_unref_R (0, NULL, tmp);
+		  handler_unref_R (0, instance, tmp);
 		}
             }
         }
       g_bsearch_array_free (hlbsa, &g_signal_hlbsa_bconfig);
     }
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
 }
 
 /**
@@ -2488,16 +2788,17 @@ g_signal_handler_find (gpointer         instance,
   
   if (mask & G_SIGNAL_MATCH_MASK)
     {
+      HandlerBucket *bucket = INSTANCE_BUCKET (instance);
       HandlerMatch *mlist;
       
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
       mlist = handlers_find (instance, mask, signal_id, detail, closure, func, data, TRUE);
       if (mlist)
 	{
 	  handler_seq_no = mlist->handler->sequential_number;
 	  handler_match_free1_R (mlist, instance);
 	}
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
     }
   
   return handler_seq_no;
@@ -2523,9 +2824,9 @@ signal_handlers_foreach_matched_R (gpointer         instance,
       n_handlers++;
       if (mlist->handler->sequential_number)
 	{
-	  SIGNAL_UNLOCK ();
+	  BUCKET_UNLOCK (INSTANCE_BUCKET (instance));
 	  callback (instance, mlist->handler->sequential_number);
-	  SIGNAL_LOCK ();
+	  BUCKET_LOCK (INSTANCE_BUCKET (instance));
 	}
       mlist = handler_match_free1_R (mlist, instance);
     }
@@ -2570,11 +2871,11 @@ g_signal_handlers_block_matched (gpointer         instance,
   
   if (mask & (G_SIGNAL_MATCH_CLOSURE | G_SIGNAL_MATCH_FUNC | G_SIGNAL_MATCH_DATA))
     {
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (INSTANCE_BUCKET (instance));
       n_handlers = signal_handlers_foreach_matched_R (instance, mask, signal_id, detail,
 						      closure, func, data,
 						      g_signal_handler_block);
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (INSTANCE_BUCKET (instance));
     }
   
   return n_handlers;
@@ -2618,11 +2919,11 @@ g_signal_handlers_unblock_matched (gpointer         instance,
   
   if (mask & (G_SIGNAL_MATCH_CLOSURE | G_SIGNAL_MATCH_FUNC | G_SIGNAL_MATCH_DATA))
     {
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (INSTANCE_BUCKET (instance));
       n_handlers = signal_handlers_foreach_matched_R (instance, mask, signal_id, detail,
 						      closure, func, data,
 						      g_signal_handler_unblock);
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (INSTANCE_BUCKET (instance));
     }
   
   return n_handlers;
@@ -2666,11 +2967,11 @@ g_signal_handlers_disconnect_matched (gpointer         instance,
   
   if (mask & (G_SIGNAL_MATCH_CLOSURE | G_SIGNAL_MATCH_FUNC | G_SIGNAL_MATCH_DATA))
     {
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (INSTANCE_BUCKET (instance));
       n_handlers = signal_handlers_foreach_matched_R (instance, mask, signal_id, detail,
 						      closure, func, data,
 						      g_signal_handler_disconnect);
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (INSTANCE_BUCKET (instance));
     }
   
   return n_handlers;
@@ -2700,21 +3001,23 @@ g_signal_has_handler_pending (gpointer instance,
 			      GQuark   detail,
 			      gboolean may_be_blocked)
 {
+  HandlerBucket *bucket;
   HandlerMatch *mlist;
   gboolean has_pending;
   
   g_return_val_if_fail (G_TYPE_CHECK_INSTANCE (instance), FALSE);
   g_return_val_if_fail (signal_id > 0, FALSE);
   
-  SIGNAL_LOCK ();
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
   if (detail)
     {
-      SignalNode *node = LOOKUP_SIGNAL_NODE (signal_id);
+      SignalNode *node = peek_signal_node (signal_id);
       
       if (!(node->flags & G_SIGNAL_DETAILED))
 	{
 	  g_warning ("%s: signal id `%u' does not support detail (%u)", G_STRLOC, signal_id, detail);
-	  SIGNAL_UNLOCK ();
+	  BUCKET_UNLOCK (bucket);
 	  return FALSE;
 	}
     }
@@ -2728,7 +3031,7 @@ g_signal_has_handler_pending (gpointer instance,
     }
   else
     has_pending = FALSE;
-  SIGNAL_UNLOCK ();
+  BUCKET_UNLOCK (bucket);
   
   return has_pending;
 }
@@ -2738,7 +3041,7 @@ signal_check_skip_emission (SignalNode *node,
 			    gpointer    instance,
 			    GQuark      detail)
 {
-  HandlerList *hlist;
+  gint *handler_counts;
 
   /* are we able to check for NULL class handlers? */
   if (!node->test_class_offset)
@@ -2765,18 +3068,49 @@ signal_check_skip_emission (SignalNode *node,
 
   /* is this a no-recurse signal already in emission? */
   if (node->flags & G_SIGNAL_NO_RECURSE &&
-      emission_find (g_restart_emissions, node->signal_id, detail, instance))
+      emission_find (INSTANCE_BUCKET (instance)->restart_emissions, node->signal_id, detail, instance))
     return FALSE;
 
-  /* do we have pending handlers? */
-  hlist = handler_list_lookup (node->signal_id, instance);
-  if (hlist && hlist->handlers)
+  /* do we have pending handlers? (instances sharing a bucket may
+   * make us emit needlessly, but never the other way round) */
+  handler_counts = g_atomic_pointer_get (&node->handler_counts);
+  if (handler_counts &&
+      g_atomic_int_get (&handler_counts[HANDLER_BUCKET (instance)]) != 0)
     return FALSE;
 
   /* none of the above, no emission required */
   return TRUE;
 }
 
+/* Like signal_check_skip_emission(), but without holding the lock.
+ * Everything it reads is only ever updated atomically or before the
+ * signal id is handed out, and a change racing with it is no different
+ * from one that happens right after the emission. Emissions it cannot
+ * decide on, and invalid ones, take the locked path.
+ */
+static inline gboolean
+signal_check_skip_emission_unlocked (guint    signal_id,
+				     gpointer instance,
+				     GQuark   detail)
+{
+  SignalNode *node = peek_signal_node (signal_id);
+
+  if (!node || node->destroyed)
+    return FALSE;
+
+  /* checking for emissions in progress needs the bucket lock */
+  if (node->flags & G_SIGNAL_NO_RECURSE)
+    return FALSE;
+
+  if (detail && !(node->flags & G_SIGNAL_DETAILED))
+    return FALSE;
+
+  if (!g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
+    return FALSE;
+
+  return signal_check_skip_emission (node, instance, detail);
+}
+
 /**
  * g_signal_emitv:
  * @instance_and_params: argument list for the signal emission. The first
@@ -2799,6 +3133,7 @@ g_signal_emitv (const GValue *instance_and_params,
 		GValue       *return_value)
 {
   gpointer instance;
+  HandlerBucket *bucket;
   SignalNode *node;
 #ifdef G_ENABLE_DEBUG
   const GValue *param_values;
@@ -2814,19 +3149,16 @@ g_signal_emitv (const GValue *instance_and_params,
   param_values = instance_and_params + 1;
 #endif
 
-  SIGNAL_LOCK ();
-  node = LOOKUP_SIGNAL_NODE (signal_id);
+  node = peek_signal_node (signal_id);
   if (!node || !g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
     {
       g_warning ("%s: signal id `%u' is invalid for instance `%p'", G_STRLOC, signal_id, instance);
-      SIGNAL_UNLOCK ();
       return;
     }
 #ifdef G_ENABLE_DEBUG
   if (detail && !(node->flags & G_SIGNAL_DETAILED))
     {
       g_warning ("%s: signal id `%u' does not support detail (%u)", G_STRLOC, signal_id, detail);
-      SIGNAL_UNLOCK ();
       return;
     }
   for (i = 0; i < node->n_params; i++)
@@ -2838,7 +3170,6 @@ g_signal_emitv (const GValue *instance_and_params,
 		    i,
 		    node->name,
 		    G_VALUE_TYPE_NAME (param_values + i));
-	SIGNAL_UNLOCK ();
 	return;
       }
   if (node->return_type != G_TYPE_NONE)
@@ -2849,7 +3180,6 @@ g_signal_emitv (const GValue *instance_and_params,
 		      G_STRLOC,
 		      type_debug_name (node->return_type),
 		      node->name);
-	  SIGNAL_UNLOCK ();
 	  return;
 	}
       else if (!node->accumulator && !G_TYPE_CHECK_VALUE_TYPE (return_value, node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE))
@@ -2859,7 +3189,6 @@ g_signal_emitv (const GValue *instance_and_params,
 		      type_debug_name (node->return_type),
 		      node->name,
 		      G_VALUE_TYPE_NAME (return_value));
-	  SIGNAL_UNLOCK ();
 	  return;
 	}
     }
@@ -2868,16 +3197,18 @@ g_signal_emitv (const GValue *instance_and_params,
 #endif	/* G_ENABLE_DEBUG */
 
   /* optimize NOP emissions */
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
   if (signal_check_skip_emission (node, instance, detail))
     {
       /* nothing to do to emit this signal */
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       /* g_printerr ("omitting emission of \"%s\"\n", node->name); */
       return;
     }
+  BUCKET_UNLOCK (bucket);
 
-  SIGNAL_UNLOCK ();
-  signal_emit_unlocked_R (node, detail, instance, return_value, instance_and_params);
+  signal_emit_unlocked_R (node, detail, instance, return_value, instance_and_params, NULL);
 }
 
 /**
@@ -2903,37 +3234,57 @@ g_signal_emit_valist (gpointer instance,
   GValue *instance_and_params;
   GType signal_return_type;
   GValue *param_values;
+  HandlerBucket *bucket;
   SignalNode *node;
   guint i, n_params;
   
   g_return_if_fail (G_TYPE_CHECK_INSTANCE (instance));
   g_return_if_fail (signal_id > 0);
 
-  SIGNAL_LOCK ();
-  node = LOOKUP_SIGNAL_NODE (signal_id);
+  /* optimize NOP emissions, before collecting anything */
+  if (signal_check_skip_emission_unlocked (signal_id, instance, detail))
+    return;
+
+  node = peek_signal_node (signal_id);
   if (!node || !g_type_is_a (G_TYPE_FROM_INSTANCE (instance), node->itype))
     {
       g_warning ("%s: signal id `%u' is invalid for instance `%p'", G_STRLOC, signal_id, instance);
-      SIGNAL_UNLOCK ();
       return;
     }
 #ifndef G_DISABLE_CHECKS
   if (detail && !(node->flags & G_SIGNAL_DETAILED))
     {
       g_warning ("%s: signal id `%u' does not support detail (%u)", G_STRLOC, signal_id, detail);
-      SIGNAL_UNLOCK ();
       return;
     }
 #endif  /* !G_DISABLE_CHECKS */
 
   /* optimize NOP emissions */
+  bucket = INSTANCE_BUCKET (instance);
+  BUCKET_LOCK (bucket);
   if (signal_check_skip_emission (node, instance, detail))
     {
       /* nothing to do to emit this signal */
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       /* g_printerr ("omitting emission of \"%s\"\n", node->name); */
       return;
     }
+  BUCKET_UNLOCK (bucket);
+
+  /* leave the arguments in var_args for the va_list marshallers of
+   * the invoked closures; they are only collected into GValues if a
+   * closure or emission hook requires them. the return location
+   * follows the arguments, so this is restricted to void signals.
+   */
+  if (node->va_marshaller && node->return_type == G_TYPE_NONE)
+    {
+      va_list args;
+
+      G_VA_COPY (args, var_args);
+      signal_emit_unlocked_R (node, detail, instance, NULL, NULL, &args);
+      va_end (args);
+      return;
+    }
 
   n_params = node->n_params;
   signal_return_type = node->return_type;
@@ -2947,7 +3298,6 @@ g_signal_emit_valist (gpointer instance,
       gboolean static_scope = node->param_types[i] & G_SIGNAL_TYPE_STATIC_SCOPE;
 
       param_values[i].g_type = 0;
-      SIGNAL_UNLOCK ();
       g_value_init (param_values + i, ptype);
       G_VALUE_COLLECT (param_values + i,
 		       var_args,
@@ -2967,14 +3317,12 @@ g_signal_emit_valist (gpointer instance,
 	  g_slice_free1 (sizeof (GValue) * (n_params + 1), instance_and_params);
 	  return;
 	}
-      SIGNAL_LOCK ();
     }
-  SIGNAL_UNLOCK ();
   instance_and_params->g_type = 0;
   g_value_init (instance_and_params, G_TYPE_FROM_INSTANCE (instance));
   g_value_set_instance (instance_and_params, instance);
   if (signal_return_type == G_TYPE_NONE)
-    signal_emit_unlocked_R (node, detail, instance, NULL, instance_and_params);
+    signal_emit_unlocked_R (node, detail, instance, NULL, instance_and_params, NULL);
   else
     {
       GValue return_value = { 0, };
@@ -2984,7 +3332,7 @@ g_signal_emit_valist (gpointer instance,
       
       g_value_init (&return_value, rtype);
 
-      signal_emit_unlocked_R (node, detail, instance, &return_value, instance_and_params);
+      signal_emit_unlocked_R (node, detail, instance, &return_value, instance_and_params, NULL);
 
       G_VALUE_LCOPY (&return_value,
 		     var_args,
@@ -3075,6 +3423,103 @@ g_signal_emit_by_name (gpointer     instance,
     g_warning ("%s: signal name `%s' is invalid for instance `%p'", G_STRLOC, detailed_signal, instance);
 }
 
+/* collects the arguments of a va_list emission into GValues, for
+ * closures and emission hooks that can't be invoked on the va_list
+ */
+static GValue*
+signal_collect_valist (SignalNode *node,
+		       gpointer    instance,
+		       guint       n_params,
+		       va_list    *var_args)
+{
+  GValue *instance_and_params;
+  va_list args;
+  guint i;
+
+  instance_and_params = g_slice_alloc0 (sizeof (GValue) * (n_params + 1));
+  g_value_init (instance_and_params, G_TYPE_FROM_INSTANCE (instance));
+  g_value_set_instance (instance_and_params, instance);
+
+  G_VA_COPY (args, *var_args);
+  for (i = 0; i < n_params; i++)
+    {
+      gchar *error;
+      GType ptype = node->param_types[i] & ~G_SIGNAL_TYPE_STATIC_SCOPE;
+      gboolean static_scope = node->param_types[i] & G_SIGNAL_TYPE_STATIC_SCOPE;
+      GValue *value = instance_and_params + 1 + i;
+
+      g_value_init (value, ptype);
+      G_VALUE_COLLECT (value,
+		       args,
+		       static_scope ? G_VALUE_NOCOPY_CONTENTS : 0,
+		       &error);
+      if (error)
+	{
+	  g_warning ("%s: %s", G_STRLOC, error);
+	  g_free (error);
+
+	  /* we purposely leak the value here, it might not be
+	   * in a sane state if an error condition occoured
+	   */
+	  while (i--)
+	    g_value_unset (instance_and_params + 1 + i);
+	  g_value_unset (instance_and_params);
+	  g_slice_free1 (sizeof (GValue) * (n_params + 1), instance_and_params);
+	  va_end (args);
+
+	  return NULL;
+	}
+    }
+  va_end (args);
+
+  return instance_and_params;
+}
+
+static void
+signal_free_collected (GValue *instance_and_params,
+		       guint   n_params)
+{
+  guint i;
+
+  for (i = 0; i < n_params + 1; i++)
+    g_value_unset (instance_and_params + i);
+  g_slice_free1 (sizeof (GValue) * (n_params + 1), instance_and_params);
+}
+
+/* invokes @closure either directly on the va_list of the emission
+ * or on its arguments collected into *@instance_and_params, which
+ * happens at most once per emission; called without the signal lock
+ */
+static void
+signal_invoke_closure (GClosure              *closure,
+		       GValue                *return_value,
+		       SignalNode            *node,
+		       gpointer               instance,
+		       guint                  n_params,
+		       const GValue         **instance_and_params,
+		       GValue               **collected,
+		       va_list               *var_args,
+		       GSignalInvocationHint *ihint)
+{
+  if (!*instance_and_params)
+    {
+      if (_g_closure_supports_invoke_va (closure))
+	{
+	  _g_closure_invoke_va (closure, return_value,
+				instance, *var_args,
+				n_params, node->param_types);
+	  return;
+	}
+      *collected = signal_collect_valist (node, instance, n_params, var_args);
+      if (!*collected)
+	return;
+      *instance_and_params = *collected;
+    }
+  g_closure_invoke (closure, return_value,
+		    n_params + 1, *instance_and_params,
+		    ihint);
+}
+
 static inline gboolean
 accumulate (GSignalInvocationHint *ihint,
 	    GValue                *return_accu,
@@ -3097,8 +3542,10 @@ signal_emit_unlocked_R (SignalNode   *node,
 			GQuark	      detail,
 			gpointer      instance,
 			GValue	     *emission_return,
-			const GValue *instance_and_params)
+			const GValue *instance_and_params,
+			va_list      *var_args)
 {
+  HandlerBucket *bucket = INSTANCE_BUCKET (instance);
   SignalAccumulator *accumulator;
   Emission emission;
   GClosure *class_closure;
@@ -3108,6 +3555,8 @@ signal_emit_unlocked_R (SignalNode   *node,
   guint signal_id;
   gulong max_sequential_handler_number;
   gboolean return_value_altered = FALSE;
+  GValue *collected = NULL;
+  guint n_params;
   
 #ifdef	G_ENABLE_DEBUG
   IF_DEBUG (SIGNALS, g_trace_instance_signals == instance || g_trap_instance_signals == instance)
@@ -3121,26 +3570,27 @@ signal_emit_unlocked_R (SignalNode   *node,
     }
 #endif	/* G_ENABLE_DEBUG */
   
-  SIGNAL_LOCK ();
+  BUCKET_LOCK (bucket);
   signal_id = node->signal_id;
+  n_params = node->n_params;
   if (node->flags & G_SIGNAL_NO_RECURSE)
     {
-      Emission *node = emission_find (g_restart_emissions, signal_id, detail, instance);
+      Emission *node = emission_find (bucket->restart_emissions, signal_id, detail, instance);
       
       if (node)
 	{
 	  node->state = EMISSION_RESTART;
-	  SIGNAL_UNLOCK ();
+	  BUCKET_UNLOCK (bucket);
 	  return return_value_altered;
 	}
     }
   accumulator = node->accumulator;
   if (accumulator)
     {
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       g_value_init (&accu, node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE);
       return_accu = &accu;
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
     }
   else
     return_accu = emission_return;
@@ -3150,14 +3600,14 @@ signal_emit_unlocked_R (SignalNode   *node,
   emission.ihint.run_type = 0;
   emission.state = 0;
   emission.chain_type = G_TYPE_NONE;
-  emission_push ((node->flags & G_SIGNAL_NO_RECURSE) ? &g_restart_emissions : &g_recursive_emissions, &emission);
+  emission_push ((node->flags & G_SIGNAL_NO_RECURSE) ? &bucket->restart_emissions : &bucket->recursive_emissions, &emission);
   class_closure = signal_lookup_closure (node, instance);
   
  EMIT_RESTART:
   
   if (handler_list)
     handler_unref_R (signal_id, instance, handler_list);
-  max_sequential_handler_number = g_handler_sequential_number;
+  max_sequential_handler_number = bucket_next_handler_id (bucket);
   hlist = handler_list_lookup (signal_id, instance);
   handler_list = hlist ? hlist->handlers : NULL;
   if (handler_list)
@@ -3170,16 +3620,16 @@ signal_emit_unlocked_R (SignalNode   *node,
       emission.state = EMISSION_RUN;
 
       emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
-      SIGNAL_UNLOCK ();
-      g_closure_invoke (class_closure,
-			return_accu,
-			node->n_params + 1,
-			instance_and_params,
-			&emission.ihint);
+      BUCKET_UNLOCK (bucket);
+      signal_invoke_closure (class_closure,
+			   return_accu,
+			   node, instance, n_params,
+			   &instance_and_params, &collected, var_args,
+			   &emission.ihint);
       if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
 	  emission.state == EMISSION_RUN)
 	emission.state = EMISSION_STOP;
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
       emission.chain_type = G_TYPE_NONE;
       return_value_altered = TRUE;
       
@@ -3194,7 +3644,10 @@ signal_emit_unlocked_R (SignalNode   *node,
       gboolean need_destroy, was_in_call, may_recurse = TRUE;
       GHook *hook;
 
+      /* emission hooks are shared by all instances */
       emission.state = EMISSION_HOOK;
+      BUCKET_UNLOCK (bucket);
+      SIGNAL_LOCK ();
       hook = g_hook_first_valid (node->emission_hooks, may_recurse);
       while (hook)
 	{
@@ -3207,7 +3660,10 @@ signal_emit_unlocked_R (SignalNode   *node,
 	      was_in_call = G_HOOK_IN_CALL (hook);
 	      hook->flags |= G_HOOK_FLAG_IN_CALL;
               SIGNAL_UNLOCK ();
-	      need_destroy = !hook_func (&emission.ihint, node->n_params + 1, instance_and_params, hook->data);
+	      if (!instance_and_params)
+		instance_and_params = collected = signal_collect_valist (node, instance, n_params, var_args);
+	      need_destroy = instance_and_params &&
+		!hook_func (&emission.ihint, n_params + 1, instance_and_params, hook->data);
 	      SIGNAL_LOCK ();
 	      if (!was_in_call)
 		hook->flags &= ~G_HOOK_FLAG_IN_CALL;
@@ -3216,6 +3672,8 @@ signal_emit_unlocked_R (SignalNode   *node,
 	    }
 	  hook = g_hook_next_valid (node->emission_hooks, hook, may_recurse);
 	}
+      SIGNAL_UNLOCK ();
+      BUCKET_LOCK (bucket);
       
       if (emission.state == EMISSION_RESTART)
 	goto EMIT_RESTART;
@@ -3240,16 +3698,16 @@ signal_emit_unlocked_R (SignalNode   *node,
 	  else if (!handler->block_count && (!handler->detail || handler->detail == detail) &&
 		   handler->sequential_number < max_sequential_handler_number)
 	    {
-	      SIGNAL_UNLOCK ();
-	      g_closure_invoke (handler->closure,
-				return_accu,
-				node->n_params + 1,
-				instance_and_params,
-				&emission.ihint);
+	      BUCKET_UNLOCK (bucket);
+	      signal_invoke_closure (handler->closure,
+				   return_accu,
+				   node, instance, n_params,
+				   &instance_and_params, &collected, var_args,
+				   &emission.ihint);
 	      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
 		  emission.state == EMISSION_RUN)
 		emission.state = EMISSION_STOP;
-	      SIGNAL_LOCK ();
+	      BUCKET_LOCK (bucket);
 	      return_value_altered = TRUE;
 	      
 	      tmp = emission.state == EMISSION_RUN ? handler->next : NULL;
@@ -3278,16 +3736,16 @@ signal_emit_unlocked_R (SignalNode   *node,
       emission.state = EMISSION_RUN;
       
       emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
-      SIGNAL_UNLOCK ();
-      g_closure_invoke (class_closure,
-			return_accu,
-			node->n_params + 1,
-			instance_and_params,
-			&emission.ihint);
+      BUCKET_UNLOCK (bucket);
+      signal_invoke_closure (class_closure,
+			   return_accu,
+			   node, instance, n_params,
+			   &instance_and_params, &collected, var_args,
+			   &emission.ihint);
       if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
 	  emission.state == EMISSION_RUN)
 	emission.state = EMISSION_STOP;
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
       emission.chain_type = G_TYPE_NONE;
       return_value_altered = TRUE;
       
@@ -3310,16 +3768,16 @@ signal_emit_unlocked_R (SignalNode   *node,
 	  if (handler->after && !handler->block_count && (!handler->detail || handler->detail == detail) &&
 	      handler->sequential_number < max_sequential_handler_number)
 	    {
-	      SIGNAL_UNLOCK ();
-	      g_closure_invoke (handler->closure,
-				return_accu,
-				node->n_params + 1,
-				instance_and_params,
-				&emission.ihint);
+	      BUCKET_UNLOCK (bucket);
+	      signal_invoke_closure (handler->closure,
+				   return_accu,
+				   node, instance, n_params,
+				   &instance_and_params, &collected, var_args,
+				   &emission.ihint);
 	      if (!accumulate (&emission.ihint, emission_return, &accu, accumulator) &&
 		  emission.state == EMISSION_RUN)
 		emission.state = EMISSION_STOP;
-	      SIGNAL_LOCK ();
+	      BUCKET_LOCK (bucket);
 	      return_value_altered = TRUE;
 	      
 	      tmp = emission.state == EMISSION_RUN ? handler->next : NULL;
@@ -3351,20 +3809,20 @@ signal_emit_unlocked_R (SignalNode   *node,
       emission.state = EMISSION_STOP;
       
       emission.chain_type = G_TYPE_FROM_INSTANCE (instance);
-      SIGNAL_UNLOCK ();
+      BUCKET_UNLOCK (bucket);
       if (node->return_type != G_TYPE_NONE && !accumulator)
 	{
 	  g_value_init (&accu, node->return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE);
 	  need_unset = TRUE;
 	}
-      g_closure_invoke (class_closure,
-			node->return_type != G_TYPE_NONE ? &accu : NULL,
-			node->n_params + 1,
-			instance_and_params,
-			&emission.ihint);
+      signal_invoke_closure (class_closure,
+			   node->return_type != G_TYPE_NONE ? &accu : NULL,
+			   node, instance, n_params,
+			   &instance_and_params, &collected, var_args,
+			   &emission.ihint);
       if (need_unset)
 	g_value_unset (&accu);
-      SIGNAL_LOCK ();
+      BUCKET_LOCK (bucket);
       emission.chain_type = G_TYPE_NONE;
       
       if (emission.state == EMISSION_RESTART)
@@ -3374,10 +3832,12 @@ signal_emit_unlocked_R (SignalNode   *node,
   if (handler_list)
     handler_unref_R (signal_id, instance, handler_list);
   
-  emission_pop ((node->flags & G_SIGNAL_NO_RECURSE) ? &g_restart_emissions : &g_recursive_emissions, &emission);
-  SIGNAL_UNLOCK ();
+  emission_pop ((node->flags & G_SIGNAL_NO_RECURSE) ? &bucket->restart_emissions : &bucket->recursive_emissions, &emission);
+  BUCKET_UNLOCK (bucket);
   if (accumulator)
     g_value_unset (&accu);
+  if (collected)
+    signal_free_collected (collected, n_params);
   
   return return_value_altered;
 }
@@ -43,6 +43,16 @@ typedef struct _GSignalInvocationHint	 GSignalInvocationHint;
  * signal system.
  */
 typedef GClosureMarshal			 GSignalCMarshaller;
+/**
+ * GSignalCVaMarshaller:
+ * 
+ * This is the signature of va_list marshaller functions, an optional
+ * marshaller that can be used in some situations to avoid
+ * marshalling the signal argument into #GValue<!-- -->s.
+ *
+ * Since: 2.20
+ */
+typedef GVaClosureMarshal		 GSignalCVaMarshaller;
 /**
  * GSignalEmissionHook:
  * @ihint: Signal invocation hint, see #GSignalInvocationHint.
@@ -287,6 +297,9 @@ guint            g_signal_new_class_handler (const gchar        *signal_name,
                                              GType               return_type,
                                              guint               n_params,
                                              ...);
+void             g_signal_set_va_marshaller (guint               signal_id,
+                                             GType               instance_type,
+                                             GSignalCVaMarshaller va_marshaller);
 
 void                  g_signal_emitv        (const GValue       *instance_and_params,
 					     guint               signal_id,
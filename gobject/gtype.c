@@ -172,6 +172,7 @@ typedef struct _ClassData       ClassData;
 typedef struct _InstanceData    InstanceData;
 typedef union  _TypeData        TypeData;
 typedef struct _IFaceEntry      IFaceEntry;
+typedef struct _IFaceEntries    IFaceEntries;
 typedef struct _IFaceHolder	IFaceHolder;
 
 
@@ -234,7 +235,7 @@ struct _TypeNode
   GQuark       qname;
   GData       *global_gdata;
   union {
-    IFaceEntry  *iface_entries;		/* for !iface types */
+    IFaceEntries * volatile iface_entries;	/* for !iface types */
     GType       *prerequisistes;
   } _prot;
   GType        supers[1]; /* flexible array */
@@ -250,14 +251,16 @@ struct _TypeNode
 #define NODE_FUNDAMENTAL_TYPE(node)		(node->supers[node->n_supers])
 #define NODE_NAME(node)				(g_quark_to_string (node->qname))
 #define	NODE_IS_IFACE(node)			(NODE_FUNDAMENTAL_TYPE (node) == G_TYPE_INTERFACE)
-#define	CLASSED_NODE_N_IFACES(node)		((node)->_prot_n_ifaces_prerequisites)
-#define	CLASSED_NODE_IFACES_ENTRIES(node)	((node)->_prot.iface_entries)
+#define	CLASSED_NODE_N_IFACES(node)		(IFACE_ENTRIES_N_ENTRIES ((node)->_prot.iface_entries))
+#define	CLASSED_NODE_IFACES_ENTRIES(node)	((node)->_prot.iface_entries ? (node)->_prot.iface_entries->entry : NULL)
 #define	IFACE_NODE_N_PREREQUISITES(node)	((node)->_prot_n_ifaces_prerequisites)
 #define	IFACE_NODE_PREREQUISITES(node)		((node)->_prot.prerequisistes)
 #define	iface_node_get_holders_L(node)		((IFaceHolder*) type_get_qdata_L ((node), static_quark_iface_holder))
 #define	iface_node_set_holders_W(node, holders)	(type_set_qdata_W ((node), static_quark_iface_holder, (holders)))
 #define	iface_node_get_dependants_array_L(n)	((GType*) type_get_qdata_L ((n), static_quark_dependants_array))
 #define	iface_node_set_dependants_array_W(n,d)	(type_set_qdata_W ((n), static_quark_dependants_array, (d)))
+#define	IFACE_ENTRIES_HEADER_SIZE		(G_STRUCT_OFFSET (IFaceEntries, entry))
+#define	IFACE_ENTRIES_N_ENTRIES(entries)	((entries) ? (entries)->n_entries : 0)
 #define	TYPE_ID_MASK				((GType) ((1 << G_TYPE_FUNDAMENTAL_SHIFT) - 1))
 
 #define NODE_IS_ANCESTOR(ancestor, node)                                                    \
@@ -280,6 +283,16 @@ struct _IFaceEntry
   InitState       init_state;
 };
 
+/* The interface entries of a classed node are never resized in place;
+ * a new array is published instead, and the old one stays around, so
+ * that lookups can go without taking type_rw_lock.
+ */
+struct _IFaceEntries
+{
+  guint           n_entries;
+  IFaceEntry      entry[1];	/* flexible array */
+};
+
 struct _CommonData
 {
   guint             ref_count;
@@ -420,8 +433,7 @@ type_node_any_new_W (TypeNode             *pnode,
 	}
       else
 	{
-	  CLASSED_NODE_N_IFACES (node) = 0;
-	  CLASSED_NODE_IFACES_ENTRIES (node) = NULL;
+	  node->_prot.iface_entries = NULL;
 	}
     }
   else
@@ -441,15 +453,19 @@ type_node_any_new_W (TypeNode             *pnode,
 	{
 	  guint j;
 	  
-	  CLASSED_NODE_N_IFACES (node) = CLASSED_NODE_N_IFACES (pnode);
-	  CLASSED_NODE_IFACES_ENTRIES (node) = g_memdup (CLASSED_NODE_IFACES_ENTRIES (pnode),
-							 sizeof (CLASSED_NODE_IFACES_ENTRIES (pnode)[0]) *
-							 CLASSED_NODE_N_IFACES (node));
-	  for (j = 0; j < CLASSED_NODE_N_IFACES (node); j++)
+	  if (CLASSED_NODE_N_IFACES (pnode))
 	    {
-	      CLASSED_NODE_IFACES_ENTRIES (node)[j].vtable = NULL;
-	      CLASSED_NODE_IFACES_ENTRIES (node)[j].init_state = UNINITIALIZED;
+	      node->_prot.iface_entries = g_memdup (pnode->_prot.iface_entries,
+						    IFACE_ENTRIES_HEADER_SIZE +
+						    sizeof (IFaceEntry) * CLASSED_NODE_N_IFACES (pnode));
+	      for (j = 0; j < CLASSED_NODE_N_IFACES (node); j++)
+		{
+		  CLASSED_NODE_IFACES_ENTRIES (node)[j].vtable = NULL;
+		  CLASSED_NODE_IFACES_ENTRIES (node)[j].init_state = UNINITIALIZED;
+		}
 	    }
+	  else
+	    node->_prot.iface_entries = NULL;
 	}
       
       i = pnode->n_children++;
@@ -519,13 +535,13 @@ type_node_new_W (TypeNode    *pnode,
 }
 
 static inline IFaceEntry*
-type_lookup_iface_entry_L (TypeNode *node,
-			   TypeNode *iface_node)
+type_lookup_iface_entries_I (IFaceEntries *entries,
+			     TypeNode     *iface_node)
 {
-  if (NODE_IS_IFACE (iface_node) && CLASSED_NODE_N_IFACES (node))
+  if (NODE_IS_IFACE (iface_node) && IFACE_ENTRIES_N_ENTRIES (entries))
     {
-      IFaceEntry *ifaces = CLASSED_NODE_IFACES_ENTRIES (node) - 1;
-      guint n_ifaces = CLASSED_NODE_N_IFACES (node);
+      IFaceEntry *ifaces = entries->entry - 1;
+      guint n_ifaces = entries->n_entries;
       GType iface_type = NODE_TYPE (iface_node);
       
       do
@@ -551,6 +567,29 @@ type_lookup_iface_entry_L (TypeNode *node,
   return NULL;
 }
 
+static inline IFaceEntry*
+type_lookup_iface_entry_L (TypeNode *node,
+			   TypeNode *iface_node)
+{
+  return type_lookup_iface_entries_I (node->_prot.iface_entries, iface_node);
+}
+
+/* Entries arrays are published atomically and never freed, so this
+ * can be called without holding type_rw_lock. The returned entry
+ * may be a stale copy, so only ->iface_type and ->vtable may be
+ * looked at, and it must not be written to.
+ */
+static inline IFaceEntry*
+type_lookup_iface_entry_I (TypeNode *node,
+			   TypeNode *iface_node)
+{
+  IFaceEntries *entries;
+
+  entries = g_atomic_pointer_get ((gpointer*) &node->_prot.iface_entries);
+
+  return type_lookup_iface_entries_I (entries, iface_node);
+}
+
 static inline gboolean
 type_lookup_prerequisite_L (TypeNode *iface,
 			    GType     prerequisite_type)
@@ -1167,8 +1206,9 @@ type_node_add_iface_entry_W (TypeNode   *node,
 			     GType       iface_type,
                              IFaceEntry *parent_entry)
 {
+  IFaceEntries *old_entries, *new_entries;
   IFaceEntry *entries;
-  guint i;
+  guint i, n_entries;
   
   g_assert (node->is_instantiatable && CLASSED_NODE_N_IFACES (node) < MAX_N_IFACES);
   
@@ -1196,15 +1236,25 @@ type_node_add_iface_entry_W (TypeNode   *node,
       }
     else if (entries[i].iface_type > iface_type)
       break;
-  CLASSED_NODE_N_IFACES (node) += 1;
-  CLASSED_NODE_IFACES_ENTRIES (node) = g_renew (IFaceEntry,
-						CLASSED_NODE_IFACES_ENTRIES (node),
-						CLASSED_NODE_N_IFACES (node));
-  entries = CLASSED_NODE_IFACES_ENTRIES (node);
-  g_memmove (entries + i + 1, entries + i, sizeof (entries[0]) * (CLASSED_NODE_N_IFACES (node) - i - 1));
+  /* build a new array, so that lock-free readers of the old one
+   * always see a consistent snapshot; the old array is kept, since
+   * such readers may still be looking at it.
+   */
+  old_entries = node->_prot.iface_entries;
+  n_entries = IFACE_ENTRIES_N_ENTRIES (old_entries);
+  new_entries = g_malloc (IFACE_ENTRIES_HEADER_SIZE + sizeof (IFaceEntry) * (n_entries + 1));
+  new_entries->n_entries = n_entries + 1;
+  entries = new_entries->entry;
+  if (old_entries)
+    {
+      memcpy (entries, old_entries->entry, sizeof (entries[0]) * i);
+      memcpy (entries + i + 1, old_entries->entry + i, sizeof (entries[0]) * (n_entries - i));
+    }
   entries[i].iface_type = iface_type;
   entries[i].vtable = NULL;
   entries[i].init_state = UNINITIALIZED;
+  g_atomic_pointer_compare_and_exchange ((gpointer*) &node->_prot.iface_entries,
+					 old_entries, new_entries);
 
   if (parent_entry)
     {
@@ -2740,6 +2790,9 @@ g_type_class_peek (GType type)
   gpointer class;
   
   node = lookup_type_node_I (type);
+  if (node && !node->plugin)
+    return g_type_class_peek_static (type);
+
   G_READ_LOCK (&type_rw_lock);
   if (node && node->is_classed && node->data && node->data->class.class) /* common.ref_count _may_ be 0 */
     class = node->data->class.class;
@@ -2767,15 +2820,20 @@ g_type_class_peek_static (GType type)
   TypeNode *node;
   gpointer class;
   
+  TypeData *data;
+  
+  /* static types never lose their data once it is set up, so there
+   * is no need to take type_rw_lock here
+   */
   node = lookup_type_node_I (type);
-  G_READ_LOCK (&type_rw_lock);
-  if (node && node->is_classed && node->data &&
-      /* peek only static types: */ node->plugin == NULL &&
-      node->data->class.class) /* common.ref_count _may_ be 0 */
-    class = node->data->class.class;
+  if (!node || !node->is_classed || /* peek only static types: */ node->plugin != NULL)
+    return NULL;
+
+  data = node->data;
+  if (data) /* common.ref_count _may_ be 0 */
+    class = data->class.class;
   else
     class = NULL;
-  G_READ_UNLOCK (&type_rw_lock);
   
   return class;
 }
@@ -2849,13 +2907,9 @@ g_type_interface_peek (gpointer instance_class,
     {
       IFaceEntry *entry;
       
-      G_READ_LOCK (&type_rw_lock);
-      
-      entry = type_lookup_iface_entry_L (node, iface);
+      entry = type_lookup_iface_entry_I (node, iface);
       if (entry && entry->vtable)	/* entry is relocatable */
 	vtable = entry->vtable;
-      
-      G_READ_UNLOCK (&type_rw_lock);
     }
   else
     g_warning (G_STRLOC ": invalid class pointer `%p'", class);
@@ -2894,13 +2948,9 @@ g_type_interface_peek_parent (gpointer g_iface)
     {
       IFaceEntry *entry;
       
-      G_READ_LOCK (&type_rw_lock);
-      
-      entry = type_lookup_iface_entry_L (node, iface);
+      entry = type_lookup_iface_entry_I (node, iface);
       if (entry && entry->vtable)	/* entry is relocatable */
 	vtable = entry->vtable;
-      
-      G_READ_UNLOCK (&type_rw_lock);
     }
   else if (node)
     g_warning (G_STRLOC ": invalid interface pointer `%p'", g_iface);
@@ -3189,6 +3239,9 @@ type_node_check_conformities_UorL (TypeNode *node,
 {
   gboolean match;
   
+  /* ->supers[] is fixed at registration time and holds all ancestors,
+   * so inheritance is an O(1) check that needs no locking
+   */
   if (/* support_inheritance && */
       NODE_IS_ANCESTOR (iface_node, node))
     return TRUE;
@@ -3196,14 +3249,21 @@ type_node_check_conformities_UorL (TypeNode *node,
   support_interfaces = support_interfaces && node->is_instantiatable && NODE_IS_IFACE (iface_node);
   support_prerequisites = support_prerequisites && NODE_IS_IFACE (node);
   match = FALSE;
-  if (support_interfaces || support_prerequisites)
+  if (support_interfaces)
+    {
+      /* instantiatable nodes are never interfaces, so there is
+       * nothing left to check for prerequisites
+       */
+      if (have_lock)
+	match = type_lookup_iface_entry_L (node, iface_node) != NULL;
+      else
+	match = type_lookup_iface_entry_I (node, iface_node) != NULL;
+    }
+  else if (support_prerequisites)
     {
       if (!have_lock)
 	G_READ_LOCK (&type_rw_lock);
-      if (support_interfaces && type_lookup_iface_entry_L (node, iface_node))
-	match = TRUE;
-      else if (support_prerequisites && type_lookup_prerequisite_L (node, NODE_TYPE (iface_node)))
-	match = TRUE;
+      match = type_lookup_prerequisite_L (node, NODE_TYPE (iface_node));
       if (!have_lock)
 	G_READ_UNLOCK (&type_rw_lock);
     }
@@ -0,0 +1,492 @@
+/* GLib testing framework examples and tests
+ * Copyright (C) 2026 agent
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+#include <stdlib.h>
+#include <glib.h>
+#include <glib-object.h>
+
+#define N_OBJECTS 200000
+
+/* --- a type with construct, construct-only and normal properties --- */
+typedef struct {
+  GObject parent_instance;
+  int     width;
+  int     height;
+  gchar  *label;
+  int     border_width;
+  int     n_set_before_constructed;
+  int     n_constructed;
+} Widget;
+
+typedef struct {
+  GObjectClass parent_class;
+} WidgetClass;
+
+enum {
+  PROP_0,
+  PROP_WIDTH,
+  PROP_HEIGHT,
+  PROP_LABEL,
+  PROP_BORDER_WIDTH
+};
+
+G_DEFINE_TYPE (Widget, widget, G_TYPE_OBJECT);
+
+static void
+widget_set_property (GObject      *object,
+                     guint         prop_id,
+                     const GValue *value,
+                     GParamSpec   *pspec)
+{
+  Widget *widget = (Widget *) object;
+
+  if (!widget->n_constructed)
+    widget->n_set_before_constructed++;
+
+  switch (prop_id)
+    {
+    case PROP_WIDTH:
+      widget->width = g_value_get_int (value);
+      break;
+    case PROP_HEIGHT:
+      widget->height = g_value_get_int (value);
+      break;
+    case PROP_LABEL:
+      g_free (widget->label);
+      widget->label = g_value_dup_string (value);
+      break;
+    case PROP_BORDER_WIDTH:
+      widget->border_width = g_value_get_int (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+widget_get_property (GObject    *object,
+                     guint       prop_id,
+                     GValue     *value,
+                     GParamSpec *pspec)
+{
+  Widget *widget = (Widget *) object;
+
+  switch (prop_id)
+    {
+    case PROP_WIDTH:
+      g_value_set_int (value, widget->width);
+      break;
+    case PROP_HEIGHT:
+      g_value_set_int (value, widget->height);
+      break;
+    case PROP_LABEL:
+      g_value_set_string (value, widget->label);
+      break;
+    case PROP_BORDER_WIDTH:
+      g_value_set_int (value, widget->border_width);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+widget_constructed (GObject *object)
+{
+  ((Widget *) object)->n_constructed++;
+}
+
+static void
+widget_finalize (GObject *object)
+{
+  g_free (((Widget *) object)->label);
+
+  G_OBJECT_CLASS (widget_parent_class)->finalize (object);
+}
+
+static void
+widget_class_init (WidgetClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+  gobject_class->set_property = widget_set_property;
+  gobject_class->get_property = widget_get_property;
+  gobject_class->constructed = widget_constructed;
+  gobject_class->finalize = widget_finalize;
+
+  g_object_class_install_property (gobject_class, PROP_WIDTH,
+                                   g_param_spec_int ("width", NULL, NULL,
+                                                     0, G_MAXINT, 10,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT));
+  g_object_class_install_property (gobject_class, PROP_HEIGHT,
+                                   g_param_spec_int ("height", NULL, NULL,
+                                                     0, G_MAXINT, 20,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT_ONLY));
+  g_object_class_install_property (gobject_class, PROP_LABEL,
+                                   g_param_spec_string ("label", NULL, NULL,
+                                                        NULL,
+                                                        G_PARAM_READWRITE));
+  g_object_class_install_property (gobject_class, PROP_BORDER_WIDTH,
+                                   g_param_spec_int ("border-width", NULL, NULL,
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READWRITE));
+}
+
+static void
+widget_init (Widget *widget)
+{
+}
+
+/* --- a derived type overriding a construct property --- */
+typedef Widget      Button;
+typedef WidgetClass ButtonClass;
+
+G_DEFINE_TYPE (Button, button, widget_get_type ());
+
+static void
+button_class_init (ButtonClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+  gobject_class->set_property = widget_set_property;
+  gobject_class->get_property = widget_get_property;
+
+  g_object_class_install_property (gobject_class, PROP_WIDTH,
+                                   g_param_spec_int ("width", NULL, NULL,
+                                                     0, G_MAXINT, 30,
+                                                     G_PARAM_READWRITE |
+                                                     G_PARAM_CONSTRUCT));
+}
+
+static void
+button_init (Button *button)
+{
+}
+
+/* --- types that get a property after they were used --- */
+typedef Widget      LateParent;
+typedef WidgetClass LateParentClass;
+typedef Widget      LateChild;
+typedef WidgetClass LateChildClass;
+
+G_DEFINE_TYPE (LateParent, late_parent, widget_get_type ());
+G_DEFINE_TYPE (LateChild, late_child, late_parent_get_type ());
+
+static void
+late_parent_class_init (LateParentClass *class)
+{
+  GObjectClass *gobject_class = G_OBJECT_CLASS (class);
+
+  gobject_class->set_property = widget_set_property;
+  gobject_class->get_property = widget_get_property;
+}
+
+static void
+late_parent_init (LateParent *parent)
+{
+}
+
+static void
+late_child_class_init (LateChildClass *class)
+{
+}
+
+static void
+late_child_init (LateChild *child)
+{
+}
+
+/* --- tests --- */
+static void
+test_new_defaults (void)
+{
+  Widget *widget;
+
+  widget = g_object_new (widget_get_type (), NULL);
+  g_assert_cmpint (widget->width, ==, 10);
+  g_assert_cmpint (widget->height, ==, 20);
+  g_assert (widget->label == NULL);
+  g_assert_cmpint (widget->n_set_before_constructed, ==, 2);
+  g_assert_cmpint (widget->n_constructed, ==, 1);
+  g_object_unref (widget);
+
+  widget = g_object_new (button_get_type (), NULL);
+  g_assert_cmpint (widget->width, ==, 30);
+  g_assert_cmpint (widget->height, ==, 20);
+  g_assert_cmpint (widget->n_set_before_constructed, ==, 2);
+  g_object_unref (widget);
+}
+
+static void
+test_new_valist (void)
+{
+  Widget *widget;
+
+  widget = g_object_new (widget_get_type (),
+                         "label", "hello",
+                         "height", 5,
+                         "width", 6,
+                         NULL);
+  g_assert_cmpint (widget->width, ==, 6);
+  g_assert_cmpint (widget->height, ==, 5);
+  g_assert_cmpstr (widget->label, ==, "hello");
+  g_assert_cmpint (widget->n_set_before_constructed, ==, 2);
+  g_object_unref (widget);
+
+  /* type prefixed names still resolve */
+  widget = g_object_new (button_get_type (), "width", 7, "Widget::label", "there", NULL);
+  g_assert_cmpint (widget->width, ==, 7);
+  g_assert_cmpstr (widget->label, ==, "there");
+  g_object_unref (widget);
+}
+
+static void
+test_new_with_properties (void)
+{
+  const gchar *names[] = { "width", "label" };
+  GValue values[2] = { { 0, }, { 0, } };
+  Widget *widget;
+
+  g_value_init (&values[0], G_TYPE_INT);
+  g_value_set_int (&values[0], 40);
+  g_value_init (&values[1], G_TYPE_STRING);
+  g_value_set_static_string (&values[1], "label");
+
+  widget = (Widget *) g_object_new_with_properties (button_get_type (), 2, names, values);
+  g_assert_cmpint (widget->width, ==, 40);
+  g_assert_cmpint (widget->height, ==, 20);
+  g_assert_cmpstr (widget->label, ==, "label");
+  g_assert_cmpint (widget->n_constructed, ==, 1);
+  g_object_unref (widget);
+
+  widget = (Widget *) g_object_new_with_properties (widget_get_type (), 0, NULL, NULL);
+  g_assert_cmpint (widget->width, ==, 10);
+  g_object_unref (widget);
+
+  g_value_unset (&values[0]);
+  g_value_unset (&values[1]);
+}
+
+static void
+test_new_twice (void)
+{
+  if (g_test_trap_fork (0, G_TEST_TRAP_SILENCE_STDERR))
+    {
+      Widget *widget;
+
+      g_log_set_always_fatal (G_LOG_FATAL_MASK);
+      widget = g_object_new (widget_get_type (), "width", 1, "width", 2, NULL);
+      g_assert_cmpint (widget->width, ==, 1);
+      g_object_unref (widget);
+      exit (0);
+    }
+  g_test_trap_assert_passed ();
+  g_test_trap_assert_stderr ("*can't be set twice*");
+}
+
+static void
+test_set_get (void)
+{
+  Widget *widget;
+  gchar *label = NULL;
+  int border_width = 0;
+  GValue value = { 0, };
+
+  widget = g_object_new (button_get_type (), NULL);
+
+  /* non-canonical names resolve like canonical ones */
+  g_object_set (widget, "border_width", 3, "label", "set", NULL);
+  g_assert_cmpint (widget->border_width, ==, 3);
+  g_object_get (widget, "border-width", &border_width, "Widget::label", &label, NULL);
+  g_assert_cmpint (border_width, ==, 3);
+  g_assert_cmpstr (label, ==, "set");
+  g_free (label);
+
+  g_value_init (&value, G_TYPE_INT);
+  g_value_set_int (&value, 4);
+  g_object_set_property (G_OBJECT (widget), "border-width", &value);
+  g_value_set_int (&value, 0);
+  g_object_get_property (G_OBJECT (widget), "border_width", &value);
+  g_assert_cmpint (g_value_get_int (&value), ==, 4);
+  g_value_unset (&value);
+
+  /* the overriding property of the derived class is found */
+  g_assert (g_object_class_find_property (G_OBJECT_GET_CLASS (widget), "width") !=
+            g_object_class_find_property (g_type_class_peek (widget_get_type ()), "width"));
+  g_assert (g_object_class_find_property (G_OBJECT_GET_CLASS (widget), "no-such-property") == NULL);
+
+  g_object_unref (widget);
+}
+
+static void
+test_install_late (void)
+{
+  GObjectClass *parent_class;
+  Widget *child;
+  int late = 0;
+
+  /* looking up a property builds the table of the child class */
+  child = g_object_new (late_child_get_type (), NULL);
+  g_object_set (child, "label", "early", NULL);
+
+  parent_class = g_type_class_ref (late_parent_get_type ());
+  g_object_class_install_property (parent_class, PROP_BORDER_WIDTH,
+                                   g_param_spec_int ("late", NULL, NULL,
+                                                     0, G_MAXINT, 0,
+                                                     G_PARAM_READWRITE));
+
+  g_object_set (child, "late", 1, NULL);
+  g_object_get (child, "late", &late, NULL);
+  g_assert_cmpint (late, ==, 1);
+  g_assert (g_object_class_find_property (G_OBJECT_GET_CLASS (child), "late") != NULL);
+
+  g_type_class_unref (parent_class);
+  g_object_unref (child);
+}
+
+static gpointer
+set_get_thread (gpointer data)
+{
+  Widget *widget = data;
+  int i;
+
+  for (i = 0; i < 10000; i++)
+    {
+      int width = 0;
+
+      g_object_set (widget, "border-width", i, NULL);
+      g_object_get (widget, "width", &width, NULL);
+      g_assert_cmpint (width, ==, 10);
+    }
+
+  return NULL;
+}
+
+static void
+test_set_get_threaded (void)
+{
+  GThread *threads[4];
+  Widget *widgets[4];
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+      widgets[i] = g_object_new (widget_get_type (), NULL);
+      threads[i] = g_thread_create (set_get_thread, widgets[i], TRUE, NULL);
+    }
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+      g_thread_join (threads[i]);
+      g_assert_cmpint (widgets[i]->border_width, ==, 9999);
+      g_object_unref (widgets[i]);
+    }
+}
+
+/* --- benchmarks --- */
+static void
+test_new_perf (void)
+{
+  const gchar *names[] = { "width", "height", "label" };
+  GValue values[3] = { { 0, }, { 0, }, { 0, } };
+  double elapsed;
+  int i;
+
+  g_test_timer_start ();
+  for (i = 0; i < N_OBJECTS; i++)
+    g_object_unref (g_object_new (widget_get_type (),
+                                  "width", 1,
+                                  "height", 2,
+                                  "label", "label",
+                                  NULL));
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (N_OBJECTS / elapsed,
+                           "g_object_new() with 3 properties per second: %.0f",
+                           N_OBJECTS / elapsed);
+
+  g_value_init (&values[0], G_TYPE_INT);
+  g_value_set_int (&values[0], 1);
+  g_value_init (&values[1], G_TYPE_INT);
+  g_value_set_int (&values[1], 2);
+  g_value_init (&values[2], G_TYPE_STRING);
+  g_value_set_static_string (&values[2], "label");
+
+  g_test_timer_start ();
+  for (i = 0; i < N_OBJECTS; i++)
+    g_object_unref (g_object_new_with_properties (widget_get_type (), 3, names, values));
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (N_OBJECTS / elapsed,
+                           "g_object_new_with_properties() with 3 properties per second: %.0f",
+                           N_OBJECTS / elapsed);
+
+  g_value_unset (&values[0]);
+  g_value_unset (&values[1]);
+  g_value_unset (&values[2]);
+}
+
+static void
+test_set_get_perf (void)
+{
+  Widget *widget;
+  double elapsed;
+  int i;
+
+  widget = g_object_new (widget_get_type (), NULL);
+
+  g_test_timer_start ();
+  for (i = 0; i < N_OBJECTS; i++)
+    {
+      int width;
+
+      g_object_set (widget, "border-width", i, NULL);
+      g_object_get (widget, "width", &width, NULL);
+    }
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (N_OBJECTS / elapsed,
+                           "g_object_set() and g_object_get() pairs per second: %.0f",
+                           N_OBJECTS / elapsed);
+
+  g_object_unref (widget);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+  g_type_init ();
+
+  g_test_add_func ("/properties/new/defaults", test_new_defaults);
+  g_test_add_func ("/properties/new/valist", test_new_valist);
+  g_test_add_func ("/properties/new/with-properties", test_new_with_properties);
+  g_test_add_func ("/properties/new/twice", test_new_twice);
+  g_test_add_func ("/properties/set-get", test_set_get);
+  g_test_add_func ("/properties/install-late", test_install_late);
+  g_test_add_func ("/properties/set-get/threaded", test_set_get_threaded);
+  if (g_test_perf ())
+    {
+      g_test_add_func ("/properties/perf/new", test_new_perf);
+      g_test_add_func ("/properties/perf/set-get", test_set_get_perf);
+    }
+
+  return g_test_run ();
+}
@@ -0,0 +1,528 @@
+/* GLib testing framework examples and tests
+ * Copyright (C) 2026 agent
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+#include <glib.h>
+#include <glib-object.h>
+
+#define N_EMISSIONS 1000000
+
+/* --- a type with a signal that has no class handler, and one that has --- */
+typedef struct {
+  GObject parent_instance;
+  int     n_class_handled;
+  gchar  *last_string;
+} Emitter;
+
+typedef struct {
+  GObjectClass parent_class;
+  void (*handled)        (Emitter     *emitter,
+                          int          value);
+  void (*string_changed) (Emitter     *emitter,
+                          const gchar *string);
+} EmitterClass;
+
+enum {
+  CHANGED,
+  HANDLED,
+  STRING_CHANGED,
+  LAST_SIGNAL
+};
+
+static guint signals[LAST_SIGNAL] = { 0 };
+
+G_DEFINE_TYPE (Emitter, emitter, G_TYPE_OBJECT);
+
+static void
+emitter_handled (Emitter *emitter,
+                 int      value)
+{
+  emitter->n_class_handled++;
+}
+
+static void
+emitter_string_changed (Emitter     *emitter,
+                        const gchar *string)
+{
+  g_free (emitter->last_string);
+  emitter->last_string = g_strdup (string);
+}
+
+static void
+emitter_finalize (GObject *object)
+{
+  Emitter *emitter = (Emitter *) object;
+
+  g_free (emitter->last_string);
+
+  G_OBJECT_CLASS (emitter_parent_class)->finalize (object);
+}
+
+static void
+emitter_class_init (EmitterClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = emitter_finalize;
+  klass->handled = emitter_handled;
+  klass->string_changed = emitter_string_changed;
+
+  signals[CHANGED] =
+    g_signal_new ("changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST | G_SIGNAL_DETAILED,
+                  0,
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__INT,
+                  G_TYPE_NONE, 1, G_TYPE_INT);
+  signals[HANDLED] =
+    g_signal_new ("handled",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (EmitterClass, handled),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__INT,
+                  G_TYPE_NONE, 1, G_TYPE_INT);
+  signals[STRING_CHANGED] =
+    g_signal_new ("string-changed",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  G_STRUCT_OFFSET (EmitterClass, string_changed),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__STRING,
+                  G_TYPE_NONE, 1, G_TYPE_STRING);
+}
+
+static void
+emitter_init (Emitter *emitter)
+{
+}
+
+static void
+count_cb (Emitter  *emitter,
+          int       value,
+          gpointer  user_data)
+{
+  int *count = user_data;
+
+  *count += value;
+}
+
+static void
+test_emit_no_handlers (void)
+{
+  Emitter *emitter, *other;
+  gulong id;
+  int count = 0;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+  other = g_object_new (emitter_get_type (), NULL);
+
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+
+  id = g_signal_connect (emitter, "changed", G_CALLBACK (count_cb), &count);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 1);
+
+  /* handlers of one instance don't run for another one */
+  g_signal_emit (other, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 1);
+
+  g_signal_handler_block (emitter, id);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 1);
+  g_signal_handler_unblock (emitter, id);
+
+  g_signal_emit_by_name (emitter, "changed", 1);
+  g_assert_cmpint (count, ==, 2);
+
+  g_signal_handler_disconnect (emitter, id);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 2);
+
+  /* detailed handlers */
+  g_signal_connect (emitter, "changed::foo", G_CALLBACK (count_cb), &count);
+  g_signal_emit (emitter, signals[CHANGED], g_quark_from_string ("bar"), 1);
+  g_assert_cmpint (count, ==, 2);
+  g_signal_emit (emitter, signals[CHANGED], g_quark_from_string ("foo"), 1);
+  g_assert_cmpint (count, ==, 3);
+
+  /* handlers go away with the instance's handler list */
+  g_signal_handlers_destroy (emitter);
+  g_signal_emit (emitter, signals[CHANGED], g_quark_from_string ("foo"), 1);
+  g_assert_cmpint (count, ==, 3);
+
+  g_signal_connect (emitter, "changed", G_CALLBACK (count_cb), &count);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 4);
+
+  g_object_unref (other);
+  g_object_unref (emitter);
+}
+
+static void
+test_emit_invalid_closure (void)
+{
+  Emitter *emitter;
+  GClosure *closure;
+  gulong id;
+  int count = 0, invalid_count = 0;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+
+  closure = g_cclosure_new (G_CALLBACK (count_cb), &invalid_count, NULL);
+  id = g_signal_connect_closure (emitter, "changed", closure, FALSE);
+  g_signal_connect (emitter, "changed", G_CALLBACK (count_cb), &count);
+
+  g_closure_invalidate (closure);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (invalid_count, ==, 0);
+  g_assert_cmpint (count, ==, 1);
+
+  /* the invalidated handler must only stop counting once */
+  g_signal_handler_disconnect (emitter, id);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 2);
+
+  closure = g_cclosure_new (G_CALLBACK (count_cb), &invalid_count, NULL);
+  g_signal_connect_closure (emitter, "changed", closure, FALSE);
+  g_closure_invalidate (closure);
+  g_signal_handlers_destroy (emitter);
+
+  g_signal_connect (emitter, "changed", G_CALLBACK (count_cb), &count);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 3);
+  g_assert_cmpint (invalid_count, ==, 0);
+
+  g_object_unref (emitter);
+}
+
+static void
+test_emit_class_handler (void)
+{
+  Emitter *emitter;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+
+  g_signal_emit (emitter, signals[HANDLED], 0, 1);
+  g_assert_cmpint (emitter->n_class_handled, ==, 1);
+
+  g_object_unref (emitter);
+}
+
+static gboolean
+count_hook (GSignalInvocationHint *ihint,
+            guint                  n_param_values,
+            const GValue          *param_values,
+            gpointer               user_data)
+{
+  int *count = user_data;
+
+  (*count)++;
+
+  return TRUE;
+}
+
+static void
+test_emit_hook (void)
+{
+  Emitter *emitter;
+  gulong hook_id;
+  int count = 0;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+
+  hook_id = g_signal_add_emission_hook (signals[CHANGED], 0, count_hook, &count, NULL);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 1);
+
+  g_signal_remove_emission_hook (signals[CHANGED], hook_id);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, 1);
+
+  g_object_unref (emitter);
+}
+
+static void
+string_cb (Emitter     *emitter,
+           const gchar *string,
+           gpointer     user_data)
+{
+  const gchar **strings = user_data;
+
+  /* the emitter's copy of the argument is not handed out */
+  g_assert (string != strings[0]);
+  g_assert_cmpstr (string, ==, strings[0]);
+  strings[1] = string;
+}
+
+static void
+stop_cb (Emitter     *emitter,
+         const gchar *string,
+         gpointer     user_data)
+{
+  g_signal_stop_emission (emitter, signals[STRING_CHANGED], 0);
+}
+
+/* a marshaller without va_list variant, forcing the arguments
+ * of an emission to be collected into GValues
+ */
+static void
+string_marshal (GClosure     *closure,
+                GValue       *return_value,
+                guint         n_param_values,
+                const GValue *param_values,
+                gpointer      invocation_hint,
+                gpointer      marshal_data)
+{
+  const gchar **strings = closure->data;
+
+  g_assert_cmpuint (n_param_values, ==, 2);
+  g_assert (g_value_get_object (param_values + 0) != NULL);
+  g_assert_cmpstr (g_value_get_string (param_values + 1), ==, strings[0]);
+  strings[2] = strings[0];
+}
+
+static gboolean
+string_hook (GSignalInvocationHint *ihint,
+             guint                  n_param_values,
+             const GValue          *param_values,
+             gpointer               user_data)
+{
+  const gchar **strings = user_data;
+
+  g_assert_cmpuint (n_param_values, ==, 2);
+  g_assert_cmpstr (g_value_get_string (param_values + 1), ==, strings[0]);
+  strings[3] = strings[0];
+
+  return FALSE;
+}
+
+static void
+test_emit_valist (void)
+{
+  Emitter *emitter;
+  GClosure *closure;
+  const gchar *strings[4] = { NULL, };
+  gchar *string;
+  gulong stop_id;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+
+  /* class closure only */
+  string = g_strdup ("first");
+  g_signal_emit (emitter, signals[STRING_CHANGED], 0, string);
+  g_assert_cmpstr (emitter->last_string, ==, "first");
+  g_free (string);
+
+  /* C handler and class closure */
+  string = g_strdup ("second");
+  strings[0] = string;
+  g_signal_connect (emitter, "string-changed", G_CALLBACK (string_cb), strings);
+  g_signal_emit (emitter, signals[STRING_CHANGED], 0, string);
+  g_assert_cmpstr (emitter->last_string, ==, "second");
+  g_assert (strings[1] != NULL);
+
+  /* stopping the emission skips the class closure */
+  g_free (emitter->last_string);
+  emitter->last_string = NULL;
+  stop_id = g_signal_connect (emitter, "string-changed", G_CALLBACK (stop_cb), NULL);
+  g_signal_emit (emitter, signals[STRING_CHANGED], 0, string);
+  g_assert (emitter->last_string == NULL);
+  g_signal_handler_disconnect (emitter, stop_id);
+
+  /* a closure with its own marshaller gets collected arguments */
+  closure = g_closure_new_simple (sizeof (GClosure), strings);
+  g_closure_set_marshal (closure, string_marshal);
+  g_signal_connect_closure (emitter, "string-changed", closure, FALSE);
+  strings[1] = NULL;
+  g_signal_emit (emitter, signals[STRING_CHANGED], 0, string);
+  g_assert (strings[1] != NULL);
+  g_assert_cmpstr (strings[2], ==, "second");
+  g_assert_cmpstr (emitter->last_string, ==, "second");
+
+  /* so do emission hooks */
+  g_signal_add_emission_hook (signals[STRING_CHANGED], 0, string_hook, strings, NULL);
+  g_signal_emit (emitter, signals[STRING_CHANGED], 0, string);
+  g_assert_cmpstr (strings[3], ==, "second");
+
+  g_free (string);
+  g_object_unref (emitter);
+}
+
+typedef struct {
+  int    n_emissions;
+  gulong handler_id;
+} ConnectData;
+
+static gpointer
+connect_thread (gpointer data)
+{
+  ConnectData *cdata = data;
+  Emitter *emitter;
+  int count = 0;
+  int i;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+  cdata->handler_id = g_signal_connect (emitter, "changed", G_CALLBACK (count_cb), &count);
+  for (i = 0; i < cdata->n_emissions; i++)
+    g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, cdata->n_emissions);
+  g_assert (g_signal_handler_is_connected (emitter, cdata->handler_id));
+  g_signal_handler_disconnect (emitter, cdata->handler_id);
+  g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_assert_cmpint (count, ==, cdata->n_emissions);
+  g_object_unref (emitter);
+
+  return NULL;
+}
+
+static void
+test_connect_threaded (void)
+{
+  ConnectData cdata[4];
+  GThread *threads[4];
+  int i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+      cdata[i].n_emissions = 10000;
+      threads[i] = g_thread_create (connect_thread, &cdata[i], TRUE, NULL);
+    }
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+
+  /* handler ids stay unique across instances */
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    for (j = i + 1; j < G_N_ELEMENTS (threads); j++)
+      g_assert_cmpuint (cdata[i].handler_id, !=, cdata[j].handler_id);
+}
+
+/* --- benchmarks --- */
+static void
+test_emit_perf (void)
+{
+  Emitter *emitter;
+  double elapsed;
+  int count = 0;
+  int i;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+
+  g_test_timer_start ();
+  for (i = 0; i < N_EMISSIONS; i++)
+    g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (N_EMISSIONS / elapsed,
+                           "unhandled emissions per second: %.0f",
+                           N_EMISSIONS / elapsed);
+
+  g_test_timer_start ();
+  for (i = 0; i < N_EMISSIONS; i++)
+    g_signal_emit (emitter, signals[HANDLED], 0, 1);
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (N_EMISSIONS / elapsed,
+                           "class handled emissions per second: %.0f",
+                           N_EMISSIONS / elapsed);
+
+  g_signal_connect (emitter, "changed", G_CALLBACK (count_cb), &count);
+  g_test_timer_start ();
+  for (i = 0; i < N_EMISSIONS; i++)
+    g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (N_EMISSIONS / elapsed,
+                           "handled emissions per second: %.0f",
+                           N_EMISSIONS / elapsed);
+  g_assert_cmpint (count, ==, N_EMISSIONS);
+
+  g_object_unref (emitter);
+}
+
+static gpointer
+emit_thread (gpointer data)
+{
+  Emitter *emitter;
+  int i;
+
+  emitter = g_object_new (emitter_get_type (), NULL);
+  for (i = 0; i < N_EMISSIONS; i++)
+    g_signal_emit (emitter, signals[CHANGED], 0, 1);
+  g_object_unref (emitter);
+
+  return NULL;
+}
+
+static void
+test_emit_threaded_perf (void)
+{
+  ConnectData cdata[4];
+  GThread *threads[4];
+  double elapsed;
+  int i;
+
+  g_test_timer_start ();
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_create (emit_thread, NULL, TRUE, NULL);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+  elapsed = g_test_timer_elapsed ();
+
+  g_test_maximized_result (G_N_ELEMENTS (threads) * N_EMISSIONS / elapsed,
+                           "unhandled emissions per second in %d threads: %.0f",
+                           (int) G_N_ELEMENTS (threads),
+                           G_N_ELEMENTS (threads) * N_EMISSIONS / elapsed);
+
+  g_test_timer_start ();
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    {
+      cdata[i].n_emissions = N_EMISSIONS;
+      threads[i] = g_thread_create (connect_thread, &cdata[i], TRUE, NULL);
+    }
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+  elapsed = g_test_timer_elapsed ();
+
+  g_test_maximized_result (G_N_ELEMENTS (threads) * N_EMISSIONS / elapsed,
+                           "handled emissions per second in %d threads: %.0f",
+                           (int) G_N_ELEMENTS (threads),
+                           G_N_ELEMENTS (threads) * N_EMISSIONS / elapsed);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+  g_type_init ();
+
+  g_test_add_func ("/signals/emit/no-handlers", test_emit_no_handlers);
+  g_test_add_func ("/signals/emit/invalid-closure", test_emit_invalid_closure);
+  g_test_add_func ("/signals/emit/class-handler", test_emit_class_handler);
+  g_test_add_func ("/signals/emit/hook", test_emit_hook);
+  g_test_add_func ("/signals/emit/valist", test_emit_valist);
+  g_test_add_func ("/signals/connect/threaded", test_connect_threaded);
+  if (g_test_perf ())
+    {
+      g_test_add_func ("/signals/perf/emit", test_emit_perf);
+      g_test_add_func ("/signals/perf/emit-threaded", test_emit_threaded_perf);
+    }
+
+  return g_test_run ();
+}
@@ -227,6 +227,68 @@ test_threaded_object_init (void)
   g_thread_join (creator);
 }
 
+typedef GObject         MyTester3;
+typedef GObjectClass    MyTester3Class;
+G_DEFINE_TYPE_WITH_CODE (MyTester3, my_tester3, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (my_face0_get_type(), NULL);
+                         );
+static void my_tester3_init (MyTester3*t) {}
+static void my_tester3_class_init (MyTester3Class*c) {}
+
+#define NUM_ADDED_INTERFACES 64
+
+static volatile int is_a_checks_done = 0;
+
+static gpointer
+is_a_check_thread (gpointer data)
+{
+  GTypeInstance *instance = data;
+  /* the interface entries of the type get replaced under our feet */
+  while (!g_atomic_int_get (&is_a_checks_done))
+    {
+      g_assert (g_type_check_instance_is_a (instance, my_face0_get_type()));
+      g_assert (g_type_check_instance_is_a (instance, G_TYPE_OBJECT));
+      g_assert (!g_type_check_instance_is_a (instance, my_face1_get_type()));
+      g_assert (g_type_interface_peek (instance->g_class, my_face0_get_type()) != NULL);
+      g_assert (G_IS_OBJECT (g_type_check_instance_cast (instance, my_tester3_get_type())));
+    }
+  return NULL;
+}
+
+static void
+test_threaded_is_a (void)
+{
+  const GInterfaceInfo iface_info = { NULL, NULL, NULL };
+  GThread *threads[3];
+  GObject *object;
+  GType ifaces[NUM_ADDED_INTERFACES];
+  int i;
+
+  object = g_object_new (my_tester3_get_type(), NULL);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    threads[i] = g_thread_create (is_a_check_thread, object, TRUE, NULL);
+
+  for (i = 0; i < NUM_ADDED_INTERFACES; i++)
+    {
+      gchar *name = g_strdup_printf ("MyAddedFace%d", i);
+      ifaces[i] = g_type_register_static_simple (G_TYPE_INTERFACE, name, sizeof (GTypeInterface),
+                                                 NULL, 0, NULL, 0);
+      g_free (name);
+      g_type_add_interface_static (my_tester3_get_type(), ifaces[i], &iface_info);
+      g_thread_yield();
+    }
+
+  g_atomic_int_set (&is_a_checks_done, TRUE);
+  for (i = 0; i < G_N_ELEMENTS (threads); i++)
+    g_thread_join (threads[i]);
+
+  for (i = 0; i < NUM_ADDED_INTERFACES; i++)
+    g_assert (g_type_is_a (my_tester3_get_type(), ifaces[i]));
+  g_assert (g_type_class_peek (my_tester3_get_type()) == G_OBJECT_GET_CLASS (object));
+  g_assert (g_type_class_peek_static (my_tester3_get_type()) == G_OBJECT_GET_CLASS (object));
+  g_object_unref (object);
+}
+
 int
 main (int   argc,
       char *argv[])
@@ -240,6 +302,7 @@ main (int   argc,
 
   g_test_add_func ("/GObject/threaded-class-init", test_threaded_class_init);
   g_test_add_func ("/GObject/threaded-object-init", test_threaded_object_init);
+  g_test_add_func ("/GType/threaded-is-a", test_threaded_is_a);
 
   return g_test_run();
 }
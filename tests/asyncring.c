@@ -0,0 +1,229 @@
+/* Unit tests for GAsyncRing
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib.h>
+
+static void
+test_basic (void)
+{
+  GAsyncRing *ring;
+  guint i;
+
+  ring = g_async_ring_new (3);
+  g_assert_cmpuint (g_async_ring_get_capacity (ring), ==, 4);
+  g_assert_cmpuint (g_async_ring_length (ring), ==, 0);
+  g_assert (g_async_ring_try_pop (ring) == NULL);
+
+  for (i = 1; i <= 4; i++)
+    g_assert (g_async_ring_try_push (ring, GUINT_TO_POINTER (i)));
+  g_assert (!g_async_ring_try_push (ring, GUINT_TO_POINTER (5)));
+  g_assert_cmpuint (g_async_ring_length (ring), ==, 4);
+
+  /* first in, first out, also across the wrap-around */
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_async_ring_pop (ring)), ==, 1);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_async_ring_pop (ring)), ==, 2);
+  g_async_ring_push (ring, GUINT_TO_POINTER (5));
+  g_async_ring_push (ring, GUINT_TO_POINTER (6));
+
+  for (i = 3; i <= 6; i++)
+    g_assert_cmpuint (GPOINTER_TO_UINT (g_async_ring_try_pop (ring)), ==, i);
+  g_assert_cmpuint (g_async_ring_length (ring), ==, 0);
+
+  g_async_ring_unref (ring);
+}
+
+static void
+test_many (void)
+{
+  GAsyncRing *ring;
+  gpointer in[10], out[10];
+  guint i, n;
+
+  ring = g_async_ring_new (8);
+
+  for (i = 0; i < G_N_ELEMENTS (in); i++)
+    in[i] = GUINT_TO_POINTER (i + 1);
+
+  g_async_ring_push_many (ring, in, 6);
+  g_assert_cmpuint (g_async_ring_length (ring), ==, 6);
+
+  n = g_async_ring_pop_many (ring, out, 4);
+  g_assert_cmpuint (n, ==, 4);
+  for (i = 0; i < n; i++)
+    g_assert (out[i] == in[i]);
+
+  /* only what is there is returned */
+  n = g_async_ring_try_pop_many (ring, out, G_N_ELEMENTS (out));
+  g_assert_cmpuint (n, ==, 2);
+  g_assert (out[0] == in[4]);
+  g_assert (out[1] == in[5]);
+
+  g_assert_cmpuint (g_async_ring_try_pop_many (ring, out, 1), ==, 0);
+
+  g_async_ring_unref (ring);
+}
+
+static void
+test_timed_pop (void)
+{
+  GAsyncRing *ring;
+  GTimeVal end_time;
+
+  ring = g_async_ring_new (2);
+
+  g_get_current_time (&end_time);
+  g_time_val_add (&end_time, 10 * 1000);
+  g_assert (g_async_ring_timed_pop (ring, &end_time) == NULL);
+
+  g_async_ring_push (ring, ring);
+  g_get_current_time (&end_time);
+  g_assert (g_async_ring_timed_pop (ring, &end_time) == ring);
+
+  g_async_ring_unref (ring);
+}
+
+static gint n_freed;
+
+static void
+count_free (gpointer data)
+{
+  n_freed++;
+}
+
+static void
+test_free_func (void)
+{
+  GAsyncRing *ring;
+
+  ring = g_async_ring_new_full (4, count_free);
+  g_async_ring_push (ring, ring);
+  g_async_ring_push (ring, ring);
+  g_async_ring_ref (ring);
+  g_async_ring_unref (ring);
+  g_assert_cmpint (n_freed, ==, 0);
+  g_async_ring_unref (ring);
+  g_assert_cmpint (n_freed, ==, 2);
+}
+
+#define N_THREADS 4
+#define N_ITEMS 100000
+#define BATCH 7
+
+static gpointer
+producer (gpointer data)
+{
+  GAsyncRing *ring = data;
+  gpointer batch[BATCH];
+  guint i, n = 0;
+
+  for (i = 1; i <= N_ITEMS; i++)
+    {
+      if (i % 3 == 0)
+	{
+	  g_async_ring_push (ring, GUINT_TO_POINTER (i));
+	  continue;
+	}
+
+      batch[n++] = GUINT_TO_POINTER (i);
+      if (n == BATCH)
+	{
+	  g_async_ring_push_many (ring, batch, n);
+	  n = 0;
+	}
+    }
+  g_async_ring_push_many (ring, batch, n);
+
+  return NULL;
+}
+
+static gpointer
+consumer (gpointer data)
+{
+  GAsyncRing *ring = data;
+  gpointer batch[BATCH];
+  guint64 sum = 0;
+  guint i, n, count = 0;
+
+  /* every consumer gets its share of items, whatever the producers do */
+  while (count < N_ITEMS)
+    {
+      if (count % 2)
+	{
+	  sum += GPOINTER_TO_UINT (g_async_ring_pop (ring));
+	  count++;
+	  continue;
+	}
+
+      n = g_async_ring_pop_many (ring, batch, MIN (BATCH, N_ITEMS - count));
+      g_assert_cmpuint (n, >, 0);
+      for (i = 0; i < n; i++)
+	sum += GPOINTER_TO_UINT (batch[i]);
+      count += n;
+    }
+
+  return g_memdup (&sum, sizeof (sum));
+}
+
+static void
+test_threads (void)
+{
+  GThread *producers[N_THREADS], *consumers[N_THREADS];
+  GAsyncRing *ring;
+  guint64 sum = 0, *partial;
+  guint i;
+
+  /* small enough for both sides to block now and then */
+  ring = g_async_ring_new (16);
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      consumers[i] = g_thread_create (consumer, ring, TRUE, NULL);
+      producers[i] = g_thread_create (producer, ring, TRUE, NULL);
+    }
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      g_thread_join (producers[i]);
+      partial = g_thread_join (consumers[i]);
+      sum += *partial;
+      g_free (partial);
+    }
+
+  g_assert_cmpuint (sum, ==, (guint64) N_THREADS * N_ITEMS * (N_ITEMS + 1) / 2);
+  g_assert_cmpuint (g_async_ring_length (ring), ==, 0);
+
+  g_async_ring_unref (ring);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/asyncring/basic", test_basic);
+  g_test_add_func ("/asyncring/many", test_many);
+  g_test_add_func ("/asyncring/timed-pop", test_timed_pop);
+  g_test_add_func ("/asyncring/free-func", test_free_func);
+  g_test_add_func ("/asyncring/threads", test_threads);
+
+  return g_test_run();
+}
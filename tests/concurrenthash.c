@@ -0,0 +1,305 @@
+/* Unit tests for GConcurrentHashTable
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <string.h>
+
+#include <glib.h>
+
+static volatile gint n_keys_destroyed;
+static volatile gint n_values_destroyed;
+
+static void
+count_key (gpointer data)
+{
+  g_atomic_int_inc (&n_keys_destroyed);
+}
+
+static void
+count_value (gpointer data)
+{
+  g_atomic_int_inc (&n_values_destroyed);
+}
+
+static void
+test_basic (void)
+{
+  GConcurrentHashTable *table;
+  gpointer key, value;
+  guint i;
+
+  table = g_concurrent_hash_table_new (g_str_hash, g_str_equal);
+
+  g_assert (g_concurrent_hash_table_lookup (table, "a") == NULL);
+  g_concurrent_hash_table_insert (table, "a", "1");
+  g_concurrent_hash_table_insert (table, "b", "2");
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 2);
+  g_assert_cmpstr (g_concurrent_hash_table_lookup (table, "a"), ==, "1");
+  g_assert_cmpstr (g_concurrent_hash_table_lookup (table, "b"), ==, "2");
+
+  g_concurrent_hash_table_insert (table, "a", "3");
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 2);
+  g_assert (g_concurrent_hash_table_lookup_extended (table, "a", &key, &value));
+  g_assert_cmpstr (key, ==, "a");
+  g_assert_cmpstr (value, ==, "3");
+  g_assert (!g_concurrent_hash_table_lookup_extended (table, "c", NULL, NULL));
+
+  g_assert (g_concurrent_hash_table_remove (table, "a"));
+  g_assert (!g_concurrent_hash_table_remove (table, "a"));
+  g_assert (g_concurrent_hash_table_steal (table, "b"));
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 0);
+
+  g_concurrent_hash_table_unref (table);
+
+  /* growing */
+  table = g_concurrent_hash_table_new (NULL, NULL);
+
+  for (i = 1; i <= 10000; i++)
+    g_concurrent_hash_table_insert (table, GUINT_TO_POINTER (i), GUINT_TO_POINTER (i + 1));
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 10000);
+
+  for (i = 1; i <= 10000; i++)
+    g_assert (g_concurrent_hash_table_lookup (table, GUINT_TO_POINTER (i)) == GUINT_TO_POINTER (i + 1));
+
+  for (i = 1; i <= 10000; i += 2)
+    g_assert (g_concurrent_hash_table_remove (table, GUINT_TO_POINTER (i)));
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 5000);
+
+  for (i = 1; i <= 10000; i++)
+    g_assert (g_concurrent_hash_table_lookup (table, GUINT_TO_POINTER (i)) ==
+	      (i % 2 ? NULL : GUINT_TO_POINTER (i + 1)));
+
+  g_concurrent_hash_table_unref (table);
+}
+
+static void
+test_destroy (void)
+{
+  GConcurrentHashTable *table;
+  gchar *keys[1000];
+  guint i;
+
+  n_keys_destroyed = n_values_destroyed = 0;
+  table = g_concurrent_hash_table_new_full (g_str_hash, g_str_equal,
+					    count_key, count_value);
+
+  for (i = 0; i < 1000; i++)
+    {
+      keys[i] = g_strdup_printf ("key-%u", i);
+      g_concurrent_hash_table_insert (table, keys[i], keys[i]);
+    }
+
+  /* a new key that isn't needed is freed right away */
+  g_concurrent_hash_table_insert (table, "key-1", NULL);
+  g_assert_cmpint (n_keys_destroyed, ==, 1);
+
+  g_concurrent_hash_table_replace (table, "key-2", NULL);
+  g_assert (g_concurrent_hash_table_remove (table, "key-3"));
+  g_assert (g_concurrent_hash_table_steal (table, "key-4"));
+  g_assert (g_concurrent_hash_table_lookup (table, "key-1") == NULL);
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 998);
+
+  /* everything else is freed by now */
+  g_concurrent_hash_table_unref (table);
+  g_assert_cmpint (n_keys_destroyed, ==, 1 + 1 + 998 + 1);
+  g_assert_cmpint (n_values_destroyed, ==, 1 + 1 + 998 + 1);
+
+  for (i = 0; i < 1000; i++)
+    g_free (keys[i]);
+}
+
+static void
+test_iter (void)
+{
+  GConcurrentHashTable *table;
+  GConcurrentHashTableIter iter;
+  gpointer key, value;
+  guint seen[2001];
+  guint i, n, n_inserted;
+
+  n_keys_destroyed = n_values_destroyed = 0;
+  table = g_concurrent_hash_table_new_full (NULL, NULL, count_key, count_value);
+
+  for (i = 1; i <= 1000; i++)
+    g_concurrent_hash_table_insert (table, GUINT_TO_POINTER (i), GUINT_TO_POINTER (i));
+
+  /* removing and adding keys, which also makes the table grow,
+   * while iterating
+   */
+  memset (seen, 0, sizeof (seen));
+  n = n_inserted = 0;
+  g_concurrent_hash_table_iter_init (&iter, table);
+  while (g_concurrent_hash_table_iter_next (&iter, &key, &value))
+    {
+      i = GPOINTER_TO_UINT (key);
+      g_assert (key == value);
+      g_assert_cmpuint (i, <=, 2000);
+      seen[i]++;
+
+      if (i <= 1000 && n++ < 500)
+	{
+	  g_assert (g_concurrent_hash_table_remove (table, GUINT_TO_POINTER (1001 - i)));
+	  g_concurrent_hash_table_insert (table, GUINT_TO_POINTER (1000 + i), GUINT_TO_POINTER (1000 + i));
+	  n_inserted++;
+	}
+    }
+
+  /* nothing removed is freed during the iteration */
+  g_assert_cmpint (n_values_destroyed, ==, 0);
+  g_assert (!g_concurrent_hash_table_iter_next (&iter, &key, &value));
+
+  for (i = 1; i <= 2000; i++)
+    {
+      if (g_concurrent_hash_table_lookup (table, GUINT_TO_POINTER (i)) && i <= 1000)
+	g_assert_cmpuint (seen[i], ==, 1);
+      else
+	g_assert_cmpuint (seen[i], <=, 1);
+    }
+
+  /* stopping early */
+  g_concurrent_hash_table_iter_init (&iter, table);
+  g_assert (g_concurrent_hash_table_iter_next (&iter, &key, &value));
+  g_concurrent_hash_table_iter_clear (&iter);
+  g_concurrent_hash_table_iter_clear (&iter);
+
+  g_assert_cmpuint (g_concurrent_hash_table_size (table), ==, 1000 - n + n_inserted);
+  g_concurrent_hash_table_unref (table);
+  g_assert_cmpint (n_keys_destroyed, ==, 1000 + n_inserted);
+  g_assert_cmpint (n_values_destroyed, ==, 1000 + n_inserted);
+}
+
+#define N_THREADS 4
+#define N_KEYS 2000
+#define N_ITERATIONS 200000
+
+static GConcurrentHashTable *shared_table;
+static volatile gint writers_done;
+
+/* keys are always stored with a value that is a multiple of them,
+ * so that readers can tell that they got a matching pair
+ */
+static gpointer
+writer_thread (gpointer data)
+{
+  guint seed = GPOINTER_TO_UINT (data);
+  guint i, key;
+
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      key = (seed + i * 7) % N_KEYS + 1;
+
+      switch (i % 4)
+	{
+	case 0:
+	case 1:
+	  g_concurrent_hash_table_insert (shared_table, GUINT_TO_POINTER (key),
+					  GUINT_TO_POINTER (key * (i % 5 + 1)));
+	  break;
+	case 2:
+	  g_concurrent_hash_table_replace (shared_table, GUINT_TO_POINTER (key),
+					   GUINT_TO_POINTER (key * 7));
+	  break;
+	case 3:
+	  g_concurrent_hash_table_remove (shared_table, GUINT_TO_POINTER (key));
+	  break;
+	}
+    }
+
+  g_atomic_int_inc (&writers_done);
+
+  return NULL;
+}
+
+static gpointer
+reader_thread (gpointer data)
+{
+  guint seed = GPOINTER_TO_UINT (data);
+  guint i = 0;
+
+  while (g_atomic_int_get (&writers_done) < N_THREADS)
+    {
+      GConcurrentHashTableIter iter;
+      gpointer key, value;
+      guint k;
+
+      for (k = 1; k <= N_KEYS; k++)
+	{
+	  value = g_concurrent_hash_table_lookup (shared_table, GUINT_TO_POINTER (k));
+	  g_assert (GPOINTER_TO_UINT (value) % k == 0);
+	}
+
+      if (i++ % 4 == seed % 4)
+	{
+	  g_concurrent_hash_table_iter_init (&iter, shared_table);
+	  while (g_concurrent_hash_table_iter_next (&iter, &key, &value))
+	    {
+	      g_assert_cmpuint (GPOINTER_TO_UINT (key), >=, 1);
+	      g_assert_cmpuint (GPOINTER_TO_UINT (key), <=, N_KEYS);
+	      g_assert (GPOINTER_TO_UINT (value) % GPOINTER_TO_UINT (key) == 0);
+	    }
+	}
+    }
+
+  return NULL;
+}
+
+static void
+test_threads (void)
+{
+  GThread *writers[N_THREADS], *readers[N_THREADS];
+  guint i, k;
+
+  shared_table = g_concurrent_hash_table_new (NULL, NULL);
+  writers_done = 0;
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      readers[i] = g_thread_create (reader_thread, GUINT_TO_POINTER (i), TRUE, NULL);
+      writers[i] = g_thread_create (writer_thread, GUINT_TO_POINTER (i * 331), TRUE, NULL);
+    }
+
+  for (i = 0; i < N_THREADS; i++)
+    {
+      g_thread_join (writers[i]);
+      g_thread_join (readers[i]);
+    }
+
+  /* the size is exact again once all writers are done */
+  for (i = 0, k = 1; k <= N_KEYS; k++)
+    if (g_concurrent_hash_table_lookup (shared_table, GUINT_TO_POINTER (k)))
+      i++;
+  g_assert_cmpuint (g_concurrent_hash_table_size (shared_table), ==, i);
+
+  g_concurrent_hash_table_unref (shared_table);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/concurrenthash/basic", test_basic);
+  g_test_add_func ("/concurrenthash/destroy", test_destroy);
+  g_test_add_func ("/concurrenthash/iter", test_iter);
+  g_test_add_func ("/concurrenthash/threads", test_threads);
+
+  return g_test_run();
+}
@@ -0,0 +1,220 @@
+/* Unit tests for GData and datasets
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib.h>
+
+static gint n_destroyed;
+
+static void
+count_destroy (gpointer data)
+{
+  n_destroyed++;
+}
+
+static void
+test_datalist_basic (void)
+{
+  GData *list;
+  GQuark keys[10];
+  gchar name[32];
+  guint i;
+
+  g_datalist_init (&list);
+  n_destroyed = 0;
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+      g_snprintf (name, sizeof (name), "dataset-test-%u", i);
+      keys[i] = g_quark_from_string (name);
+    }
+
+  /* growing beyond a few entries */
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    g_datalist_id_set_data_full (&list, keys[i], GUINT_TO_POINTER (i + 1),
+				 count_destroy);
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    g_assert_cmpuint (GPOINTER_TO_UINT (g_datalist_id_get_data (&list, keys[i])), ==, i + 1);
+
+  /* replacing notifies */
+  g_datalist_id_set_data (&list, keys[0], GUINT_TO_POINTER (42));
+  g_assert_cmpint (n_destroyed, ==, 1);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_datalist_id_get_data (&list, keys[0])), ==, 42);
+
+  /* stealing doesn't */
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_datalist_id_remove_no_notify (&list, keys[1])), ==, 2);
+  g_assert_cmpint (n_destroyed, ==, 1);
+  g_assert (g_datalist_id_get_data (&list, keys[1]) == NULL);
+
+  /* removing does, and shrinks the list again */
+  for (i = 2; i < G_N_ELEMENTS (keys) - 1; i++)
+    g_datalist_id_remove_data (&list, keys[i]);
+  g_assert_cmpint (n_destroyed, ==, 8);
+  g_assert_cmpuint (GPOINTER_TO_UINT (g_datalist_id_get_data (&list, keys[9])), ==, 10);
+
+  g_datalist_clear (&list);
+  g_assert_cmpint (n_destroyed, ==, 9);
+  g_assert (list == NULL);
+}
+
+static void
+test_datalist_flags (void)
+{
+  GData *list;
+  GQuark key;
+
+  g_datalist_init (&list);
+  key = g_quark_from_string ("dataset-test-flags");
+
+  g_datalist_set_flags (&list, 1);
+  g_datalist_id_set_data (&list, key, &list);
+  g_assert_cmpuint (g_datalist_get_flags (&list), ==, 1);
+  g_assert (g_datalist_id_get_data (&list, key) == &list);
+
+  g_datalist_set_flags (&list, 2);
+  g_datalist_unset_flags (&list, 1);
+  g_assert_cmpuint (g_datalist_get_flags (&list), ==, 2);
+  g_assert (g_datalist_id_get_data (&list, key) == &list);
+
+  g_datalist_clear (&list);
+  g_assert_cmpuint (g_datalist_get_flags (&list), ==, 2);
+}
+
+static void
+remove_while_iterating (GQuark   key,
+			gpointer data,
+			gpointer user_data)
+{
+  GData **list = user_data;
+
+  /* drop the next one, it must not be visited */
+  g_datalist_id_remove_data (list, GPOINTER_TO_UINT (data));
+  n_destroyed++;
+}
+
+static void
+test_datalist_foreach (void)
+{
+  GData *list;
+  GQuark a, b, c;
+
+  g_datalist_init (&list);
+  a = g_quark_from_string ("dataset-test-a");
+  b = g_quark_from_string ("dataset-test-b");
+  c = g_quark_from_string ("dataset-test-c");
+
+  g_datalist_id_set_data (&list, a, GUINT_TO_POINTER (b));
+  g_datalist_id_set_data (&list, b, GUINT_TO_POINTER (c));
+  g_datalist_id_set_data (&list, c, GUINT_TO_POINTER (a));
+
+  /* newest first: c drops a, b drops c */
+  n_destroyed = 0;
+  g_datalist_foreach (&list, remove_while_iterating, &list);
+  g_assert_cmpint (n_destroyed, ==, 2);
+  g_assert (g_datalist_id_get_data (&list, a) == NULL);
+  g_assert (g_datalist_id_get_data (&list, b) == GUINT_TO_POINTER (c));
+  g_assert (g_datalist_id_get_data (&list, c) == NULL);
+
+  g_datalist_clear (&list);
+}
+
+static void
+test_dataset (void)
+{
+  static gint location;
+  GQuark key;
+
+  key = g_quark_from_string ("dataset-test-location");
+  n_destroyed = 0;
+
+  g_dataset_id_set_data_full (&location, key, &location, count_destroy);
+  g_assert (g_dataset_id_get_data (&location, key) == &location);
+
+  g_dataset_id_remove_data (&location, key);
+  g_assert_cmpint (n_destroyed, ==, 1);
+  g_assert (g_dataset_id_get_data (&location, key) == NULL);
+
+  g_dataset_id_set_data_full (&location, key, &location, count_destroy);
+  g_dataset_destroy (&location);
+  g_assert_cmpint (n_destroyed, ==, 2);
+  g_assert (g_dataset_id_get_data (&location, key) == NULL);
+}
+
+#define N_THREADS 8
+#define N_ITERATIONS 20000
+
+static gpointer
+datalist_thread (gpointer data)
+{
+  GData *list;
+  GQuark keys[6];
+  guint i, j;
+
+  g_datalist_init (&list);
+  for (j = 0; j < G_N_ELEMENTS (keys); j++)
+    {
+      gchar name[32];
+
+      g_snprintf (name, sizeof (name), "dataset-test-thread-%u", j);
+      keys[j] = g_quark_from_string (name);
+    }
+
+  for (i = 0; i < N_ITERATIONS; i++)
+    {
+      j = i % G_N_ELEMENTS (keys);
+
+      g_datalist_id_set_data (&list, keys[j], GUINT_TO_POINTER (i + 1));
+      g_assert (g_datalist_id_get_data (&list, keys[j]) == GUINT_TO_POINTER (i + 1));
+      if (i % 3 == 0)
+	g_datalist_id_remove_data (&list, keys[(j + 1) % G_N_ELEMENTS (keys)]);
+    }
+
+  g_datalist_clear (&list);
+
+  return NULL;
+}
+
+static void
+test_datalist_threads (void)
+{
+  GThread *threads[N_THREADS];
+  guint i;
+
+  for (i = 0; i < N_THREADS; i++)
+    threads[i] = g_thread_create (datalist_thread, NULL, TRUE, NULL);
+
+  for (i = 0; i < N_THREADS; i++)
+    g_thread_join (threads[i]);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/datalist/basic", test_datalist_basic);
+  g_test_add_func ("/datalist/flags", test_datalist_flags);
+  g_test_add_func ("/datalist/foreach", test_datalist_foreach);
+  g_test_add_func ("/datalist/threads", test_datalist_threads);
+  g_test_add_func ("/dataset/basic", test_dataset);
+
+  return g_test_run();
+}
@@ -378,6 +378,100 @@ static void direct_hash_test (void)
 }
 
 
+static gint destroy_counter;
+
+static void
+count_destroy (gpointer data)
+{
+  destroy_counter++;
+}
+
+/* keys that are their own values don't need separate storage, until
+ * the first value that isn't
+ */
+static void set_hash_test (void)
+{
+     gint       i;
+     GHashTable     *h;
+     gpointer   key, value;
+
+     h = g_hash_table_new_full (NULL, NULL, count_destroy, NULL);
+     destroy_counter = 0;
+
+     for (i = 1; i <= 100; i++)
+          g_hash_table_insert (h, GINT_TO_POINTER (i), GINT_TO_POINTER (i));
+
+     g_assert (g_hash_table_size (h) == 100);
+     for (i = 1; i <= 100; i++)
+          g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (i)) == GINT_TO_POINTER (i));
+
+     /* inserting an existing key destroys the new key */
+     g_hash_table_insert (h, GINT_TO_POINTER (5), GINT_TO_POINTER (5));
+     g_assert (destroy_counter == 1);
+
+     /* the first real value */
+     g_hash_table_replace (h, GINT_TO_POINTER (7), GINT_TO_POINTER (700));
+     g_assert (destroy_counter == 2);
+     g_hash_table_insert (h, GINT_TO_POINTER (1000), GINT_TO_POINTER (2000));
+
+     for (i = 1; i <= 100; i++)
+          {
+          g_assert (g_hash_table_lookup_extended (h, GINT_TO_POINTER (i), &key, &value));
+          g_assert (key == GINT_TO_POINTER (i));
+          g_assert (value == GINT_TO_POINTER (i == 7 ? 700 : i));
+          }
+     g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (1000)) == GINT_TO_POINTER (2000));
+
+     /* values survive growing and shrinking */
+     for (i = 101; i <= 1000; i++)
+          g_hash_table_insert (h, GINT_TO_POINTER (i), GINT_TO_POINTER (i));
+     for (i = 2; i <= 1000; i++)
+          if (i != 7)
+               g_hash_table_remove (h, GINT_TO_POINTER (i));
+
+     g_assert (g_hash_table_size (h) == 2);
+     g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (1)) == GINT_TO_POINTER (1));
+     g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (7)) == GINT_TO_POINTER (700));
+
+    g_hash_table_destroy (h);
+}
+
+/* many inserts and removes at a stable size, which fills the table
+ * with tombstones that have to be cleaned up along the way
+ */
+static void churn_hash_test (void)
+{
+     gint       i, j;
+     GHashTable     *h;
+     gboolean   present[512];
+
+     h = g_hash_table_new (NULL, NULL);
+     memset (present, 0, sizeof (present));
+
+     for (i = 0; i < 200000; i++)
+          {
+          j = (i * 7919) % 512;
+
+          if (present[j])
+               g_assert (g_hash_table_remove (h, GINT_TO_POINTER (j + 1)));
+          else
+               g_hash_table_insert (h, GINT_TO_POINTER (j + 1), GINT_TO_POINTER (j + 2));
+          present[j] = !present[j];
+
+          if (i % 1000 == 0)
+               for (j = 0; j < 512; j++)
+                    g_assert (g_hash_table_lookup (h, GINT_TO_POINTER (j + 1)) ==
+                              (present[j] ? GINT_TO_POINTER (j + 2) : NULL));
+          }
+
+     for (i = 0, j = 0; j < 512; j++)
+          if (present[j])
+               i++;
+     g_assert (g_hash_table_size (h) == i);
+
+    g_hash_table_destroy (h);
+}
+
 
 int
 main (int   argc,
@@ -453,6 +547,8 @@ main (int   argc,
   second_hash_test (TRUE);
   second_hash_test (FALSE);
   direct_hash_test ();
+  set_hash_test ();
+  churn_hash_test ();
 
   return 0;
 
@@ -24,6 +24,7 @@
 #include <unistd.h>
 #endif
 #include <sys/types.h>
+#include <fcntl.h>
 #include <signal.h>
 
 #include "glib.h"
@@ -134,6 +135,26 @@ test_mapping (void)
   g_mapped_file_free (map);
 }
 
+static void
+test_mapping_fd (void)
+{
+  GError *error = NULL;
+  GMappedFile *map;
+  int fd;
+
+  write_or_die (filename, "ABCDEF", -1);
+
+  fd = g_open (filename, O_RDONLY, 0);
+  g_assert (fd != -1);
+  map = g_mapped_file_new_from_fd (fd, FALSE, &error);
+  g_assert (error == NULL);
+  close (fd);
+
+  g_assert (g_mapped_file_get_length (map) == 6);
+  g_assert (strncmp (g_mapped_file_get_contents (map), "ABCDEF", 6) == 0);
+  g_mapped_file_free (map);
+}
+
 static void 
 test_private (void)
 {
@@ -231,6 +252,9 @@ parent_main (int   argc,
   /* test mapping with various flag combinations */
   test_mapping ();
 
+  /* test mapping an open file */
+  test_mapping_fd ();
+
   /* test private modification */
   test_private ();
 
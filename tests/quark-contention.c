@@ -0,0 +1,124 @@
+/* quark-contention.c - measure quark lookups from many threads
+ *
+ * Looks up already existing quarks with g_quark_from_string(),
+ * g_quark_try_string() and g_intern_string() from 1, 2, 4, ...
+ * N_THREADS threads at once. Lookups don't take a lock, so the
+ * throughput should grow with the number of threads.
+ *
+ * Usage: quark-contention [N_THREADS [N_LOOKUPS]]
+ */
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <glib.h>
+
+#define N_NAMES 1000
+
+static gchar *names[N_NAMES];
+static GQuark quarks[N_NAMES];
+static gint n_lookups = 1000000;
+
+static gint n_ready;
+static volatile gint go;
+
+static gpointer
+lookup_thread (gpointer data)
+{
+  guint seed = GPOINTER_TO_UINT (data);
+  gint i, j;
+
+  g_atomic_int_inc (&n_ready);
+  while (!g_atomic_int_get (&go))
+    g_thread_yield ();
+
+  for (i = 0; i < n_lookups; i++)
+    {
+      j = (seed + i * 7) % N_NAMES;
+
+      switch (i % 3)
+	{
+	case 0:
+	  g_assert (g_quark_from_string (names[j]) == quarks[j]);
+	  break;
+	case 1:
+	  g_assert (g_quark_try_string (names[j]) == quarks[j]);
+	  break;
+	case 2:
+	  g_assert (g_intern_string (names[j]) == g_quark_to_string (quarks[j]));
+	  break;
+	}
+    }
+
+  return NULL;
+}
+
+static void
+run (gint n_threads)
+{
+  GThread **threads;
+  GTimer *timer;
+  gdouble elapsed;
+  gint i;
+
+  threads = g_new (GThread *, n_threads);
+  n_ready = 0;
+  go = FALSE;
+
+  for (i = 0; i < n_threads; i++)
+    threads[i] = g_thread_create (lookup_thread, GINT_TO_POINTER (i * 101),
+				  TRUE, NULL);
+
+  while (g_atomic_int_get (&n_ready) < n_threads)
+    g_thread_yield ();
+
+  timer = g_timer_new ();
+  g_atomic_int_set (&go, TRUE);
+
+  for (i = 0; i < n_threads; i++)
+    g_thread_join (threads[i]);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_print ("%3d threads: %8.3f s, %12.0f lookups/s\n",
+	   n_threads, elapsed, n_threads * (gdouble) n_lookups / elapsed);
+
+  g_timer_destroy (timer);
+  g_free (threads);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gint max_threads = 8;
+  gint i;
+
+  g_thread_init (NULL);
+
+  if (argc > 1)
+    max_threads = atoi (argv[1]);
+  if (argc > 2)
+    n_lookups = atoi (argv[2]);
+
+  if (max_threads < 1 || n_lookups < 1)
+    {
+      fprintf (stderr, "usage: %s [N_THREADS [N_LOOKUPS]]\n", argv[0]);
+      return 1;
+    }
+
+  for (i = 0; i < N_NAMES; i++)
+    {
+      names[i] = g_strdup_printf ("quark-contention-%d", i);
+      quarks[i] = g_quark_from_string (names[i]);
+    }
+
+  for (i = 1; i < max_threads; i *= 2)
+    run (i);
+  run (max_threads);
+
+  return 0;
+}
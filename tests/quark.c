@@ -0,0 +1,114 @@
+/* Unit tests for GQuark
+ *
+ * This work is provided "as is"; redistribution and modification
+ * in whole or in part, in any medium, physical or electronic is
+ * permitted without restriction.
+ *
+ * This work is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * In no event shall the authors or contributors be liable for any
+ * direct, indirect, incidental, special, exemplary, or consequential
+ * damages (including, but not limited to, procurement of substitute
+ * goods or services; loss of use, data, or profits; or business
+ * interruption) however caused and on any theory of liability, whether
+ * in contract, strict liability, or tort (including negligence or
+ * otherwise) arising in any way out of the use of this software, even
+ * if advised of the possibility of such damage.
+ */
+
+#include <glib.h>
+
+static void
+test_basic (void)
+{
+  static const gchar static_name[] = "quark-test-static";
+  GQuark quark;
+  gchar *name;
+
+  g_assert (g_quark_from_string (NULL) == 0);
+  g_assert (g_quark_to_string (0) == NULL);
+
+  g_assert (g_quark_try_string ("quark-test-basic") == 0);
+  quark = g_quark_from_string ("quark-test-basic");
+  g_assert (quark != 0);
+  g_assert (g_quark_try_string ("quark-test-basic") == quark);
+  g_assert_cmpstr (g_quark_to_string (quark), ==, "quark-test-basic");
+
+  name = g_strdup ("quark-test-basic");
+  g_assert (g_quark_from_string (name) == quark);
+  g_assert (g_intern_string (name) == g_quark_to_string (quark));
+  g_free (name);
+
+  /* static strings are used as they are */
+  quark = g_quark_from_static_string (static_name);
+  g_assert (g_quark_to_string (quark) == static_name);
+  g_assert (g_intern_static_string ("quark-test-static") == static_name);
+
+  g_assert (g_quark_to_string (G_MAXUINT32) == NULL);
+}
+
+#define N_THREADS 8
+#define N_NAMES 5000
+
+static gpointer
+create_quarks (gpointer data)
+{
+  GQuark *quarks;
+  gchar name[64];
+  guint i, j;
+
+  quarks = g_new (GQuark, N_NAMES);
+
+  /* all threads create the same quarks, in different orders */
+  for (i = 0; i < N_NAMES; i++)
+    {
+      j = (i + GPOINTER_TO_UINT (data) * 997) % N_NAMES;
+      g_snprintf (name, sizeof (name), "quark-test-%u", j);
+      quarks[j] = g_quark_from_string (name);
+      g_assert_cmpstr (g_quark_to_string (quarks[j]), ==, name);
+    }
+
+  return quarks;
+}
+
+static void
+test_threads (void)
+{
+  GThread *threads[N_THREADS];
+  GQuark *quarks[N_THREADS];
+  gchar name[64];
+  guint i, j;
+
+  for (i = 0; i < N_THREADS; i++)
+    threads[i] = g_thread_create (create_quarks, GUINT_TO_POINTER (i), TRUE, NULL);
+
+  for (i = 0; i < N_THREADS; i++)
+    quarks[i] = g_thread_join (threads[i]);
+
+  for (j = 0; j < N_NAMES; j++)
+    {
+      g_snprintf (name, sizeof (name), "quark-test-%u", j);
+      g_assert (g_quark_try_string (name) == quarks[0][j]);
+
+      for (i = 1; i < N_THREADS; i++)
+	g_assert (quarks[i][j] == quarks[0][j]);
+    }
+
+  for (i = 0; i < N_THREADS; i++)
+    g_free (quarks[i]);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_thread_init (NULL);
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/quark/basic", test_basic);
+  g_test_add_func ("/quark/threads", test_threads);
+
+  return g_test_run();
+}
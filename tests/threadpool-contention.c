@@ -0,0 +1,184 @@
+/* threadpool-contention.c - measure the cost of pushing many tiny tasks
+ *
+ * Compares a pool created with g_thread_pool_new() against one created
+ * with g_thread_pool_new_work_stealing(), and g_thread_pool_push()
+ * against g_thread_pool_push_many().
+ *
+ * Usage: threadpool-contention [N_THREADS [N_TASKS]]
+ */
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <glib.h>
+
+#define BATCH_SIZE 64
+
+static gint n_done;
+
+static void
+tiny_task (gpointer data,
+	   gpointer user_data)
+{
+  volatile guint x = GPOINTER_TO_UINT (data);
+
+  x = x * 31 + 7;
+  g_atomic_int_inc (&n_done);
+}
+
+/* A task that splits itself, so that the work originates inside the
+ * pool, as in a parallel divide and conquer algorithm */
+static void
+split_task (gpointer data,
+	    gpointer user_data)
+{
+  GThreadPool *pool = user_data;
+  guint depth = GPOINTER_TO_UINT (data) - 1;
+
+  if (depth > 0)
+    {
+      /* depth - 1, stored as depth - 1 + 1 */
+      g_thread_pool_push (pool, GUINT_TO_POINTER (depth), NULL);
+      g_thread_pool_push (pool, GUINT_TO_POINTER (depth), NULL);
+    }
+
+  g_atomic_int_inc (&n_done);
+}
+
+static GThreadPool *
+create_pool (gboolean work_stealing,
+	     GFunc    func,
+	     gint     n_threads)
+{
+  GThreadPool *pool;
+
+  if (work_stealing)
+    pool = g_thread_pool_new_work_stealing (func, NULL, n_threads, NULL);
+  else
+    pool = g_thread_pool_new (func, NULL, n_threads, TRUE, NULL);
+
+  pool->user_data = pool;
+
+  return pool;
+}
+
+static void
+wait_for (gint n_tasks)
+{
+  while (g_atomic_int_get (&n_done) < n_tasks)
+    g_thread_yield ();
+}
+
+static void
+run_flat (gboolean work_stealing,
+	  gboolean batched,
+	  gint     n_threads,
+	  gint     n_tasks)
+{
+  gpointer batch[BATCH_SIZE];
+  GThreadPool *pool;
+  GTimer *timer;
+  gint i, j;
+
+  n_done = 0;
+  pool = create_pool (work_stealing, tiny_task, n_threads);
+  timer = g_timer_new ();
+
+  if (batched)
+    {
+      for (i = 0; i < n_tasks; i += BATCH_SIZE)
+	{
+	  gint n = MIN (BATCH_SIZE, n_tasks - i);
+
+	  for (j = 0; j < n; j++)
+	    batch[j] = GINT_TO_POINTER (i + j + 1);
+	  g_thread_pool_push_many (pool, batch, n, NULL);
+	}
+    }
+  else
+    {
+      for (i = 0; i < n_tasks; i++)
+	g_thread_pool_push (pool, GINT_TO_POINTER (i + 1), NULL);
+    }
+
+  wait_for (n_tasks);
+  g_timer_stop (timer);
+
+  g_print ("%-14s %-10s %8d tasks: %8.3f s, %10.0f tasks/s\n",
+	   work_stealing ? "work-stealing" : "classic",
+	   batched ? "push_many" : "push",
+	   n_tasks, g_timer_elapsed (timer, NULL),
+	   n_tasks / g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+  g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+static void
+run_split (gboolean work_stealing,
+	   gint     n_threads,
+	   guint    depth)
+{
+  GThreadPool *pool;
+  GTimer *timer;
+  gint n_tasks;
+
+  n_done = 0;
+  n_tasks = (1 << (depth + 1)) - 1;
+  pool = create_pool (work_stealing, split_task, n_threads);
+  timer = g_timer_new ();
+
+  /* Tasks must not be NULL, so they are depth + 1 */
+  g_thread_pool_push (pool, GUINT_TO_POINTER (depth + 1), NULL);
+
+  wait_for (n_tasks);
+  g_timer_stop (timer);
+
+  g_print ("%-14s %-10s %8d tasks: %8.3f s, %10.0f tasks/s\n",
+	   work_stealing ? "work-stealing" : "classic",
+	   "split",
+	   n_tasks, g_timer_elapsed (timer, NULL),
+	   n_tasks / g_timer_elapsed (timer, NULL));
+
+  g_timer_destroy (timer);
+  g_thread_pool_free (pool, FALSE, TRUE);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gint n_threads = 4;
+  gint n_tasks = 200000;
+  guint depth;
+
+  g_thread_init (NULL);
+
+  if (argc > 1)
+    n_threads = atoi (argv[1]);
+  if (argc > 2)
+    n_tasks = atoi (argv[2]);
+
+  if (n_threads < 1 || n_tasks < 1)
+    {
+      fprintf (stderr, "usage: %s [N_THREADS [N_TASKS]]\n", argv[0]);
+      return 1;
+    }
+
+  for (depth = 0; (2 << (depth + 1)) - 1 <= n_tasks; depth++)
+    ;
+
+  g_print ("%d threads\n", n_threads);
+
+  run_flat (FALSE, FALSE, n_threads, n_tasks);
+  run_flat (FALSE, TRUE, n_threads, n_tasks);
+  run_flat (TRUE, FALSE, n_threads, n_tasks);
+  run_flat (TRUE, TRUE, n_threads, n_tasks);
+  run_split (FALSE, n_threads, depth);
+  run_split (TRUE, n_threads, depth);
+
+  return 0;
+}
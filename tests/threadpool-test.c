@@ -200,6 +200,60 @@ test_thread_pools (void)
   g_assert (running_thread_counter == 0);
 }
 
+static gint ws_task_counter = 0;
+
+static void
+test_thread_work_stealing_entry_func (gpointer data, gpointer user_data)
+{
+  GThreadPool *pool = user_data;
+  guint depth;
+
+  depth = GPOINTER_TO_UINT (data) - 1;
+
+  /* Tasks pushed from inside the pool end up in the deque of the
+   * pushing thread and have to be stolen by the others */
+  if (depth > 0)
+    {
+      /* depth - 1, stored as depth - 1 + 1 */
+      g_thread_pool_push (pool, GUINT_TO_POINTER (depth), NULL);
+      g_thread_pool_push (pool, GUINT_TO_POINTER (depth), NULL);
+    }
+
+  g_atomic_int_inc (&ws_task_counter);
+}
+
+static void
+test_thread_work_stealing (void)
+{
+  GThreadPool *pool;
+  gpointer tasks[100];
+  guint i;
+
+  pool = g_thread_pool_new_work_stealing (test_thread_work_stealing_entry_func,
+					  NULL, 4, NULL);
+  pool->user_data = pool;
+  g_assert (g_thread_pool_get_num_threads (pool) == 4);
+
+  /* Tasks are depth + 1, as they must not be NULL. Every task of
+   * depth d results in 2^(d+1) - 1 calls */
+  g_thread_pool_push (pool, GUINT_TO_POINTER (10 + 1), NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (tasks); i++)
+    tasks[i] = GUINT_TO_POINTER (0 + 1);
+  g_thread_pool_push_many (pool, tasks, G_N_ELEMENTS (tasks), NULL);
+
+  /* Threads leaving the pool hand their tasks over to the others */
+  g_thread_pool_set_max_threads (pool, 2, NULL);
+  g_thread_pool_set_max_threads (pool, 6, NULL);
+
+  while (g_atomic_int_get (&ws_task_counter) < 2047 + G_N_ELEMENTS (tasks))
+    g_usleep (1000);
+
+  g_thread_pool_free (pool, FALSE, TRUE);
+
+  g_assert (ws_task_counter == 2047 + G_N_ELEMENTS (tasks));
+}
+
 static gint
 test_thread_sort_compare_func (gconstpointer a, gconstpointer b, gpointer user_data)
 {
@@ -413,6 +467,9 @@ test_check_start_and_stop (gpointer user_data)
     case 7:
       test_thread_idle_time ();
       break;
+    case 8:
+      test_thread_work_stealing ();
+      break;
     default:
       DEBUG_MSG (("***** END OF TESTS *****"));
       g_main_loop_quit (main_loop);
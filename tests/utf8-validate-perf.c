@@ -0,0 +1,150 @@
+/* utf8-validate-perf.c - measure g_utf8_validate() throughput
+ *
+ * Validates large ASCII, Latin, CJK and invalid texts, both with a
+ * length and nul-terminated, and compares against a plain byte at a
+ * time loop like the one g_utf8_validate() falls back to.
+ *
+ * Usage: utf8-validate-perf [SIZE_KB [N_ROUNDS]]
+ */
+
+#undef G_DISABLE_ASSERT
+#undef G_LOG_DOMAIN
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <glib.h>
+
+static const gchar *
+validate_bytewise (const gchar *text,
+		   gssize       len)
+{
+  const guchar *p = (const guchar *) text;
+  const guchar *end = p + len;
+
+  while (p < end)
+    {
+      gint n, i;
+
+      if (*p < 0x80)
+	n = 1;
+      else if ((*p & 0xe0) == 0xc0)
+	n = 2;
+      else if ((*p & 0xf0) == 0xe0)
+	n = 3;
+      else if ((*p & 0xf8) == 0xf0)
+	n = 4;
+      else
+	break;
+
+      if (end - p < n)
+	break;
+      for (i = 1; i < n; i++)
+	if ((p[i] & 0xc0) != 0x80)
+	  break;
+      if (i < n)
+	break;
+      p += n;
+    }
+
+  return (const gchar *) p;
+}
+
+static gchar *
+make_text (const gchar *pattern,
+	   gsize        size)
+{
+  gsize pattern_len = strlen (pattern);
+  gchar *text;
+  gsize i;
+
+  text = g_malloc (size + 1);
+  for (i = 0; i + pattern_len <= size; i += pattern_len)
+    memcpy (text + i, pattern, pattern_len);
+  memset (text + i, 'x', size - i);
+  text[size] = '\0';
+
+  return text;
+}
+
+static void
+run (const gchar *name,
+     const gchar *text,
+     gsize        size,
+     gint         n_rounds)
+{
+  const gchar *end;
+  GTimer *timer;
+  gdouble mb, t_len, t_nul, t_bytewise;
+  gint i;
+
+  mb = size * (gdouble) n_rounds / (1024 * 1024);
+  timer = g_timer_new ();
+
+  g_timer_start (timer);
+  for (i = 0; i < n_rounds; i++)
+    g_utf8_validate (text, size, &end);
+  t_len = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_rounds; i++)
+    g_utf8_validate (text, -1, &end);
+  t_nul = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < n_rounds; i++)
+    end = validate_bytewise (text, size);
+  t_bytewise = g_timer_elapsed (timer, NULL);
+
+  g_print ("%-8s %10.0f MB/s with length %10.0f MB/s nul-terminated %10.0f MB/s bytewise\n",
+	   name, mb / t_len, mb / t_nul, mb / t_bytewise);
+
+  g_timer_destroy (timer);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gsize size = 1024 * 1024;
+  gint n_rounds = 100;
+  gchar *text;
+
+  if (argc > 1)
+    size = atoi (argv[1]) * 1024;
+  if (argc > 2)
+    n_rounds = atoi (argv[2]);
+
+  if (size < 1 || n_rounds < 1)
+    {
+      fprintf (stderr, "usage: %s [SIZE_KB [N_ROUNDS]]\n", argv[0]);
+      return 1;
+    }
+
+  text = make_text ("The quick brown fox jumps over the lazy dog. ", size);
+  g_assert (g_utf8_validate (text, -1, NULL));
+  run ("ascii", text, size, n_rounds);
+  g_free (text);
+
+  text = make_text ("Der Fl\xc3\xbcgel, l'\xc3\xa9t\xc3\xa9, a\xc3\xb1o, s\xc3\xb8ster. ", size);
+  g_assert (g_utf8_validate (text, -1, NULL));
+  run ("latin", text, size, n_rounds);
+  g_free (text);
+
+  text = make_text ("\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e\xe3\x81\xae\xe6\x96\x87\xe7\xab\xa0\xe3\x80\x82", size);
+  g_assert (g_utf8_validate (text, -1, NULL));
+  run ("cjk", text, size, n_rounds);
+  g_free (text);
+
+  /* valid text with a stray continuation byte at the end, so that
+   * the whole text has to be looked at before it is rejected
+   */
+  text = make_text ("Caf\xc3\xa9 \xe6\x97\xa5\xe6\x9c\xac ", size);
+  text[size - 1] = '\x80';
+  g_assert (!g_utf8_validate (text, -1, NULL));
+  run ("invalid", text, size, n_rounds);
+  g_free (text);
+
+  return 0;
+}
@@ -17,6 +17,8 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <string.h>
+
 #include "glib.h"
 
 #define UNICODE_VALID(Char)                   \
@@ -306,6 +308,135 @@ do_test (gint         index,
     }
 }
 
+/* A byte at a time reference, to check long texts against */
+static const gchar *
+validate_reference (const gchar *text,
+		    gint         len)
+{
+  const guchar *p = (const guchar *) text;
+  const guchar *end = p + len;
+
+  while (p < end && *p)
+    {
+      gunichar c, min;
+      gint n, i;
+
+      if (*p < 0x80)
+	{
+	  p++;
+	  continue;
+	}
+      else if ((*p & 0xe0) == 0xc0)
+	n = 2, c = *p & 0x1f, min = 0x80;
+      else if ((*p & 0xf0) == 0xe0)
+	n = 3, c = *p & 0x0f, min = 0x800;
+      else if ((*p & 0xf8) == 0xf0)
+	n = 4, c = *p & 0x07, min = 0x10000;
+      else
+	break;
+
+      if (end - p < n)
+	break;
+      for (i = 1; i < n; i++)
+	{
+	  if ((p[i] & 0xc0) != 0x80)
+	    break;
+	  c = (c << 6) | (p[i] & 0x3f);
+	}
+      if (i < n || c < min || !UNICODE_VALID (c))
+	break;
+      p += n;
+    }
+
+  return (const gchar *) p;
+}
+
+static void
+do_long_test (const gchar *text,
+	      gint         len)
+{
+  const gchar *end, *expected;
+  gboolean result;
+  gchar *copy;
+
+  expected = validate_reference (text, len);
+
+  result = g_utf8_validate (text, len, &end);
+  if (result != (expected == text + len) || end != expected)
+    {
+      any_failed = TRUE;
+      g_print ("g_utf8_validate() on long text of %d bytes failed, "
+	       "expected %d, got %d\n",
+	       len, (gint) (expected - text), (gint) (end - text));
+    }
+
+  /* nul-terminated, placed at the end of the allocation */
+  copy = g_malloc (len + 1);
+  memcpy (copy, text, len);
+  copy[len] = '\0';
+  expected = validate_reference (copy, len + 1);
+
+  result = g_utf8_validate (copy, -1, &end);
+  if (result != (*expected == '\0') || end != copy + (expected - copy))
+    {
+      any_failed = TRUE;
+      g_print ("g_utf8_validate() on nul-terminated long text of %d bytes failed, "
+	       "expected %d, got %d\n",
+	       len, (gint) (expected - copy), (gint) (end - copy));
+    }
+  g_free (copy);
+}
+
+/* Texts longer than a vector, with each of the short tests spliced
+ * in at every offset, so that the vectorized validators see them
+ * across block boundaries.
+ */
+static void
+do_long_tests (void)
+{
+  static const gchar *fillers[] = {
+    "abcdefgh",
+    "\xc3\xa9t\xc3\xa9 caf\xc3\xa9",			/* Latin */
+    "\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e",		/* CJK */
+    "\xf0\x9f\x98\x80\xf0\x90\x80\x80",			/* 4 byte */
+    "\xef\xbf\xbd\xef\xb7\x80\xe4\xbf\xbe",		/* near noncharacters */
+  };
+  gchar buf[160];
+  gint f, i, offset, len, text_len;
+
+  for (f = 0; f < G_N_ELEMENTS (fillers); f++)
+    {
+      gint filler_len = strlen (fillers[f]);
+
+      for (i = 0; i < sizeof (buf); i++)
+	buf[i] = fillers[f][i % filler_len];
+
+      /* just filler, cut at any length */
+      for (len = 0; len < 130; len++)
+	do_long_test (buf, len);
+
+      for (i = 0; test[i].text; i++)
+	{
+	  if (test[i].max_len >= 0)
+	    continue;
+	  text_len = strlen (test[i].text);
+
+	  for (offset = 0; offset < 70; offset++)
+	    {
+	      gchar line[256];
+
+	      /* the filler may be cut in the middle of a character,
+	       * the reference takes care of that
+	       */
+	      memcpy (line, buf, offset);
+	      memcpy (line + offset, test[i].text, text_len);
+	      memcpy (line + offset + text_len, buf, 80);
+	      do_long_test (line, offset + text_len + 80);
+	    }
+	}
+    }
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -315,5 +446,7 @@ main (int argc, char *argv[])
     do_test (i, test[i].text, test[i].max_len, 
 	     test[i].offset, test[i].valid);
 
+  do_long_tests ();
+
   return any_failed ? 1 : 0;
 }